@@ -14,116 +14,6 @@
 #include "HexToBin.h"
 
 
-/**
-  This function reads a binary from disk.
-
-  @param[in]  FileName          Pointer to file name
-  @param[out] BufferSize        Return the number of bytes read.
-  @param[out] Buffer            The buffer to put read data into.
-
-  @retval EFI_SUCCESS           Data was read.
-  @retval EFI_NO_MEDIA          The device has no media.
-  @retval EFI_DEVICE_ERROR      The device reported an error.
-  @retval EFI_VOLUME_CORRUPTED  The file system structures are corrupted.
-  @retval EFI_BUFFER_TO_SMALL   Buffer is too small. ReadSize contains required size.
-
-**/
-EFI_STATUS
-EFIAPI
-ReadFileFromDisk (
-  IN  CHAR16               *FileName,
-  OUT  UINTN               *BufferSize,
-  OUT  VOID                **Buffer
-  )
-{
-  EFI_STATUS           Status;
-  SHELL_FILE_HANDLE    FileHandle;
-  UINTN                FileSize;
-  VOID                 *FileBuffer;
-
-  FileBuffer = NULL;
-
-  Status = ShellOpenFileByName (FileName, &FileHandle, EFI_FILE_MODE_READ, 0);
-  if (EFI_ERROR (Status)) {
-    Print (L"Open file failed: %r\n", Status);
-    return Status;
-  }
-
-  Status = ShellGetFileSize (FileHandle, &FileSize);
-  if (EFI_ERROR (Status)) {
-    Print (L"Failed to read file size, Status: %r\n", Status);
-    if (FileHandle != NULL) {
-      ShellCloseFile (&FileHandle);
-    }
-    return Status;
-  }
-
-  Status = gBS->AllocatePool (
-                  EfiBootServicesData,
-                  (UINTN) FileSize,
-                  (VOID**) &FileBuffer
-                  );
-  if ((FileBuffer == NULL) || EFI_ERROR(Status)) {
-    Print (L"Allocate resouce failed\n");
-    if (FileHandle != NULL) {
-      ShellCloseFile (&FileHandle);
-    }
-    return EFI_OUT_OF_RESOURCES;
-  }
-
-  Status = ShellReadFile (FileHandle, &FileSize, FileBuffer);
-  if (EFI_ERROR (Status)) {
-    Print (L"Failed to read file, Status: %r\n", Status);
-    if (FileHandle != NULL) {
-      ShellCloseFile (&FileHandle);
-    }
-    if (FileBuffer != NULL) {
-      FreePool (FileBuffer);
-    }
-    return Status;
-  }
-
-  ShellCloseFile (&FileHandle);
-
-  *BufferSize = FileSize;
-  *Buffer     = FileBuffer;
-
-  return EFI_SUCCESS;
-}
-
-EFI_STATUS
-EFIAPI
-SaveFileToDisk (
-  IN  CHAR16              *FileName,
-  IN  UINTN               BufferSize,
-  IN  VOID                *Buffer
-  )
-{
-  EFI_STATUS           Status;
-  SHELL_FILE_HANDLE    FileHandle;
-
-  if (!EFI_ERROR (ShellFileExists (FileName))) {
-    ShellDeleteFileByName (FileName);
-  }
-
-  Status = ShellOpenFileByName (FileName, &FileHandle, EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE, 0);
-  if (EFI_ERROR (Status)) {
-    Print (L"Open file failed: %r\n", Status);
-    return Status;
-  }
-
-  Status = ShellWriteFile (FileHandle, &BufferSize, Buffer);
-  if (EFI_ERROR (Status)) {
-    Print (L"Write file failed: %r\n", Status);
-    ShellCloseFile (&FileHandle);
-    return Status;
-  }
-
-  ShellCloseFile (&FileHandle);
-
-  return EFI_SUCCESS;
-}
-
 /**
   Change char to int value based on Hex.
 
@@ -190,88 +80,31 @@ IntelHexGetWord (
 }
 
 /**
-  Copy one line data from buffer data to the line buffer.
+  Convert an Intel HEX file to a binary image, reading it a line at a time.
 
-  @param[in]      Buffer          Buffer data.
-  @param[in]      BufferSize      Buffer Size.
-  @param[in, out] LineBuffer      Line buffer to store the found line data.
-  @param[in, out] LineSize        On input, size of the input line buffer.
-                                  On output, size of the actual line buffer.
+  @param[in]  HexFile         The Intel HEX file.
+  @param[out] BinBuffer       The binary image; free with FreePool.
+  @param[out] BinSize         Size of the binary image.
 
-  @retval EFI_BUFFER_TOO_SMALL    The size of input line buffer is not enough.
-  @retval EFI_SUCCESS             Copy line data into the line buffer.
+  @retval EFI_SUCCESS             The image was converted.
+  @retval EFI_OUT_OF_RESOURCES    No enough buffer to allocate.
+  @retval EFI_VOLUME_CORRUPTED    A record is shorter than its byte count.
+  @retval EFI_UNSUPPORTED         A record type is unknown.
+  @retval Others                  The file could not be read.
 
 **/
-EFI_STATUS
-IntelHexGetLine (
-  IN      UINT8                *Buffer,
-  IN      UINTN                BufferSize,
-  IN OUT  UINT8                *LineBuffer,
-  IN OUT  UINTN                *LineSize
-  )
-{
-  UINTN                       Length;
-  UINT8                       *PtrBuf;
-  UINTN                       PtrEnd;
-
-  PtrBuf = Buffer;
-  PtrEnd = (UINTN) Buffer + BufferSize;
-
-  //
-  // 0x0D indicates a line break. Otherwise there is no line break
-  //
-  while ((UINTN) PtrBuf < PtrEnd) {
-    if (*PtrBuf == 0x0D || *PtrBuf == 0x0A) {
-      break;
-    }
-    PtrBuf++;
-  }
-
-  if ((UINTN) PtrBuf >= (PtrEnd - 1)) {
-    //
-    // The buffer ends without any line break
-    // or it is the last character of the buffer
-    //
-    Length = BufferSize;
-  } else if (*(PtrBuf + 1) == 0x0A) {
-    //
-    // Further check if a 0x0A follows. If yes, count 0xA
-    //
-    Length = (UINTN) PtrBuf - (UINTN) Buffer + 2;
-  } else {
-    Length = (UINTN) PtrBuf - (UINTN) Buffer + 1;
-  }
-
-  if (Length > (*LineSize)) {
-    *LineSize = Length;
-    return EFI_BUFFER_TOO_SMALL;
-  }
-
-  SetMem (LineBuffer, *LineSize, 0x0);
-  *LineSize = Length;
-  CopyMem (LineBuffer, Buffer, Length);
-
-  return EFI_SUCCESS;
-}
-
 EFI_STATUS
 EFIAPI
 ProcessIntelHexFile (
-  IN VOID              *DataBuffer,
-  IN UINTN             BufferSize,
-  IN OUT VOID          **BinBuffer,
-  IN OUT UINTN         *BinSize
+  IN  FILE_IO_STREAM    *HexFile,
+  OUT VOID              **BinBuffer,
+  OUT UINTN             *BinSize
   )
 {
   EFI_STATUS               Status;
-  UINT8                    *Source;
-  UINT8                    *CurrentPtr;
-  UINT8                    *BufferEnd;
-  UINT8                    *SourcePtrLine;
+  CHAR8                    *SourcePtrLine;
   UINT8                    *PtrLine;
   UINTN                    LineLength;
-  UINTN                    SourceLength;
-  UINTN                    MaxLineLength;
   UINTN                    LineNumber;
   UINT8                    ByteCount;
   UINT16                   Address;
@@ -282,47 +115,42 @@ ProcessIntelHexFile (
   UINT8                    Data;
   UINTN                    BinLength;
 
-  BufferEnd        = (UINT8 *) ( (UINTN) DataBuffer + BufferSize);
-  CurrentPtr       = (UINT8 *) DataBuffer;
-  MaxLineLength    = MAX_LINE_LENGTH;
-  LineNumber       = 0;
+  LineNumber = 0;
+  BinLength  = 0;
 
-  SourcePtrLine = AllocatePool (MaxLineLength);
+  SourcePtrLine = AllocatePool (MAX_LINE_LENGTH);
   if (SourcePtrLine == NULL) {
     DEBUG ((DEBUG_ERROR, "Allocate resource for line failed.\n"));
     return EFI_OUT_OF_RESOURCES;
   }
 
-  Buffer = AllocatePool (BufferSize);
+  Buffer = AllocatePool (MAX_BIN_SIZE);
   if (Buffer == NULL) {
     DEBUG ((DEBUG_ERROR, "Allocate resource for BIN buffer failed.\n"));
+    FreePool (SourcePtrLine);
     return EFI_OUT_OF_RESOURCES;
   }
 
-  SetMem (Buffer, BufferSize, 0xFF);
+  SetMem (Buffer, MAX_BIN_SIZE, 0xFF);
 
-  while (CurrentPtr < BufferEnd) {
-    Source              = CurrentPtr;
-    SourceLength        = (UINTN) BufferEnd - (UINTN) CurrentPtr;
-    LineLength          = MaxLineLength;
-    CheckSum            = 0;
+  while (TRUE) {
+    CheckSum   = 0;
+    LineLength = MAX_LINE_LENGTH;
 
-    Status = IntelHexGetLine (
-               (UINT8 *) Source,
-               SourceLength,
-               (UINT8 *) SourcePtrLine,
-               &LineLength
-               );
+    Status = FileIoReadLine (HexFile, SourcePtrLine, &LineLength);
+    if (Status == EFI_END_OF_FILE) {
+      break;
+    }
     if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "IntelHexGetLine() falied: %r\n", Status));
-      FreePool (PtrLine);
-      FreePool (Buffer);
-      return Status;
+      DEBUG ((DEBUG_ERROR, "FileIoReadLine() failed: %r\n", Status));
+      goto Error;
     }
 
-    PtrLine = SourcePtrLine;
+    if (LineLength == 0) {
+      continue;
+    }
 
-    CurrentPtr = (UINT8 *) ((UINTN) CurrentPtr + LineLength);
+    PtrLine = (UINT8 *) SourcePtrLine;
 
     if (*PtrLine != INTEL_HEX_START_CODE) {
       DEBUG ((DEBUG_INFO, "Invalid Hex format on Line: 0x%x\n", LineNumber));
@@ -333,11 +161,20 @@ ProcessIntelHexFile (
     // Start code  |  Byte count  |  Address  |  Record type  |  Data  |  Checksum
     // Byte count, two hex digits (one hex digit pair)
     //
+    if (LineLength < INTEL_HEX_RECORD_LENGTH (0)) {
+      Status = EFI_VOLUME_CORRUPTED;
+      goto Error;
+    }
     PtrLine++;
     ByteCount = IntelHexGetByte (PtrLine);
     if (ByteCount == 0) {
       break;
     }
+    if (LineLength < INTEL_HEX_RECORD_LENGTH (ByteCount)) {
+      DEBUG ((DEBUG_ERROR, "Record too short on Line: 0x%x\n", LineNumber));
+      Status = EFI_VOLUME_CORRUPTED;
+      goto Error;
+    }
     CheckSum += ByteCount;
 
     //
@@ -366,7 +203,7 @@ ProcessIntelHexFile (
         CheckSum += Data;
         PtrLine  += 2;
 
-        CopyMem (Buffer + BinLength, &Data, sizeof (UINT8));
+        Buffer[BinLength] = Data;
 
         BinLength++;
       }
@@ -395,21 +232,25 @@ ProcessIntelHexFile (
 
     default:
       DEBUG ((DEBUG_INFO, "Invalid Record type: 0x%x on Line: 0x%x\n", RecordType, LineNumber));
-      return EFI_UNSUPPORTED;
+      Status = EFI_UNSUPPORTED;
+      goto Error;
     }
 
     LineNumber++;
   }
 
-  if (SourcePtrLine != NULL) {
-    FreePool (SourcePtrLine);
-  }
+  FreePool (SourcePtrLine);
   *BinBuffer = Buffer;
   *BinSize   = BinLength;
 
   DEBUG ((DEBUG_INFO, "BIN file size: 0x%x\n", *BinSize));
 
   return EFI_SUCCESS;
+
+Error:
+  FreePool (SourcePtrLine);
+  FreePool (Buffer);
+  return Status;
 }
 
 /**
@@ -449,8 +290,7 @@ ShellAppMain (
   )
 {
   EFI_STATUS                Status;
-  VOID                      *HexBuffer;
-  UINTN                     HexBufferSize;
+  FILE_IO_STREAM            *HexFile;
   VOID                      *BinBuffer;
   UINTN                     BinBufferSize;
 
@@ -471,28 +311,26 @@ ShellAppMain (
     //
     // Read a Intel Hex file
     //
-    Status = ReadFileFromDisk (Argv[1], &HexBufferSize, &HexBuffer);
+    Status = FileIoOpenReader (Argv[1], 0, FILE_IO_DOUBLE_BUFFER, &HexFile);
     if (EFI_ERROR (Status)) {
       Print (L"Read Intel Hex file failed. %r\n", Status);
       return Status;
     }
 
-    Status = ProcessIntelHexFile (HexBuffer, HexBufferSize, &BinBuffer, &BinBufferSize);
+    Status = ProcessIntelHexFile (HexFile, &BinBuffer, &BinBufferSize);
+    FileIoClose (HexFile);
     if (EFI_ERROR (Status)) {
       Print (L"Process Intel Hex file failed. %r\n", Status);
       return Status;
     }
 
-    Status = SaveFileToDisk (Argv[2], BinBufferSize, BinBuffer);
+    Status = FileIoWriteFile (Argv[2], BinBufferSize, BinBuffer);
+    FreePool (BinBuffer);
     if (EFI_ERROR (Status)) {
       Print (L"Write BIN file failed. %r\n", Status);
       return Status;
     }
 
-    if (BinBuffer != NULL) {
-      FreePool (BinBuffer);
-    }
-
     return EFI_SUCCESS;
   }
 
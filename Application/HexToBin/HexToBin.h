@@ -26,6 +26,7 @@
 #include <Library/BaseMemoryLib.h>
 #include <Library/DevicePathLib.h>
 #include <Library/PrintLib.h>
+#include <Library/FileIoLib.h>
 #include <Protocol/BlockIo.h>
 #include <Protocol/DiskIo.h>
 //
@@ -47,4 +48,16 @@ typedef enum {
 
 #define INTEL_HEX_START_CODE      ':'
 
+//
+// Characters in a record with Count data bytes: start code, byte count,
+// address, record type, data and checksum.
+//
+#define INTEL_HEX_RECORD_LENGTH(Count)  (1 + 2 + 4 + 2 + (Count) * 2 + 2)
+
+//
+// Data records hold 16 bit addresses, and the last may run up to 255 bytes
+// past the top address.
+//
+#define MAX_BIN_SIZE              (SIZE_64KB + MAX_UINT8)
+
 #endif
@@ -33,8 +33,6 @@ typedef struct {
   EFI_DISK_IO_PROTOCOL      *DiskIo;
 } PARTITON_DATA;
 
-STATIC CONST CHAR8 Hex[] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
-
 LIST_ENTRY                  mPartitionListHead;
 EFI_DEVICE_PATH_PROTOCOL    *mDiskDevicePath;
 PARTITON_DATA               *mPartData;
@@ -52,6 +50,19 @@ PARTITON_DATA               *mPartData;
 #define FILL_BUF_SIZE               (16 * 1024 * 1024)
 #define SPARSE_BLOCK_SIZE           4096
 
+//
+// Bytes of the image read, and written to the partition, at a time.  The
+// image is double buffered, so the next chunk is read while one is written.
+//
+#define FLASH_CHUNK_SIZE            SIZE_16MB
+
+//
+// RAW data of at least this size is written straight from the read buffer;
+// smaller RAW and FILL chunks are gathered in the fill buffer while they are
+// contiguous on the disk.
+//
+#define SPARSE_DIRECT_WRITE_SIZE    SIZE_1MB
+
 typedef struct {
   UINT32       Magic;
   UINT16       MajorVersion;
@@ -71,94 +82,87 @@ typedef struct {
   UINT32       TotalSize;
 } CHUNK_HEADER;
 
+typedef struct {
+  EFI_DISK_IO_PROTOCOL      *DiskIo;
+  UINT32                    MediaId;
+  UINT8                     *Buffer;     // FILL_BUF_SIZE bytes
+  UINT64                    Offset;      // Disk offset of the gathered bytes
+  UINTN                     Length;      // Bytes gathered in Buffer
+} SPARSE_WRITER;
+
+/**
+  Save a range of a disk to a file, one chunk at a time.
+
+  @param[in]  DiskIo        Disk IO protocol of the disk.
+  @param[in]  MediaId       Media ID of the disk.
+  @param[in]  Offset        Starting byte offset on the disk.
+  @param[in]  Size          Bytes to save.
+  @param[in]  FileName      The file to write.
+
+  @retval EFI_SUCCESS       The range was saved.
+  @retval Others            The disk could not be read or the file written.
+
+**/
+STATIC
 EFI_STATUS
-EFIAPI
-ReadFileFromDisk (
-  IN  CHAR16               *FileName,
-  OUT  UINTN               *BufferSize,
-  OUT  VOID                **Buffer
+SaveDiskRangeToFile (
+  IN EFI_DISK_IO_PROTOCOL   *DiskIo,
+  IN UINT32                 MediaId,
+  IN UINT64                 Offset,
+  IN UINT64                 Size,
+  IN CHAR16                 *FileName
   )
 {
   EFI_STATUS           Status;
-  SHELL_FILE_HANDLE    FileHandle;
-  UINTN                FileSize;
-  VOID                 *FileBuffer;
+  EFI_STATUS           CloseStatus;
+  FILE_IO_STREAM       *File;
+  VOID                 *Chunk;
+  UINTN                ChunkSize;
 
-  Status = ShellOpenFileByName (FileName, &FileHandle, EFI_FILE_MODE_READ, 0);
+  Status = FileIoOpenWriter (FileName, Size, 0, FILE_IO_DOUBLE_BUFFER, &File);
   if (EFI_ERROR (Status)) {
     Print (L"Open file failed: %r\n", Status);
     return Status;
   }
 
-  Status = ShellGetFileSize (FileHandle, &FileSize);
-  if (EFI_ERROR (Status)) {
-    Print (L"Failed to read file size, Status: %r\n", Status);
-    if (FileHandle != NULL) {
-      ShellCloseFile (&FileHandle);
+  //
+  // Read each chunk straight into the writer's buffer; while the disk is
+  // read the previous chunk is written to the file.
+  //
+  while (Size > 0) {
+    Status = FileIoGetWriteBuffer (File, &Chunk, &ChunkSize);
+    if (EFI_ERROR (Status)) {
+      break;
     }
-    return Status;
-  }
 
-  FileBuffer = AllocateZeroPool (FileSize);
-  if (FileBuffer == NULL) {
-    Print (L"Allocate resouce failed\n");
-    if (FileHandle != NULL) {
-      ShellCloseFile (&FileHandle);
+    if (ChunkSize > Size) {
+      ChunkSize = (UINTN) Size;
     }
-    return EFI_OUT_OF_RESOURCES;
-  }
 
-  Status = ShellReadFile (FileHandle, &FileSize, FileBuffer);
-  if (EFI_ERROR (Status)) {
-    Print (L"Failed to read file, Status: %r\n", Status);
-    if (FileHandle != NULL) {
-      ShellCloseFile (&FileHandle);
-    }
-    if (FileBuffer != NULL) {
-      FreePool (FileBuffer);
+    Status = DiskIo->ReadDisk (DiskIo, MediaId, Offset, ChunkSize, Chunk);
+    if (EFI_ERROR (Status)) {
+      break;
     }
-    return Status;
-  }
-
-  ShellCloseFile (&FileHandle);
 
-  *BufferSize = FileSize;
-  *Buffer     = FileBuffer;
-
-  return EFI_SUCCESS;
-}
-
-EFI_STATUS
-EFIAPI
-SaveFileToDisk (
-  IN  CHAR16              *FileName,
-  IN  UINTN               BufferSize,
-  IN  VOID                *Buffer
-  )
-{
-  EFI_STATUS           Status;
-  SHELL_FILE_HANDLE    FileHandle;
+    Status = FileIoCommitWrite (File, ChunkSize);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
 
-  if (!EFI_ERROR (ShellFileExists (FileName))) {
-    ShellDeleteFileByName (FileName);
+    Offset += ChunkSize;
+    Size   -= ChunkSize;
   }
 
-  Status = ShellOpenFileByName (FileName, &FileHandle, EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE, 0);
-  if (EFI_ERROR (Status)) {
-    Print (L"Open file failed: %r\n", Status);
-    return Status;
+  CloseStatus = FileIoClose (File);
+  if (!EFI_ERROR (Status)) {
+    Status = CloseStatus;
   }
 
-  Status = ShellWriteFile (FileHandle, &BufferSize, Buffer);
   if (EFI_ERROR (Status)) {
-    Print (L"Write file failed: %r\n", Status);
-    ShellCloseFile (&FileHandle);
-    return Status;
+    Print (L"Save file failed: %r\n", Status);
   }
 
-  ShellCloseFile (&FileHandle);
-
-  return EFI_SUCCESS;
+  return Status;
 }
 
 BOOLEAN
@@ -669,98 +673,16 @@ SavePartitionData (
   EFI_STATUS               Status;
   EFI_BLOCK_IO_PROTOCOL    *BlockIo;
   EFI_DISK_IO_PROTOCOL     *DiskIo;
-  UINT32                   MediaId;
-  UINTN                    PartitionSize;
-  VOID                     *Buffer;
-
-  Buffer = NULL;
+  UINT64                   PartitionSize;
 
   Status = OpenPartition (PartitionName, &BlockIo, &DiskIo);
   if (EFI_ERROR (Status)) {
     return Status;
   }
 
-  //
-  // Check read partition size will fit on device.
-  //
-  PartitionSize = (BlockIo->Media->LastBlock + 1) * BlockIo->Media->BlockSize;
-  if (PartitionSize > SIZE_2GB) {
-    DEBUG ((DEBUG_ERROR, "Partition is too big. Size: 0x%x\n", PartitionSize));
-    return EFI_VOLUME_FULL;
-  }
-
-  MediaId = BlockIo->Media->MediaId;
-
-  Buffer = AllocateZeroPool (PartitionSize);
-  if (Buffer == NULL) {
-    return EFI_OUT_OF_RESOURCES;
-  }
-
-  Status = DiskIo->ReadDisk (DiskIo, MediaId, 0, PartitionSize, Buffer);
-  if (EFI_ERROR (Status)) {
-    FreePool (Buffer);
-    return Status;
-  }
-
-  Status = SaveFileToDisk (FileName, PartitionSize, Buffer);
-  if (EFI_ERROR (Status)) {
-    if (Buffer != NULL) {
-      FreePool (Buffer);
-      Buffer = NULL;
-    }
-    return Status;
-  }
-
-  if (Buffer != NULL) {
-    FreePool (Buffer);
-    Buffer = NULL;
-  }
+  PartitionSize = MultU64x32 (BlockIo->Media->LastBlock + 1, BlockIo->Media->BlockSize);
 
-  return EFI_SUCCESS;
-}
-
-VOID
-EFIAPI
-DumpHex (
-  IN UINTN        Indent,
-  IN UINTN        Offset,
-  IN UINTN        DataSize,
-  IN VOID         *UserData
-  )
-{
-  UINT8 *Data;
-
-  CHAR8 Val[50];
-
-  CHAR8 Str[20];
-
-  UINT8 TempByte;
-  UINTN Size;
-  UINTN Index;
-
-  Data = UserData;
-  while (DataSize != 0) {
-    Size = 16;
-    if (Size > DataSize) {
-      Size = DataSize;
-    }
-
-    for (Index = 0; Index < Size; Index += 1) {
-      TempByte            = Data[Index];
-      Val[Index * 3 + 0]  = Hex[TempByte >> 4];
-      Val[Index * 3 + 1]  = Hex[TempByte & 0xF];
-      Val[Index * 3 + 2]  = (CHAR8) ((Index == 7) ? '-' : ' ');
-      Str[Index]          = (CHAR8) ((TempByte < ' ' || TempByte > '~') ? '.' : TempByte);
-    }
-
-    Val[Index * 3]  = 0;
-    Str[Index]      = 0;
-    Print(L"%*a%08X: %-48a *%a*\r\n", Indent, "", Offset, Val, Str);
-
-    Data += Size;
-    Offset += Size;
-    DataSize -= Size;
-  }
+  return SaveDiskRangeToFile (DiskIo, BlockIo->Media->MediaId, 0, PartitionSize, FileName);
 }
 
 VOID
@@ -810,141 +732,509 @@ DumpParentDevice (
   Print (L"OptimalTransferLengthGranularity: 0x%x\n", mPartData->BlockIo->Media->OptimalTransferLengthGranularity);
 }
 
+/**
+  Read the next bytes of an image; a short read means the image is truncated.
+
+  @param[in]  File          The image.
+  @param[in]  Size          Bytes to read.
+  @param[out] Buffer        Receives the bytes.
+
+  @retval EFI_SUCCESS           The bytes were read.
+  @retval EFI_VOLUME_CORRUPTED  The image ends first.
+  @retval Others                The image could not be read.
+
+**/
+STATIC
+EFI_STATUS
+ReadImage (
+  IN  FILE_IO_STREAM  *File,
+  IN  UINTN           Size,
+  OUT VOID            *Buffer
+  )
+{
+  EFI_STATUS          Status;
+  UINTN               ReadSize;
+
+  ReadSize = Size;
+  Status   = FileIoRead (File, &ReadSize, Buffer);
+  if (!EFI_ERROR (Status) && (ReadSize != Size)) {
+    DEBUG ((DEBUG_ERROR, "Image is truncated.\n"));
+    Status = EFI_VOLUME_CORRUPTED;
+  }
+
+  return Status;
+}
+
+/**
+  Skip the next bytes of an image.
+
+  @param[in]  File          The image.
+  @param[in]  Size          Bytes to skip.
+
+  @retval EFI_SUCCESS           The bytes were skipped.
+  @retval EFI_VOLUME_CORRUPTED  The image ends first.
+  @retval Others                The image could not be read.
+
+**/
+STATIC
+EFI_STATUS
+SkipImage (
+  IN FILE_IO_STREAM   *File,
+  IN UINT64           Size
+  )
+{
+  EFI_STATUS          Status;
+  VOID                *Data;
+  UINTN               Length;
+
+  Status = EFI_SUCCESS;
+  while ((Size > 0) && !EFI_ERROR (Status)) {
+    Status = FileIoReadChunkEx (File, (UINTN) MIN (Size, MAX_UINTN), &Data, &Length);
+    if (!EFI_ERROR (Status) && (Length == 0)) {
+      DEBUG ((DEBUG_ERROR, "Image is truncated.\n"));
+      Status = EFI_VOLUME_CORRUPTED;
+    }
+    Size -= Length;
+  }
+
+  return Status;
+}
+
+/**
+  Write the bytes gathered by a sparse writer to the disk.
+
+  @param[in]  Writer        The sparse writer.
+
+  @return The status of the write.
+
+**/
+STATIC
+EFI_STATUS
+SparseWriterFlush (
+  IN SPARSE_WRITER          *Writer
+  )
+{
+  EFI_STATUS          Status;
+
+  if (Writer->Length == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Status = Writer->DiskIo->WriteDisk (Writer->DiskIo, Writer->MediaId, Writer->Offset, Writer->Length, Writer->Buffer);
+  Writer->Offset += Writer->Length;
+  Writer->Length  = 0;
+  return Status;
+}
+
+/**
+  Make room in a sparse writer for Length bytes at a disk offset, flushing
+  what is gathered when the bytes would not follow it or not fit.
+
+  @param[in]  Writer        The sparse writer.
+  @param[in]  Offset        Disk offset of the bytes.
+  @param[in]  Length        Bytes to gather, at most FILL_BUF_SIZE.
+
+  @return The status of the flush.
+
+**/
+STATIC
+EFI_STATUS
+SparseWriterReserve (
+  IN SPARSE_WRITER          *Writer,
+  IN UINT64                 Offset,
+  IN UINTN                  Length
+  )
+{
+  EFI_STATUS          Status;
+
+  Status = EFI_SUCCESS;
+  if ((Writer->Offset + Writer->Length != Offset) || (Writer->Length + Length > FILL_BUF_SIZE)) {
+    Status         = SparseWriterFlush (Writer);
+    Writer->Offset = Offset;
+  }
+  return Status;
+}
+
+/**
+  Write RAW chunk data.  Large spans go to the disk straight from the read
+  buffer; small ones are gathered with their contiguous neighbours.
+
+  @param[in]  Writer        The sparse writer.
+  @param[in]  Offset        Disk offset of the data.
+  @param[in]  Data          The data.
+  @param[in]  Length        Bytes of data.
+
+  @return The status of the writes.
+
+**/
+STATIC
+EFI_STATUS
+SparseWriterRaw (
+  IN SPARSE_WRITER          *Writer,
+  IN UINT64                 Offset,
+  IN VOID                   *Data,
+  IN UINTN                  Length
+  )
+{
+  EFI_STATUS          Status;
+
+  if (Length >= SPARSE_DIRECT_WRITE_SIZE) {
+    Status = SparseWriterFlush (Writer);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+    Writer->Offset = Offset + Length;
+    return Writer->DiskIo->WriteDisk (Writer->DiskIo, Writer->MediaId, Offset, Length, Data);
+  }
+
+  Status = SparseWriterReserve (Writer, Offset, Length);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  CopyMem (Writer->Buffer + Writer->Length, Data, Length);
+  Writer->Length += Length;
+  return EFI_SUCCESS;
+}
+
+/**
+  Write a FILL chunk.  A fill that fits is gathered with its contiguous
+  neighbours; a larger one is written from a buffer full of the pattern.
+
+  @param[in]  Writer        The sparse writer.
+  @param[in]  Offset        Disk offset of the fill.
+  @param[in]  Length        Bytes to fill, a multiple of 4.
+  @param[in]  Value         The 32-bit pattern.
+
+  @return The status of the writes.
+
+**/
+STATIC
+EFI_STATUS
+SparseWriterFill (
+  IN SPARSE_WRITER          *Writer,
+  IN UINT64                 Offset,
+  IN UINT64                 Length,
+  IN UINT32                 Value
+  )
+{
+  EFI_STATUS          Status;
+  UINTN               Count;
+
+  if (Length < SPARSE_DIRECT_WRITE_SIZE) {
+    //
+    // SetMem32 needs an aligned destination.
+    //
+    Status = EFI_SUCCESS;
+    if ((Writer->Length % sizeof (UINT32)) != 0) {
+      Status = SparseWriterFlush (Writer);
+    }
+    if (!EFI_ERROR (Status)) {
+      Status = SparseWriterReserve (Writer, Offset, (UINTN) Length);
+    }
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+    SetMem32 (Writer->Buffer + Writer->Length, (UINTN) Length, Value);
+    Writer->Length += (UINTN) Length;
+    return EFI_SUCCESS;
+  }
+
+  Status = SparseWriterFlush (Writer);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  SetMem32 (Writer->Buffer, (UINTN) MIN (Length, FILL_BUF_SIZE), Value);
+  while ((Length > 0) && !EFI_ERROR (Status)) {
+    Count   = (UINTN) MIN (Length, FILL_BUF_SIZE);
+    Status  = Writer->DiskIo->WriteDisk (Writer->DiskIo, Writer->MediaId, Offset, Count, Writer->Buffer);
+    Offset += Count;
+    Length -= Count;
+  }
+  Writer->Offset = Offset;
+  return Status;
+}
+
+/**
+  Flash an Android sparse image, decoding it chunk by chunk as it is read.
+
+  RAW data is handed to the disk from the stream's read buffers, so memory
+  use is the two read buffers and one gather buffer whatever the image size.
+
+  @param[in]  DiskIo          Disk IO protocol of the partition.
+  @param[in]  MediaId         Media ID of the partition.
+  @param[in]  PartitionSize   Bytes in the partition.
+  @param[in]  File            The image, at its sparse header.
+
+  @retval EFI_SUCCESS           The image was flashed.
+  @retval EFI_VOLUME_FULL       The image does not fit in the partition.
+  @retval EFI_VOLUME_CORRUPTED  The image is malformed or truncated.
+  @retval Others                The image could not be read or written.
+
+**/
 EFI_STATUS
 EFIAPI
 FlashSparseImage (
-  IN CHAR8         *PartitionName,
-  IN SPARSE_HEADER *SparseHeader
+  IN EFI_DISK_IO_PROTOCOL   *DiskIo,
+  IN UINT32                 MediaId,
+  IN UINT64                 PartitionSize,
+  IN FILE_IO_STREAM         *File
   )
 {
   EFI_STATUS        Status;
+  EFI_STATUS        FlushStatus;
+  SPARSE_HEADER     SparseHeader;
+  CHUNK_HEADER      ChunkHeader;
+  SPARSE_WRITER     Writer;
   UINTN             Chunk;
-  UINTN             Offset;
-  UINTN             Left;
-  UINTN             Count;
-  UINTN             FillBufSize;
-  UINT8             *Image;
-  CHUNK_HEADER      *ChunkHeader;
-  VOID              *FillBuf;
+  UINT64            Offset;
+  UINT64            Left;
+  UINT64            DataSize;
+  UINT32            FillValue;
+  VOID              *Data;
+  UINTN             Length;
+
+  Status = ReadImage (File, sizeof (SPARSE_HEADER), &SparseHeader);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
 
-  Status = EFI_SUCCESS;
-  Offset = 0;
+  DEBUG ((DEBUG_INFO, "Sparse Magic: 0x%x\n", SparseHeader.Magic));
+  DEBUG ((DEBUG_INFO, "Major: %d, Minor: %d\n", SparseHeader.MajorVersion, SparseHeader.MinorVersion));
+  DEBUG ((DEBUG_INFO, "FileHeaderSize: %d, ChunkHeaderSize: %d\n", SparseHeader.FileHeaderSize, SparseHeader.ChunkHeaderSize));
+  DEBUG ((DEBUG_INFO, "BlockSize: %d, TotalBlocks: %d\n", SparseHeader.BlockSize, SparseHeader.TotalBlocks));
+  DEBUG ((DEBUG_INFO, "TotalChunks: %d, ImageChecksum: %d\n", SparseHeader.TotalChunks, SparseHeader.ImageChecksum));
 
-  Image = (UINT8 *)SparseHeader;
-  Image += SparseHeader->FileHeaderSize;
+  if (SparseHeader.MajorVersion != 1) {
+    DEBUG ((DEBUG_ERROR, "Sparse image version %d.%d not supported.\n", SparseHeader.MajorVersion, SparseHeader.MinorVersion));
+    return EFI_INVALID_PARAMETER;
+  }
 
-  //
-  // Allocate the fill buffer
-  //
-  FillBufSize = FILL_BUF_SIZE;
-  FillBuf = AllocatePool (FillBufSize);
-  if (FillBuf == NULL) {
+  if ((SparseHeader.FileHeaderSize < sizeof (SPARSE_HEADER)) ||
+      (SparseHeader.ChunkHeaderSize < sizeof (CHUNK_HEADER)) ||
+      (SparseHeader.BlockSize == 0) || ((SparseHeader.BlockSize % sizeof (UINT32)) != 0)) {
+    DEBUG ((DEBUG_ERROR, "Sparse image header is corrupted.\n"));
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  if (MultU64x32 (SparseHeader.TotalBlocks, SparseHeader.BlockSize) > PartitionSize) {
+    DEBUG ((DEBUG_ERROR, "Partition not big enough.\n"));
+    return EFI_VOLUME_FULL;
+  }
+
+  ZeroMem (&Writer, sizeof (Writer));
+  Writer.DiskIo  = DiskIo;
+  Writer.MediaId = MediaId;
+  Writer.Buffer  = AllocatePool (FILL_BUF_SIZE);
+  if (Writer.Buffer == NULL) {
     DEBUG ((DEBUG_ERROR, "Fail to allocate the fill buffer.\n"));
     return EFI_OUT_OF_RESOURCES;
   }
 
-  for (Chunk = 0; Chunk < SparseHeader->TotalChunks; Chunk++) {
-    ChunkHeader = (CHUNK_HEADER *)Image;
+  Offset = 0;
+  Status = SkipImage (File, SparseHeader.FileHeaderSize - sizeof (SPARSE_HEADER));
+
+  for (Chunk = 0; (Chunk < SparseHeader.TotalChunks) && !EFI_ERROR (Status); Chunk++) {
+    Status = ReadImage (File, sizeof (CHUNK_HEADER), &ChunkHeader);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+    Status = SkipImage (File, SparseHeader.ChunkHeaderSize - sizeof (CHUNK_HEADER));
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
     DEBUG ((DEBUG_INFO,
       "Chunk #%d - Type: 0x%x Size: %d TotalSize: 0x%lx Offset 0x%lx\n",
       (Chunk + 1),
-      ChunkHeader->ChunkType,
-      ChunkHeader->ChunkSize,
-      ChunkHeader->TotalSize,
+      ChunkHeader.ChunkType,
+      ChunkHeader.ChunkSize,
+      ChunkHeader.TotalSize,
       Offset
       ));
 
-    Image += sizeof (CHUNK_HEADER);
+    if (ChunkHeader.TotalSize < SparseHeader.ChunkHeaderSize) {
+      Status = EFI_VOLUME_CORRUPTED;
+      break;
+    }
+    DataSize = ChunkHeader.TotalSize - SparseHeader.ChunkHeaderSize;
+    Left     = MultU64x32 (ChunkHeader.ChunkSize, SparseHeader.BlockSize);
 
-    switch (ChunkHeader->ChunkType) {
+    if (((ChunkHeader.ChunkType == CHUNK_TYPE_RAW) || (ChunkHeader.ChunkType == CHUNK_TYPE_FILL)) &&
+        (Offset + Left > PartitionSize)) {
+      DEBUG ((DEBUG_ERROR, "Chunk #%d is beyond the partition.\n", (Chunk + 1)));
+      Status = EFI_VOLUME_FULL;
+      break;
+    }
+
+    switch (ChunkHeader.ChunkType) {
     case CHUNK_TYPE_RAW:
-      Status = WritePartition (
-                 PartitionName,
-                 Offset,
-                 Image,
-                 ChunkHeader->ChunkSize * SparseHeader->BlockSize
-                 );
-      if (EFI_ERROR (Status)) {
-        FreePool (FillBuf);
-        return Status;
+      if (DataSize != Left) {
+        Status = EFI_VOLUME_CORRUPTED;
+        break;
       }
-      Image += (UINTN)ChunkHeader->ChunkSize * SparseHeader->BlockSize;
-      Offset += (UINTN)ChunkHeader->ChunkSize * SparseHeader->BlockSize;
-      break;
-    case CHUNK_TYPE_FILL:
-      Left = (UINTN)ChunkHeader->ChunkSize * SparseHeader->BlockSize;
-      while (Left > 0) {
-        if (Left > FILL_BUF_SIZE) {
-          Count = FILL_BUF_SIZE;
-        } else {
-          Count = Left;
-        }
-        SetMem32 (FillBuf, Count, *(UINT32 *)Image);
-        Status = WritePartition (
-                   PartitionName,
-                   Offset,
-                   FillBuf,
-                   Count
-                   );
+      while ((Left > 0) && !EFI_ERROR (Status)) {
+        Status = FileIoReadChunkEx (File, (UINTN) MIN (Left, MAX_UINTN), &Data, &Length);
         if (EFI_ERROR (Status)) {
-          FreePool (FillBuf);
-          return Status;
+          break;
+        }
+        if (Length == 0) {
+          DEBUG ((DEBUG_ERROR, "Image is truncated.\n"));
+          Status = EFI_VOLUME_CORRUPTED;
+          break;
         }
-        Offset += Count;
-        Left = Left - Count;
+        Status  = SparseWriterRaw (&Writer, Offset, Data, Length);
+        Offset += Length;
+        Left   -= Length;
+      }
+      break;
+    case CHUNK_TYPE_FILL:
+      if (DataSize < sizeof (UINT32)) {
+        Status = EFI_VOLUME_CORRUPTED;
+        break;
+      }
+      Status = ReadImage (File, sizeof (UINT32), &FillValue);
+      if (!EFI_ERROR (Status)) {
+        Status = SparseWriterFill (&Writer, Offset, Left, FillValue);
+      }
+      Offset += Left;
+      if (!EFI_ERROR (Status)) {
+        Status = SkipImage (File, DataSize - sizeof (UINT32));
       }
-      Image += sizeof (UINT32);
       break;
     case CHUNK_TYPE_DONT_CARE:
-      Offset += (UINTN)ChunkHeader->ChunkSize * SparseHeader->BlockSize;
+      Offset += Left;
+      Status  = SkipImage (File, DataSize);
+      break;
+    case CHUNK_TYPE_CRC32:
+      Status = SkipImage (File, DataSize);
       break;
     default:
-      Print (L"Unsupported Chunk Type:0x%x\n", ChunkHeader->ChunkType);
+      Print (L"Unsupported Chunk Type:0x%x\n", ChunkHeader.ChunkType);
+      Status = SkipImage (File, DataSize);
+      break;
+    }
+  }
+
+  FlushStatus = SparseWriterFlush (&Writer);
+  if (!EFI_ERROR (Status)) {
+    Status = FlushStatus;
+  }
+
+  FreePool (Writer.Buffer);
+  return Status;
+}
+
+/**
+  Flash a raw image, writing each chunk to the partition as it is read.
+
+  @param[in]  DiskIo          Disk IO protocol of the partition.
+  @param[in]  MediaId         Media ID of the partition.
+  @param[in]  PartitionSize   Bytes in the partition.
+  @param[in]  File            The image.
+
+  @retval EFI_SUCCESS         The image was flashed.
+  @retval EFI_VOLUME_FULL     The image does not fit in the partition.
+  @retval Others              The image could not be read or written.
+
+**/
+STATIC
+EFI_STATUS
+FlashRawImage (
+  IN EFI_DISK_IO_PROTOCOL   *DiskIo,
+  IN UINT32                 MediaId,
+  IN UINT64                 PartitionSize,
+  IN FILE_IO_STREAM         *File
+  )
+{
+  EFI_STATUS          Status;
+  UINT64              Offset;
+  VOID                *Data;
+  UINTN               Length;
+
+  if (FileIoGetSize (File) > PartitionSize) {
+    DEBUG ((DEBUG_ERROR, "Partition not big enough.\n"));
+    DEBUG ((DEBUG_ERROR, "Partition Size: %ld\nImage Size: %ld\n", PartitionSize, FileIoGetSize (File)));
+    return EFI_VOLUME_FULL;
+  }
+
+  //
+  // While a chunk is written, the stream reads the next one.
+  //
+  Offset = 0;
+  while (TRUE) {
+    Status = FileIoReadChunk (File, &Data, &Length);
+    if (EFI_ERROR (Status) || (Length == 0)) {
       break;
     }
+
+    Status = DiskIo->WriteDisk (DiskIo, MediaId, Offset, Length, Data);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+    Offset += Length;
   }
 
-  FreePool (FillBuf);
   return Status;
 }
 
+/**
+  Flash a raw or Android sparse image file to a partition.  The image is
+  streamed, so it does not have to fit in memory.
+
+  @param[in]  PartitionName   The partition.
+  @param[in]  FileName        The image file.
+
+  @retval EFI_SUCCESS         The image was flashed.
+  @retval Others              The partition or image could not be used.
+
+**/
 EFI_STATUS
 EFIAPI
 FlashPartition (
   IN CHAR8     *PartitionName,
-  IN UINTN     BufferSize,
-  IN VOID      *Buffer
+  IN CHAR16    *FileName
   )
 {
-  EFI_STATUS          Status;
-  SPARSE_HEADER       *SparseHeader;
+  EFI_STATUS               Status;
+  EFI_STATUS               CloseStatus;
+  EFI_BLOCK_IO_PROTOCOL    *BlockIo;
+  EFI_DISK_IO_PROTOCOL     *DiskIo;
+  FILE_IO_STREAM           *File;
+  UINT64                   PartitionSize;
+  UINT32                   Magic;
+  UINTN                    Size;
 
-  if (Buffer == NULL) {
-    return EFI_INVALID_PARAMETER;
+  Status = OpenPartition (PartitionName, &BlockIo, &DiskIo);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
+  PartitionSize = MultU64x32 (BlockIo->Media->LastBlock + 1, BlockIo->Media->BlockSize);
 
-  SparseHeader = (SPARSE_HEADER *) Buffer;
-  if (SparseHeader->Magic == SPARSE_HEADER_MAGIC) {
-    DEBUG ((DEBUG_INFO, "Sparse Magic: 0x%x\n", SparseHeader->Magic));
-    DEBUG ((DEBUG_INFO, "Major: %d, Minor: %d\n", SparseHeader->MajorVersion, SparseHeader->MinorVersion));
-    DEBUG ((DEBUG_INFO, "FileHeaderSize: %d, ChunkHeaderSize: %d\n", SparseHeader->FileHeaderSize, SparseHeader->ChunkHeaderSize));
-    DEBUG ((DEBUG_INFO, "BlockSize: %d, TotalBlocks: %d\n", SparseHeader->BlockSize, SparseHeader->TotalBlocks));
-    DEBUG ((DEBUG_INFO, "TotalChunks: %d, ImageChecksum: %d\n", SparseHeader->TotalChunks, SparseHeader->ImageChecksum));
+  Status = FileIoOpenReader (FileName, FLASH_CHUNK_SIZE, FILE_IO_DOUBLE_BUFFER, &File);
+  if (EFI_ERROR (Status)) {
+    Print (L"Open file failed: %r\n", Status);
+    return Status;
+  }
 
-    if (SparseHeader->MajorVersion != 1) {
-      DEBUG ((DEBUG_ERROR, "Sparse image version %d.%d not supported.\n", SparseHeader->MajorVersion, SparseHeader->MinorVersion));
-      return EFI_INVALID_PARAMETER;
+  Magic = 0;
+  Size  = sizeof (Magic);
+  Status = FileIoPeek (File, &Size, &Magic);
+  if (!EFI_ERROR (Status)) {
+    if ((Size == sizeof (Magic)) && (Magic == SPARSE_HEADER_MAGIC)) {
+      Status = FlashSparseImage (DiskIo, BlockIo->Media->MediaId, PartitionSize, File);
+    } else {
+      Status = FlashRawImage (DiskIo, BlockIo->Media->MediaId, PartitionSize, File);
     }
-    Status = FlashSparseImage (PartitionName, SparseHeader);
-  } else {
-    Status = WritePartition (
-               PartitionName,
-               0,
-               Buffer,
-               BufferSize
-               );
   }
 
+  CloseStatus = FileIoClose (File);
+  if (!EFI_ERROR (Status)) {
+    Status = CloseStatus;
+  }
+
+  BlockIo->FlushBlocks (BlockIo);
+
   return Status;
 }
 
@@ -1155,7 +1445,7 @@ SaveGptTable (
     return Status;
   }
 
-  Status = SaveFileToDisk (L"PrimarySave.bin", BufferSize, Buffer);
+  Status = FileIoWriteFile (L"PrimarySave.bin", BufferSize, Buffer);
   if (EFI_ERROR (Status)) {
     if (Buffer != NULL) {
       FreePool (Buffer);
@@ -1195,7 +1485,7 @@ SaveGptTable (
     return Status;
   }
 
-  Status = SaveFileToDisk (L"SecondarySave.bin", BufferSize, Buffer);
+  Status = FileIoWriteFile (L"SecondarySave.bin", BufferSize, Buffer);
   if (EFI_ERROR (Status)) {
     if (Buffer != NULL) {
       FreePool (Buffer);
@@ -1223,48 +1513,17 @@ SaveDiskData (
   IN UINTN                  BufferSize
   )
 {
-  EFI_STATUS          Status;
-  VOID                *Buffer;
-
   if (PartData == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
-  Buffer = AllocateZeroPool (BufferSize);
-  if (Buffer == NULL) {
-    return EFI_OUT_OF_RESOURCES;
-  }
-
-  Status = PartData->DiskIo->ReadDisk (
-             PartData->DiskIo,
-             PartData->BlockIo->Media->MediaId,
-             Offset,
-             BufferSize,
-             Buffer
-             );
-  if (EFI_ERROR (Status)) {
-    if (Buffer != NULL) {
-      FreePool (Buffer);
-      Buffer = NULL;
-    }
-    return Status;
-  }
-
-  Status = SaveFileToDisk (FileName, BufferSize, Buffer);
-  if (EFI_ERROR (Status)) {
-    if (Buffer != NULL) {
-      FreePool (Buffer);
-      Buffer = NULL;
-    }
-    return Status;
-  }
-
-  if (Buffer != NULL) {
-    FreePool (Buffer);
-    Buffer = NULL;
-  }
-
-  return Status;
+  return SaveDiskRangeToFile (
+           PartData->DiskIo,
+           PartData->BlockIo->Media->MediaId,
+           Offset,
+           BufferSize,
+           FileName
+           );
 }
 
 EFI_STATUS
@@ -1277,44 +1536,59 @@ WriteDataToDisk (
   )
 {
   EFI_STATUS             Status;
-  VOID                   *Buffer;
-  UINTN                  BufferSize;
-  UINTN                  TempSize;
-
-  TempSize = Size;
+  EFI_STATUS             CloseStatus;
+  FILE_IO_STREAM         *File;
+  VOID                   *Chunk;
+  UINTN                  ChunkSize;
+  UINT64                 Remaining;
 
-  Status = ReadFileFromDisk (FileName, &BufferSize, &Buffer);
+  Status = FileIoOpenReader (FileName, 0, FILE_IO_DOUBLE_BUFFER, &File);
   if (EFI_ERROR (Status)) {
+    Print (L"Open file failed: %r\n", Status);
     return Status;
   }
 
-  if (Size == 0) {
-    TempSize = BufferSize;
+  //
+  // Write Size bytes of the file, or all of it when Size is 0.
+  //
+  Remaining = FileIoGetSize (File);
+  if ((Size != 0) && (Size < Remaining)) {
+    Remaining = Size;
   }
 
-  Status = PartData->DiskIo->WriteDisk (
-             PartData->DiskIo,
-             PartData->BlockIo->Media->MediaId,
-             Offset,
-             TempSize,
-             Buffer
-             );
-  if (EFI_ERROR (Status)) {
-    if (Buffer != NULL) {
-      FreePool (Buffer);
-      Buffer = NULL;
+  while (Remaining > 0) {
+    Status = FileIoReadChunk (File, &Chunk, &ChunkSize);
+    if (EFI_ERROR (Status) || (ChunkSize == 0)) {
+      break;
     }
-    return Status;
-  }
 
-  PartData->BlockIo->FlushBlocks (PartData->BlockIo);
+    if (ChunkSize > Remaining) {
+      ChunkSize = (UINTN) Remaining;
+    }
 
-  if (Buffer != NULL) {
-    FreePool (Buffer);
-    Buffer = NULL;
+    Status = PartData->DiskIo->WriteDisk (
+               PartData->DiskIo,
+               PartData->BlockIo->Media->MediaId,
+               Offset,
+               ChunkSize,
+               Chunk
+               );
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    Offset    += ChunkSize;
+    Remaining -= ChunkSize;
   }
 
-  return EFI_SUCCESS;
+  CloseStatus = FileIoClose (File);
+  if (!EFI_ERROR (Status)) {
+    Status = CloseStatus;
+  }
+
+  PartData->BlockIo->FlushBlocks (PartData->BlockIo);
+
+  return Status;
 }
 
 EFI_STATUS
@@ -1367,7 +1641,7 @@ DumpDiskData (
     Print (L"Offset %016lx Size %08x bytes\n", Offset, BufferSize);
   }
 
-  DumpHex (2, 0, BufferSize, Buffer);
+  HexDump (2, 0, BufferSize, Buffer);
 
   return EFI_SUCCESS;
 }
@@ -1556,24 +1830,13 @@ ShellAppMain (
     if ((!StrCmp (Argv[1], L"flash")) || (!StrCmp (Argv[1], L"FLASH"))) {
       UnicodeStrToAsciiStrS (Argv[2], PartitionName, ARRAY_SIZE (PartitionName));
 
-      Status = ReadFileFromDisk (Argv[3], &BufferSize, &Buffer);
-      if (EFI_ERROR (Status)) {
-        Print (L"Read flash file failed. %r\n", Status);
-        return Status;
-      }
-
-      Status = FlashPartition (PartitionName, BufferSize, Buffer);
+      Status = FlashPartition (PartitionName, Argv[3]);
       if (EFI_ERROR (Status)) {
         Print (L"Flash partition %a failed: %r\n", PartitionName, Status);
       } else {
         Print (L"Flash partition %a Passed: %r\n", PartitionName, Status);
       }
 
-      if (Buffer != NULL) {
-        FreePool (Buffer);
-        Buffer = NULL;
-      }
-
       if (mPartData != NULL) {
         FreePool (mPartData);
         mPartData = NULL;
@@ -1603,7 +1866,7 @@ ShellAppMain (
         return Status;
       }
 
-      DumpHex (2, 0, BufferSize, Buffer);
+      HexDump (2, 0, BufferSize, Buffer);
 
       if (Buffer != NULL) {
         FreePool (Buffer);
@@ -26,6 +26,8 @@
 #include <Library/BaseMemoryLib.h>
 #include <Library/DevicePathLib.h>
 #include <Library/PrintLib.h>
+#include <Library/FileIoLib.h>
+#include <Library/HexDumpLib.h>
 #include <Protocol/BlockIo.h>
 #include <Protocol/DiskIo.h>
 
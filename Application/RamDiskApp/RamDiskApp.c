@@ -14,17 +14,16 @@
 #include "RamDiskApp.h"
 
 /**
-  This function reads a binary from disk.
+  This function reads a binary from disk into reserved memory for a RAM disk,
+  a chunk at a time.
 
   @param[in]  FileName          Pointer to file name
   @param[out] BufferSize        Return the number of bytes read.
   @param[out] Buffer            The buffer to put read data into.
 
   @retval EFI_SUCCESS           Data was read.
-  @retval EFI_NO_MEDIA          The device has no media.
-  @retval EFI_DEVICE_ERROR      The device reported an error.
-  @retval EFI_VOLUME_CORRUPTED  The file system structures are corrupted.
-  @retval EFI_BUFFER_TO_SMALL   Buffer is too small. ReadSize contains required size.
+  @retval EFI_OUT_OF_RESOURCES  No enough buffer to allocate.
+  @retval Others                The file could not be read.
 
 **/
 EFI_STATUS
@@ -36,25 +35,23 @@ ReadFileFromDisk (
   )
 {
   EFI_STATUS           Status;
-  SHELL_FILE_HANDLE    FileHandle;
-  UINTN                FileSize;
+  FILE_IO_STREAM       *Stream;
+  UINT64               FileSize;
+  UINTN                ReadSize;
   VOID                 *FileBuffer;
 
   FileBuffer = NULL;
 
-  Status = ShellOpenFileByName (FileName, &FileHandle, EFI_FILE_MODE_READ, 0);
+  Status = FileIoOpenReader (FileName, 0, FILE_IO_DOUBLE_BUFFER, &Stream);
   if (EFI_ERROR (Status)) {
     Print (L"Open file failed: %r\n", Status);
     return Status;
   }
 
-  Status = ShellGetFileSize (FileHandle, &FileSize);
-  if (EFI_ERROR (Status)) {
-    Print (L"Failed to read file size, Status: %r\n", Status);
-    if (FileHandle != NULL) {
-      ShellCloseFile (&FileHandle);
-    }
-    return Status;
+  FileSize = FileIoGetSize (Stream);
+  if (FileSize > MAX_UINTN) {
+    FileIoClose (Stream);
+    return EFI_OUT_OF_RESOURCES;
   }
 
   Status = gBS->AllocatePool (
@@ -64,27 +61,20 @@ ReadFileFromDisk (
                   );
   if ((FileBuffer == NULL) || EFI_ERROR(Status)) {
     Print (L"Allocate resouce failed\n");
-    if (FileHandle != NULL) {
-      ShellCloseFile (&FileHandle);
-    }
+    FileIoClose (Stream);
     return EFI_OUT_OF_RESOURCES;
   }
 
-  Status = ShellReadFile (FileHandle, &FileSize, FileBuffer);
+  ReadSize = (UINTN) FileSize;
+  Status = FileIoRead (Stream, &ReadSize, FileBuffer);
+  FileIoClose (Stream);
   if (EFI_ERROR (Status)) {
     Print (L"Failed to read file, Status: %r\n", Status);
-    if (FileHandle != NULL) {
-      ShellCloseFile (&FileHandle);
-    }
-    if (FileBuffer != NULL) {
-      FreePool (FileBuffer);
-    }
+    FreePool (FileBuffer);
     return Status;
   }
 
-  ShellCloseFile (&FileHandle);
-
-  *BufferSize = FileSize;
+  *BufferSize = ReadSize;
   *Buffer     = FileBuffer;
 
   return EFI_SUCCESS;
@@ -25,6 +25,7 @@
 #include <Library/BaseMemoryLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/DevicePathLib.h>
+#include <Library/FileIoLib.h>
 #include <Protocol/RamDisk.h>
 
 #endif
@@ -25,6 +25,7 @@
 #include <Library/ShellLib.h>
 #include <Library/TimerLib.h>
 #include <Library/NetLib.h>
+#include <Library/FileIoLib.h>
 #include <Protocol/SimpleTextOut.h>
 #include <Protocol/SimpleTextIn.h>
 #include <Protocol/Dhcp4.h>
@@ -49,7 +50,6 @@ EFI_HANDLE                       mTcpHandle = NULL;
 
 EFI_EVENT                        mFinishedEvent;
 
-#define RX_FRAGMENT_SIZE         2048
 #define TCP_STATION_PORT         5554
 
 BOOLEAN IsRxDone = FALSE;
@@ -80,40 +80,26 @@ CommonNotify (
 
 EFI_STATUS
 TcpDataReceive (
-  IN  OUT UINTN               *BufferSize,
-  IN  OUT VOID                **Buffer
+  IN  FILE_IO_STREAM          *File
   )
 {
   EFI_STATUS             Status;
-  VOID                   *FragmentBuffer;
-  UINT8                  *DataBuffer;
-  UINT8                  *BufferTemp;
-  NET_FRAGMENT           Fragment;
-  UINTN                  TotalDataNumber;
-  UINTN                  AllocateLength;
-
-  DataBuffer      = NULL;
-  Fragment.Len    = 0;
-  Fragment.Bulk   = NULL;
-  TotalDataNumber = 0;
-  AllocateLength  = 0;
-  *BufferSize     = 0;
-  *Buffer         = NULL;
-
-  Status = EFI_SUCCESS;
-
-  FragmentBuffer = AllocateZeroPool (RX_FRAGMENT_SIZE);
-  ASSERT (FragmentBuffer != NULL);
-  if (FragmentBuffer == NULL) {
-    DEBUG ((DEBUG_ERROR, "TCP out of resources"));
-    return EFI_OUT_OF_RESOURCES;
-  }
+  VOID                   *Buffer;
+  UINTN                  BufferSize;
 
+  //
+  // Receive straight into the file's chunks until the connection closes
+  //
   while (TRUE) {
+    Status = FileIoGetWriteBuffer (File, &Buffer, &BufferSize);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
     IsRxDone = FALSE;
-    mRxData.DataLength = RX_FRAGMENT_SIZE;
-    mRxData.FragmentTable[0].FragmentLength = RX_FRAGMENT_SIZE;
-    mRxData.FragmentTable[0].FragmentBuffer = FragmentBuffer;
+    mRxData.DataLength = (UINT32) BufferSize;
+    mRxData.FragmentTable[0].FragmentLength = (UINT32) BufferSize;
+    mRxData.FragmentTable[0].FragmentBuffer = Buffer;
 
     Status = mTcpConnection->Receive (mTcpConnection, &mReceiveToken);
     if (EFI_ERROR (Status)) {
@@ -131,75 +117,14 @@ TcpDataReceive (
       return Status;
     }
 
-    Fragment.Len  = mReceiveToken.Packet.RxData->FragmentTable[0].FragmentLength;
-    Fragment.Bulk = (UINT8 *) mReceiveToken.Packet.RxData->FragmentTable[0].FragmentBuffer;
-
     //
-    // Append the received data
+    // Keep the received data
     //
-    if (AllocateLength < TotalDataNumber + Fragment.Len) {
-      AllocateLength += SIZE_8MB;
-      BufferTemp = AllocateZeroPool (AllocateLength);
-      if (BufferTemp == NULL) {
-        if (DataBuffer != NULL) {
-          FreePool (DataBuffer);
-        }
-        return EFI_OUT_OF_RESOURCES;
-      }
-
-      if (DataBuffer != NULL) {
-        CopyMem (BufferTemp, DataBuffer, TotalDataNumber);
-        FreePool (DataBuffer);
-      }
-    }
-
-    if (Fragment.Bulk != NULL) {
-      CopyMem (BufferTemp + TotalDataNumber, Fragment.Bulk, Fragment.Len);
+    Status = FileIoCommitWrite (File, mReceiveToken.Packet.RxData->FragmentTable[0].FragmentLength);
+    if (EFI_ERROR (Status)) {
+      return Status;
     }
-
-    TotalDataNumber += Fragment.Len;
-    DataBuffer      = BufferTemp;
-
-    *Buffer     = BufferTemp;
-    *BufferSize = TotalDataNumber;
-  }
-
-  return Status;
-}
-
-VOID
-EFIAPI
-SaveFileToDisk (
-  IN  UINTN               BufferSize,
-  IN  VOID                *Buffer
-  )
-{
-  EFI_STATUS           Status;
-  SHELL_FILE_HANDLE    FileHandle;
-
-  mTextOut->OutputString (mTextOut, L"Save file...\r\n");
-
-  if (!EFI_ERROR (ShellFileExists (L"Download.bin"))) {
-    ShellDeleteFileByName (L"Download.bin");
   }
-
-  Status = ShellOpenFileByName (L"Download.bin", &FileHandle, EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE, 0);
-  if (EFI_ERROR (Status)) {
-    mTextOut->OutputString (mTextOut, L"ERROR: Open file\n");
-    FreePool (Buffer);
-    return;
-  }
-
-  Status = ShellWriteFile (FileHandle, &BufferSize, Buffer);
-  if (EFI_ERROR (Status)) {
-    mTextOut->OutputString (mTextOut, L"ERROR: Write file\n");
-    FreePool (Buffer);
-    ShellCloseFile (&FileHandle);
-    return;
-  }
-
-  ShellCloseFile (&FileHandle);
-  mTextOut->OutputString (mTextOut, L"Save file completed.\r\n");
 }
 
 VOID
@@ -211,8 +136,7 @@ ConnectionAccepted (
 {
   EFI_STATUS             Status;
   EFI_TCP4_LISTEN_TOKEN  *AcceptToken;
-  UINTN                  DataSize;
-  VOID                   *Data;
+  FILE_IO_STREAM         *File;
 
   AcceptToken = (EFI_TCP4_LISTEN_TOKEN *) Context;
   Status = AcceptToken->CompletionToken.Status;
@@ -249,9 +173,23 @@ ConnectionAccepted (
                   );
   ASSERT_EFI_ERROR (Status);
 
-  TcpDataReceive (&DataSize, &Data);
+  mTextOut->OutputString (mTextOut, L"Save file...\r\n");
 
-  SaveFileToDisk (DataSize, Data);
+  Status = FileIoOpenWriter (L"Download.bin", 0, 0, 0, &File);
+  if (EFI_ERROR (Status)) {
+    mTextOut->OutputString (mTextOut, L"ERROR: Open file\n");
+    return;
+  }
+
+  TcpDataReceive (File);
+
+  Status = FileIoClose (File);
+  if (EFI_ERROR (Status)) {
+    mTextOut->OutputString (mTextOut, L"ERROR: Write file\n");
+    return;
+  }
+
+  mTextOut->OutputString (mTextOut, L"Save file completed.\r\n");
 }
 
 /**
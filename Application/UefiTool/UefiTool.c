@@ -196,44 +196,6 @@ ApUtReadCpuId (
   AsmCpuidEx (gUtContext.CpuIdIndex, gUtContext.CpuIdSubIndex, &CpuidRegister->Eax, &CpuidRegister->Ebx, &CpuidRegister->Ecx, &CpuidRegister->Edx);
 }
 
-EFI_STATUS
-EFIAPI
-SaveFileToDisk (
-  IN  CHAR16              *FileName,
-  IN  UINTN               BufferSize,
-  IN  VOID                *Buffer
-  )
-{
-  EFI_STATUS           Status;
-  SHELL_FILE_HANDLE    FileHandle;
-
-  if (!EFI_ERROR (ShellFileExists (FileName))) {
-    ShellDeleteFileByName (FileName);
-  }
-
-  Status = ShellOpenFileByName (
-             FileName,
-             &FileHandle,
-             EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE,
-             0
-             );
-  if (EFI_ERROR (Status)) {
-    Print (L"Open file failed: %r\n", Status);
-    return Status;
-  }
-
-  Status = ShellWriteFile (FileHandle, &BufferSize, Buffer);
-  if (EFI_ERROR (Status)) {
-    Print (L"Write file failed: %r\n", Status);
-    ShellCloseFile (&FileHandle);
-    return Status;
-  }
-
-  ShellCloseFile (&FileHandle);
-
-  return EFI_SUCCESS;
-}
-
 /**
   Get microcode update signature of currently loaded microcode update.
 
@@ -523,7 +485,7 @@ UefiToolRoutine (
   // Dump memory to file
   //
   if (Opcode == OPCODE_DUMPMEM_BIT) {
-    Status = SaveFileToDisk (gUtContext.DumpMemFile, gUtContext.DumpMemSize, (UINT8 *) gUtContext.DumpMemAddress);
+    Status = FileIoWriteFile (gUtContext.DumpMemFile, gUtContext.DumpMemSize, (VOID *) gUtContext.DumpMemAddress);
     if (EFI_ERROR (Status)) {
       Print (L"Save memory to file failed.\n");
       return Status;
@@ -0,0 +1,343 @@
+/** @file
+  PixelConvert.c
+
+  Row converters from Blt pixels to packed 24bpp pixels for the print screen
+  logger.  The converter is chosen once per capture, so the per pixel loops
+  carry no format tests.  Four pixels are converted at a time with 32 bit
+  loads and stores, or with one SSSE3 byte shuffle on X64 processors that
+  support it.
+
+  PixelBitMask modes are read into Blt pixels first, extracting each channel
+  with a shift, mask and scale worked out once per mode.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include "PrintScreenLogger.h"
+
+/**
+  Pack four pixels, each in the low three bytes of a UINT32, into 12 bytes.
+
+  @param  Dest      The 12 byte destination.
+  @param  P0        The first pixel.
+  @param  P1        The second pixel.
+  @param  P2        The third pixel.
+  @param  P3        The fourth pixel.
+
+**/
+STATIC
+VOID
+PackFourPixels (
+  OUT UINT8   *Dest,
+  IN  UINT32  P0,
+  IN  UINT32  P1,
+  IN  UINT32  P2,
+  IN  UINT32  P3
+  )
+{
+    WriteUnaligned32 ((UINT32 *)Dest,       (P0 & 0x00FFFFFF) | (P1 << 24));
+    WriteUnaligned32 ((UINT32 *)(Dest + 4), ((P1 >> 8) & 0x0000FFFF) | (P2 << 16));
+    WriteUnaligned32 ((UINT32 *)(Dest + 8), ((P2 >> 16) & 0x000000FF) | (P3 << 8));
+}
+
+/**
+  Swap the red and blue bytes of a Blt pixel held in a UINT32.
+
+  @param  Pixel     The pixel.
+
+  @return The pixel with red in the low byte.
+
+**/
+STATIC
+UINT32
+SwapRedBlue (
+  IN UINT32  Pixel
+  )
+{
+    return ((Pixel & 0xFF) << 16) | (Pixel & 0xFF00) | ((Pixel >> 16) & 0xFF);
+}
+
+/**
+  Convert Blt pixels to 24bpp pixels, blue first, as in a BMP.
+
+  @param  Dest      Count * 3 bytes.
+  @param  Src       The Blt pixels.
+  @param  Count     Number of pixels.
+
+**/
+VOID
+ConvertRowToBgr (
+  OUT UINT8                                *Dest,
+  IN  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Src,
+  IN  UINTN                                Count
+  )
+{
+    CONST UINT32  *Pixel;
+
+    Pixel = (CONST UINT32 *)Src;
+    for (; Count >= 4; Count -= 4, Pixel += 4, Dest += 12) {
+        PackFourPixels (Dest, Pixel[0], Pixel[1], Pixel[2], Pixel[3]);
+    }
+    for (; Count != 0; Count--, Pixel++) {
+        *Dest++ = (UINT8)*Pixel;
+        *Dest++ = (UINT8)(*Pixel >> 8);
+        *Dest++ = (UINT8)(*Pixel >> 16);
+    }
+}
+
+/**
+  Convert Blt pixels to 24bpp pixels, red first, as in a PNG.
+
+  @param  Dest      Count * 3 bytes.
+  @param  Src       The Blt pixels.
+  @param  Count     Number of pixels.
+
+**/
+VOID
+ConvertRowToRgb (
+  OUT UINT8                                *Dest,
+  IN  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Src,
+  IN  UINTN                                Count
+  )
+{
+    CONST UINT32  *Pixel;
+
+    Pixel = (CONST UINT32 *)Src;
+    for (; Count >= 4; Count -= 4, Pixel += 4, Dest += 12) {
+        PackFourPixels (Dest,
+                        SwapRedBlue (Pixel[0]),
+                        SwapRedBlue (Pixel[1]),
+                        SwapRedBlue (Pixel[2]),
+                        SwapRedBlue (Pixel[3]));
+    }
+    for (; Count != 0; Count--, Pixel++) {
+        *Dest++ = (UINT8)(*Pixel >> 16);
+        *Dest++ = (UINT8)(*Pixel >> 8);
+        *Dest++ = (UINT8)*Pixel;
+    }
+}
+
+#if defined (MDE_CPU_X64)
+
+/**
+  Convert Blt pixels to 24bpp pixels with SSSE3, blue first.
+
+  @param  Dest      Count * 3 bytes.
+  @param  Src       The Blt pixels.
+  @param  Count     Number of pixels.
+
+**/
+STATIC
+VOID
+ConvertRowToBgrSsse3 (
+  OUT UINT8                                *Dest,
+  IN  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Src,
+  IN  UINTN                                Count
+  )
+{
+    AsmConvertRowSsse3 (Dest, Src, Count & ~(UINTN)3, FALSE);
+    ConvertRowToBgr (Dest + (Count & ~(UINTN)3) * 3, Src + (Count & ~(UINTN)3), Count & 3);
+}
+
+/**
+  Convert Blt pixels to 24bpp pixels with SSSE3, red first.
+
+  @param  Dest      Count * 3 bytes.
+  @param  Src       The Blt pixels.
+  @param  Count     Number of pixels.
+
+**/
+STATIC
+VOID
+ConvertRowToRgbSsse3 (
+  OUT UINT8                                *Dest,
+  IN  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Src,
+  IN  UINTN                                Count
+  )
+{
+    AsmConvertRowSsse3 (Dest, Src, Count & ~(UINTN)3, TRUE);
+    ConvertRowToRgb (Dest + (Count & ~(UINTN)3) * 3, Src + (Count & ~(UINTN)3), Count & 3);
+}
+
+#endif
+
+/**
+  Work out how to extract a channel of a PixelBitMask pixel as 8 bits.
+
+  @param  Channel   Receives the shift, mask and scale.
+  @param  Mask      The channel's bit mask.
+
+**/
+STATIC
+VOID
+InitPixelChannel (
+  OUT PIXEL_CHANNEL  *Channel,
+  IN  UINT32         Mask
+  )
+{
+    UINTN  Width;
+
+    if (Mask == 0) {
+        ZeroMem (Channel, sizeof (*Channel));
+        return;
+    }
+
+    Channel->Shift = (UINT32)LowBitSet32 (Mask);
+    Width = HighBitSet32 (Mask) - Channel->Shift + 1;
+
+    //
+    // Keep the top 8 bits of wider channels, and scale narrower ones so
+    // their largest value becomes 255.
+    //
+    if (Width > 8) {
+        Channel->Shift += (UINT32)(Width - 8);
+        Width = 8;
+    }
+    Channel->Mask = (1 << Width) - 1;
+    Channel->Scale = ((255 << 16) + Channel->Mask - 1) / Channel->Mask;
+}
+
+/**
+  Work out how to convert the pixels of a PixelBitMask mode to Blt pixels.
+
+  @param  Converter     Receives the channel extraction of the mode.
+  @param  PixelMask     The mode's pixel bit masks.
+
+  @retval EFI_SUCCESS       Converter is ready.
+  @retval EFI_UNSUPPORTED   The pixels are wider than 32 bits or have no bits.
+
+**/
+EFI_STATUS
+InitPixelMaskConverter (
+  OUT PIXEL_MASK_CONVERTER     *Converter,
+  IN  CONST EFI_PIXEL_BITMASK  *PixelMask
+  )
+{
+    UINT32  AllBits;
+
+    AllBits = PixelMask->RedMask | PixelMask->GreenMask | PixelMask->BlueMask | PixelMask->ReservedMask;
+    if (AllBits == 0) {
+        return EFI_UNSUPPORTED;
+    }
+
+    InitPixelChannel (&Converter->Red, PixelMask->RedMask);
+    InitPixelChannel (&Converter->Green, PixelMask->GreenMask);
+    InitPixelChannel (&Converter->Blue, PixelMask->BlueMask);
+    Converter->BytesPerPixel = (HighBitSet32 (AllBits) + 8) / 8;
+
+    return EFI_SUCCESS;
+}
+
+/**
+  Extract a channel of a PixelBitMask pixel as 8 bits.
+
+  @param  Channel   The channel's shift, mask and scale.
+  @param  Pixel     The pixel.
+
+  @return The channel value, 0 to 255.
+
+**/
+#define EXTRACT_CHANNEL(Channel, Pixel) \
+    (((((Pixel) >> (Channel).Shift) & (Channel).Mask) * (Channel).Scale) >> 16)
+
+/**
+  Convert a PixelBitMask pixel to a Blt pixel held in a UINT32.
+
+  @param  Converter     The channel extraction of the mode.
+  @param  Pixel         The pixel.
+
+  @return The Blt pixel.
+
+**/
+STATIC
+UINT32
+MaskedPixelToBlt (
+  IN CONST PIXEL_MASK_CONVERTER  *Converter,
+  IN UINT32                      Pixel
+  )
+{
+    return EXTRACT_CHANNEL (Converter->Blue, Pixel) |
+           (EXTRACT_CHANNEL (Converter->Green, Pixel) << 8) |
+           (EXTRACT_CHANNEL (Converter->Red, Pixel) << 16);
+}
+
+/**
+  Convert a row of PixelBitMask pixels to Blt pixels in place.  The packed
+  frame buffer pixels are at the end of the row, in its last
+  Count * BytesPerPixel bytes, so each Blt pixel is written over pixels that
+  have already been read.
+
+  @param  Converter     The channel extraction of the mode.
+  @param  Row           Count Blt pixels.
+  @param  Count         Number of pixels.
+
+**/
+VOID
+ConvertMaskedRow (
+  IN     CONST PIXEL_MASK_CONVERTER     *Converter,
+  IN OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Row,
+  IN     UINTN                          Count
+  )
+{
+    UINT32        *Dest;
+    CONST UINT8   *Src;
+    UINTN         Index;
+
+    Dest = (UINT32 *)Row;
+    Src = (CONST UINT8 *)(Row + Count) - Count * Converter->BytesPerPixel;
+
+    switch (Converter->BytesPerPixel) {
+    case 1:
+        for (Index = 0; Index < Count; Index++) {
+            Dest[Index] = MaskedPixelToBlt (Converter, Src[Index]);
+        }
+        break;
+    case 2:
+        for (Index = 0; Index < Count; Index++, Src += 2) {
+            Dest[Index] = MaskedPixelToBlt (Converter, ReadUnaligned16 ((CONST UINT16 *)Src));
+        }
+        break;
+    case 3:
+        for (Index = 0; Index < Count; Index++, Src += 3) {
+            Dest[Index] = MaskedPixelToBlt (Converter, Src[0] | (Src[1] << 8) | (Src[2] << 16));
+        }
+        break;
+    default:
+        for (Index = 0; Index < Count; Index++) {
+            Dest[Index] = MaskedPixelToBlt (Converter, Dest[Index]);
+        }
+        break;
+    }
+}
+
+/**
+  Choose the fastest row converter for a byte order.
+
+  @param  RedFirst  TRUE for red first pixels, FALSE for blue first.
+
+  @return The row converter.
+
+**/
+PRINT_SCREEN_ROW_CONVERTER
+GetRowConverter (
+  IN BOOLEAN  RedFirst
+  )
+{
+#if defined (MDE_CPU_X64)
+    UINT32  RegEcx;
+
+    AsmCpuid (1, NULL, NULL, &RegEcx, NULL);
+    if ((RegEcx & BIT9) != 0) {
+        return RedFirst ? ConvertRowToRgbSsse3 : ConvertRowToBgrSsse3;
+    }
+#endif
+
+    return RedFirst ? ConvertRowToRgb : ConvertRowToBgr;
+}
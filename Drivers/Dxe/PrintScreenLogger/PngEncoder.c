@@ -0,0 +1,587 @@
+/** @file
+  PngEncoder.c
+
+  A small streaming PNG encoder for the print screen logger.  Rows of 24bpp RGB
+  pixels are filtered with the Up filter and compressed with a single fixed
+  Huffman deflate stream, using a one probe hash to find matches.  Screens are
+  mostly flat color and repeated rows, which this compresses well at little
+  cost.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include "PrintScreenLogger.h"
+
+#define PNG_WINDOW_SIZE      32768
+#define PNG_HASH_BITS        15
+#define PNG_HASH_SIZE        (1 << PNG_HASH_BITS)
+#define PNG_MIN_MATCH        3
+#define PNG_MAX_MATCH        258
+#define PNG_MIN_LOOKAHEAD    (PNG_MAX_MATCH + PNG_MIN_MATCH + 1)
+#define PNG_END_OF_BLOCK     256
+#define PNG_FILTER_UP        2
+#define PNG_ADLER_BASE       65521
+#define PNG_ADLER_NMAX       5552
+
+STATIC CONST UINT8 mPngSignature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+STATIC CONST UINT16 mLengthBase[] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+STATIC CONST UINT8 mLengthExtra[] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+STATIC CONST UINT16 mDistanceBase[] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+STATIC CONST UINT8 mDistanceExtra[] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+//
+// Fixed Huffman codes, bit reversed for LSB first output, and the length and
+// distance code of each value.  Built once by PngInitTables().
+//
+STATIC BOOLEAN mPngTablesReady = FALSE;
+STATIC UINT16  mLiteralCode[288];
+STATIC UINT8   mLiteralBits[288];
+STATIC UINT8   mDistanceCode5[30];
+STATIC UINT8   mLengthCode[PNG_MAX_MATCH - PNG_MIN_MATCH + 1];
+STATIC UINT8   mDistanceCode[512];
+
+/**
+  Reverse the low bits of a Huffman code.
+
+  @param  Code      The code.
+  @param  Bits      Number of bits in the code.
+
+  @return The reversed code.
+
+**/
+STATIC
+UINT16
+PngReverseBits (
+  IN UINTN  Code,
+  IN UINTN  Bits
+  )
+{
+    UINTN  Reversed;
+
+    for (Reversed = 0; Bits != 0; Bits--, Code >>= 1) {
+        Reversed = (Reversed << 1) | (Code & 1);
+    }
+    return (UINT16)Reversed;
+}
+
+/**
+  Build the fixed Huffman code and the length and distance code tables.
+
+**/
+STATIC
+VOID
+PngInitTables (
+    VOID
+    )
+{
+    UINTN  Value;
+    UINTN  Code;
+    UINTN  Distance;
+
+    if (mPngTablesReady) {
+        return;
+    }
+
+    for (Value = 0; Value < 288; Value++) {
+        if (Value < 144) {
+            mLiteralCode[Value] = PngReverseBits (0x30 + Value, 8);
+            mLiteralBits[Value] = 8;
+        } else if (Value < 256) {
+            mLiteralCode[Value] = PngReverseBits (0x190 + Value - 144, 9);
+            mLiteralBits[Value] = 9;
+        } else if (Value < 280) {
+            mLiteralCode[Value] = PngReverseBits (Value - 256, 7);
+            mLiteralBits[Value] = 7;
+        } else {
+            mLiteralCode[Value] = PngReverseBits (0xC0 + Value - 280, 8);
+            mLiteralBits[Value] = 8;
+        }
+    }
+
+    for (Code = 0; Code < ARRAY_SIZE (mDistanceBase); Code++) {
+        mDistanceCode5[Code] = (UINT8)PngReverseBits (Code, 5);
+        for (Distance = mDistanceBase[Code]; Distance < mDistanceBase[Code] + (1U << mDistanceExtra[Code]); Distance++) {
+            if (Distance <= 256) {
+                mDistanceCode[Distance - 1] = (UINT8)Code;
+            } else {
+                mDistanceCode[256 + ((Distance - 1) >> 7)] = (UINT8)Code;
+            }
+        }
+    }
+
+    //
+    // Length 258 has its own code rather than the last of code 284's range.
+    //
+    for (Code = 0; Code < ARRAY_SIZE (mLengthBase) - 1; Code++) {
+        for (Value = mLengthBase[Code]; Value < mLengthBase[Code] + (1U << mLengthExtra[Code]); Value++) {
+            mLengthCode[Value - PNG_MIN_MATCH] = (UINT8)Code;
+        }
+    }
+    mLengthCode[PNG_MAX_MATCH - PNG_MIN_MATCH] = (UINT8)(ARRAY_SIZE (mLengthBase) - 1);
+
+    mPngTablesReady = TRUE;
+}
+
+/**
+  Store a 32 bit value in big endian byte order.
+
+  @param  Buffer    Where to store the value.
+  @param  Value     The value.
+
+**/
+STATIC
+VOID
+PngPutUint32 (
+  OUT UINT8   *Buffer,
+  IN  UINT32  Value
+  )
+{
+    Buffer[0] = (UINT8)(Value >> 24);
+    Buffer[1] = (UINT8)(Value >> 16);
+    Buffer[2] = (UINT8)(Value >> 8);
+    Buffer[3] = (UINT8)Value;
+}
+
+/**
+  Write a buffer to the PNG file.  Once a write fails the encoder keeps the
+  error and writes nothing more.
+
+  @param  Encoder   The encoder.
+  @param  Buffer    The data.
+  @param  Size      Number of bytes.
+
+**/
+STATIC
+VOID
+PngWrite (
+  IN OUT PNG_ENCODER  *Encoder,
+  IN     CONST VOID   *Buffer,
+  IN     UINTN        Size
+  )
+{
+    UINTN  WriteSize;
+
+    if (EFI_ERROR(Encoder->Status)) {
+        return;
+    }
+
+    WriteSize = Size;
+    Encoder->Status = Encoder->File->Write (Encoder->File, &WriteSize, (VOID *)Buffer);
+    if (!EFI_ERROR(Encoder->Status) && (WriteSize != Size)) {
+        DEBUG((DEBUG_ERROR, "Wrong number of bytes written.  S/B=%ld, Actual=%ld\n", Size, WriteSize));
+        Encoder->Status = EFI_BAD_BUFFER_SIZE;
+    }
+}
+
+/**
+  Finish and write a chunk.  Chunk points to room for the length and type,
+  followed by Length bytes of data and room for the CRC.
+
+  @param  Encoder   The encoder.
+  @param  Chunk     The chunk buffer.
+  @param  Type      The four character chunk type.
+  @param  Length    Number of data bytes.
+
+**/
+STATIC
+VOID
+PngWriteChunk (
+  IN OUT PNG_ENCODER  *Encoder,
+  IN OUT UINT8        *Chunk,
+  IN     CONST CHAR8  *Type,
+  IN     UINTN        Length
+  )
+{
+    UINT32  Crc;
+
+    PngPutUint32 (Chunk, (UINT32)Length);
+    CopyMem (Chunk + 4, Type, 4);
+    Crc = 0;
+    gBS->CalculateCrc32 (Chunk + 4, Length + 4, &Crc);
+    PngPutUint32 (Chunk + 8 + Length, Crc);
+    PngWrite (Encoder, Chunk, Length + 12);
+}
+
+/**
+  Write the compressed data gathered so far as an IDAT chunk.
+
+  @param  Encoder   The encoder.
+
+**/
+STATIC
+VOID
+PngFlushChunk (
+  IN OUT PNG_ENCODER  *Encoder
+  )
+{
+    if (Encoder->ChunkLength != 0) {
+        PngWriteChunk (Encoder, Encoder->Chunk, "IDAT", Encoder->ChunkLength);
+        Encoder->ChunkLength = 0;
+    }
+}
+
+/**
+  Append a byte to the compressed data.
+
+  @param  Encoder   The encoder.
+  @param  Byte      The byte.
+
+**/
+STATIC
+VOID
+PngPutByte (
+  IN OUT PNG_ENCODER  *Encoder,
+  IN     UINT8        Byte
+  )
+{
+    Encoder->Chunk[8 + Encoder->ChunkLength++] = Byte;
+    if (Encoder->ChunkLength == PNG_IDAT_SIZE) {
+        PngFlushChunk (Encoder);
+    }
+}
+
+/**
+  Append bits to the compressed data, least significant bit first.
+
+  @param  Encoder   The encoder.
+  @param  Value     The bits.
+  @param  Count     Number of bits, at most 16.
+
+**/
+STATIC
+VOID
+PngPutBits (
+  IN OUT PNG_ENCODER  *Encoder,
+  IN     UINTN        Value,
+  IN     UINTN        Count
+  )
+{
+    Encoder->BitBuffer |= (UINT32)Value << Encoder->BitCount;
+    Encoder->BitCount  += Count;
+    while (Encoder->BitCount >= 8) {
+        PngPutByte (Encoder, (UINT8)Encoder->BitBuffer);
+        Encoder->BitBuffer >>= 8;
+        Encoder->BitCount   -= 8;
+    }
+}
+
+/**
+  Compress the window up to a lookahead from its end, or all of it when
+  flushing.
+
+  @param  Encoder   The encoder.
+  @param  Flush     TRUE to compress all buffered data.
+
+**/
+STATIC
+VOID
+PngDeflate (
+  IN OUT PNG_ENCODER  *Encoder,
+  IN     BOOLEAN      Flush
+  )
+{
+    UINT8   *Window;
+    UINTN   Limit;
+    UINTN   Position;
+    UINTN   Hash;
+    UINTN   Match;
+    UINTN   Length;
+    UINTN   MaxLength;
+    UINTN   Distance;
+    UINTN   Code;
+
+    Window = Encoder->Window;
+    if (Flush) {
+        Limit = Encoder->WindowEnd;
+    } else if (Encoder->WindowEnd > PNG_MIN_LOOKAHEAD) {
+        Limit = Encoder->WindowEnd - PNG_MIN_LOOKAHEAD;
+    } else {
+        return;
+    }
+
+    for (Position = Encoder->Position; Position < Limit; ) {
+        Length = 0;
+        if (Position + PNG_MIN_MATCH <= Encoder->WindowEnd) {
+            Hash = ((Window[Position] << 10) ^ (Window[Position + 1] << 5) ^ Window[Position + 2]) & (PNG_HASH_SIZE - 1);
+            Match = Encoder->Head[Hash];
+            Encoder->Head[Hash] = (UINT32)(Position + 1);
+            if ((Match != 0) && (Position - (Match - 1) <= PNG_WINDOW_SIZE)) {
+                Match--;
+                MaxLength = MIN (PNG_MAX_MATCH, Encoder->WindowEnd - Position);
+                while ((Length < MaxLength) && (Window[Match + Length] == Window[Position + Length])) {
+                    Length++;
+                }
+            }
+        }
+
+        if (Length < PNG_MIN_MATCH) {
+            PngPutBits (Encoder, mLiteralCode[Window[Position]], mLiteralBits[Window[Position]]);
+            Position++;
+            continue;
+        }
+
+        Code = mLengthCode[Length - PNG_MIN_MATCH];
+        PngPutBits (Encoder, mLiteralCode[257 + Code], mLiteralBits[257 + Code]);
+        PngPutBits (Encoder, Length - mLengthBase[Code], mLengthExtra[Code]);
+
+        Distance = Position - Match;
+        Code = (Distance <= 256) ? mDistanceCode[Distance - 1] : mDistanceCode[256 + ((Distance - 1) >> 7)];
+        PngPutBits (Encoder, mDistanceCode5[Code], 5);
+        PngPutBits (Encoder, Distance - mDistanceBase[Code], mDistanceExtra[Code]);
+
+        Position += Length;
+    }
+    Encoder->Position = Position;
+}
+
+/**
+  Add filtered bytes to the deflate stream.
+
+  @param  Encoder   The encoder.
+  @param  Data      The bytes.
+  @param  Size      Number of bytes.
+
+**/
+STATIC
+VOID
+PngFeed (
+  IN OUT PNG_ENCODER  *Encoder,
+  IN     CONST UINT8  *Data,
+  IN     UINTN        Size
+  )
+{
+    UINTN  Count;
+    UINTN  Index;
+
+    while (Size != 0) {
+        Count = MIN (Size, 2 * PNG_WINDOW_SIZE - Encoder->WindowEnd);
+        CopyMem (Encoder->Window + Encoder->WindowEnd, Data, Count);
+        Encoder->WindowEnd += Count;
+        Data += Count;
+        Size -= Count;
+
+        PngDeflate (Encoder, FALSE);
+
+        //
+        // Slide the upper half of the window down when it is full.  The hash
+        // positions are stored plus one, so those that fall out become 0.
+        //
+        if (Encoder->WindowEnd == 2 * PNG_WINDOW_SIZE) {
+            ASSERT (Encoder->Position >= PNG_WINDOW_SIZE);
+            CopyMem (Encoder->Window, Encoder->Window + PNG_WINDOW_SIZE, PNG_WINDOW_SIZE);
+            Encoder->WindowEnd -= PNG_WINDOW_SIZE;
+            Encoder->Position  -= PNG_WINDOW_SIZE;
+            for (Index = 0; Index < PNG_HASH_SIZE; Index++) {
+                Encoder->Head[Index] = (Encoder->Head[Index] > PNG_WINDOW_SIZE) ? Encoder->Head[Index] - PNG_WINDOW_SIZE : 0;
+            }
+        }
+    }
+}
+
+/**
+  Free the buffers of an encoder, abandoning the image.
+
+  @param  Encoder   The encoder.
+
+**/
+VOID
+PngEncoderFree (
+  IN OUT PNG_ENCODER  *Encoder
+  )
+{
+    if (Encoder->Window != NULL) {
+        FreePool (Encoder->Window);
+        Encoder->Window = NULL;
+    }
+    if (Encoder->Head != NULL) {
+        FreePool (Encoder->Head);
+        Encoder->Head = NULL;
+    }
+    if (Encoder->Chunk != NULL) {
+        FreePool (Encoder->Chunk);
+        Encoder->Chunk = NULL;
+    }
+    if (Encoder->Row != NULL) {
+        FreePool (Encoder->Row);
+        Encoder->Row = NULL;
+    }
+}
+
+/**
+  Start a PNG file: write the signature and header, and set up the encoder.
+
+  @param  Encoder       The encoder.
+  @param  FileHandle    The file to write.
+  @param  Width         Image width in pixels.
+  @param  Height        Image height in pixels.
+
+  @retval EFI_SUCCESS           The encoder is ready for Height rows.
+  @retval EFI_OUT_OF_RESOURCES  No enough buffer to allocate.
+  @retval Others                Writing the file failed.
+
+**/
+EFI_STATUS
+PngEncoderStart (
+  OUT PNG_ENCODER        *Encoder,
+  IN  EFI_FILE_PROTOCOL  *FileHandle,
+  IN  UINT32             Width,
+  IN  UINT32             Height
+  )
+{
+    UINT8  Header[8 + 13 + 4];
+
+    PngInitTables ();
+
+    ZeroMem (Encoder, sizeof (*Encoder));
+    Encoder->File     = FileHandle;
+    Encoder->RowBytes = (UINTN)Width * 3;
+    Encoder->Adler1   = 1;
+
+    //
+    // The row buffer holds the filter byte and filtered row, then the
+    // previous row, which starts as zeros so that Up filters the first row
+    // as None.
+    //
+    Encoder->Window = AllocatePool (2 * PNG_WINDOW_SIZE);
+    Encoder->Head   = AllocateZeroPool (PNG_HASH_SIZE * sizeof (UINT32));
+    Encoder->Chunk  = AllocatePool (8 + PNG_IDAT_SIZE + 4);
+    Encoder->Row    = AllocateZeroPool (1 + 2 * Encoder->RowBytes);
+    if ((Encoder->Window == NULL) || (Encoder->Head == NULL) || (Encoder->Chunk == NULL) || (Encoder->Row == NULL)) {
+        PngEncoderFree (Encoder);
+        return EFI_OUT_OF_RESOURCES;
+    }
+
+    PngWrite (Encoder, mPngSignature, sizeof (mPngSignature));
+
+    PngPutUint32 (Header + 8, Width);
+    PngPutUint32 (Header + 12, Height);
+    Header[16] = 8;     // Bit depth
+    Header[17] = 2;     // Color type RGB
+    Header[18] = 0;     // Deflate
+    Header[19] = 0;     // Adaptive filtering
+    Header[20] = 0;     // Not interlaced
+    PngWriteChunk (Encoder, Header, "IHDR", 13);
+
+    //
+    // zlib header for a 32K window, then open one fixed Huffman block that
+    // runs to the end of the image.
+    //
+    PngPutByte (Encoder, 0x78);
+    PngPutByte (Encoder, 0x01);
+    PngPutBits (Encoder, 0, 1);
+    PngPutBits (Encoder, 1, 2);
+
+    if (EFI_ERROR(Encoder->Status)) {
+        PngEncoderFree (Encoder);
+    }
+    return Encoder->Status;
+}
+
+/**
+  Add a row of the image.
+
+  @param  Encoder   The encoder.
+  @param  Pixels    Width pixels of 3 bytes, red first.
+
+**/
+VOID
+PngEncoderWriteRow (
+  IN OUT PNG_ENCODER  *Encoder,
+  IN     CONST UINT8  *Pixels
+  )
+{
+    UINT8  *Filtered;
+    UINT8  *Previous;
+    UINTN  Index;
+    UINTN  Adler1;
+    UINTN  Adler2;
+    UINTN  Count;
+
+    Filtered = Encoder->Row;
+    Previous = Encoder->Row + 1 + Encoder->RowBytes;
+
+    Filtered[0] = PNG_FILTER_UP;
+    for (Index = 0; Index < Encoder->RowBytes; Index++) {
+        Filtered[1 + Index] = (UINT8)(Pixels[Index] - Previous[Index]);
+    }
+    CopyMem (Previous, Pixels, Encoder->RowBytes);
+
+    //
+    // Adler-32 of the uncompressed stream, reduced once per PNG_ADLER_NMAX
+    // bytes as zlib does.
+    //
+    Adler1 = Encoder->Adler1;
+    Adler2 = Encoder->Adler2;
+    for (Index = 0; Index < 1 + Encoder->RowBytes; ) {
+        Count = MIN (PNG_ADLER_NMAX, 1 + Encoder->RowBytes - Index);
+        for (; Count != 0; Count--, Index++) {
+            Adler1 += Filtered[Index];
+            Adler2 += Adler1;
+        }
+        Adler1 %= PNG_ADLER_BASE;
+        Adler2 %= PNG_ADLER_BASE;
+    }
+    Encoder->Adler1 = (UINT32)Adler1;
+    Encoder->Adler2 = (UINT32)Adler2;
+
+    PngFeed (Encoder, Filtered, 1 + Encoder->RowBytes);
+}
+
+/**
+  Finish the PNG file after the last row and free the encoder.
+
+  @param  Encoder   The encoder.
+
+  @retval EFI_SUCCESS   The file was written.
+  @retval Others        Writing the file failed.
+
+**/
+EFI_STATUS
+PngEncoderFinish (
+  IN OUT PNG_ENCODER  *Encoder
+  )
+{
+    UINT8  End[8 + 4];
+
+    PngDeflate (Encoder, TRUE);
+
+    //
+    // End the open block, add an empty final block and pad to a byte.
+    //
+    PngPutBits (Encoder, mLiteralCode[PNG_END_OF_BLOCK], mLiteralBits[PNG_END_OF_BLOCK]);
+    PngPutBits (Encoder, 1, 1);
+    PngPutBits (Encoder, 1, 2);
+    PngPutBits (Encoder, mLiteralCode[PNG_END_OF_BLOCK], mLiteralBits[PNG_END_OF_BLOCK]);
+    PngPutBits (Encoder, 0, (8 - Encoder->BitCount) & 7);
+
+    PngPutByte (Encoder, (UINT8)(Encoder->Adler2 >> 8));
+    PngPutByte (Encoder, (UINT8)Encoder->Adler2);
+    PngPutByte (Encoder, (UINT8)(Encoder->Adler1 >> 8));
+    PngPutByte (Encoder, (UINT8)Encoder->Adler1);
+    PngFlushChunk (Encoder);
+
+    PngWriteChunk (Encoder, End, "IEND", 0);
+
+    PngEncoderFree (Encoder);
+    return Encoder->Status;
+}
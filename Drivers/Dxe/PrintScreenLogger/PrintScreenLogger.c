@@ -38,11 +38,16 @@ typedef struct {
 //
 // PrtScreen comes in as an EFI_SYS_REQUEST shift state.
 //
-// Register two notifications, one for a RightCtrl-PrtScn and one for a LeftCtrl-PrtScn
+// Register two notifications, one for a RightCtrl-PrtScn and one for a LeftCtrl-PrtScn,
+// and four more for Ctrl-Shift-PrtScn, which starts and stops a screen recording.
 //      
 STATIC PRINT_SCREEN_KEYS  gPrtScnKeys[] = {
     {{{0,0},{EFI_SHIFT_STATE_VALID | EFI_LEFT_CONTROL_PRESSED  | EFI_SYS_REQ_PRESSED, 0}}, NULL},
-    {{{0,0},{EFI_SHIFT_STATE_VALID | EFI_RIGHT_CONTROL_PRESSED | EFI_SYS_REQ_PRESSED, 0}}, NULL}
+    {{{0,0},{EFI_SHIFT_STATE_VALID | EFI_RIGHT_CONTROL_PRESSED | EFI_SYS_REQ_PRESSED, 0}}, NULL},
+    {{{0,0},{EFI_SHIFT_STATE_VALID | EFI_LEFT_CONTROL_PRESSED  | EFI_LEFT_SHIFT_PRESSED  | EFI_SYS_REQ_PRESSED, 0}}, NULL},
+    {{{0,0},{EFI_SHIFT_STATE_VALID | EFI_LEFT_CONTROL_PRESSED  | EFI_RIGHT_SHIFT_PRESSED | EFI_SYS_REQ_PRESSED, 0}}, NULL},
+    {{{0,0},{EFI_SHIFT_STATE_VALID | EFI_RIGHT_CONTROL_PRESSED | EFI_LEFT_SHIFT_PRESSED  | EFI_SYS_REQ_PRESSED, 0}}, NULL},
+    {{{0,0},{EFI_SHIFT_STATE_VALID | EFI_RIGHT_CONTROL_PRESSED | EFI_RIGHT_SHIFT_PRESSED | EFI_SYS_REQ_PRESSED, 0}}, NULL}
 };
 
 #define NUMBER_KEY_NOTIFIES (sizeof(gPrtScnKeys)/sizeof(PRINT_SCREEN_KEYS)) 
@@ -52,6 +57,33 @@ STATIC PRINT_SCREEN_KEYS  gPrtScnKeys[] = {
 STATIC EFI_SIMPLE_TEXT_INPUT_EX_PROTOCOL *gTxtInEx    = NULL;
 STATIC EFI_EVENT                          gTimerEvent = NULL;
 
+//
+// The enabled USB volume and the next free PrtScreen#### index on it.  They are
+// looked up on the first capture and kept until a file system is installed or
+// writing to the volume fails.
+//
+STATIC EFI_FILE_PROTOCOL                 *gVolumeHandle         = NULL;
+STATIC UINTN                              gNextFileIndex        = 0;
+STATIC EFI_EVENT                          gFsNotifyEvent        = NULL;
+STATIC VOID                              *gFsNotifyRegistration = NULL;
+
+//
+// Captures waiting to be written, oldest at gCaptureHead.  The key notification
+// adds captures and the TPL_CALLBACK gQueueEvent timer writes and removes them.
+//
+STATIC PRINT_SCREEN_CAPTURE               gCaptures[PRINT_SCREEN_QUEUE_DEPTH];
+STATIC UINTN                              gCaptureHead          = 0;
+STATIC UINTN                              gCaptureCount         = 0;
+STATIC EFI_EVENT                          gQueueEvent           = NULL;
+
+//
+// The pixel buffer of the last written capture, kept for the next one so a
+// capture usually does not allocate in the key notification.  Only this one
+// buffer outlives its capture.
+//
+STATIC EFI_GRAPHICS_OUTPUT_BLT_PIXEL     *gSparePixels          = NULL;
+STATIC UINTN                              gSpareSize            = 0;
+
 /**
 
   Scan USB Drives looking for a file named PrintScreenEnable.txt.  The presence
@@ -98,6 +130,8 @@ FindUsbDriveForPrintScreen (
         goto CleanUp;
     }
 
+    Status = EFI_NOT_FOUND;
+
     //
     // Search the handles to find one that has has a USB node in the device path.
     //
@@ -178,109 +212,561 @@ CleanUp:
 }
 
 /**
-  Convert a Gop 32 bits per pixel video frame buffer to a 
-  24 bits per pixel *.BMP graphics image
+  Find the next free PrtScreen#### index on a volume.
 
-  @param  BmpFileName   Name of file to create
-  @param  Gop           GRAPHICS_OUTPUT_PROTOCOL
-  @param  BltBuffer     Buffer containing GOP version of BmpImage.
+  The root directory is read once and the index after the highest
+  PrtScreen#### file found is returned, whatever the file extension.
 
-  @retval EFI_SUCCESS           GopBlt and GopBltSize are returned.
-  @retval EFI_UNSUPPORTED       BmpImage is not a valid *.BMP image
-  @retval EFI_BUFFER_TOO_SMALL  The passed in GopBlt buffer is not big enough.
-                                GopBltSize will contain the required size.
-  @retval EFI_OUT_OF_RESOURCES  No enough buffer to allocate.
+  @param    VolumeHandle    The root directory of the volume.
+  @param    NextIndex       The next free index.
+
+  @retval   EFI_SUCCESS     NextIndex is valid.
+  @retval   Others          The directory could not be read.
 
 **/
 EFI_STATUS
-WriteBmpToFile (
-  IN EFI_FILE_PROTOCOL             *FileHandle
-) {
+FindNextPrintScreenIndex (
+  IN  EFI_FILE_PROTOCOL  *VolumeHandle,
+  OUT UINTN              *NextIndex
+  )
+{
+    EFI_STATUS                       Status;
+    EFI_FILE_INFO                   *FileInfo;
+    UINTN                            BufferSize;
+    UINTN                            Size;
+    UINTN                            Index;
+    UINTN                            Digit;
+    UINTN                            MaxIndex;
+    CONST CHAR16                    *Name;
 
-    EFI_STATUS                     Status;
-    BMP_IMAGE_HEADER              *BmpHeader;
-    UINTN                          DataSizePerLine;
-    UINTN                          BmpBufferSize;
-    UINT8                         *Image;
-    EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Blt;
-    EFI_GRAPHICS_OUTPUT_BLT_PIXEL *BltBuffer;
-    UINT32                         Height;
-    UINT32                         Width;
-    UINT64                         WriteSize;
+#define PRINT_SCREEN_FILE_PREFIX        L"PrtScreen"
+#define PRINT_SCREEN_FILE_PREFIX_LENGTH (sizeof (PRINT_SCREEN_FILE_PREFIX) / sizeof (CHAR16) - 1)
 
-    EFI_GRAPHICS_OUTPUT_PROTOCOL   *Gop;
+    BufferSize = SIZE_OF_EFI_FILE_INFO + 256 * sizeof (CHAR16);
+    FileInfo = AllocatePool (BufferSize);
+    if (FileInfo == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+    }
 
-#define BMP_BITS_PER_PIXEL  24
+    MaxIndex = 0;
+    Status = VolumeHandle->SetPosition (VolumeHandle, 0);
+    while (!EFI_ERROR(Status)) {
+        Size = BufferSize;
+        Status = VolumeHandle->Read (VolumeHandle, &Size, FileInfo);
+        if (EFI_ERROR(Status) || (Size == 0)) {
+            break;
+        }
 
-    BmpHeader = NULL;
-    BltBuffer = NULL;
+        if ((FileInfo->Attribute & EFI_FILE_DIRECTORY) != 0) {
+            continue;
+        }
 
-    Status = gBS->LocateProtocol (&gEfiGraphicsOutputProtocolGuid,
-                                  NULL,
-                                  (VOID **)&Gop
-                                 );
+        //
+        // Match PrtScreen followed by four digits and an extension
+        //
+        Name = FileInfo->FileName;
+        if (StrnCmp (Name, PRINT_SCREEN_FILE_PREFIX, PRINT_SCREEN_FILE_PREFIX_LENGTH) != 0) {
+            continue;
+        }
+        Name += PRINT_SCREEN_FILE_PREFIX_LENGTH;
+        Index = 0;
+        for (Digit = 0; Digit < 4; Digit++) {
+            if ((Name[Digit] < L'0') || (Name[Digit] > L'9')) {
+                break;
+            }
+            Index = Index * 10 + (Name[Digit] - L'0');
+        }
+        if ((Digit == 4) && (Name[Digit] == L'.') && (Index > MaxIndex)) {
+            MaxIndex = Index;
+        }
+    }
+
+    FreePool (FileInfo);
     if (EFI_ERROR(Status)) {
-        DEBUG((DEBUG_ERROR, "Unable to locate Gop protocol\n"));
+        DEBUG((DEBUG_ERROR, "%a: Unable to read the root directory. Code = %r\n", __FUNCTION__, Status));
         return Status;
     }
 
-    if ((Gop->Mode->Info->PixelFormat != PixelRedGreenBlueReserved8BitPerColor) &&
-        (Gop->Mode->Info->PixelFormat != PixelBlueGreenRedReserved8BitPerColor)) {
+    *NextIndex = MaxIndex + 1;
+    return EFI_SUCCESS;
+}
+
+/**
+  Close the cached print screen volume, so that the next capture looks
+  for an enabled USB drive again.
+
+**/
+VOID
+ReleasePrintScreenVolume (
+    VOID
+    )
+{
+    EFI_STATUS Status;
+
+    if (gVolumeHandle != NULL) {
+        Status = gVolumeHandle->Close (gVolumeHandle);
+        if (EFI_ERROR(Status)) {
+            DEBUG((DEBUG_ERROR,"%a: Error closing Vol Handle. Code = %r\n", __FUNCTION__, Status));
+        }
+        gVolumeHandle = NULL;
+    }
+    gNextFileIndex = 0;
+}
+
+/**
+  Get the print screen volume and its next free file index, looking them
+  up if they are not cached.
+
+  @param    VolumeHandle    The root directory of the volume.
+
+  @retval   EFI_SUCCESS     The volume and gNextFileIndex are valid.
+  @retval   Others          No enabled USB drive was found.
+
+**/
+EFI_STATUS
+GetPrintScreenVolume (
+  OUT EFI_FILE_PROTOCOL  **VolumeHandle
+  )
+{
+    EFI_STATUS Status;
+
+    if (gVolumeHandle == NULL) {
+        Status = FindUsbDriveForPrintScreen (&gVolumeHandle);
+        if (EFI_ERROR(Status)) {
+            gVolumeHandle = NULL;
+            return Status;
+        }
+
+        Status = FindNextPrintScreenIndex (gVolumeHandle, &gNextFileIndex);
+        if (EFI_ERROR(Status)) {
+            ReleasePrintScreenVolume ();
+            return Status;
+        }
+    }
+
+    *VolumeHandle = gVolumeHandle;
+    return EFI_SUCCESS;
+}
+
+/**
+  Simple File System install notification.  A new volume may be the enabled
+  USB drive, so drop the cached one.
+
+  @param    Event           Not Used.
+  @param    Context         Not Used.
+
+**/
+VOID
+EFIAPI
+FileSystemNotify (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+    ReleasePrintScreenVolume ();
+}
+
+/**
+  Write a block of the image file and check that all of it was written.
+
+  @param  FileHandle    The file to write.
+  @param  Buffer        The data.
+  @param  Size          Bytes to write.
+
+  @retval EFI_SUCCESS           The data was written.
+  @retval EFI_BAD_BUFFER_SIZE   Fewer bytes were written.
+  @retval Others                The write failed.
+
+**/
+STATIC
+EFI_STATUS
+WriteImageData (
+  IN EFI_FILE_PROTOCOL             *FileHandle,
+  IN VOID                          *Buffer,
+  IN UINTN                          Size
+) {
+
+    EFI_STATUS                     Status;
+    UINTN                          WriteSize;
+
+    WriteSize = Size;
+    Status = FileHandle->Write (FileHandle, &WriteSize, Buffer);
+    if (EFI_ERROR(Status)) {
+        DEBUG((DEBUG_ERROR, "Error writing image file. Code=%r\n", Status));
+        return Status;
+    }
+    if (WriteSize != Size) {
+        DEBUG((DEBUG_ERROR, "Wrong number of bytes written.  S/B=%ld, Actual=%ld\n", Size, WriteSize));
+        return EFI_BAD_BUFFER_SIZE;
+    }
+
+    return EFI_SUCCESS;
+}
+
+/**
+  Read rows of the screen as Blt pixels.  PixelBitMask modes are read from
+  the frame buffer, as GOP drivers often cannot Blt them.
+
+  @param  Gop       The graphics output protocol.
+  @param  Buffer    Receives Rows full width rows of Blt pixels.
+  @param  Y         The first row.
+  @param  Rows      Number of rows.
+
+  @retval EFI_SUCCESS       The rows were read.
+  @retval EFI_UNSUPPORTED   The mode's pixels cannot be read.
+  @retval Others            Blt failed.
+
+**/
+EFI_STATUS
+ReadScreen (
+  IN  EFI_GRAPHICS_OUTPUT_PROTOCOL   *Gop,
+  OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Buffer,
+  IN  UINT32                         Y,
+  IN  UINT32                         Rows
+  )
+{
+    EFI_STATUS                            Status;
+    EFI_GRAPHICS_OUTPUT_MODE_INFORMATION *Info;
+    PIXEL_MASK_CONVERTER                  Converter;
+    EFI_GRAPHICS_OUTPUT_BLT_PIXEL        *Row;
+    UINT8                                *FrameBuffer;
+    UINTN                                 RowBytes;
+    UINTN                                 Stride;
+    UINT32                                Index;
+
+    Info = Gop->Mode->Info;
+    if (Info->PixelFormat != PixelBitMask) {
+        return Gop->Blt (Gop,
+                         Buffer,
+                         EfiBltVideoToBltBuffer,
+                         0,
+                         Y,
+                         0,
+                         0,
+                         Info->HorizontalResolution,
+                         Rows,
+                         0
+                        );
+    }
+
+    Status = InitPixelMaskConverter (&Converter, &Info->PixelInformation);
+    if (EFI_ERROR(Status) || (Gop->Mode->FrameBufferBase == 0)) {
         DEBUG((DEBUG_ERROR, "%a: Unsupported video mode\n", __FUNCTION__));
         return EFI_UNSUPPORTED;
     }
 
-    BltBuffer = (EFI_GRAPHICS_OUTPUT_BLT_PIXEL *)  AllocatePool (Gop->Mode->FrameBufferSize); 
-    if (NULL == BltBuffer) {
-        return EFI_OUT_OF_RESOURCES;
+    //
+    // Copy each frame buffer row to the end of its Blt row in one sequential
+    // read, which is far faster than reading the frame buffer pixel by pixel,
+    // then convert it in place.
+    //
+    RowBytes = Info->HorizontalResolution * Converter.BytesPerPixel;
+    Stride = Info->PixelsPerScanLine * Converter.BytesPerPixel;
+    FrameBuffer = (UINT8 *)(UINTN)Gop->Mode->FrameBufferBase + Y * Stride;
+    Row = Buffer;
+    for (Index = 0; Index < Rows; Index++) {
+        CopyMem ((UINT8 *)(Row + Info->HorizontalResolution) - RowBytes, FrameBuffer, RowBytes);
+        ConvertMaskedRow (&Converter, Row, Info->HorizontalResolution);
+        FrameBuffer += Stride;
+        Row += Info->HorizontalResolution;
+    }
+
+    return EFI_SUCCESS;
+}
+
+/**
+  Release the pixel buffer of a capture.  The larger of it and the spare
+  buffer is kept as the spare buffer and the other one is freed.  Runs at
+  TPL_NOTIFY, the TPL of the key notification that takes the spare buffer.
+
+  @param  Capture       The capture.
+
+**/
+STATIC
+VOID
+ReleaseCapturePixels (
+  IN OUT PRINT_SCREEN_CAPTURE  *Capture
+  )
+{
+    if (Capture->Pixels == NULL) {
+        return;
+    }
+
+    if ((gSparePixels == NULL) || (Capture->BufferSize > gSpareSize)) {
+        if (gSparePixels != NULL) {
+            FreePool (gSparePixels);
+        }
+        gSparePixels = Capture->Pixels;
+        gSpareSize = Capture->BufferSize;
+    } else {
+        FreePool (Capture->Pixels);
     }
 
-    Height = Gop->Mode->Info->VerticalResolution;
-    Width = Gop->Mode->Info->HorizontalResolution;
-
-    Status = Gop->Blt (Gop,
-                       BltBuffer,
-                       EfiBltVideoToBltBuffer,
-                       0,
-                       0,
-                       0,
-                       0,
-                       Width,
-                       Height,
-                       0
-                      );
+    Capture->Pixels = NULL;
+    Capture->BufferSize = 0;
+}
+
+/**
+  Rows of the screen in one band of a capture that is read when it is
+  written: at most PRINT_SCREEN_BAND_SIZE bytes of Blt pixels, at least one
+  row.
+
+  @param  Capture       The capture.
+
+  @return Rows per band.
+
+**/
+STATIC
+UINT32
+GetBandRows (
+  IN CONST PRINT_SCREEN_CAPTURE  *Capture
+  )
+{
+    UINTN  Rows;
+
+    Rows = PRINT_SCREEN_BAND_SIZE / ((UINTN)Capture->Width * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+    return (UINT32)MIN (MAX (Rows, 1), Capture->Height);
+}
+
+/**
+  Get rows of a capture as Blt pixels: from its copy of the screen, or from
+  the screen itself for a capture that has no copy.
+
+  @param  Capture       The capture.
+  @param  Band          GetBandRows() rows of Blt pixels, used when the
+                        capture has no copy.
+  @param  Y             The first row.
+  @param  Rows          Number of rows.
+  @param  Pixels        Receives the first of the rows.
+
+  @retval EFI_SUCCESS       The rows are at Pixels.
+  @retval EFI_ABORTED       The video mode has changed since the capture.
+  @retval Others            The screen could not be read.
+
+**/
+STATIC
+EFI_STATUS
+GetCaptureRows (
+  IN  PRINT_SCREEN_CAPTURE            *Capture,
+  IN  EFI_GRAPHICS_OUTPUT_BLT_PIXEL   *Band,
+  IN  UINT32                          Y,
+  IN  UINT32                          Rows,
+  OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL   **Pixels
+  )
+{
+    EFI_STATUS                     Status;
+    EFI_GRAPHICS_OUTPUT_PROTOCOL   *Gop;
+
+    if (Capture->Pixels != NULL) {
+        *Pixels = Capture->Pixels + (UINTN)Y * Capture->Width;
+        return EFI_SUCCESS;
+    }
+
+    Status = gBS->LocateProtocol (&gEfiGraphicsOutputProtocolGuid, NULL, (VOID **)&Gop);
     if (EFI_ERROR(Status)) {
-        DEBUG((DEBUG_ERROR, "Unable to BLt video to buffer, code=%r\n",Status));
-        goto ErrorExit;
+        return Status;
+    }
+    if ((Gop->Mode->Info->HorizontalResolution != Capture->Width) ||
+        (Gop->Mode->Info->VerticalResolution != Capture->Height)) {
+        DEBUG((DEBUG_ERROR, "%a: Video mode changed, capture dropped\n", __FUNCTION__));
+        return EFI_ABORTED;
+    }
+
+    Status = ReadScreen (Gop, Band, Y, Rows);
+    if (EFI_ERROR(Status)) {
+        DEBUG((DEBUG_ERROR, "Unable to read the screen, code=%r\n",Status));
+        return Status;
     }
 
-    DataSizePerLine = ((Gop->Mode->Info->HorizontalResolution * BMP_BITS_PER_PIXEL + 31) >> 3) & (~0x3);
-    BmpBufferSize = MultU64x32 (DataSizePerLine, Gop->Mode->Info->VerticalResolution) + sizeof(BMP_IMAGE_HEADER) + ((sizeof(BMP_IMAGE_HEADER) + 3) & ~0x03);
+    *Pixels = Band;
+    return EFI_SUCCESS;
+}
 
-    if (BmpBufferSize > (UINT32) ~0) {
-        Status = EFI_INVALID_PARAMETER;
-        goto ErrorExit;
+/**
+  Copy the screen into the next free capture slot, in the spare pixel buffer
+  or a new one.  This runs in the key notification, so it only reads the
+  screen; the capture is written to the drive later by WriteQueuedCapture.
+  Without pool for a copy the capture is still queued, and the screen is
+  read band by band when it is written.
+
+  Depending on PcdPrintScreenText the text console is copied as well, or
+  instead of the image when there is text to copy.
+
+  @retval EFI_SUCCESS           The screen was queued.
+  @retval EFI_OUT_OF_RESOURCES  The queue is full or no enough buffer to allocate.
+  @retval Others                The screen could not be read.
+
+**/
+EFI_STATUS
+CaptureScreen (
+    VOID
+    )
+{
+    EFI_STATUS                     Status;
+    EFI_GRAPHICS_OUTPUT_PROTOCOL   *Gop;
+    PRINT_SCREEN_CAPTURE          *Capture;
+    UINT32                         Height;
+    UINT32                         Width;
+    UINTN                          Size;
+    UINT8                          TextMode;
+
+    if (gCaptureCount == PRINT_SCREEN_QUEUE_DEPTH) {
+        DEBUG((DEBUG_ERROR, "%a: Capture queue full, screen not captured\n", __FUNCTION__));
+        return EFI_OUT_OF_RESOURCES;
+    }
+
+    Capture = &gCaptures[(gCaptureHead + gCaptureCount) % PRINT_SCREEN_QUEUE_DEPTH];
+    Capture->Width = 0;
+    Capture->Height = 0;
+
+    TextMode = PcdGet8 (PcdPrintScreenText);
+    if (TextMode != PRINT_SCREEN_TEXT_NONE) {
+        Status = CaptureText (Capture);
+        if (EFI_ERROR(Status)) {
+            DEBUG((DEBUG_WARN, "%a: Text console not captured, code=%r\n", __FUNCTION__, Status));
+        }
+    } else {
+        Capture->Columns = 0;
+        Capture->Rows = 0;
+    }
+
+    if ((TextMode != PRINT_SCREEN_TEXT_ONLY) || (Capture->Rows == 0)) {
+        Status = gBS->LocateProtocol (&gEfiGraphicsOutputProtocolGuid,
+                                      NULL,
+                                      (VOID **)&Gop
+                                     );
+        if (EFI_ERROR(Status)) {
+            DEBUG((DEBUG_ERROR, "Unable to locate Gop protocol\n"));
+            goto Done;
+        }
+
+        Height = Gop->Mode->Info->VerticalResolution;
+        Width = Gop->Mode->Info->HorizontalResolution;
+        Size = (UINTN)MultU64x32 (Width, Height) * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL);
+
+        if ((gSparePixels != NULL) && (gSpareSize >= Size)) {
+            Capture->Pixels = gSparePixels;
+            Capture->BufferSize = gSpareSize;
+            gSparePixels = NULL;
+            gSpareSize = 0;
+        } else {
+            Capture->Pixels = AllocatePool (Size);
+            Capture->BufferSize = Size;
+        }
+
+        if (Capture->Pixels == NULL) {
+            DEBUG((DEBUG_WARN, "%a: No pool for a copy, the screen is read when written\n", __FUNCTION__));
+            Capture->BufferSize = 0;
+            Capture->Width = Width;
+            Capture->Height = Height;
+            Status = EFI_SUCCESS;
+            goto Done;
+        }
+
+        Status = ReadScreen (Gop, Capture->Pixels, 0, Height);
+        if (EFI_ERROR(Status)) {
+            DEBUG((DEBUG_ERROR, "Unable to read the screen, code=%r\n",Status));
+            ReleaseCapturePixels (Capture);
+            goto Done;
+        }
+
+        Capture->Width = Width;
+        Capture->Height = Height;
+    }
+
+Done:
+    //
+    // Queue whatever was captured; a text console without graphics still
+    // gets its text written.
+    //
+    if ((Capture->Width == 0) && (Capture->Rows == 0)) {
+        return EFI_ERROR(Status) ? Status : EFI_NOT_FOUND;
+    }
+    gCaptureCount++;
+
+    return EFI_SUCCESS;
+}
+
+/**
+  Convert a captured 32 bits per pixel screen to a 
+  24 bits per pixel *.BMP graphics image
+
+  The image is converted and written PRINT_SCREEN_BAND_SIZE bytes at a time,
+  bottom rows first as a BMP stores its rows bottom up.  A capture without a
+  copy of the screen reads the screen a band at a time.
+
+  @param  FileHandle    The file to write.
+  @param  Capture       The captured screen.
+
+  @retval EFI_SUCCESS           The image was written.
+  @retval EFI_INVALID_PARAMETER The image is too large for a BMP.
+  @retval EFI_OUT_OF_RESOURCES  No enough buffer to allocate.
+
+**/
+EFI_STATUS
+WriteBmpToFile (
+  IN EFI_FILE_PROTOCOL             *FileHandle,
+  IN PRINT_SCREEN_CAPTURE          *Capture
+) {
+
+    EFI_STATUS                     Status;
+    UINT8                          Header[(sizeof (BMP_IMAGE_HEADER) + 3) & ~0x03];
+    BMP_IMAGE_HEADER              *BmpHeader;
+    UINTN                          DataSizePerLine;
+    UINT64                         BmpFileSize;
+    UINT8                         *Image;
+    EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Band;
+    EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Pixels;
+    UINT32                         Height;
+    UINT32                         Width;
+    UINT32                         BandRows;
+    UINT32                         Rows;
+    UINT32                         Y;
+    UINT32                         Index;
+    PRINT_SCREEN_ROW_CONVERTER     ConvertRow;
+
+#define BMP_BITS_PER_PIXEL  24
+
+    Height = Capture->Height;
+    Width = Capture->Width;
+
+    DataSizePerLine = ((Width * BMP_BITS_PER_PIXEL + 31) >> 3) & (~0x3);
+    BmpFileSize = MultU64x32 (DataSizePerLine, Height) + sizeof (Header);
+
+    if (BmpFileSize > (UINT32) ~0) {
+        return EFI_INVALID_PARAMETER;
+    }
+
+    BandRows = (UINT32)MIN (MAX (PRINT_SCREEN_BAND_SIZE / DataSizePerLine, 1), Height);
+    Band = NULL;
+    if (Capture->Pixels == NULL) {
+        BandRows = MIN (BandRows, GetBandRows (Capture));
+        Band = AllocatePool ((UINTN)Width * BandRows * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+        if (Band == NULL) {
+            return EFI_OUT_OF_RESOURCES;
+        }
     }
 
-    BmpHeader = AllocateZeroPool (BmpBufferSize); // Insure unfilled area is zeroed
-    if (NULL == BmpHeader) {
+    Image = AllocateZeroPool (DataSizePerLine * BandRows); // Insure row padding is zeroed
+    if (Image == NULL) {
         Status = EFI_OUT_OF_RESOURCES;
         goto ErrorExit;
     }
 
-    Status = EFI_SUCCESS;
+    ZeroMem (Header, sizeof (Header));
+    BmpHeader = (BMP_IMAGE_HEADER *)Header;
 
     BmpHeader->CharB = 'B';           // Header flag
     BmpHeader->CharM = 'M';
-    BmpHeader->Size = (UINT32) BmpBufferSize;
+    BmpHeader->Size = (UINT32) BmpFileSize;
     BmpHeader->Reserved[0] = 0;
     BmpHeader->Reserved[1] = 0;
-    BmpHeader->ImageOffset = (sizeof(BMP_IMAGE_HEADER) + 3) & ~0x03;  // Start first row on 4 byte boundary
+    BmpHeader->ImageOffset = sizeof (Header);  // Start first row on 4 byte boundary
     BmpHeader->HeaderSize = sizeof (BMP_IMAGE_HEADER) - OFFSET_OF(BMP_IMAGE_HEADER, HeaderSize);
     BmpHeader->PixelWidth = Width;
     BmpHeader->PixelHeight = Height;
     BmpHeader->Planes = 1;
-    BmpHeader->BitPerPixel = 24;
+    BmpHeader->BitPerPixel = BMP_BITS_PER_PIXEL;
     BmpHeader->CompressionType = 0;   // Not Compressed
     BmpHeader->ImageSize = 0;
     BmpHeader->XPixelsPerMeter = 11000;  // Approximately 300 dpi
@@ -288,46 +774,359 @@ WriteBmpToFile (
     BmpHeader->NumberOfColors = 0;
     BmpHeader->ImportantColors = 0;
 
-    Image = ((UINT8 *) BmpHeader) + BmpHeader->ImageOffset;
+    Status = WriteImageData (FileHandle, Header, sizeof (Header));
+    if (EFI_ERROR(Status)) {
+        goto ErrorExit;
+    }
+
+    //
+    // Blt returns pixels in EFI_GRAPHICS_OUTPUT_BLT_PIXEL order whatever the
+    // mode's pixel format, which is the blue first order of a BMP.
+    //
+    ConvertRow = GetRowConverter (FALSE);
+    for (Y = Height; Y > 0; Y -= Rows) {
+        Rows = MIN (BandRows, Y);
+        Status = GetCaptureRows (Capture, Band, Y - Rows, Rows, &Pixels);
+        if (EFI_ERROR(Status)) {
+            goto ErrorExit;
+        }
+
+        for (Index = 0; Index < Rows; Index++) {
+            ConvertRow (Image + Index * DataSizePerLine,   // Rows start on 4 byte boundaries.
+                        Pixels + (UINTN)(Rows - Index - 1) * Width,
+                        Width);
+        }
 
-    for (Height = 0; Height < BmpHeader->PixelHeight; Height++) {
-        Blt = &BltBuffer[(BmpHeader->PixelHeight - Height - 1) * BmpHeader->PixelWidth];
-        for (Width = 0; Width < BmpHeader->PixelWidth; Width++, Blt++) {
-            if (Gop->Mode->Info->PixelFormat == PixelRedGreenBlueReserved8BitPerColor) {
-                *Image++ = Blt->Red;
-                *Image++ = Blt->Green;
-                *Image++ = Blt->Blue;
-            } else {    // PixelBlueGreenRedReserved8BitPerColor
-                *Image++ = Blt->Blue;
-                *Image++ = Blt->Green;
-                *Image++ = Blt->Red;
-            }   
+        Status = WriteImageData (FileHandle, Image, Rows * DataSizePerLine);
+        if (EFI_ERROR(Status)) {
+            goto ErrorExit;
         }
-        Image = (UINT8 *)(  ((UINT64)Image + 3) & ~0x03);  // Start next row on 4 byte boundary.
     }
 
-    WriteSize = BmpBufferSize;
-    Status = FileHandle->Write (FileHandle, &WriteSize, BmpHeader);
+ErrorExit:
+    if (Image != NULL) {
+        FreePool (Image);
+    }
+    if (Band != NULL) {
+        FreePool (Band);
+    }
+
+    return Status;
+}
+
+/**
+  Convert a captured screen into a 24 bits per pixel PNG image.
+
+  Each row is handed to the encoder, which writes IDAT chunks as they fill.
+  A capture without a copy of the screen reads the screen a band at a time.
+
+  @param  FileHandle    The file to write.
+  @param  Capture       The captured screen.
+
+  @retval EFI_SUCCESS           The image was written.
+  @retval EFI_OUT_OF_RESOURCES  No enough buffer to allocate.
+  @retval Others                The file could not be written.
+
+**/
+EFI_STATUS
+WritePngToFile (
+  IN EFI_FILE_PROTOCOL             *FileHandle,
+  IN PRINT_SCREEN_CAPTURE          *Capture
+) {
+
+    EFI_STATUS                     Status;
+    UINT8                         *Row;
+    EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Band;
+    EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Pixels;
+    UINT32                         BandRows;
+    UINT32                         Rows;
+    UINT32                         Y;
+    UINT32                         Index;
+    PNG_ENCODER                    Encoder;
+    PRINT_SCREEN_ROW_CONVERTER     ConvertRow;
+
+    BandRows = GetBandRows (Capture);
+    Band = NULL;
+    if (Capture->Pixels == NULL) {
+        Band = AllocatePool ((UINTN)Capture->Width * BandRows * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+        if (Band == NULL) {
+            return EFI_OUT_OF_RESOURCES;
+        }
+    }
+
+    Row = AllocatePool (Capture->Width * 3);
+    if (Row == NULL) {
+        Status = EFI_OUT_OF_RESOURCES;
+        goto ErrorExit;
+    }
+
+    Status = PngEncoderStart (&Encoder, FileHandle, Capture->Width, Capture->Height);
     if (EFI_ERROR(Status)) {
-        DEBUG((DEBUG_ERROR, "Error writing Bmp file. Code=%r\n", Status));
+        DEBUG((DEBUG_ERROR, "Error writing Png file. Code=%r\n", Status));
+        goto ErrorExit;
     }
-    if (WriteSize != BmpBufferSize) {
-        DEBUG((DEBUG_ERROR, "Wrong number of bytes written.  S/B=%ld, Actual=%ld\n", BmpBufferSize, WriteSize));
-        Status = EFI_BAD_BUFFER_SIZE;
+
+    //
+    // Blt returns pixels in EFI_GRAPHICS_OUTPUT_BLT_PIXEL order whatever the
+    // mode's pixel format.  PNG rows run top down, red first.
+    //
+    ConvertRow = GetRowConverter (TRUE);
+    for (Y = 0; Y < Capture->Height; Y += Rows) {
+        Rows = MIN (BandRows, Capture->Height - Y);
+        Status = GetCaptureRows (Capture, Band, Y, Rows, &Pixels);
+        if (EFI_ERROR(Status)) {
+            PngEncoderFree (&Encoder);
+            goto ErrorExit;
+        }
+
+        for (Index = 0; Index < Rows; Index++) {
+            ConvertRow (Row, Pixels + (UINTN)Index * Capture->Width, Capture->Width);
+            PngEncoderWriteRow (&Encoder, Row);
+        }
+
+        //
+        // Stop reading and compressing the screen once the file cannot be
+        // written.
+        //
+        if (EFI_ERROR(Encoder.Status)) {
+            Status = Encoder.Status;
+            DEBUG((DEBUG_ERROR, "Error writing Png file. Code=%r\n", Status));
+            PngEncoderFree (&Encoder);
+            goto ErrorExit;
+        }
+    }
+
+    Status = PngEncoderFinish (&Encoder);
+    if (EFI_ERROR(Status)) {
+        DEBUG((DEBUG_ERROR, "Error writing Png file. Code=%r\n", Status));
     }
 
 ErrorExit:
-    if (BltBuffer != NULL) {
-        FreePool (BltBuffer);
+    if (Row != NULL) {
+        FreePool (Row);
     }
+    if (Band != NULL) {
+        FreePool (Band);
+    }
+
+    return Status;
+}
+
+/**
+  Create the next PrtScreen#### file on the enabled USB drive.
+
+  @param  Extension     The file name extension, three characters.
+  @param  FileName      Receives the file name; PRINT_SCREEN_FILE_NAME_SIZE bytes.
+  @param  FileHandle    The created file.
+
+  @retval EFI_SUCCESS   The file was created.
+  @retval Others        No enabled drive was found or the file could not be created.
+
+**/
+EFI_STATUS
+CreatePrintScreenFile (
+  IN  CONST CHAR16       *Extension,
+  OUT CHAR16             *FileName,
+  OUT EFI_FILE_PROTOCOL  **FileHandle
+  )
+{
+    EFI_STATUS         Status;
+    EFI_FILE_PROTOCOL *VolumeHandle;
+
+    //
+    // 1. Get the suitable USB drive - one that has PrintScreenEnable.txt on it.
+    //
+    Status = GetPrintScreenVolume (&VolumeHandle);
+    if (EFI_ERROR(Status)) {
+        return Status;
+    }
+
+    //
+    // 2. Use the next PrtScreen#### value, past the highest one on the drive
+    //
+    if (gNextFileIndex > MAX_PRINT_SCREEN_FILES) {
+        DEBUG((DEBUG_ERROR,"%a: Too many print screen files.\n", __FUNCTION__));
+        return EFI_VOLUME_FULL;
+    }
+    UnicodeSPrint (FileName,
+                   PRINT_SCREEN_FILE_NAME_SIZE,
+                   L"PrtScreen%04d.%s",
+                   gNextFileIndex,
+                   Extension);
+
+    //
+    // 3. Create the new file
+    //
+    Status = VolumeHandle->Open (VolumeHandle, FileHandle, FileName, EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE, EFI_FILE_ARCHIVE);
+    if (EFI_ERROR(Status)) {
+        DEBUG((DEBUG_ERROR,"%a: Unable to create file %s. Code = %r\n", __FUNCTION__, FileName, Status));
+        //
+        // The drive may have been removed; look for it again next time.
+        //
+        ReleasePrintScreenVolume ();
+        return Status;
+    }
+    gNextFileIndex++;
 
-    if (BmpHeader != NULL) {
-        FreePool (BmpHeader );
+    return EFI_SUCCESS;
+}
+
+/**
+  Open a file next to a PrtScreen#### file, with the same number and another
+  extension, on the enabled USB drive.
+
+  @param  FileName      The PrtScreen#### file name.  Receives the new name.
+  @param  Extension     The new file name extension, three characters.
+  @param  FileHandle    The created file.
+
+  @retval EFI_SUCCESS   The file was created.
+  @retval Others        The file could not be created.
+
+**/
+STATIC
+EFI_STATUS
+CreateCompanionFile (
+  IN OUT CHAR16             *FileName,
+  IN     CONST CHAR16       *Extension,
+  OUT    EFI_FILE_PROTOCOL  **FileHandle
+  )
+{
+    EFI_STATUS  Status;
+
+    if (gVolumeHandle == NULL) {
+        return EFI_NOT_FOUND;
     }
 
+    StrCpyS (FileName + StrLen (FileName) - 3, 4, Extension);
+    Status = gVolumeHandle->Open (gVolumeHandle, FileHandle, FileName, EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE, EFI_FILE_ARCHIVE);
+    if (EFI_ERROR(Status)) {
+        DEBUG((DEBUG_ERROR,"%a: Unable to create file %s. Code = %r\n", __FUNCTION__, FileName, Status));
+    }
     return Status;
 }
 
+/**
+  Close a capture file, reporting how writing it went.  The volume stays open
+  for the next capture.
+
+  @param  FileHandle    The file.
+  @param  FileName      The file name.
+  @param  Status        The status of writing the file.
+
+**/
+STATIC
+VOID
+CloseCaptureFile (
+  IN EFI_FILE_PROTOCOL  *FileHandle,
+  IN CONST CHAR16       *FileName,
+  IN EFI_STATUS         Status
+  )
+{
+    EFI_STATUS  Status2;
+
+    if (!EFI_ERROR(Status)) {
+        DEBUG((DEBUG_INFO,"%a: Screen captured to file %s.\n", __FUNCTION__, FileName));
+    }
+
+    Status2 = FileHandle->Close (FileHandle);
+    if (EFI_ERROR(Status2)) {
+        DEBUG((DEBUG_ERROR,"%a: Error closing file %s. Code = %r\n", __FUNCTION__, FileName, Status2));
+    }
+}
+
+/**
+  Write a captured screen to the next PrtScreen#### file on the enabled USB
+  drive.  Captured text goes to a PrtScreen####.txt file with the same number
+  as the image, or the next number when there is no image.
+
+  @param  Capture       The captured screen.
+
+**/
+VOID
+WriteCaptureToFile (
+  IN PRINT_SCREEN_CAPTURE  *Capture
+  )
+{
+    EFI_FILE_PROTOCOL *FileHandle;
+    CHAR16             PrtScrnFileName[PRINT_SCREEN_FILE_NAME_SIZE / sizeof (CHAR16)];
+    EFI_STATUS         Status;
+
+    if (Capture->Width != 0) {
+        Status = CreatePrintScreenFile (PcdGetBool (PcdPrintScreenPng) ? L"png" : L"bmp",
+                                        PrtScrnFileName,
+                                        &FileHandle);
+        if (EFI_ERROR(Status)) {
+            return;
+        }
+
+        //
+        // Write the captured screen to the new file
+        //
+        if (PcdGetBool (PcdPrintScreenPng)) {
+            Status = WritePngToFile (FileHandle, Capture);
+        } else {
+            Status = WriteBmpToFile (FileHandle, Capture);
+        }
+        CloseCaptureFile (FileHandle, PrtScrnFileName, Status);
+    }
+
+    if (Capture->Rows != 0) {
+        if (Capture->Width != 0) {
+            Status = CreateCompanionFile (PrtScrnFileName, L"txt", &FileHandle);
+        } else {
+            Status = CreatePrintScreenFile (L"txt", PrtScrnFileName, &FileHandle);
+        }
+        if (EFI_ERROR(Status)) {
+            return;
+        }
+
+        Status = WriteTextToFile (FileHandle, Capture);
+        CloseCaptureFile (FileHandle, PrtScrnFileName, Status);
+    }
+}
+
+/**
+  Capture queue timer handler.  Writes the oldest queued capture and, if more
+  are queued, runs again on the next timer tick so that key notifications get
+  to run between captures.
+
+  @param    Event           Not Used.
+  @param    Context         Not Used.
+
+**/
+VOID
+EFIAPI
+WriteQueuedCapture (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+    EFI_TPL    OldTpl;
+    UINTN      Pending;
+
+    if (gCaptureCount == 0) {
+        return;
+    }
+
+    //
+    // The key notification only fills free slots, so the head slot is ours
+    // until it is released below.  Its pixels are not kept with it, so at
+    // most the queued captures and one spare buffer hold a full screen.
+    //
+    WriteCaptureToFile (&gCaptures[gCaptureHead]);
+
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    ReleaseCapturePixels (&gCaptures[gCaptureHead]);
+    gCaptureHead = (gCaptureHead + 1) % PRINT_SCREEN_QUEUE_DEPTH;
+    gCaptureCount--;
+    Pending = gCaptureCount;
+    gBS->RestoreTPL (OldTpl);
+
+    if (Pending != 0) {
+        gBS->SetTimer (gQueueEvent, TimerRelative, 0);
+    }
+}
+
 /**
   Handler for hot key notification
 
@@ -343,15 +1142,10 @@ PrintScreenCallback (
   IN EFI_KEY_DATA     *KeyData
 )
 {   
-    EFI_FILE_PROTOCOL *FileHandle;
-    UINTN              Index;
-    CHAR16             PrtScrnFileName[] = L"PrtScreen####.bmp";
     EFI_STATUS         Status;
-    EFI_STATUS         Status2;
-    EFI_FILE_PROTOCOL *VolumeHandle;
 
-    // We only register two keys - LeftCtrl-PrtScn and RightCtrl-PrtScn.  
-    // Assume print screen function if this function is called.
+    // We only register Ctrl-PrtScn and Ctrl-Shift-PrtScn.  Assume print screen
+    // function if this function is called without a shift key.
     DEBUG((DEBUG_INFO,"%a: Starting PrintScreen capture. Sc=%x, Uc=%x, Sh=%x, Ts=%x\n",
         __FUNCTION__,
         KeyData->Key.ScanCode,
@@ -366,76 +1160,21 @@ PrintScreenCallback (
         return EFI_SUCCESS;
     }
 
-    //
-    // 1. Find a suitable USB drive - one that has PrintScreenEnable.txt on it.
-    //
-    Status = FindUsbDriveForPrintScreen(&VolumeHandle);
-
-    if (!EFI_ERROR(Status)) {
+    if ((KeyData->KeyState.KeyShiftState & (EFI_LEFT_SHIFT_PRESSED | EFI_RIGHT_SHIFT_PRESSED)) != 0) {
+        ToggleScreenRecording ();
+    } else {
         //
-        // 2. Find the first value of PrtScreen#### that is available 
+        // Only copy the screen here; the queue timer writes it to the drive once
+        // the TPL drops to TPL_CALLBACK.
         //
-        Index = 0;
-
-        do {
-            Index++;
-            if (Index > MAX_PRINT_SCREEN_FILES) {
-                goto Exit;
-            }
-
-            UnicodeSPrint (PrtScrnFileName, sizeof (PrtScrnFileName), L"PrtScreen%04d.bmp", Index);
-            Status = VolumeHandle->Open (VolumeHandle, &FileHandle, PrtScrnFileName, EFI_FILE_MODE_READ, 0);
-            if (!EFI_ERROR(Status)) {
-                if (Index % PRINT_SCREEN_DEBUG_WARNING == 0) {
-                    DEBUG((DEBUG_INFO,"%a: File %s exists.  Trying again\n", __FUNCTION__, PrtScrnFileName));                    
-                }
-                Status2 = FileHandle->Close (FileHandle);
-                if (EFI_ERROR(Status2)) {
-                    DEBUG((DEBUG_ERROR,"%a: Error closing File Handle. Code = %r\n", __FUNCTION__, Status2));
-                }
-                continue;
-            }
-            if (Status == EFI_NOT_FOUND) {
-                break;
-            }
-        } while (TRUE); 
-
-        //
-        // 3. Create the new file that will contain the bitmap
-        //
-        Status = VolumeHandle->Open (VolumeHandle, &FileHandle, PrtScrnFileName, EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE, EFI_FILE_ARCHIVE);
-        if (EFI_ERROR(Status)) {
-            DEBUG((DEBUG_ERROR,"%a: Unable to create file %s. Code = %r\n", __FUNCTION__, PrtScrnFileName, Status));
-            goto Exit;
-        }
-
-        //
-        // 4. Write the contents of the display to the new file
-        //
-        Status = WriteBmpToFile (FileHandle);
+        Status = CaptureScreen ();
         if (!EFI_ERROR(Status)) {
-            DEBUG((DEBUG_INFO,"%a: Screen captured to file %s.\n", __FUNCTION__, PrtScrnFileName));
-        }
-        //
-        // 4. Close the bitmap file
-        //
-        Status2 = FileHandle->Close (FileHandle);
-        if (EFI_ERROR(Status2)) {
-            DEBUG((DEBUG_ERROR,"%a: Error closing bit map file %s. Code = %r\n", __FUNCTION__, PrtScrnFileName, Status2));
-        }
-Exit:
-        //
-        // 5. Close the USB volume
-        //
-        Status2 = VolumeHandle->Close (VolumeHandle);
-        if (EFI_ERROR(Status2)) {
-            DEBUG((DEBUG_ERROR,"%a: Error closing Vol Handle. Code = %r\n", __FUNCTION__, Status2));
+            gBS->SetTimer (gQueueEvent, TimerRelative, 0);
         }
     }
 
-    // Ignore future PrtScn requests for some period.  This is due to the make
-    // and break of PrtScn being identical, and it takes a few seconds to complete
-    // a single screen capture.
+    // Ignore the PrtScn break, which is identical to the make, and key
+    // repeats for a short period.
     Status = gBS->SetTimer (gTimerEvent, TimerRelative, PRINT_SCREEN_DELAY);
    
     return EFI_SUCCESS;
@@ -466,6 +1205,43 @@ UnRegisterNotifications (
         gBS->CloseEvent (gTimerEvent);
 
     }
+
+    if (gFsNotifyEvent != NULL) {
+        gBS->CloseEvent (gFsNotifyEvent);
+        gFsNotifyEvent = NULL;
+    }
+
+    if (gQueueEvent != NULL) {
+        gBS->SetTimer (gQueueEvent, TimerCancel, 0);
+        gBS->CloseEvent (gQueueEvent);
+        gQueueEvent = NULL;
+    }
+
+    for (i = 0; i < PRINT_SCREEN_QUEUE_DEPTH; i++) {
+        if (gCaptures[i].Pixels != NULL) {
+            FreePool (gCaptures[i].Pixels);
+            gCaptures[i].Pixels = NULL;
+            gCaptures[i].BufferSize = 0;
+        }
+        if (gCaptures[i].Text != NULL) {
+            FreePool (gCaptures[i].Text);
+            gCaptures[i].Text = NULL;
+            gCaptures[i].TextSize = 0;
+        }
+    }
+    gCaptureCount = 0;
+
+    if (gSparePixels != NULL) {
+        FreePool (gSparePixels);
+        gSparePixels = NULL;
+        gSpareSize = 0;
+    }
+
+    ShutdownScreenRecorder ();
+
+    ShutdownTextShadow ();
+
+    ReleasePrintScreenVolume ();
 }
 
 /**
@@ -562,6 +1338,53 @@ PrintScreenLoggerEntry (
                 Status = gBS->SignalEvent (gTimerEvent);                
             }
         }
+
+        if (!EFI_ERROR(Status)) {
+            //
+            // 5. Create the timer that writes queued captures to the drive
+            //
+            Status = gBS->CreateEvent(
+                                EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                                TPL_CALLBACK,
+                                WriteQueuedCapture,
+                                NULL,
+                                &gQueueEvent);
+        }
+
+        if (!EFI_ERROR(Status)) {
+            //
+            // 6. Create the Ctrl-Shift-PrtScn screen recording timer
+            //
+            Status = InitializeScreenRecorder ();
+        }
+
+        if (!EFI_ERROR(Status)) {
+            //
+            // 7. Drop the cached USB volume when a file system is installed
+            //
+            Status = gBS->CreateEvent(
+                                EVT_NOTIFY_SIGNAL,
+                                TPL_CALLBACK,
+                                FileSystemNotify,
+                                NULL,
+                                &gFsNotifyEvent);
+            if (!EFI_ERROR(Status)) {
+                Status = gBS->RegisterProtocolNotify (
+                                &gEfiSimpleFileSystemProtocolGuid,
+                                gFsNotifyEvent,
+                                &gFsNotifyRegistration);
+            }
+        }
+
+        if (!EFI_ERROR(Status) && (PcdGet8 (PcdPrintScreenText) != PRINT_SCREEN_TEXT_NONE)) {
+            //
+            // 8. Keep a copy of the text console for text captures.  Without
+            //    it captures are images only.
+            //
+            if (EFI_ERROR(InitializeTextShadow ())) {
+                DEBUG((DEBUG_WARN, "%a: No text console, text captures disabled\n", __FUNCTION__));
+            }
+        }
  
         if (!EFI_ERROR(Status)) {
             DEBUG((DEBUG_INFO, "%a: exit. Ready for Ctl-PrtScn operation\n", __FUNCTION__));                
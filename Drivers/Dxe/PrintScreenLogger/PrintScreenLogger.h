@@ -35,6 +35,8 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <Uefi.h>
 #include <Uefi/UefiInternalFormRepresentation.h>
 
+#include <Guid/FileInfo.h>
+
 #include <IndustryStandard/Bmp.h>
 
 #include <Protocol/GraphicsOutput.h>
@@ -42,24 +44,440 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <Protocol/SimpleTextInEx.h>
 
 #include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/DevicePathLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
 #include <Library/PrintLib.h>
+#include <Library/TimerLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
 
 #define PRINT_SCREEN_ENABLE_FILENAME   L"PrintScreenEnable.txt"
 #define MAX_PRINT_SCREEN_FILES         512
 #define PRINT_SCREEN_DEBUG_WARNING     32
+#define PRINT_SCREEN_FILE_NAME_SIZE    sizeof (L"PrtScreen####.bmp")
+
+//
+// Most bytes of a BMP image converted and written at a time.
+//
+#define PRINT_SCREEN_BAND_SIZE         SIZE_128KB
+
+//
+// Captures that can wait to be written.  A capture taken while the queue is
+// full is dropped.
+//
+#define PRINT_SCREEN_QUEUE_DEPTH       4
 
 //
 // Print Screen Delay.  There appears to be no way to see the difference between
 // PrtScn key down and key up.  So, we get called twice.  Also, the PrtScn key appears
 // to have repeat enabled.  To prevent duplicate screen captures, this code ignores
-// PrtScn keys for 3 seconds after completing a PrtScn.
+// PrtScn keys for 250ms after taking a capture.  Captures are written after the
+// key notification returns, so this does not cover the time spent writing.
+//
+// 250 ms in 100ns intervals = 250 * us in 1 ms * 100ns in 1us
+#define PRINT_SCREEN_DELAY       (250 * 1000       * 10)
+
+//
+// PcdPrintScreenText values: what a capture writes for the text console.
+//
+#define PRINT_SCREEN_TEXT_NONE         0    // Image only
+#define PRINT_SCREEN_TEXT_ALONGSIDE    1    // PrtScreen####.txt next to the image
+#define PRINT_SCREEN_TEXT_ONLY         2    // Text only, the image when there is no text
+
+//
+// A copy of the screen, in Blt pixels, and of the text console waiting in
+// the capture queue.  Pixels is released once the capture has been written;
+// the text buffer is small and kept for later captures.  When there is no
+// pool for a copy, Pixels is NULL with Width set and the screen is read a
+// band at a time when the capture is written.
+//
+typedef struct {
+    EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Pixels;      // Width * Height pixels, top row first, or NULL
+    UINTN                          BufferSize;  // Bytes allocated at Pixels
+    UINT32                         Width;       // 0 when the image was not captured
+    UINT32                         Height;
+    CHAR16                        *Text;        // Columns * Rows characters, top row first
+    UINTN                          TextSize;    // Bytes allocated at Text
+    UINT32                         Columns;     // 0 when the text was not captured
+    UINT32                         Rows;
+} PRINT_SCREEN_CAPTURE;
+
+/**
+  Convert a row of Blt pixels to packed 24bpp pixels.
+
+  @param  Dest      Count * 3 bytes.
+  @param  Src       The Blt pixels.
+  @param  Count     Number of pixels.
+
+**/
+typedef
+VOID
+(*PRINT_SCREEN_ROW_CONVERTER) (
+  OUT UINT8                                *Dest,
+  IN  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Src,
+  IN  UINTN                                Count
+  );
+
+/**
+  Convert Blt pixels to 24bpp pixels, blue first, as in a BMP.
+
+  @param  Dest      Count * 3 bytes.
+  @param  Src       The Blt pixels.
+  @param  Count     Number of pixels.
+
+**/
+VOID
+ConvertRowToBgr (
+  OUT UINT8                                *Dest,
+  IN  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Src,
+  IN  UINTN                                Count
+  );
+
+/**
+  Convert Blt pixels to 24bpp pixels, red first, as in a PNG.
+
+  @param  Dest      Count * 3 bytes.
+  @param  Src       The Blt pixels.
+  @param  Count     Number of pixels.
+
+**/
+VOID
+ConvertRowToRgb (
+  OUT UINT8                                *Dest,
+  IN  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Src,
+  IN  UINTN                                Count
+  );
+
+/**
+  Convert Blt pixels to 24bpp pixels with one SSSE3 shuffle per four pixels.
+
+  @param  Dest      Count * 3 bytes.
+  @param  Src       The Blt pixels.
+  @param  Count     Number of pixels, a multiple of 4.
+  @param  RedFirst  TRUE for red first pixels, FALSE for blue first.
+
+**/
+VOID
+EFIAPI
+AsmConvertRowSsse3 (
+  OUT UINT8                                *Dest,
+  IN  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Src,
+  IN  UINTN                                Count,
+  IN  BOOLEAN                              RedFirst
+  );
+
+/**
+  Choose the fastest row converter for a byte order.
+
+  @param  RedFirst  TRUE for red first pixels, FALSE for blue first.
+
+  @return The row converter.
+
+**/
+PRINT_SCREEN_ROW_CONVERTER
+GetRowConverter (
+  IN BOOLEAN  RedFirst
+  );
+
+//
+// Extraction of one channel of a PixelBitMask pixel as 8 bits:
+// ((Pixel >> Shift) & Mask) * Scale >> 16.
+//
+typedef struct {
+    UINT32  Shift;
+    UINT32  Mask;
+    UINT32  Scale;
+} PIXEL_CHANNEL;
+
+typedef struct {
+    PIXEL_CHANNEL  Red;
+    PIXEL_CHANNEL  Green;
+    PIXEL_CHANNEL  Blue;
+    UINTN          BytesPerPixel;   // Frame buffer bytes per pixel, 1 to 4
+} PIXEL_MASK_CONVERTER;
+
+/**
+  Work out how to convert the pixels of a PixelBitMask mode to Blt pixels.
+
+  @param  Converter     Receives the channel extraction of the mode.
+  @param  PixelMask     The mode's pixel bit masks.
+
+  @retval EFI_SUCCESS       Converter is ready.
+  @retval EFI_UNSUPPORTED   The pixels are wider than 32 bits or have no bits.
+
+**/
+EFI_STATUS
+InitPixelMaskConverter (
+  OUT PIXEL_MASK_CONVERTER     *Converter,
+  IN  CONST EFI_PIXEL_BITMASK  *PixelMask
+  );
+
+/**
+  Convert a row of PixelBitMask pixels to Blt pixels in place.  The packed
+  frame buffer pixels are at the end of the row, in its last
+  Count * BytesPerPixel bytes.
+
+  @param  Converter     The channel extraction of the mode.
+  @param  Row           Count Blt pixels.
+  @param  Count         Number of pixels.
+
+**/
+VOID
+ConvertMaskedRow (
+  IN     CONST PIXEL_MASK_CONVERTER     *Converter,
+  IN OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Row,
+  IN     UINTN                          Count
+  );
+
+/**
+  Read rows of the screen as Blt pixels.  PixelBitMask modes are read from
+  the frame buffer, as GOP drivers often cannot Blt them.
+
+  @param  Gop       The graphics output protocol.
+  @param  Buffer    Receives Rows full width rows of Blt pixels.
+  @param  Y         The first row.
+  @param  Rows      Number of rows.
+
+  @retval EFI_SUCCESS       The rows were read.
+  @retval EFI_UNSUPPORTED   The mode's pixels cannot be read.
+  @retval Others            Blt failed.
+
+**/
+EFI_STATUS
+ReadScreen (
+  IN  EFI_GRAPHICS_OUTPUT_PROTOCOL   *Gop,
+  OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Buffer,
+  IN  UINT32                         Y,
+  IN  UINT32                         Rows
+  );
+
+//
+// Bytes of compressed data written per PNG IDAT chunk.
+//
+#define PNG_IDAT_SIZE            SIZE_64KB
+
+typedef struct {
+    EFI_FILE_PROTOCOL  *File;
+    EFI_STATUS          Status;         // First error writing the file
+    UINTN               RowBytes;
+    UINT8              *Row;            // Filtered row, then the previous row
+    UINT8              *Window;         // Two deflate windows of filtered data
+    UINTN               WindowEnd;
+    UINTN               Position;       // Next window byte to compress
+    UINT32             *Head;           // Last window position + 1 of each hash
+    UINT8              *Chunk;          // IDAT chunk being filled
+    UINTN               ChunkLength;
+    UINT32              BitBuffer;
+    UINTN               BitCount;
+    UINT32              Adler1;
+    UINT32              Adler2;
+} PNG_ENCODER;
+
+/**
+  Start a PNG file: write the signature and header, and set up the encoder.
+
+  @param  Encoder       The encoder.
+  @param  FileHandle    The file to write.
+  @param  Width         Image width in pixels.
+  @param  Height        Image height in pixels.
+
+  @retval EFI_SUCCESS           The encoder is ready for Height rows.
+  @retval EFI_OUT_OF_RESOURCES  No enough buffer to allocate.
+  @retval Others                Writing the file failed.
+
+**/
+EFI_STATUS
+PngEncoderStart (
+  OUT PNG_ENCODER        *Encoder,
+  IN  EFI_FILE_PROTOCOL  *FileHandle,
+  IN  UINT32             Width,
+  IN  UINT32             Height
+  );
+
+/**
+  Add a row of the image.
+
+  @param  Encoder   The encoder.
+  @param  Pixels    Width pixels of 3 bytes, red first.
+
+**/
+VOID
+PngEncoderWriteRow (
+  IN OUT PNG_ENCODER  *Encoder,
+  IN     CONST UINT8  *Pixels
+  );
+
+/**
+  Finish the PNG file after the last row and free the encoder.
+
+  @param  Encoder   The encoder.
+
+  @retval EFI_SUCCESS   The file was written.
+  @retval Others        Writing the file failed.
+
+**/
+EFI_STATUS
+PngEncoderFinish (
+  IN OUT PNG_ENCODER  *Encoder
+  );
+
+/**
+  Free the buffers of an encoder, abandoning the image.
+
+  @param  Encoder   The encoder.
+
+**/
+VOID
+PngEncoderFree (
+  IN OUT PNG_ENCODER  *Encoder
+  );
+
 //
-// 3 seconds in 100ns intervals = 3 * ms in 1 second * us in 1 ms * 100ns in 1us
-#define PRINT_SCREEN_DELAY       (3 * 1000           * 1000       * 10)
+// Screen recordings, PrtScreen####.psr, hold the screen size and then one
+// record per sample in which the screen changed.  The screen is split into
+// PRINT_SCREEN_TILE_SIZE square tiles and a sample stores each run of changed
+// tiles in a tile row as a rectangle of 24bpp pixels, blue first, top row
+// first.  A frame's rectangles end with one of zero width.  Stopping the
+// recording writes a frame with no rectangles, which gives the end time.
+// All fields are little endian.
+//
+#define PRINT_SCREEN_TILE_SIZE         32
+#define PRINT_SCREEN_RECORD_SIGNATURE  SIGNATURE_32 ('P', 'S', 'R', 'C')
+#define PRINT_SCREEN_FRAME_SIGNATURE   SIGNATURE_32 ('P', 'S', 'R', 'F')
+#define PRINT_SCREEN_RECORD_VERSION    1
+
+#pragma pack(1)
+
+typedef struct {
+    UINT32  Signature;              // PRINT_SCREEN_RECORD_SIGNATURE
+    UINT16  Version;                // PRINT_SCREEN_RECORD_VERSION
+    UINT16  TileSize;
+    UINT32  Width;
+    UINT32  Height;
+    UINT32  Interval;               // Milliseconds between samples
+} PRINT_SCREEN_RECORD_HEADER;
+
+typedef struct {
+    UINT32  Signature;              // PRINT_SCREEN_FRAME_SIGNATURE
+    UINT32  Sample;                 // Samples taken before this one
+    UINT32  Time;                   // Milliseconds since the first sample, 0 without a TimerLib
+} PRINT_SCREEN_FRAME_HEADER;
+
+typedef struct {
+    UINT16  X;
+    UINT16  Y;
+    UINT16  Width;                  // 0 ends the frame
+    UINT16  Height;
+} PRINT_SCREEN_RECORD_RECT;         // Followed by Width * Height * 3 bytes
+
+#pragma pack()
+
+/**
+  Create the next PrtScreen#### file on the enabled USB drive.
+
+  @param  Extension     The file name extension, three characters.
+  @param  FileName      Receives the file name; PRINT_SCREEN_FILE_NAME_SIZE bytes.
+  @param  FileHandle    The created file.
+
+  @retval EFI_SUCCESS   The file was created.
+  @retval Others        No enabled drive was found or the file could not be created.
+
+**/
+EFI_STATUS
+CreatePrintScreenFile (
+  IN  CONST CHAR16       *Extension,
+  OUT CHAR16             *FileName,
+  OUT EFI_FILE_PROTOCOL  **FileHandle
+  );
+
+/**
+  Create the screen recording timer.
+
+  @retval EFI_SUCCESS   The recorder is ready.
+  @retval Others        The timer could not be created.
+
+**/
+EFI_STATUS
+InitializeScreenRecorder (
+  VOID
+  );
+
+/**
+  Start a screen recording, or stop the one running.  Called from the key
+  notification; the recording timer opens and closes the file.
+
+**/
+VOID
+ToggleScreenRecording (
+  VOID
+  );
+
+/**
+  Stop any screen recording and close the recording timer.
+
+**/
+VOID
+ShutdownScreenRecorder (
+  VOID
+  );
+
+/**
+  Start keeping a copy of the text console by hooking the system table's
+  ConOut.
+
+  @retval EFI_SUCCESS       The text console is shadowed.
+  @retval EFI_NOT_READY     There is no console output yet.
+
+**/
+EFI_STATUS
+InitializeTextShadow (
+  VOID
+  );
+
+/**
+  Unhook ConOut and free the shadow screen.
+
+**/
+VOID
+ShutdownTextShadow (
+  VOID
+  );
+
+/**
+  Copy the shadow text screen into a capture slot, growing the slot's text
+  buffer if needed.
+
+  @param  Capture       The capture slot.  Columns and Rows are 0 when no
+                        text is captured.
+
+  @retval EFI_SUCCESS           The text was captured.
+  @retval EFI_NOT_READY         The text console is not shadowed.
+  @retval EFI_OUT_OF_RESOURCES  No enough buffer to allocate.
+
+**/
+EFI_STATUS
+CaptureText (
+  IN OUT PRINT_SCREEN_CAPTURE  *Capture
+  );
+
+/**
+  Write captured text as UTF-8, one line per row without trailing spaces.
+
+  @param  FileHandle    The file to write.
+  @param  Capture       The captured text.
+
+  @retval EFI_SUCCESS           The text was written.
+  @retval EFI_OUT_OF_RESOURCES  No enough buffer to allocate.
+  @retval Others                The file could not be written.
+
+**/
+EFI_STATUS
+WriteTextToFile (
+  IN EFI_FILE_PROTOCOL     *FileHandle,
+  IN PRINT_SCREEN_CAPTURE  *Capture
+  );
 
 #endif  // __PRINTSCREEN_LOGGER_H__
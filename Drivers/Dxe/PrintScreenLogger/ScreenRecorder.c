@@ -0,0 +1,547 @@
+/** @file
+  ScreenRecorder.c
+
+  Ctrl-Shift-PrtScn screen recording for the print screen logger.  While a
+  recording runs, a timer reads the screen every PcdPrintScreenRecordInterval
+  milliseconds, one row of tiles at a time, hashes each tile and writes only
+  the tiles whose hash changed since the previous sample.  The cost of a
+  sample beyond reading the screen, and the size of the file, follow how much
+  of the screen changed.  Tools/Python/ScreenRecording/PsrToVideo.py turns a
+  recording into a video.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include "PrintScreenLogger.h"
+
+#define FNV_OFFSET_BASIS     0x811C9DC5
+#define FNV_PRIME            0x01000193
+
+typedef struct {
+    EFI_FILE_PROTOCOL             *File;
+    CHAR16                         FileName[PRINT_SCREEN_FILE_NAME_SIZE / sizeof (CHAR16)];
+    EFI_STATUS                     Status;      // First error writing the file
+    UINT32                         Width;
+    UINT32                         Height;
+    UINTN                          TilesX;
+    UINTN                          TilesY;
+    UINT32                        *TileHash;    // Hash of each tile at the last sample
+    EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Band;        // One row of tiles
+    UINT8                         *Buffer;      // Data waiting to be written
+    UINTN                          BufferSize;
+    UINTN                          BufferLength;
+    BOOLEAN                        FrameOpen;   // A frame header was written and not yet ended
+    UINT32                         Sample;
+    UINT64                         ElapsedNs;
+    UINT64                         LastTicks;
+    PRINT_SCREEN_ROW_CONVERTER     ConvertRow;
+} SCREEN_RECORDER;
+
+STATIC SCREEN_RECORDER  mRecorder;
+STATIC BOOLEAN          mRecordRequested = FALSE;
+STATIC EFI_EVENT        mRecordEvent     = NULL;
+
+/**
+  Write the buffered recording data to the file.
+
+**/
+STATIC
+VOID
+RecordFlush (
+  VOID
+  )
+{
+    UINTN  Size;
+
+    if ((mRecorder.BufferLength != 0) && !EFI_ERROR(mRecorder.Status)) {
+        Size = mRecorder.BufferLength;
+        mRecorder.Status = mRecorder.File->Write (mRecorder.File, &Size, mRecorder.Buffer);
+        if (!EFI_ERROR(mRecorder.Status) && (Size != mRecorder.BufferLength)) {
+            mRecorder.Status = EFI_BAD_BUFFER_SIZE;
+        }
+    }
+    mRecorder.BufferLength = 0;
+}
+
+/**
+  Reserve space at the end of the write buffer, flushing it if it is full.
+
+  @param  Size      Bytes needed, at most BufferSize.
+
+  @return Where to put the data.
+
+**/
+STATIC
+UINT8 *
+RecordReserve (
+  IN UINTN  Size
+  )
+{
+    UINT8  *Data;
+
+    if (mRecorder.BufferLength + Size > mRecorder.BufferSize) {
+        RecordFlush ();
+    }
+    Data = mRecorder.Buffer + mRecorder.BufferLength;
+    mRecorder.BufferLength += Size;
+    return Data;
+}
+
+/**
+  Add the time since the last sample to the recording time.
+
+**/
+STATIC
+VOID
+RecordUpdateTime (
+  VOID
+  )
+{
+    UINT64  Ticks;
+    UINT64  Delta;
+    UINT64  CounterStart;
+    UINT64  CounterEnd;
+
+    Ticks = GetPerformanceCounter ();
+    GetPerformanceCounterProperties (&CounterStart, &CounterEnd);
+
+    if (CounterStart > CounterEnd) {
+        if (mRecorder.LastTicks >= Ticks) {
+            Delta = mRecorder.LastTicks - Ticks;
+        } else {
+            Delta = (mRecorder.LastTicks - CounterEnd) + (CounterStart - Ticks);
+        }
+    } else {
+        if (Ticks >= mRecorder.LastTicks) {
+            Delta = Ticks - mRecorder.LastTicks;
+        } else {
+            Delta = (Ticks - CounterStart) + (CounterEnd - mRecorder.LastTicks);
+        }
+    }
+
+    mRecorder.ElapsedNs += GetTimeInNanoSecond (Delta);
+    mRecorder.LastTicks = Ticks;
+}
+
+/**
+  Write the header of the current frame.
+
+**/
+STATIC
+VOID
+RecordFrameHeader (
+  VOID
+  )
+{
+    PRINT_SCREEN_FRAME_HEADER  *Frame;
+
+    Frame = (PRINT_SCREEN_FRAME_HEADER *)RecordReserve (sizeof (*Frame));
+    Frame->Signature = PRINT_SCREEN_FRAME_SIGNATURE;
+    Frame->Sample = mRecorder.Sample;
+    Frame->Time = (UINT32)DivU64x32 (mRecorder.ElapsedNs, 1000000);
+    mRecorder.FrameOpen = TRUE;
+}
+
+/**
+  Write a rectangle of the band, or the end of a frame.
+
+  @param  X         Left of the rectangle.
+  @param  Y         Top of the rectangle on the screen.
+  @param  Width     Width of the rectangle; 0 ends the frame.
+  @param  Height    Rows of the band in the rectangle.
+
+**/
+STATIC
+VOID
+RecordRect (
+  IN UINT32  X,
+  IN UINT32  Y,
+  IN UINT32  Width,
+  IN UINT32  Height
+  )
+{
+    PRINT_SCREEN_RECORD_RECT  *Rect;
+    UINT32                     Row;
+
+    Rect = (PRINT_SCREEN_RECORD_RECT *)RecordReserve (sizeof (*Rect));
+    Rect->X = (UINT16)X;
+    Rect->Y = (UINT16)Y;
+    Rect->Width = (UINT16)Width;
+    Rect->Height = (UINT16)Height;
+
+    //
+    // Blt pixels are blue first, as the recording stores them.
+    //
+    for (Row = 0; (Width != 0) && (Row < Height); Row++) {
+        mRecorder.ConvertRow (RecordReserve (Width * 3),
+                              mRecorder.Band + (UINTN)Row * mRecorder.Width + X,
+                              Width);
+    }
+}
+
+/**
+  End the frame of the current sample, if one was started.
+
+**/
+STATIC
+VOID
+RecordFrameEnd (
+  VOID
+  )
+{
+    if (mRecorder.FrameOpen) {
+        RecordRect (0, 0, 0, 0);
+        mRecorder.FrameOpen = FALSE;
+    }
+}
+
+/**
+  Hash the pixels of a tile.
+
+  @param  Pixels    Top left pixel of the tile.
+  @param  Stride    Pixels per screen row.
+  @param  Width     Tile width.
+  @param  Height    Tile height.
+
+  @return The FNV-1a hash of the tile's pixels.
+
+**/
+STATIC
+UINT32
+HashTile (
+  IN CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Pixels,
+  IN UINTN                                Stride,
+  IN UINTN                                Width,
+  IN UINTN                                Height
+  )
+{
+    CONST UINT32  *Pixel;
+    UINT32         Hash;
+    UINTN          Row;
+    UINTN          Column;
+
+    Hash = FNV_OFFSET_BASIS;
+    for (Row = 0; Row < Height; Row++) {
+        Pixel = (CONST UINT32 *)(Pixels + Row * Stride);
+        for (Column = 0; Column < Width; Column++) {
+            //
+            // The reserved byte is undefined, so leave it out.
+            //
+            Hash = (Hash ^ (Pixel[Column] & 0x00FFFFFF)) * FNV_PRIME;
+        }
+    }
+    return Hash;
+}
+
+/**
+  Sample the screen and write the tiles that changed since the last sample.
+
+  @param  Gop       The graphics output protocol.
+
+  @retval EFI_SUCCESS   The sample was written.
+  @retval Others        The screen could not be read or the file written.
+
+**/
+STATIC
+EFI_STATUS
+RecordFrame (
+  IN EFI_GRAPHICS_OUTPUT_PROTOCOL  *Gop
+  )
+{
+    EFI_STATUS  Status;
+    UINTN       TileX;
+    UINTN       TileY;
+    UINTN       RunStart;
+    UINT32      Y;
+    UINT32      Rows;
+    UINT32      Columns;
+    UINT32      Hash;
+    UINT32      *TileHash;
+    BOOLEAN     Dirty;
+
+    RecordUpdateTime ();
+
+    for (TileY = 0; TileY < mRecorder.TilesY; TileY++) {
+        Y = (UINT32)(TileY * PRINT_SCREEN_TILE_SIZE);
+        Rows = MIN (PRINT_SCREEN_TILE_SIZE, mRecorder.Height - Y);
+        Status = ReadScreen (Gop, mRecorder.Band, Y, Rows);
+        if (EFI_ERROR(Status)) {
+            //
+            // Close the rectangles of the earlier bands, if any, so that the
+            // file stays readable.
+            //
+            RecordFrameEnd ();
+            return Status;
+        }
+
+        //
+        // Write each run of changed tiles as one rectangle.  The pass past the
+        // last tile ends a run that reaches the right edge.
+        //
+        TileHash = mRecorder.TileHash + TileY * mRecorder.TilesX;
+        RunStart = MAX_UINTN;
+        for (TileX = 0; TileX <= mRecorder.TilesX; TileX++) {
+            Dirty = FALSE;
+            if (TileX < mRecorder.TilesX) {
+                Columns = MIN (PRINT_SCREEN_TILE_SIZE, mRecorder.Width - (UINT32)(TileX * PRINT_SCREEN_TILE_SIZE));
+                Hash = HashTile (mRecorder.Band + TileX * PRINT_SCREEN_TILE_SIZE, mRecorder.Width, Columns, Rows);
+                Dirty = (mRecorder.Sample == 0) || (Hash != TileHash[TileX]);
+                TileHash[TileX] = Hash;
+            }
+
+            if (Dirty && (RunStart == MAX_UINTN)) {
+                RunStart = TileX;
+            } else if (!Dirty && (RunStart != MAX_UINTN)) {
+                if (!mRecorder.FrameOpen) {
+                    RecordFrameHeader ();
+                }
+                RecordRect ((UINT32)(RunStart * PRINT_SCREEN_TILE_SIZE),
+                            Y,
+                            MIN (mRecorder.Width, (UINT32)(TileX * PRINT_SCREEN_TILE_SIZE)) - (UINT32)(RunStart * PRINT_SCREEN_TILE_SIZE),
+                            Rows);
+                RunStart = MAX_UINTN;
+            }
+        }
+    }
+
+    RecordFrameEnd ();
+    mRecorder.Sample++;
+
+    return mRecorder.Status;
+}
+
+/**
+  Free the recorder's buffers.
+
+**/
+STATIC
+VOID
+FreeRecorder (
+  VOID
+  )
+{
+    if (mRecorder.TileHash != NULL) {
+        FreePool (mRecorder.TileHash);
+    }
+    if (mRecorder.Band != NULL) {
+        FreePool (mRecorder.Band);
+    }
+    if (mRecorder.Buffer != NULL) {
+        FreePool (mRecorder.Buffer);
+    }
+    ZeroMem (&mRecorder, sizeof (mRecorder));
+}
+
+/**
+  Create the next PrtScreen####.psr file and write its header.
+
+  @param  Gop       The graphics output protocol.
+
+  @retval EFI_SUCCESS           The recording is started.
+  @retval EFI_UNSUPPORTED       The screen is too large for the recording format.
+  @retval EFI_OUT_OF_RESOURCES  No enough buffer to allocate.
+  @retval Others                The file could not be created.
+
+**/
+STATIC
+EFI_STATUS
+StartRecording (
+  IN EFI_GRAPHICS_OUTPUT_PROTOCOL  *Gop
+  )
+{
+    EFI_STATUS                   Status;
+    PRINT_SCREEN_RECORD_HEADER  *Header;
+
+    mRecorder.Width = Gop->Mode->Info->HorizontalResolution;
+    mRecorder.Height = Gop->Mode->Info->VerticalResolution;
+    if ((mRecorder.Width > MAX_UINT16) || (mRecorder.Height > MAX_UINT16)) {
+        return EFI_UNSUPPORTED;
+    }
+
+    mRecorder.TilesX = (mRecorder.Width + PRINT_SCREEN_TILE_SIZE - 1) / PRINT_SCREEN_TILE_SIZE;
+    mRecorder.TilesY = (mRecorder.Height + PRINT_SCREEN_TILE_SIZE - 1) / PRINT_SCREEN_TILE_SIZE;
+    mRecorder.BufferSize = MAX (SIZE_64KB, mRecorder.Width * 3);
+    mRecorder.TileHash = AllocatePool (mRecorder.TilesX * mRecorder.TilesY * sizeof (UINT32));
+    mRecorder.Band = AllocatePool ((UINTN)mRecorder.Width * PRINT_SCREEN_TILE_SIZE * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+    mRecorder.Buffer = AllocatePool (mRecorder.BufferSize);
+    if ((mRecorder.TileHash == NULL) || (mRecorder.Band == NULL) || (mRecorder.Buffer == NULL)) {
+        FreeRecorder ();
+        return EFI_OUT_OF_RESOURCES;
+    }
+
+    Status = CreatePrintScreenFile (L"psr", mRecorder.FileName, &mRecorder.File);
+    if (EFI_ERROR(Status)) {
+        FreeRecorder ();
+        return Status;
+    }
+
+    mRecorder.ConvertRow = GetRowConverter (FALSE);
+    mRecorder.LastTicks = GetPerformanceCounter ();
+
+    Header = (PRINT_SCREEN_RECORD_HEADER *)RecordReserve (sizeof (*Header));
+    Header->Signature = PRINT_SCREEN_RECORD_SIGNATURE;
+    Header->Version = PRINT_SCREEN_RECORD_VERSION;
+    Header->TileSize = PRINT_SCREEN_TILE_SIZE;
+    Header->Width = mRecorder.Width;
+    Header->Height = mRecorder.Height;
+    Header->Interval = PcdGet32 (PcdPrintScreenRecordInterval);
+
+    DEBUG((DEBUG_INFO, "%a: Recording the screen to %s.\n", __FUNCTION__, mRecorder.FileName));
+    return EFI_SUCCESS;
+}
+
+/**
+  Write the end frame and close the recording.
+
+**/
+STATIC
+VOID
+StopRecording (
+  VOID
+  )
+{
+    EFI_STATUS  Status;
+
+    //
+    // The end frame must not land inside a frame that is still open.
+    //
+    RecordFrameEnd ();
+    RecordUpdateTime ();
+    RecordFrameHeader ();
+    RecordFrameEnd ();
+    RecordFlush ();
+    if (EFI_ERROR(mRecorder.Status)) {
+        DEBUG((DEBUG_ERROR, "%a: Error writing %s. Code = %r\n", __FUNCTION__, mRecorder.FileName, mRecorder.Status));
+    }
+
+    Status = mRecorder.File->Close (mRecorder.File);
+    if (EFI_ERROR(Status)) {
+        DEBUG((DEBUG_ERROR, "%a: Error closing %s. Code = %r\n", __FUNCTION__, mRecorder.FileName, Status));
+    } else {
+        DEBUG((DEBUG_INFO, "%a: %d samples recorded to %s.\n", __FUNCTION__, mRecorder.Sample, mRecorder.FileName));
+    }
+
+    FreeRecorder ();
+}
+
+/**
+  Recording timer handler.  Opens the recording on the first tick after it is
+  requested, takes a sample on each tick, and closes it once it is no longer
+  requested.  A mode change ends the file and starts a new one.
+
+  @param    Event           Not Used.
+  @param    Context         Not Used.
+
+**/
+STATIC
+VOID
+EFIAPI
+RecordScreen (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+    EFI_STATUS                     Status;
+    EFI_GRAPHICS_OUTPUT_PROTOCOL   *Gop;
+
+    Gop = NULL;
+    Status = EFI_ABORTED;
+    if (mRecordRequested) {
+        Status = gBS->LocateProtocol (&gEfiGraphicsOutputProtocolGuid, NULL, (VOID **)&Gop);
+    }
+
+    if ((mRecorder.File != NULL) &&
+        (EFI_ERROR(Status) ||
+         (Gop->Mode->Info->HorizontalResolution != mRecorder.Width) ||
+         (Gop->Mode->Info->VerticalResolution != mRecorder.Height))) {
+        StopRecording ();
+    }
+
+    if (!EFI_ERROR(Status) && (mRecorder.File == NULL)) {
+        Status = StartRecording (Gop);
+    }
+
+    if (!EFI_ERROR(Status)) {
+        Status = RecordFrame (Gop);
+        if (EFI_ERROR(Status)) {
+            StopRecording ();
+        }
+    }
+
+    if (EFI_ERROR(Status)) {
+        if (mRecordRequested) {
+            DEBUG((DEBUG_ERROR, "%a: Screen recording stopped. Code = %r\n", __FUNCTION__, Status));
+        }
+        mRecordRequested = FALSE;
+        gBS->SetTimer (mRecordEvent, TimerCancel, 0);
+    }
+}
+
+/**
+  Create the screen recording timer.
+
+  @retval EFI_SUCCESS   The recorder is ready.
+  @retval Others        The timer could not be created.
+
+**/
+EFI_STATUS
+InitializeScreenRecorder (
+  VOID
+  )
+{
+    return gBS->CreateEvent (EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                             TPL_CALLBACK,
+                             RecordScreen,
+                             NULL,
+                             &mRecordEvent);
+}
+
+/**
+  Start a screen recording, or stop the one running.  Called from the key
+  notification; the recording timer opens and closes the file.
+
+**/
+VOID
+ToggleScreenRecording (
+  VOID
+  )
+{
+    mRecordRequested = !mRecordRequested;
+    if (mRecordRequested) {
+        DEBUG((DEBUG_INFO, "%a: Starting screen recording\n", __FUNCTION__));
+        gBS->SetTimer (mRecordEvent,
+                       TimerPeriodic,
+                       MultU64x32 (PcdGet32 (PcdPrintScreenRecordInterval), 10000));  // 100ns units
+    } else {
+        DEBUG((DEBUG_INFO, "%a: Stopping screen recording\n", __FUNCTION__));
+        gBS->SetTimer (mRecordEvent, TimerRelative, 0);
+    }
+}
+
+/**
+  Stop any screen recording and close the recording timer.
+
+**/
+VOID
+ShutdownScreenRecorder (
+  VOID
+  )
+{
+    if (mRecordEvent != NULL) {
+        gBS->SetTimer (mRecordEvent, TimerCancel, 0);
+        gBS->CloseEvent (mRecordEvent);
+        mRecordEvent = NULL;
+    }
+
+    mRecordRequested = FALSE;
+    if (mRecorder.File != NULL) {
+        StopRecording ();
+    }
+}
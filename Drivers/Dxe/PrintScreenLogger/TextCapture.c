@@ -0,0 +1,454 @@
+/** @file
+  TextCapture.c
+
+  Text console capture for the print screen logger.  The console output
+  protocol has no way to read back what is on the screen, so the logger keeps
+  its own copy: the system table's ConOut OutputString, ClearScreen, SetMode
+  and Reset are hooked to mirror the characters written into a shadow buffer,
+  which a capture copies and writes as a UTF-8 PrtScreen####.txt file.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include "PrintScreenLogger.h"
+
+//
+// ConSplitter and the console drivers take these as glyph width controls.
+//
+#define TEXT_WIDE_CHAR       0xFFF1
+#define TEXT_NARROW_CHAR     0xFFF2
+
+typedef struct {
+    EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *ConOut;
+    EFI_TEXT_RESET                    Reset;
+    EFI_TEXT_STRING                   OutputString;
+    EFI_TEXT_SET_MODE                 SetMode;
+    EFI_TEXT_CLEAR_SCREEN             ClearScreen;
+    CHAR16                           *Screen;       // Columns * Rows characters, top row first
+    UINTN                             Columns;
+    UINTN                             Rows;
+} TEXT_SHADOW;
+
+STATIC TEXT_SHADOW  mShadow;
+
+/**
+  Blank the shadow screen.
+
+**/
+STATIC
+VOID
+ShadowClear (
+  VOID
+  )
+{
+    if (mShadow.Screen != NULL) {
+        SetMem16 (mShadow.Screen, mShadow.Columns * mShadow.Rows * sizeof (CHAR16), L' ');
+    }
+}
+
+/**
+  Size the shadow screen to the current text mode and blank it.
+
+**/
+STATIC
+VOID
+ShadowResize (
+  VOID
+  )
+{
+    EFI_STATUS  Status;
+    CHAR16      *Screen;
+    UINTN       Columns;
+    UINTN       Rows;
+
+    Status = mShadow.ConOut->QueryMode (mShadow.ConOut, mShadow.ConOut->Mode->Mode, &Columns, &Rows);
+    if (EFI_ERROR(Status)) {
+        Columns = 0;
+        Rows = 0;
+    }
+
+    if ((Columns != mShadow.Columns) || (Rows != mShadow.Rows)) {
+        //
+        // A capture may interrupt this from the key notification, so the
+        // screen is detached before it is freed and sized before it is set.
+        //
+        Screen = mShadow.Screen;
+        mShadow.Screen = NULL;
+        if (Screen != NULL) {
+            FreePool (Screen);
+        }
+        mShadow.Columns = Columns;
+        mShadow.Rows = Rows;
+        if ((Columns != 0) && (Rows != 0)) {
+            mShadow.Screen = AllocatePool (Columns * Rows * sizeof (CHAR16));
+        }
+        if (mShadow.Screen == NULL) {
+            mShadow.Columns = 0;
+            mShadow.Rows = 0;
+        }
+    }
+
+    ShadowClear ();
+}
+
+/**
+  Move the cursor to the next row, scrolling the shadow screen up at the
+  bottom as the console does.
+
+  @param  Row       The cursor row.
+
+**/
+STATIC
+VOID
+ShadowNewLine (
+  IN OUT UINTN  *Row
+  )
+{
+    if (*Row + 1 < mShadow.Rows) {
+        (*Row)++;
+        return;
+    }
+
+    CopyMem (mShadow.Screen,
+             mShadow.Screen + mShadow.Columns,
+             (mShadow.Rows - 1) * mShadow.Columns * sizeof (CHAR16));
+    SetMem16 (mShadow.Screen + (mShadow.Rows - 1) * mShadow.Columns,
+              mShadow.Columns * sizeof (CHAR16),
+              L' ');
+}
+
+/**
+  OutputString hook.  Mirrors the string into the shadow screen from the
+  console's cursor position, then passes it on.
+
+  @param  This      The console output protocol.
+  @param  String    The string to display.
+
+  @return The status of the console's OutputString.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+ShadowOutputString (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN CHAR16                           *String
+  )
+{
+    CONST CHAR16  *Char;
+    UINTN         Column;
+    UINTN         Row;
+
+    if ((mShadow.Screen != NULL) &&
+        (This->Mode->CursorColumn >= 0) && ((UINTN)This->Mode->CursorColumn < mShadow.Columns) &&
+        (This->Mode->CursorRow >= 0) && ((UINTN)This->Mode->CursorRow < mShadow.Rows)) {
+        Column = (UINTN)This->Mode->CursorColumn;
+        Row = (UINTN)This->Mode->CursorRow;
+
+        for (Char = String; *Char != CHAR_NULL; Char++) {
+            switch (*Char) {
+            case CHAR_CARRIAGE_RETURN:
+                Column = 0;
+                break;
+
+            case CHAR_LINEFEED:
+                ShadowNewLine (&Row);
+                break;
+
+            case CHAR_BACKSPACE:
+                //
+                // The console erases the character before the cursor, back
+                // to the end of the previous row at the start of a row.
+                //
+                if (Column > 0) {
+                    Column--;
+                } else if (Row > 0) {
+                    Row--;
+                    Column = mShadow.Columns - 1;
+                }
+                mShadow.Screen[Row * mShadow.Columns + Column] = L' ';
+                break;
+
+            case TEXT_WIDE_CHAR:
+            case TEXT_NARROW_CHAR:
+                break;
+
+            default:
+                mShadow.Screen[Row * mShadow.Columns + Column] = *Char;
+                if (++Column == mShadow.Columns) {
+                    Column = 0;
+                    ShadowNewLine (&Row);
+                }
+                break;
+            }
+        }
+    }
+
+    return mShadow.OutputString (This, String);
+}
+
+/**
+  ClearScreen hook.
+
+  @param  This      The console output protocol.
+
+  @return The status of the console's ClearScreen.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+ShadowClearScreen (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This
+  )
+{
+    EFI_STATUS  Status;
+
+    Status = mShadow.ClearScreen (This);
+    if (!EFI_ERROR(Status)) {
+        ShadowClear ();
+    }
+    return Status;
+}
+
+/**
+  SetMode hook.
+
+  @param  This          The console output protocol.
+  @param  ModeNumber    The text mode to set.
+
+  @return The status of the console's SetMode.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+ShadowSetMode (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN UINTN                            ModeNumber
+  )
+{
+    EFI_STATUS  Status;
+
+    Status = mShadow.SetMode (This, ModeNumber);
+    if (!EFI_ERROR(Status)) {
+        ShadowResize ();
+    }
+    return Status;
+}
+
+/**
+  Reset hook.
+
+  @param  This                  The console output protocol.
+  @param  ExtendedVerification  Passed on to the console.
+
+  @return The status of the console's Reset.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+ShadowReset (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN BOOLEAN                          ExtendedVerification
+  )
+{
+    EFI_STATUS  Status;
+
+    Status = mShadow.Reset (This, ExtendedVerification);
+    if (!EFI_ERROR(Status)) {
+        ShadowResize ();
+    }
+    return Status;
+}
+
+/**
+  Start keeping a copy of the text console by hooking the system table's
+  ConOut.
+
+  @retval EFI_SUCCESS       The text console is shadowed.
+  @retval EFI_NOT_READY     There is no console output yet.
+
+**/
+EFI_STATUS
+InitializeTextShadow (
+  VOID
+  )
+{
+    EFI_TPL  OldTpl;
+
+    if ((gST->ConOut == NULL) || (gST->ConOut->Mode == NULL)) {
+        return EFI_NOT_READY;
+    }
+
+    mShadow.ConOut = gST->ConOut;
+    ShadowResize ();
+
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    mShadow.Reset = mShadow.ConOut->Reset;
+    mShadow.OutputString = mShadow.ConOut->OutputString;
+    mShadow.SetMode = mShadow.ConOut->SetMode;
+    mShadow.ClearScreen = mShadow.ConOut->ClearScreen;
+    mShadow.ConOut->Reset = ShadowReset;
+    mShadow.ConOut->OutputString = ShadowOutputString;
+    mShadow.ConOut->SetMode = ShadowSetMode;
+    mShadow.ConOut->ClearScreen = ShadowClearScreen;
+    gBS->RestoreTPL (OldTpl);
+
+    return EFI_SUCCESS;
+}
+
+/**
+  Unhook ConOut and free the shadow screen.
+
+**/
+VOID
+ShutdownTextShadow (
+  VOID
+  )
+{
+    EFI_TPL  OldTpl;
+
+    if (mShadow.ConOut == NULL) {
+        return;
+    }
+
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    mShadow.ConOut->Reset = mShadow.Reset;
+    mShadow.ConOut->OutputString = mShadow.OutputString;
+    mShadow.ConOut->SetMode = mShadow.SetMode;
+    mShadow.ConOut->ClearScreen = mShadow.ClearScreen;
+    gBS->RestoreTPL (OldTpl);
+
+    if (mShadow.Screen != NULL) {
+        FreePool (mShadow.Screen);
+    }
+    ZeroMem (&mShadow, sizeof (mShadow));
+}
+
+/**
+  Copy the shadow text screen into a capture slot, growing the slot's text
+  buffer if needed.
+
+  @param  Capture       The capture slot.  Columns and Rows are 0 when no
+                        text is captured.
+
+  @retval EFI_SUCCESS           The text was captured.
+  @retval EFI_NOT_READY         The text console is not shadowed.
+  @retval EFI_OUT_OF_RESOURCES  No enough buffer to allocate.
+
+**/
+EFI_STATUS
+CaptureText (
+  IN OUT PRINT_SCREEN_CAPTURE  *Capture
+  )
+{
+    UINTN  Size;
+
+    Capture->Columns = 0;
+    Capture->Rows = 0;
+    if (mShadow.Screen == NULL) {
+        return EFI_NOT_READY;
+    }
+
+    Size = mShadow.Columns * mShadow.Rows * sizeof (CHAR16);
+    if (Capture->TextSize < Size) {
+        if (Capture->Text != NULL) {
+            FreePool (Capture->Text);
+        }
+        Capture->TextSize = 0;
+        Capture->Text = AllocatePool (Size);
+        if (Capture->Text == NULL) {
+            return EFI_OUT_OF_RESOURCES;
+        }
+        Capture->TextSize = Size;
+    }
+
+    CopyMem (Capture->Text, mShadow.Screen, Size);
+    Capture->Columns = (UINT32)mShadow.Columns;
+    Capture->Rows = (UINT32)mShadow.Rows;
+
+    return EFI_SUCCESS;
+}
+
+/**
+  Write captured text as UTF-8, one line per row without trailing spaces.
+
+  @param  FileHandle    The file to write.
+  @param  Capture       The captured text.
+
+  @retval EFI_SUCCESS           The text was written.
+  @retval EFI_OUT_OF_RESOURCES  No enough buffer to allocate.
+  @retval Others                The file could not be written.
+
+**/
+EFI_STATUS
+WriteTextToFile (
+  IN EFI_FILE_PROTOCOL     *FileHandle,
+  IN PRINT_SCREEN_CAPTURE  *Capture
+  )
+{
+    EFI_STATUS     Status;
+    UINT8          *Buffer;
+    UINT8          *Utf8;
+    CONST CHAR16   *Line;
+    UINTN          Length;
+    UINTN          Size;
+    UINTN          WriteSize;
+    UINTN          Row;
+    UINTN          Column;
+    CHAR16         Char;
+
+    //
+    // Each UCS-2 character takes at most 3 bytes, and each row a newline.
+    //
+    Buffer = AllocatePool ((Capture->Columns * 3 + 1) * Capture->Rows);
+    if (Buffer == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+    }
+
+    Utf8 = Buffer;
+    for (Row = 0; Row < Capture->Rows; Row++) {
+        Line = Capture->Text + Row * Capture->Columns;
+        for (Length = Capture->Columns; (Length > 0) && (Line[Length - 1] == L' '); Length--) {
+        }
+
+        for (Column = 0; Column < Length; Column++) {
+            Char = Line[Column];
+            if ((Char < 0x20) || ((Char >= 0xD800) && (Char < 0xE000))) {
+                *Utf8++ = '?';
+            } else if (Char < 0x80) {
+                *Utf8++ = (UINT8)Char;
+            } else if (Char < 0x800) {
+                *Utf8++ = (UINT8)(0xC0 | (Char >> 6));
+                *Utf8++ = (UINT8)(0x80 | (Char & 0x3F));
+            } else {
+                *Utf8++ = (UINT8)(0xE0 | (Char >> 12));
+                *Utf8++ = (UINT8)(0x80 | ((Char >> 6) & 0x3F));
+                *Utf8++ = (UINT8)(0x80 | (Char & 0x3F));
+            }
+        }
+        *Utf8++ = '\n';
+    }
+
+    Size = Utf8 - Buffer;
+    WriteSize = Size;
+    Status = FileHandle->Write (FileHandle, &WriteSize, Buffer);
+    if (!EFI_ERROR(Status) && (WriteSize != Size)) {
+        Status = EFI_BAD_BUFFER_SIZE;
+    }
+    if (EFI_ERROR(Status)) {
+        DEBUG((DEBUG_ERROR, "Error writing text file. Code=%r\n", Status));
+    }
+
+    FreePool (Buffer);
+    return Status;
+}
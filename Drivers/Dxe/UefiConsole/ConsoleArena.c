@@ -0,0 +1,164 @@
+/** @file
+  Scratch arena for per-command allocations of the UEFI console.
+
+  The command line copies, the argument vector and the parsed parameter list
+  of a command all live until the command returns, so they are carved out of
+  one preallocated block and rewound together with ConsoleArenaReset().
+  Requests that do not fit fall back to the pool, so each buffer must still
+  be passed to ConsoleArenaFree(), which frees only those.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include "UefiConsole.h"
+
+STATIC UINT8  *mArenaBase = NULL;
+STATIC UINTN  mArenaTop   = 0;
+
+/**
+  Allocate the scratch arena.
+
+  @retval EFI_SUCCESS           The arena is ready to use.
+  @retval EFI_OUT_OF_RESOURCES  The arena could not be allocated; every
+                                request will be served from the pool.
+**/
+EFI_STATUS
+ConsoleArenaInit (
+  VOID
+  )
+{
+  mArenaTop  = 0;
+  mArenaBase = AllocatePool (CONSOLE_ARENA_SIZE);
+  return (mArenaBase == NULL) ? EFI_OUT_OF_RESOURCES : EFI_SUCCESS;
+}
+
+/**
+  Free the scratch arena.
+**/
+VOID
+ConsoleArenaDestroy (
+  VOID
+  )
+{
+  SHELL_FREE_NON_NULL (mArenaBase);
+  mArenaTop = 0;
+}
+
+/**
+  Get the current top of the arena, to be passed to ConsoleArenaReset().
+
+  @return The current arena mark.
+**/
+UINTN
+ConsoleArenaMark (
+  VOID
+  )
+{
+  return mArenaTop;
+}
+
+/**
+  Rewind the arena to Mark, reusing its space for later allocations.
+
+  Only the arena space is released.  Requests that fell back to the pool are
+  not tracked, so every buffer must still be passed to ConsoleArenaFree().
+
+  @param[in] Mark   A value returned by ConsoleArenaMark().
+**/
+VOID
+ConsoleArenaReset (
+  IN UINTN  Mark
+  )
+{
+  ASSERT (Mark <= mArenaTop);
+  mArenaTop = Mark;
+}
+
+/**
+  Allocate a zero-filled buffer from the arena, or from the pool if the arena
+  is full.
+
+  @param[in] AllocationSize   Number of bytes to allocate.
+
+  @return The buffer, or NULL if the pool is also exhausted.
+**/
+VOID *
+ConsoleArenaAllocateZero (
+  IN UINTN  AllocationSize
+  )
+{
+  VOID   *Buffer;
+  UINTN  Size;
+
+  Size = ALIGN_VALUE (AllocationSize, sizeof (UINT64));
+  if (mArenaBase == NULL || Size < AllocationSize || Size > CONSOLE_ARENA_SIZE - mArenaTop) {
+    return AllocateZeroPool (AllocationSize);
+  }
+
+  Buffer     = mArenaBase + mArenaTop;
+  mArenaTop += Size;
+  return ZeroMem (Buffer, AllocationSize);
+}
+
+/**
+  Allocate a copy of a buffer from the arena, or from the pool if the arena
+  is full.
+
+  @param[in] AllocationSize   Number of bytes to allocate and copy.
+  @param[in] Buffer           The buffer to copy.
+
+  @return The copy, or NULL if the pool is also exhausted.
+**/
+VOID *
+ConsoleArenaAllocateCopy (
+  IN UINTN       AllocationSize,
+  IN CONST VOID  *Buffer
+  )
+{
+  VOID   *Copy;
+  UINTN  Size;
+
+  ASSERT (Buffer != NULL);
+
+  Size = ALIGN_VALUE (AllocationSize, sizeof (UINT64));
+  if (mArenaBase == NULL || Size < AllocationSize || Size > CONSOLE_ARENA_SIZE - mArenaTop) {
+    return AllocateCopyPool (AllocationSize, Buffer);
+  }
+
+  Copy       = mArenaBase + mArenaTop;
+  mArenaTop += Size;
+  return CopyMem (Copy, Buffer, AllocationSize);
+}
+
+/**
+  Free a buffer returned by ConsoleArenaAllocateZero() or
+  ConsoleArenaAllocateCopy().  Arena buffers are left for ConsoleArenaReset();
+  pool buffers are freed immediately.  Call it for every buffer, since the
+  caller cannot tell which of the two it got.
+
+  @param[in] Buffer   The buffer to free.  NULL is ignored.
+**/
+VOID
+ConsoleArenaFree (
+  IN VOID  *Buffer
+  )
+{
+  if (Buffer == NULL) {
+    return;
+  }
+
+  if (mArenaBase != NULL &&
+      (UINT8 *) Buffer >= mArenaBase &&
+      (UINT8 *) Buffer <  mArenaBase + CONSOLE_ARENA_SIZE) {
+    return;
+  }
+
+  FreePool (Buffer);
+}
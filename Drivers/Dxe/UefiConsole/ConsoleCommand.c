@@ -14,6 +14,7 @@
 #include "UefiConsole.h"
 
 STATIC SHELL_COMMAND_INTERNAL_LIST_ENTRY  mCommandList;
+STATIC LIST_ENTRY                         mCommandHash[CONSOLE_COMMAND_HASH_BUCKETS];
 STATIC CHAR16                             *mProfileList;
 STATIC UINTN                              mProfileListSize;
 STATIC UINT64                             mExitCode;
@@ -21,56 +22,70 @@ BOOLEAN                                   mExitRequested;
 
 EFI_UNICODE_COLLATION_PROTOCOL           *gUnicodeCollation = NULL;
 
-STATIC CONST CHAR8 Hex[] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
-
 /**
-  Dump some hexadecimal data to the screen.
+  Compute the case-folded hash of a command name.
+
+  Command names are compared case-insensitively, so every character is
+  folded to upper case before it is mixed into the FNV-1a hash.
 
-  @param[in] Indent     How many spaces to indent the output.
-  @param[in] Offset     The offset of the printing.
-  @param[in] DataSize   The size in bytes of UserData.
-  @param[in] UserData   The data to print out.
+  @param[in] CommandString  The command name.
 
+  @return The hash value of CommandString.
 **/
-VOID
-EFIAPI
-DumpHex (
-  IN UINTN        Indent,
-  IN UINTN        Offset,
-  IN UINTN        DataSize,
-  IN VOID         *UserData
+STATIC
+UINT32
+ConsoleCommandHash (
+  IN CONST CHAR16  *CommandString
   )
 {
-  UINT8           *Data;
-  CHAR8           Val[50];
-  CHAR8           Str[20];
-  UINT8           TempByte;
-  UINTN           Size;
-  UINTN           Index;
-
-  Data = UserData;
-  while (DataSize != 0) {
-    Size = 16;
-    if (Size > DataSize) {
-      Size = DataSize;
-    }
+  UINT32  Hash;
 
-    for (Index = 0; Index < Size; Index += 1) {
-      TempByte            = Data[Index];
-      Val[Index * 3 + 0]  = Hex[TempByte >> 4];
-      Val[Index * 3 + 1]  = Hex[TempByte & 0xF];
-      Val[Index * 3 + 2]  = (CHAR8) ((Index == 7) ? '-' : ' ');
-      Str[Index]          = (CHAR8) ((TempByte < ' ' || TempByte > '~') ? '.' : TempByte);
-    }
+  Hash = 0x811C9DC5;
+  for (; *CommandString != CHAR_NULL; CommandString++) {
+    Hash = (Hash ^ CharToUpper (*CommandString)) * 0x01000193;
+  }
 
-    Val[Index * 3]  = 0;
-    Str[Index]      = 0;
-    Print (L"%*a%08X: %-48a *%a*\r\n", Indent, "", Offset, Val, Str);
+  return Hash;
+}
+
+/**
+  Find a registered command by name through the hash index.
 
-    Data += Size;
-    Offset += Size;
-    DataSize -= Size;
+  @param[in] CommandString  The command name to look for.
+
+  @return The internal list entry of the command, or NULL if not registered.
+**/
+STATIC
+SHELL_COMMAND_INTERNAL_LIST_ENTRY *
+ConsoleCommandFind (
+  IN CONST CHAR16  *CommandString
+  )
+{
+  UINT32                            Hash;
+  LIST_ENTRY                        *Bucket;
+  LIST_ENTRY                        *Link;
+  SHELL_COMMAND_INTERNAL_LIST_ENTRY *Node;
+
+  Hash   = ConsoleCommandHash (CommandString);
+  Bucket = &mCommandHash[Hash & (CONSOLE_COMMAND_HASH_BUCKETS - 1)];
+
+  for (Link = GetFirstNode (Bucket); !IsNull (Bucket, Link); Link = GetNextNode (Bucket, Link)) {
+    Node = BASE_CR (Link, SHELL_COMMAND_INTERNAL_LIST_ENTRY, HashLink);
+    ASSERT (Node->CommandString != NULL);
+    //
+    // Only a full hash match needs the collation compare.
+    //
+    if ((Node->Hash == Hash) &&
+        (gUnicodeCollation->StriColl (
+           gUnicodeCollation,
+           (CHAR16 *) CommandString,
+           Node->CommandString) == 0)
+      ) {
+      return Node;
+    }
   }
+
+  return NULL;
 }
 
 /**
@@ -106,6 +121,9 @@ ConsoleCommandRunCommandHandler (
   )
 {
   SHELL_COMMAND_INTERNAL_LIST_ENTRY   *Node;
+  UINT64                              StartTicks;
+  UINT64                              ElapsedNs;
+  SHELL_STATUS                        Status;
 
   //
   // assert for NULL parameters
@@ -115,29 +133,84 @@ ConsoleCommandRunCommandHandler (
   //
   // check for the command
   //
-  for ( Node = (SHELL_COMMAND_INTERNAL_LIST_ENTRY *)GetFirstNode (&mCommandList.Link)
-      ; !IsNull (&mCommandList.Link, &Node->Link)
-      ; Node = (SHELL_COMMAND_INTERNAL_LIST_ENTRY *)GetNextNode (&mCommandList.Link, &Node->Link)
-     ){
-    ASSERT (Node->CommandString != NULL);
-    if (gUnicodeCollation->StriColl (
-          gUnicodeCollation,
-          (CHAR16 *) CommandString,
-          Node->CommandString) == 0
-      ) {
-      if (CanAffectLE != NULL) {
-        *CanAffectLE = Node->LastError;
-      }
-      if (RetVal != NULL) {
-        *RetVal = Node->CommandHandler (NULL, gST);
-      } else {
-        Node->CommandHandler (NULL, gST);
-      }
-      return (RETURN_SUCCESS);
+  Node = ConsoleCommandFind (CommandString);
+  if (Node == NULL) {
+    return (RETURN_NOT_FOUND);
+  }
+
+  if (CanAffectLE != NULL) {
+    *CanAffectLE = Node->LastError;
+  }
+
+  StartTicks = GetPerformanceCounter ();
+  Status     = Node->CommandHandler (NULL, gST);
+  ElapsedNs  = ConsoleGetElapsedTime (StartTicks);
+
+  if (Node->Invocations == 0 || ElapsedNs < Node->MinNs) {
+    Node->MinNs = ElapsedNs;
+  }
+  if (ElapsedNs > Node->MaxNs) {
+    Node->MaxNs = ElapsedNs;
+  }
+  Node->TotalNs += ElapsedNs;
+  Node->Invocations++;
+
+  if (RetVal != NULL) {
+    *RetVal = Status;
+  }
+  return (RETURN_SUCCESS);
+}
+
+/**
+  Get the list of registered commands, in registration order.
+
+  @return The head of a list of SHELL_COMMAND_INTERNAL_LIST_ENTRY, linked
+          through Link.
+**/
+CONST LIST_ENTRY *
+ConsoleCommandGetList (
+  VOID
+  )
+{
+  return &mCommandList.Link;
+}
+
+/**
+  Get the time elapsed since a performance counter value.  The counter may
+  count up or down, and may have wrapped once.
+
+  @param[in] StartTicks   A value returned by GetPerformanceCounter().
+
+  @return The elapsed time in nanoseconds.
+**/
+UINT64
+ConsoleGetElapsedTime (
+  IN UINT64  StartTicks
+  )
+{
+  UINT64  EndTicks;
+  UINT64  CounterStart;
+  UINT64  CounterEnd;
+  UINT64  Ticks;
+
+  EndTicks = GetPerformanceCounter ();
+  GetPerformanceCounterProperties (&CounterStart, &CounterEnd);
+
+  if (CounterStart > CounterEnd) {
+    if (StartTicks >= EndTicks) {
+      Ticks = StartTicks - EndTicks;
+    } else {
+      Ticks = (StartTicks - CounterEnd) + (CounterStart - EndTicks);
+    }
+  } else {
+    if (EndTicks >= StartTicks) {
+      Ticks = EndTicks - StartTicks;
+    } else {
+      Ticks = (EndTicks - CounterStart) + (CounterEnd - StartTicks);
     }
   }
 
-  return (RETURN_NOT_FOUND);
+  return GetTimeInNanoSecond (Ticks);
 }
 
 /**
@@ -157,6 +230,18 @@ ConsoleCommandRegisterExit (
   mExitCode = ErrorCode;
 }
 
+/**
+  Clear the Exit indicator once the script that ran 'exit' has ended.
+**/
+VOID
+EFIAPI
+ConsoleCommandClearExit (
+  VOID
+  )
+{
+  mExitRequested = FALSE;
+}
+
 /**
   Retrieve the Exit indicator.
 
@@ -274,30 +359,12 @@ ShellCommandIsCommandOnInternalList (
   IN CONST  CHAR16 *CommandString
   )
 {
-  SHELL_COMMAND_INTERNAL_LIST_ENTRY *Node;
-
   //
   // assert for NULL parameter
   //
   ASSERT (CommandString != NULL);
 
-  //
-  // check for the command
-  //
-  for ( Node = (SHELL_COMMAND_INTERNAL_LIST_ENTRY *) GetFirstNode (&mCommandList.Link)
-      ; !IsNull (&mCommandList.Link, &Node->Link)
-      ; Node = (SHELL_COMMAND_INTERNAL_LIST_ENTRY *) GetNextNode (&mCommandList.Link, &Node->Link)
-     ) {
-    ASSERT(Node->CommandString != NULL);
-    if (gUnicodeCollation->StriColl (
-          gUnicodeCollation,
-          (CHAR16 *) CommandString,
-          Node->CommandString) == 0
-       ) {
-      return (TRUE);
-    }
-  }
-  return (FALSE);
+  return (BOOLEAN) (ConsoleCommandFind (CommandString) != NULL);
 }
 
 /**
@@ -423,6 +490,7 @@ ConsoleCommandRegisterCommandName (
   Node->LastError       = CanAffectLE;
   Node->HiiHandle       = HiiHandle;
   Node->ManFormatHelp   = ManFormatHelp;
+  Node->Hash            = ConsoleCommandHash (CommandString);
 
   if (StrLen (ProfileName) > 0
     && ((mProfileList != NULL
@@ -440,8 +508,9 @@ ConsoleCommandRegisterCommandName (
   }
 
   //
-  // Insert a new entry on top of the list
+  // Index the entry by name, then insert it on top of the list
   //
+  InsertTailList (&mCommandHash[Node->Hash & (CONSOLE_COMMAND_HASH_BUCKETS - 1)], &Node->HashLink);
   InsertHeadList (&mCommandList.Link, &Node->Link);
 
   //
@@ -517,6 +586,7 @@ ConsoleCommandsDestructor (
   while (!IsListEmpty (&mCommandList.Link)) {
     Node = (SHELL_COMMAND_INTERNAL_LIST_ENTRY *) GetFirstNode (&mCommandList.Link);
     RemoveEntryList (&Node->Link);
+    RemoveEntryList (&Node->HashLink);
     SHELL_FREE_NON_NULL (Node->CommandString);
     FreePool (Node);
     DEBUG_CODE (Node = NULL;);
@@ -526,6 +596,8 @@ ConsoleCommandsDestructor (
     FreePool (mProfileList);
   }
 
+  ConsolePciFreeCache ();
+
   gUnicodeCollation            = NULL;
 
   return EFI_SUCCESS;
@@ -549,8 +621,12 @@ ConsoleCommandsConstructor (
   )
 {
   EFI_STATUS        Status;
+  UINTN             Index;
 
   InitializeListHead (&mCommandList.Link);
+  for (Index = 0; Index < CONSOLE_COMMAND_HASH_BUCKETS; Index++) {
+    InitializeListHead (&mCommandHash[Index]);
+  }
 
   mExitRequested    = FALSE;
   mProfileListSize  = 0;
@@ -565,8 +641,15 @@ ConsoleCommandsConstructor (
   // Install our console command handlers that are always installed
   //
   ConsoleCommandRegisterCommandName (L"mem",    ShellCommandRunMem     , ShellCommandGetManFileNameDebug, 0, L"Debug", TRUE, NULL, 0 );
+  ConsoleCommandRegisterCommandName (L"dmem",   ShellCommandRunMem     , ShellCommandGetManFileNameDebug, 0, L"Debug", TRUE, NULL, 0 );
+  ConsoleCommandRegisterCommandName (L"mm",     ShellCommandRunMm      , ShellCommandGetManFileNameDebug, 0, L"Debug", TRUE, NULL, 0 );
+  ConsoleCommandRegisterCommandName (L"pci",    ShellCommandRunPci     , ShellCommandGetManFileNameDebug, 0, L"Debug", TRUE, NULL, 0 );
   ConsoleCommandRegisterCommandName (L"exit",   ShellCommandRunExit    , ShellCommandGetManFileNameDebug, 0, L"Debug", TRUE, NULL, 0 );
   ConsoleCommandRegisterCommandName (L"reset",  ShellCommandRunReset   , ShellCommandGetManFileNameDebug, 0, L"Debug", TRUE, NULL, 0 );
+  ConsoleCommandRegisterCommandName (L"run",    ShellCommandRunRun     , ShellCommandGetManFileNameDebug, 0, L"Debug", TRUE, NULL, 0 );
+  ConsoleCommandRegisterCommandName (L"grep",   ShellCommandRunGrep    , ShellCommandGetManFileNameDebug, 0, L"Debug", TRUE, NULL, 0 );
+  ConsoleCommandRegisterCommandName (L"echo",   ShellCommandRunEcho    , ShellCommandGetManFileNameDebug, 0, L"Debug", TRUE, NULL, 0 );
+  ConsoleCommandRegisterCommandName (L"stats",  ShellCommandRunStats   , ShellCommandGetManFileNameDebug, 0, L"Debug", TRUE, NULL, 0 );
 
   return EFI_SUCCESS;
 }
@@ -14,24 +14,6 @@
 #ifndef _CONSOLE_COMMAND_H_
 #define _CONSOLE_COMMAND_H_
 
-/**
-  Dump some hexadecimal data to the screen.
-
-  @param[in] Indent     How many spaces to indent the output.
-  @param[in] Offset     The offset of the printing.
-  @param[in] DataSize   The size in bytes of UserData.
-  @param[in] UserData   The data to print out.
-
-**/
-VOID
-EFIAPI
-DumpHex (
-  IN UINTN        Indent,
-  IN UINTN        Offset,
-  IN UINTN        DataSize,
-  IN VOID         *UserData
-  );
-
 /**
   Checks if a command string has been registered for CommandString and if so it runs
   the previously registered handler for that command with the command line.
@@ -77,6 +59,15 @@ ConsoleCommandRegisterExit (
   IN CONST UINT64 ErrorCode
   );
 
+/**
+  Clear the Exit indicator once the script that ran 'exit' has ended.
+**/
+VOID
+EFIAPI
+ConsoleCommandClearExit (
+  VOID
+  );
+
 /**
   Retrieve the Exit indicator.
 
@@ -156,16 +147,50 @@ SHELL_STATUS
   IN EFI_SYSTEM_TABLE  *SystemTable
   );
 
+//
+// Number of buckets in the command name hash index.  Must be a power of two.
+//
+#define CONSOLE_COMMAND_HASH_BUCKETS  64
+
 typedef struct {
   LIST_ENTRY                  Link;
+  LIST_ENTRY                  HashLink;
+  UINT32                      Hash;
   CHAR16                      *CommandString;
   SHELL_GET_MAN_FILENAME      GetManFileName;
   SHELL_RUN_COMMAND           CommandHandler;
   BOOLEAN                     LastError;
   EFI_HANDLE                  HiiHandle;
   EFI_STRING_ID               ManFormatHelp;
+  UINT64                      Invocations;          ///< Number of runs, for 'stats'.
+  UINT64                      TotalNs;              ///< Total run time in ns.
+  UINT64                      MinNs;                ///< Shortest run time in ns.
+  UINT64                      MaxNs;                ///< Longest run time in ns.
 } SHELL_COMMAND_INTERNAL_LIST_ENTRY;
 
+/**
+  Get the list of registered commands, in registration order.
+
+  @return The head of a list of SHELL_COMMAND_INTERNAL_LIST_ENTRY, linked
+          through Link.
+**/
+CONST LIST_ENTRY *
+ConsoleCommandGetList (
+  VOID
+  );
+
+/**
+  Get the time elapsed since a performance counter value.
+
+  @param[in] StartTicks   A value returned by GetPerformanceCounter().
+
+  @return The elapsed time in nanoseconds.
+**/
+UINT64
+ConsoleGetElapsedTime (
+  IN UINT64  StartTicks
+  );
+
 /**
   Function for 'mem' command.
 
@@ -179,6 +204,72 @@ ShellCommandRunMem (
   IN EFI_SYSTEM_TABLE  *SystemTable
   );
 
+/**
+  Function for 'mm' command.
+
+  @param[in] ImageHandle  Handle to the Image (NULL if Internal).
+  @param[in] SystemTable  Pointer to the System Table (NULL if Internal).
+**/
+SHELL_STATUS
+EFIAPI
+ShellCommandRunMm (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  );
+
+/**
+  Function for 'pci' command.
+
+  @param[in] ImageHandle  Handle to the Image (NULL if Internal).
+  @param[in] SystemTable  Pointer to the System Table (NULL if Internal).
+**/
+SHELL_STATUS
+EFIAPI
+ShellCommandRunPci (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  );
+
+/**
+  Convert an access width of 1, 2, 4 or 8 bytes to a root bridge width.
+
+  @param[in]  String    The width in bytes; NULL selects 1.
+  @param[out] Width     The root bridge access width.
+
+  @retval TRUE    String is a valid width.
+  @retval FALSE   String is not a valid width.
+**/
+BOOLEAN
+ConsoleParseAccessWidth (
+  IN  CONST CHAR16                           *String,
+  OUT EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_WIDTH  *Width
+  );
+
+/**
+  Find the PCI root bridge that decodes a bus of a segment.
+
+  @param[in]  Segment   The PCI segment number.
+  @param[in]  Bus       The bus number.
+  @param[out] PciRbIo   The root bridge.
+
+  @retval EFI_SUCCESS     The root bridge was found.
+  @retval EFI_NOT_FOUND   No root bridge decodes the bus.
+**/
+EFI_STATUS
+ConsoleGetPciRootBridgeIo (
+  IN  UINT32                           Segment,
+  IN  UINT8                            Bus,
+  OUT EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL  **PciRbIo
+  );
+
+/**
+  Free the device table cached by the 'pci' command.
+**/
+VOID
+ConsolePciFreeCache (
+  VOID
+  );
+
 /**
   Function for 'exit' command.
 
@@ -205,4 +296,56 @@ ShellCommandRunReset (
   IN EFI_SYSTEM_TABLE  *SystemTable
   );
 
+/**
+  Function for 'run' command.
+
+  @param[in] ImageHandle  Handle to the Image (NULL if Internal).
+  @param[in] SystemTable  Pointer to the System Table (NULL if Internal).
+**/
+SHELL_STATUS
+EFIAPI
+ShellCommandRunRun (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  );
+
+/**
+  Function for 'grep' command.
+
+  @param[in] ImageHandle  Handle to the Image (NULL if Internal).
+  @param[in] SystemTable  Pointer to the System Table (NULL if Internal).
+**/
+SHELL_STATUS
+EFIAPI
+ShellCommandRunGrep (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  );
+
+/**
+  Function for 'echo' command.
+
+  @param[in] ImageHandle  Handle to the Image (NULL if Internal).
+  @param[in] SystemTable  Pointer to the System Table (NULL if Internal).
+**/
+SHELL_STATUS
+EFIAPI
+ShellCommandRunEcho (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  );
+
+/**
+  Function for 'stats' command.
+
+  @param[in] ImageHandle  Handle to the Image (NULL if Internal).
+  @param[in] SystemTable  Pointer to the System Table (NULL if Internal).
+**/
+SHELL_STATUS
+EFIAPI
+ShellCommandRunStats (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  );
+
 #endif
@@ -176,6 +176,12 @@ DEBUG_CODE_END();
   parameters for inclusion in EFI_SHELL_PARAMETERS_PROTOCOL.  this supports space
   delimited and quote surrounded parameter definition.
 
+  The command line is copied once and tokenized in place in a single pass: quotes
+  and ^ escapes are removed while the characters are compacted, each parameter is
+  terminated where its delimiting space was, and Argv points into that copy.  The
+  pointer array and the copy share one allocation, so *Argv is the only buffer to
+  free.
+
   All special character processing (alias, environment variable, redirection,
   etc... must be complete before calling this API.
 
@@ -187,6 +193,7 @@ DEBUG_CODE_END();
 
   @return EFI_SUCCESS           the operation was sucessful
   @return EFI_OUT_OF_RESOURCES  a memory allocation failed.
+  @return EFI_INVALID_PARAMETER a closing " could not be found.
 **/
 EFI_STATUS
 ParseCommandLineToArgs (
@@ -196,79 +203,100 @@ ParseCommandLineToArgs (
   IN OUT UINTN    *Argc
   )
 {
-  UINTN       Count;
-  CHAR16      *TempParameter;
-  CHAR16      *Walker;
-  CHAR16      *NewParam;
-  CHAR16      *NewCommandLine;
-  UINTN       Size;
-  EFI_STATUS  Status;
+  UINTN       Length;
+  UINTN       MaxCount;
+  CHAR16      **NewArgv;
+  CHAR16      *Buffer;
+  CHAR16      *Read;
+  CHAR16      *Write;
+  CHAR16      Delimiter;
+  BOOLEAN     InQuote;
 
   ASSERT (Argc != NULL);
   ASSERT (Argv != NULL);
 
-  if (CommandLine == NULL || StrLen (CommandLine) == 0) {
-    (*Argc) = 0;
-    (*Argv) = NULL;
+  (*Argc) = 0;
+  (*Argv) = NULL;
+
+  //
+  // Skip the leading and trailing spaces and tabs, as TrimSpaces() would.
+  //
+  if (CommandLine != NULL) {
+    while (*CommandLine == L' ' || *CommandLine == L'\t') {
+      CommandLine++;
+    }
+  }
+  if (CommandLine == NULL || *CommandLine == CHAR_NULL) {
     return (EFI_SUCCESS);
   }
-
-  NewCommandLine = AllocateCopyPool (StrSize (CommandLine), CommandLine);
-  if (NewCommandLine == NULL) {
-    return (EFI_OUT_OF_RESOURCES);
+  Length = StrLen (CommandLine);
+  while (CommandLine[Length - 1] == L' ' || CommandLine[Length - 1] == L'\t') {
+    Length--;
   }
 
-  TrimSpaces (&NewCommandLine);
-  Size = StrSize (NewCommandLine);
-  TempParameter = AllocateZeroPool (Size);
-  if (TempParameter == NULL) {
-    SHELL_FREE_NON_NULL (NewCommandLine);
+  //
+  // Parameters are separated by at least one space, which bounds their number.
+  //
+  MaxCount = (Length + 1) / 2;
+  NewArgv  = ConsoleArenaAllocateZero (MaxCount * sizeof (CHAR16 *) + (Length + 1) * sizeof (CHAR16));
+  if (NewArgv == NULL) {
     return (EFI_OUT_OF_RESOURCES);
   }
+  Buffer = (CHAR16 *) (NewArgv + MaxCount);
+  CopyMem (Buffer, CommandLine, Length * sizeof (CHAR16));
 
-  for ( Count = 0
-      , Walker = (CHAR16 *) NewCommandLine
-      ; Walker != NULL && *Walker != CHAR_NULL
-      ; Count++
-      ) {
-    if (EFI_ERROR (GetNextParameter (&Walker, &TempParameter, Size, TRUE))) {
+  //
+  // Write never passes Read, so each parameter is compacted over the characters
+  // already consumed and terminated in place of its delimiter.
+  //
+  Read  = Buffer;
+  Write = Buffer;
+  while (TRUE) {
+    while (*Read == L' ') {
+      Read++;
+    }
+    if (*Read == CHAR_NULL) {
       break;
     }
-  }
 
-  //
-  // lets allocate the pointer array
-  //
-  (*Argv) = AllocateZeroPool ((Count) * sizeof (CHAR16 *));
-  if (*Argv == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Done;
-  }
+    ASSERT (*Argc < MaxCount);
+    NewArgv[(*Argc)++] = Write;
+    InQuote = FALSE;
+    for (; *Read != CHAR_NULL; Read++) {
+      if (*Read == L'^') {
+        //
+        // eliminate the escape ^ and keep the next character as is
+        //
+        if (*++Read == CHAR_NULL) {
+          break;
+        }
+      } else if (*Read == L'\"') {
+        InQuote = (BOOLEAN) !InQuote;
+        if (StripQuotation) {
+          continue;
+        }
+      } else if (*Read == L' ' && !InQuote) {
+        break;
+      }
+      *Write++ = *Read;
+    }
 
-  *Argc = 0;
-  Walker = (CHAR16 *)NewCommandLine;
-  while (Walker != NULL && *Walker != CHAR_NULL) {
-    SetMem16 (TempParameter, Size, CHAR_NULL);
-    if (EFI_ERROR (GetNextParameter (&Walker, &TempParameter, Size, StripQuotation))) {
-      Status = EFI_INVALID_PARAMETER;
-      goto Done;
+    if (InQuote) {
+      ConsoleArenaFree (NewArgv);
+      (*Argc) = 0;
+      return (EFI_INVALID_PARAMETER);
     }
 
-    NewParam = AllocateCopyPool (StrSize (TempParameter), TempParameter);
-    if (NewParam == NULL) {
-      Status = EFI_OUT_OF_RESOURCES;
-      goto Done;
+    Delimiter = *Read;
+    *Write++  = CHAR_NULL;
+    if (Delimiter == CHAR_NULL) {
+      break;
     }
-    ((CHAR16 **) (*Argv))[ (*Argc)] = NewParam;
-    (*Argc)++;
+    Read++;
   }
-  ASSERT (Count >= (*Argc));
-  Status = EFI_SUCCESS;
 
-Done:
-  SHELL_FREE_NON_NULL (TempParameter);
-  SHELL_FREE_NON_NULL (NewCommandLine);
-  return (Status);
+  (*Argv) = NewArgv;
+  return (EFI_SUCCESS);
 }
 
 /**
@@ -287,20 +315,14 @@ RestoreArgcArgv (
   IN UINTN                              *OldArgc
   )
 {
-  UINTN LoopCounter;
   ASSERT (ShellParameters != NULL);
   ASSERT (OldArgv         != NULL);
   ASSERT (OldArgc         != NULL);
 
-  if (ShellParameters->Argv != NULL) {
-    for ( LoopCounter = 0
-        ; LoopCounter < ShellParameters->Argc
-        ; LoopCounter++
-       ) {
-      FreePool(ShellParameters->Argv[LoopCounter]);
-    }
-    FreePool (ShellParameters->Argv);
-  }
+  //
+  // The parameters live in the same buffer as the Argv array.
+  //
+  ConsoleArenaFree (ShellParameters->Argv);
   ShellParameters->Argv = *OldArgv;
   *OldArgv = NULL;
   ShellParameters->Argc = *OldArgc;
@@ -441,87 +463,226 @@ ConsoleInternalShellIsHexOrDecimalNumber (
   return (TRUE);
 }
 
+/**
+  Convert a Unicode character to upper case only if
+  it maps to a valid small-case ASCII character.
+
+  This internal function only deal with Unicode character
+  which maps to a valid small-case ASCII character, i.e.
+  L'a' to L'z'. For other Unicode character, the input character
+  is returned directly.
+
+  @param  Char  The character to convert.
+
+  @retval LowerCharacter   If the Char is with range L'a' to L'z'.
+  @retval Unchanged        Otherwise.
+
+**/
+CHAR16
+InternalConsoleCharToUpper (
+  IN      CHAR16                    Char
+  )
+{
+  if (Char >= L'a' && Char <= L'z') {
+    return (CHAR16) (Char - (L'a' - L'A'));
+  }
+
+  return Char;
+}
+
+//
+// Check list index of the flags that are always supported, followed by the
+// caller's check list.  The index doubles as the bit in Present.
+//
+#define CONSOLE_PARAM_HELP           0
+#define CONSOLE_PARAM_PAGE_BREAK     1
+#define CONSOLE_PARAM_FIRST_ITEM     2
+#define CONSOLE_PARAM_MAX_ITEMS      32
+
+//
+// Number of slots in the flag name hash.  Must be a power of two larger than
+// CONSOLE_PARAM_MAX_ITEMS so that a probe always ends on an empty slot.
+//
+#define CONSOLE_PARAM_HASH_SLOTS     64
+
 typedef struct {
-  LIST_ENTRY     Link;
-  CHAR16         *Name;
-  SHELL_PARAM_TYPE      Type;
-  CHAR16         *Value;
-  UINTN          OriginalPosition;
-} SHELL_PARAM_PACKAGE;
+  CONST CHAR16      *Name;                                  ///< Name from the check list.
+  SHELL_PARAM_TYPE  Type;
+  CONST CHAR16      *Argument;                              ///< Argument that matched it.
+  CONST CHAR16      *Value;                                 ///< Value, a slice of Argv unless joined.
+  BOOLEAN           Joined;                                 ///< Value was allocated by joining arguments.
+} CONSOLE_PARAM_ITEM;
+
+//
+// The package returned as an opaque LIST_ENTRY pointer.  It is filled in one
+// pass over Argv and keeps pointers into Argv instead of copies, so it must be
+// freed before the Argv it was parsed from.
+//
+typedef struct {
+  UINT32              Present;                              ///< Bit per item seen on the command line.
+  UINT32              StartItems;                           ///< Bit per TypeStart item.
+  UINTN               ItemCount;
+  UINT8               Hash[CONSOLE_PARAM_HASH_SLOTS];       ///< Item index + 1, 0 if empty.
+  CONSOLE_PARAM_ITEM  Item[CONSOLE_PARAM_MAX_ITEMS];
+  UINTN               PositionCount;
+  CONST CHAR16        *Position[1];                         ///< PositionCount entries.
+} CONSOLE_PARAM_PACKAGE;
 
 /**
-  Checks the list of valid arguments and returns TRUE if the item was found.  If the
-  return value is TRUE then the type parameter is set also.
+  Hash a flag name, ignoring case.
 
-  if CheckList is NULL then ASSERT();
-  if Name is NULL then ASSERT();
-  if Type is NULL then ASSERT();
+  @param[in] Name     The flag name.
 
-  @param Name                   pointer to Name of parameter found
-  @param CheckList              List to check against
-  @param Type                   pointer to type of parameter if it was found
+  @return The hash slot to start probing from.
+**/
+STATIC
+UINTN
+ConsoleParamHash (
+  IN CONST CHAR16  *Name
+  )
+{
+  UINT32  Hash;
 
-  @retval TRUE                  the Parameter was found.  Type is valid.
-  @retval FALSE                 the Parameter was not found.  Type is not valid.
+  for (Hash = 0; *Name != CHAR_NULL; Name++) {
+    Hash = Hash * 31 + InternalConsoleCharToUpper (*Name);
+  }
+
+  return Hash & (CONSOLE_PARAM_HASH_SLOTS - 1);
+}
+
+/**
+  Compare the first Length characters of two flag names, ignoring case.
+
+  @param[in] Name1    The first name.
+  @param[in] Name2    The second name.
+  @param[in] Length   Number of characters to compare; MAX_UINTN compares the
+                      whole strings.
+
+  @retval TRUE    The names match.
+  @retval FALSE   The names differ.
 **/
+STATIC
 BOOLEAN
-ConsoleInternalIsOnCheckList (
-  IN CONST CHAR16               *Name,
-  IN CONST SHELL_PARAM_ITEM     *CheckList,
-  OUT SHELL_PARAM_TYPE          *Type
+ConsoleParamNameEqual (
+  IN CONST CHAR16  *Name1,
+  IN CONST CHAR16  *Name2,
+  IN UINTN         Length
   )
 {
-  SHELL_PARAM_ITEM              *TempListItem;
-  CHAR16                        *TempString;
+  for (; Length != 0; Length--, Name1++, Name2++) {
+    if (InternalConsoleCharToUpper (*Name1) != InternalConsoleCharToUpper (*Name2)) {
+      return (FALSE);
+    }
+    if (*Name1 == CHAR_NULL) {
+      break;
+    }
+  }
 
-  //
-  // ASSERT that all 3 pointer parameters aren't NULL
-  //
-  ASSERT (CheckList  != NULL);
-  ASSERT (Type       != NULL);
-  ASSERT (Name       != NULL);
+  return (TRUE);
+}
+
+/**
+  Find a flag name in the package's check list.
+
+  -? and -b must match exactly, other names ignore case.  TypeStart items also
+  match any name that starts with them.
+
+  @param[in] Package    The package.
+  @param[in] Name       The name to look for.
+
+  @return The item index, or MAX_UINTN if Name is not on the check list.
+**/
+STATIC
+UINTN
+ConsoleParamFindItem (
+  IN CONST CONSOLE_PARAM_PACKAGE  *Package,
+  IN CONST CHAR16                 *Name
+  )
+{
+  UINTN   Slot;
+  UINTN   Index;
+  UINT32  StartItems;
+
+  for (Slot = ConsoleParamHash (Name)
+      ; Package->Hash[Slot] != 0
+      ; Slot = (Slot + 1) & (CONSOLE_PARAM_HASH_SLOTS - 1)
+      ) {
+    Index = Package->Hash[Slot] - 1;
+    if (Index < CONSOLE_PARAM_FIRST_ITEM) {
+      if (StrCmp (Name, Package->Item[Index].Name) == 0) {
+        return (Index);
+      }
+    } else if (ConsoleParamNameEqual (Name, Package->Item[Index].Name, MAX_UINTN)) {
+      return (Index);
+    }
+  }
+
+  for (StartItems = Package->StartItems, Index = 0; StartItems != 0; StartItems >>= 1, Index++) {
+    if ((StartItems & 1) != 0 &&
+        ConsoleParamNameEqual (Name, Package->Item[Index].Name, StrLen (Package->Item[Index].Name))) {
+      return (Index);
+    }
+  }
+
+  return (MAX_UINTN);
+}
+
+/**
+  Set up the items and the name hash of a package from a check list.
+
+  @param[in, out] Package     The package.
+  @param[in]      CheckList   List of valid parameters.
+
+  @retval EFI_SUCCESS             The package is ready for parsing.
+  @retval EFI_INVALID_PARAMETER   The check list is too long.
+**/
+STATIC
+EFI_STATUS
+ConsoleParamInitItems (
+  IN OUT CONSOLE_PARAM_PACKAGE  *Package,
+  IN CONST SHELL_PARAM_ITEM     *CheckList
+  )
+{
+  UINTN  Index;
+  UINTN  Slot;
 
   //
   // question mark and page break mode are always supported
   //
-  if ((StrCmp (Name, L"-?") == 0) ||
-      (StrCmp (Name, L"-b") == 0)
-     ) {
-    *Type = TypeFlag;
-    return (TRUE);
+  Package->Item[CONSOLE_PARAM_HELP].Name       = L"-?";
+  Package->Item[CONSOLE_PARAM_HELP].Type       = TypeFlag;
+  Package->Item[CONSOLE_PARAM_PAGE_BREAK].Name = L"-b";
+  Package->Item[CONSOLE_PARAM_PAGE_BREAK].Type = TypeFlag;
+
+  for (Index = CONSOLE_PARAM_FIRST_ITEM; CheckList->Name != NULL; CheckList++, Index++) {
+    if (Index == CONSOLE_PARAM_MAX_ITEMS) {
+      ASSERT (FALSE);
+      return (EFI_INVALID_PARAMETER);
+    }
+    Package->Item[Index].Name = CheckList->Name;
+    Package->Item[Index].Type = CheckList->Type;
+    if (CheckList->Type == TypeStart) {
+      Package->StartItems |= (UINT32) 1 << Index;
+    }
   }
+  Package->ItemCount = Index;
 
   //
-  // Enumerate through the list
+  // Insert in check list order so that the first of two equal names is the
+  // one found, as when the check list is searched.
   //
-  for (TempListItem = (SHELL_PARAM_ITEM *)CheckList ; TempListItem->Name != NULL ; TempListItem++) {
-    //
-    // If the Type is TypeStart only check the first characters of the passed in param
-    // If it matches set the type and return TRUE
-    //
-    if (TempListItem->Type == TypeStart) {
-      if (StrnCmp (Name, TempListItem->Name, StrLen (TempListItem->Name)) == 0) {
-        *Type = TempListItem->Type;
-        return (TRUE);
-      }
-      TempString = NULL;
-      TempString = ConsoleStrnCatGrow (&TempString, NULL, Name, StrLen (TempListItem->Name));
-      if (TempString != NULL) {
-        if (StringNoCaseCompare (&TempString, &TempListItem->Name) == 0) {
-          *Type = TempListItem->Type;
-          FreePool (TempString);
-          return (TRUE);
-        }
-        FreePool (TempString);
-      }
-    } else if (StringNoCaseCompare (&Name, &TempListItem->Name) == 0) {
-      *Type = TempListItem->Type;
-      return (TRUE);
+  for (Index = 0; Index < Package->ItemCount; Index++) {
+    for (Slot = ConsoleParamHash (Package->Item[Index].Name)
+        ; Package->Hash[Slot] != 0
+        ; Slot = (Slot + 1) & (CONSOLE_PARAM_HASH_SLOTS - 1)
+        ) {
     }
+    Package->Hash[Slot] = (UINT8) (Index + 1);
   }
 
-  return (FALSE);
+  return (EFI_SUCCESS);
 }
+
 /**
   Checks the string for indicators of "flag" status.  this is a leading '/', '-', or '+'
 
@@ -563,11 +724,55 @@ ConsoleInternalIsFlag (
   return (FALSE);
 }
 
+/**
+  Append an argument to the value of a TypeDoubleValue or TypeMaxValue item,
+  separated by a space.
+
+  @param[in, out] Item        The item.
+  @param[in]      Argument    The argument to append.
+
+  @retval EFI_SUCCESS             The value was extended.
+  @retval EFI_OUT_OF_RESOURCES    A memory allocation failed.
+**/
+STATIC
+EFI_STATUS
+ConsoleParamAppendValue (
+  IN OUT CONSOLE_PARAM_ITEM  *Item,
+  IN CONST CHAR16            *Argument
+  )
+{
+  UINTN   OldLength;
+  UINTN   Size;
+  CHAR16  *NewValue;
+
+  OldLength = StrLen (Item->Value);
+  Size      = (OldLength + 1) * sizeof (CHAR16) + StrSize (Argument);
+  NewValue  = ConsoleArenaAllocateZero (Size);
+  if (NewValue == NULL) {
+    return (EFI_OUT_OF_RESOURCES);
+  }
+
+  CopyMem (NewValue, Item->Value, OldLength * sizeof (CHAR16));
+  NewValue[OldLength] = L' ';
+  StrCpyS (NewValue + OldLength + 1, Size / sizeof (CHAR16) - OldLength - 1, Argument);
+  if (Item->Joined) {
+    ConsoleArenaFree ((CHAR16 *) Item->Value);
+  }
+  Item->Value  = NewValue;
+  Item->Joined = TRUE;
+  return (EFI_SUCCESS);
+}
+
 /**
   Checks the command line arguments passed against the list of valid ones.
 
   If no initialization is required, then return RETURN_SUCCESS.
 
+  The arguments are walked once.  Flags are looked up in a hash of the check
+  list and recorded by check list index, and values and positional parameters
+  point into Argv, so a parse takes a single allocation for the package and
+  every query on it is answered without a search.
+
   @param[in] CheckList          pointer to list of parameters to check
   @param[out] CheckPackage      pointer to pointer to list checked values
   @param[out] ProblemParam      optional pointer to pointer to unicode string for
@@ -599,20 +804,16 @@ ConsoleInternalCommandLineParse (
   IN BOOLEAN                    AlwaysAllowNumbers
   )
 {
+  CONSOLE_PARAM_PACKAGE         *Package;
+  CONSOLE_PARAM_ITEM            *CurrentItem;
   UINTN                         LoopCounter;
-  SHELL_PARAM_TYPE              CurrentItemType;
-  SHELL_PARAM_PACKAGE           *CurrentItemPackage;
+  UINTN                         Index;
   UINTN                         GetItemValue;
-  UINTN                         ValueSize;
-  UINTN                         Count;
   CONST CHAR16                  *TempPointer;
-  UINTN                         CurrentValueSize;
-  CHAR16                        *NewValue;
+  EFI_STATUS                    Status;
 
-  CurrentItemPackage = NULL;
+  CurrentItem  = NULL;
   GetItemValue = 0;
-  ValueSize = 0;
-  Count = 0;
 
   //
   // If there is only 1 item we dont need to do anything
@@ -628,15 +829,18 @@ ConsoleInternalCommandLineParse (
   ASSERT (CheckList  != NULL);
   ASSERT (Argv       != NULL);
 
-  //
-  // initialize the linked list
-  //
-  *CheckPackage = (LIST_ENTRY *)AllocateZeroPool (sizeof (LIST_ENTRY));
-  if (*CheckPackage == NULL) {
+  Package = ConsoleArenaAllocateZero (OFFSET_OF (CONSOLE_PARAM_PACKAGE, Position) + Argc * sizeof (CONST CHAR16 *));
+  if (Package == NULL) {
+    *CheckPackage = NULL;
     return (EFI_OUT_OF_RESOURCES);
   }
 
-  InitializeListHead (*CheckPackage);
+  Status = ConsoleParamInitItems (Package, CheckList);
+  if (EFI_ERROR (Status)) {
+    ConsoleArenaFree (Package);
+    *CheckPackage = NULL;
+    return (Status);
+  }
 
   //
   // loop through each of the arguments
@@ -646,101 +850,60 @@ ConsoleInternalCommandLineParse (
       //
       // do nothing for NULL argv
       //
-    } else if (ConsoleInternalIsOnCheckList (Argv[LoopCounter], CheckList, &CurrentItemType)) {
-      //
-      // We might have leftover if last parameter didnt have optional value
-      //
-      if (GetItemValue != 0) {
-        GetItemValue = 0;
-        InsertHeadList (*CheckPackage, &CurrentItemPackage->Link);
-      }
+      continue;
+    }
+
+    Index = ConsoleParamFindItem (Package, Argv[LoopCounter]);
+    if (Index != MAX_UINTN) {
       //
-      // this is a flag
+      // this is a flag; a later instance replaces an earlier one
       //
-      CurrentItemPackage = AllocateZeroPool (sizeof (SHELL_PARAM_PACKAGE));
-      if (CurrentItemPackage == NULL) {
-        ConsoleCommandLineFreeVarList (*CheckPackage);
-        *CheckPackage = NULL;
-        return (EFI_OUT_OF_RESOURCES);
-      }
-      CurrentItemPackage->Name  = AllocateCopyPool (StrSize (Argv[LoopCounter]), Argv[LoopCounter]);
-      if (CurrentItemPackage->Name == NULL) {
-        ConsoleCommandLineFreeVarList (*CheckPackage);
-        *CheckPackage = NULL;
-        return (EFI_OUT_OF_RESOURCES);
+      CurrentItem = &Package->Item[Index];
+      if (CurrentItem->Joined) {
+        ConsoleArenaFree ((CHAR16 *) CurrentItem->Value);
       }
-      CurrentItemPackage->Type  = CurrentItemType;
-      CurrentItemPackage->OriginalPosition = (UINTN) (-1);
-      CurrentItemPackage->Value = NULL;
+      CurrentItem->Argument = Argv[LoopCounter];
+      CurrentItem->Value    = NULL;
+      CurrentItem->Joined   = FALSE;
+      Package->Present     |= (UINT32) 1 << Index;
 
       //
       // Does this flag require a value
       //
-      switch (CurrentItemPackage->Type) {
-        //
-        // possibly trigger the next loop(s) to populate the value of this item
-        //
+      switch (CurrentItem->Type) {
         case TypeValue:
         case TypeTimeValue:
           GetItemValue = 1;
-          ValueSize = 0;
           break;
         case TypeDoubleValue:
           GetItemValue = 2;
-          ValueSize = 0;
           break;
         case TypeMaxValue:
           GetItemValue = (UINTN)(-1);
-          ValueSize = 0;
           break;
         default:
-          //
-          // this item has no value expected; we are done
-          //
-          InsertHeadList(*CheckPackage, &CurrentItemPackage->Link);
-          ASSERT(GetItemValue == 0);
+          GetItemValue = 0;
           break;
       }
-    } else if (GetItemValue != 0 && CurrentItemPackage != NULL && !ConsoleInternalIsFlag(Argv[LoopCounter], AlwaysAllowNumbers, (BOOLEAN)(CurrentItemPackage->Type == TypeTimeValue))) {
+    } else if (GetItemValue != 0 && !ConsoleInternalIsFlag (Argv[LoopCounter], AlwaysAllowNumbers, (BOOLEAN)(CurrentItem->Type == TypeTimeValue))) {
       //
       // get the item VALUE for a previous flag
       //
-      CurrentValueSize = ValueSize + StrSize(Argv[LoopCounter]) + sizeof(CHAR16);
-      NewValue = ReallocatePool(ValueSize, CurrentValueSize, CurrentItemPackage->Value);
-      if (NewValue == NULL) {
-        SHELL_FREE_NON_NULL (CurrentItemPackage->Value);
-        SHELL_FREE_NON_NULL (CurrentItemPackage);
-        ConsoleCommandLineFreeVarList (*CheckPackage);
-        *CheckPackage = NULL;
-        return EFI_OUT_OF_RESOURCES;
-      }
-      CurrentItemPackage->Value = NewValue;
-      if (ValueSize == 0) {
-        StrCpyS( CurrentItemPackage->Value,
-                  CurrentValueSize/sizeof(CHAR16),
-                  Argv[LoopCounter]
-                  );
+      if (CurrentItem->Value == NULL) {
+        CurrentItem->Value = Argv[LoopCounter];
       } else {
-        StrCatS( CurrentItemPackage->Value,
-                  CurrentValueSize/sizeof(CHAR16),
-                  L" "
-                  );
-        StrCatS( CurrentItemPackage->Value,
-                  CurrentValueSize/sizeof(CHAR16),
-                  Argv[LoopCounter]
-                  );
+        Status = ConsoleParamAppendValue (CurrentItem, Argv[LoopCounter]);
+        if (EFI_ERROR (Status)) {
+          ConsoleCommandLineFreeVarList ((LIST_ENTRY *) Package);
+          *CheckPackage = NULL;
+          return (Status);
+        }
       }
-      ValueSize += StrSize (Argv[LoopCounter]) + sizeof (CHAR16);
-
       GetItemValue--;
-      if (GetItemValue == 0) {
-        InsertHeadList (*CheckPackage, &CurrentItemPackage->Link);
-      }
     } else if (!ConsoleInternalIsFlag (Argv[LoopCounter], AlwaysAllowNumbers, FALSE)) {
       //
       // add this one as a non-flag
       //
-
       TempPointer = Argv[LoopCounter];
       if ((*TempPointer == L'^' && *(TempPointer+1) == L'-')
        || (*TempPointer == L'^' && *(TempPointer+1) == L'/')
@@ -748,22 +911,7 @@ ConsoleInternalCommandLineParse (
       ) {
         TempPointer++;
       }
-      CurrentItemPackage = AllocateZeroPool (sizeof (SHELL_PARAM_PACKAGE));
-      if (CurrentItemPackage == NULL) {
-        ConsoleCommandLineFreeVarList (*CheckPackage);
-        *CheckPackage = NULL;
-        return (EFI_OUT_OF_RESOURCES);
-      }
-      CurrentItemPackage->Name  = NULL;
-      CurrentItemPackage->Type  = TypePosition;
-      CurrentItemPackage->Value = AllocateCopyPool (StrSize (TempPointer), TempPointer);
-      if (CurrentItemPackage->Value == NULL) {
-        ConsoleCommandLineFreeVarList (*CheckPackage);
-        *CheckPackage = NULL;
-        return (EFI_OUT_OF_RESOURCES);
-      }
-      CurrentItemPackage->OriginalPosition = Count++;
-      InsertHeadList (*CheckPackage, &CurrentItemPackage->Link);
+      Package->Position[Package->PositionCount++] = TempPointer;
     } else {
       //
       // this was a non-recognised flag... error!
@@ -771,16 +919,13 @@ ConsoleInternalCommandLineParse (
       if (ProblemParam != NULL) {
         *ProblemParam = AllocateCopyPool (StrSize (Argv[LoopCounter]), Argv[LoopCounter]);
       }
-      ConsoleCommandLineFreeVarList (*CheckPackage);
+      ConsoleCommandLineFreeVarList ((LIST_ENTRY *) Package);
       *CheckPackage = NULL;
       return (EFI_VOLUME_CORRUPTED);
     }
   }
-  if (GetItemValue != 0) {
-    GetItemValue = 0;
-    InsertHeadList (*CheckPackage, &CurrentItemPackage->Link);
-  }
 
+  *CheckPackage = (LIST_ENTRY *) Package;
   return (EFI_SUCCESS);
 }
 
@@ -856,7 +1001,8 @@ ConsoleCommandLineFreeVarList (
   IN LIST_ENTRY                 *CheckPackage
   )
 {
-  LIST_ENTRY                    *Node;
+  CONSOLE_PARAM_PACKAGE         *Package;
+  UINTN                         Index;
 
   //
   // check for CheckPackage == NULL
@@ -866,41 +1012,49 @@ ConsoleCommandLineFreeVarList (
   }
 
   //
-  // for each node in the list
+  // only joined values were allocated apart from the package
   //
-  for (Node = GetFirstNode(CheckPackage)
-      ; !IsListEmpty(CheckPackage)
-      ; Node = GetFirstNode(CheckPackage)
-     ) {
-    //
-    // Remove it from the list
-    //
-    RemoveEntryList (Node);
-
-    //
-    // if it has a name free the name
-    //
-    if (((SHELL_PARAM_PACKAGE *)Node)->Name != NULL) {
-      FreePool (((SHELL_PARAM_PACKAGE *)Node)->Name);
+  Package = (CONSOLE_PARAM_PACKAGE *) CheckPackage;
+  for (Index = 0; Index < Package->ItemCount; Index++) {
+    if (Package->Item[Index].Joined) {
+      ConsoleArenaFree ((CHAR16 *) Package->Item[Index].Value);
     }
+  }
 
-    //
-    // if it has a value free the value
-    //
-    if (((SHELL_PARAM_PACKAGE *)Node)->Value != NULL) {
-      FreePool (((SHELL_PARAM_PACKAGE *)Node)->Value);
-    }
+  ConsoleArenaFree (Package);
+}
 
-    //
-    // free the node structure
-    //
-    FreePool ((SHELL_PARAM_PACKAGE *)Node);
+/**
+  Find a key that is present on the command line.
+
+  @param[in] CheckPackage       The package of parsed command line arguments.
+  @param[in] KeyString          The Key of the command line argument.
+
+  @return The item of the key, or NULL if it is not on the command line.
+**/
+STATIC
+CONST CONSOLE_PARAM_ITEM *
+ConsoleParamGetPresentItem (
+  IN CONST LIST_ENTRY           *CheckPackage,
+  IN CONST CHAR16               *KeyString
+  )
+{
+  CONST CONSOLE_PARAM_PACKAGE   *Package;
+  UINTN                         Index;
+
+  if (CheckPackage == NULL || KeyString == NULL) {
+    return (NULL);
   }
-  //
-  // free the list head node
-  //
-  FreePool (CheckPackage);
+
+  Package = (CONST CONSOLE_PARAM_PACKAGE *) CheckPackage;
+  Index   = ConsoleParamFindItem (Package, KeyString);
+  if (Index == MAX_UINTN || (Package->Present & ((UINT32) 1 << Index)) == 0) {
+    return (NULL);
+  }
+
+  return (&Package->Item[Index]);
 }
+
 /**
   Checks for presence of a flag parameter
 
@@ -922,50 +1076,9 @@ ConsoleCommandLineGetFlag (
   IN CONST CHAR16              *CONST KeyString
   )
 {
-  LIST_ENTRY                    *Node;
-  CHAR16                        *TempString;
-
-  //
-  // return FALSE for no package or KeyString is NULL
-  //
-  if (CheckPackage == NULL || KeyString == NULL) {
-    return (FALSE);
-  }
-
-  //
-  // enumerate through the list of parametrs
-  //
-  for ( Node = GetFirstNode (CheckPackage)
-      ; !IsNull (CheckPackage, Node)
-      ; Node = GetNextNode (CheckPackage, Node)
-      ){
-    //
-    // If the Name matches, return TRUE (and there may be NULL name)
-    //
-    if (((SHELL_PARAM_PACKAGE *)Node)->Name != NULL) {
-      //
-      // If Type is TypeStart then only compare the begining of the strings
-      //
-      if (((SHELL_PARAM_PACKAGE *)Node)->Type == TypeStart) {
-        if (StrnCmp (KeyString, ((SHELL_PARAM_PACKAGE *)Node)->Name, StrLen (KeyString)) == 0) {
-          return (TRUE);
-        }
-        TempString = NULL;
-        TempString = ConsoleStrnCatGrow (&TempString, NULL, KeyString, StrLen (((SHELL_PARAM_PACKAGE *)Node)->Name));
-        if (TempString != NULL) {
-          if (StringNoCaseCompare (&KeyString, & ((SHELL_PARAM_PACKAGE *)Node)->Name) == 0) {
-            FreePool (TempString);
-            return (TRUE);
-          }
-          FreePool (TempString);
-        }
-      } else if (StringNoCaseCompare (&KeyString, & ((SHELL_PARAM_PACKAGE *)Node)->Name) == 0) {
-        return (TRUE);
-      }
-    }
-  }
-  return (FALSE);
+  return (BOOLEAN) (ConsoleParamGetPresentItem (CheckPackage, KeyString) != NULL);
 }
+
 /**
   Returns value from command line argument.
 
@@ -986,49 +1099,21 @@ ConsoleCommandLineGetValue (
   IN CHAR16                     *KeyString
   )
 {
-  LIST_ENTRY                    *Node;
-  CHAR16                        *TempString;
+  CONST CONSOLE_PARAM_ITEM      *Item;
 
-  //
-  // return NULL for no package or KeyString is NULL
-  //
-  if (CheckPackage == NULL || KeyString == NULL) {
+  Item = ConsoleParamGetPresentItem (CheckPackage, KeyString);
+  if (Item == NULL) {
     return (NULL);
   }
 
   //
-  // enumerate through the list of parametrs
+  // If Type is TypeStart the value is the rest of the argument
   //
-  for ( Node = GetFirstNode (CheckPackage)
-      ; !IsNull (CheckPackage, Node)
-      ; Node = GetNextNode (CheckPackage, Node)
-      ) {
-    //
-    // If the Name matches, return TRUE (and there may be NULL name)
-    //
-    if (((SHELL_PARAM_PACKAGE*)Node)->Name != NULL) {
-      //
-      // If Type is TypeStart then only compare the begining of the strings
-      //
-      if (((SHELL_PARAM_PACKAGE*)Node)->Type == TypeStart) {
-        if (StrnCmp(KeyString, ((SHELL_PARAM_PACKAGE*)Node)->Name, StrLen (KeyString)) == 0) {
-          return (((SHELL_PARAM_PACKAGE*)Node)->Name + StrLen (KeyString));
-        }
-        TempString = NULL;
-        TempString = ConsoleStrnCatGrow (&TempString, NULL, KeyString, StrLen (((SHELL_PARAM_PACKAGE*)Node)->Name));
-        if (TempString != NULL) {
-          if (StringNoCaseCompare (&KeyString, &((SHELL_PARAM_PACKAGE*)Node)->Name) == 0) {
-            FreePool(TempString);
-            return (((SHELL_PARAM_PACKAGE*)Node)->Name + StrLen (KeyString));
-          }
-          FreePool (TempString);
-        }
-      } else if (StringNoCaseCompare (&KeyString, &((SHELL_PARAM_PACKAGE*)Node)->Name) == 0) {
-        return (((SHELL_PARAM_PACKAGE*)Node)->Value);
-      }
-    }
+  if (Item->Type == TypeStart) {
+    return (Item->Argument + StrLen (KeyString));
   }
-  return (NULL);
+
+  return (Item->Value);
 }
 
 /**
@@ -1051,7 +1136,7 @@ ConsoleCommandLineGetRawValue (
   IN UINTN                      Position
   )
 {
-  LIST_ENTRY                    *Node;
+  CONST CONSOLE_PARAM_PACKAGE   *Package;
 
   //
   // check for CheckPackage == NULL
@@ -1060,21 +1145,12 @@ ConsoleCommandLineGetRawValue (
     return (NULL);
   }
 
-  //
-  // enumerate through the list of parametrs
-  //
-  for ( Node = GetFirstNode (CheckPackage)
-      ; !IsNull (CheckPackage, Node)
-      ; Node = GetNextNode (CheckPackage, Node)
-     ){
-    //
-    // If the position matches, return the value
-    //
-    if (((SHELL_PARAM_PACKAGE *)Node)->OriginalPosition == Position) {
-      return (((SHELL_PARAM_PACKAGE *)Node)->Value);
-    }
+  Package = (CONST CONSOLE_PARAM_PACKAGE *) CheckPackage;
+  if (Position >= Package->PositionCount) {
+    return (NULL);
   }
-  return (NULL);
+
+  return (Package->Position[Position]);
 }
 
 /**
@@ -1093,21 +1169,11 @@ ConsoleCommandLineGetCount (
   IN CONST LIST_ENTRY              *CheckPackage
   )
 {
-  LIST_ENTRY  *Node1;
-  UINTN       Count;
-
   if (CheckPackage == NULL) {
     return (0);
   }
-  for (Node1 = GetFirstNode (CheckPackage), Count = 0
-      ; !IsNull (CheckPackage, Node1)
-      ; Node1 = GetNextNode (CheckPackage, Node1)
-     ) {
-    if (((SHELL_PARAM_PACKAGE *)Node1)->Name == NULL) {
-      Count++;
-    }
-  }
-  return (Count);
+
+  return (((CONST CONSOLE_PARAM_PACKAGE *) CheckPackage)->PositionCount);
 }
 
 /**
@@ -1265,33 +1331,6 @@ ConsoleIsDecimalDigitCharacter (
   return (BOOLEAN) (Char >= L'0' && Char <= L'9');
 }
 
-/**
-  Convert a Unicode character to upper case only if
-  it maps to a valid small-case ASCII character.
-
-  This internal function only deal with Unicode character
-  which maps to a valid small-case ASCII character, i.e.
-  L'a' to L'z'. For other Unicode character, the input character
-  is returned directly.
-
-  @param  Char  The character to convert.
-
-  @retval LowerCharacter   If the Char is with range L'a' to L'z'.
-  @retval Unchanged        Otherwise.
-
-**/
-CHAR16
-InternalConsoleCharToUpper (
-  IN      CHAR16                    Char
-  )
-{
-  if (Char >= L'a' && Char <= L'z') {
-    return (CHAR16) (Char - (L'a' - L'A'));
-  }
-
-  return Char;
-}
-
 /**
   Convert a Unicode character to numerical value.
 
@@ -0,0 +1,1644 @@
+/** @file
+  Script files and command pipelines of the UEFI console.
+
+  A script is read from an FV raw section or a file system and split into
+  statements once.  Flow control statements are reduced to jumps between
+  statement indexes, so running the script is a walk over an array; only
+  the %-variables are expanded as each statement runs.
+
+  A pipeline runs its commands one after another with the console output of
+  every command but the last one redirected into a buffer, which the next
+  command reads with ConsoleGetPipeInput().
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include "UefiConsole.h"
+
+typedef enum {
+  ScriptCommand,
+  ScriptLabel,
+  ScriptGoto,
+  ScriptFor,
+  ScriptEndFor,
+  ScriptIf,
+  ScriptElse,
+  ScriptEndIf
+} SCRIPT_STATEMENT_TYPE;
+
+typedef struct {
+  SCRIPT_STATEMENT_TYPE   Type;
+  UINTN                   LineNumber;       ///< Line of the statement in the script, from 1.
+  BOOLEAN                 Echo;             ///< FALSE for a line starting with '@'.
+  CHAR16                  *Text;            ///< Command line, or label name.
+  UINTN                   Argc;             ///< Tokens of a flow control statement.
+  CHAR16                  **Argv;
+  UINTN                   Target;           ///< Statement a flow control statement jumps to.
+} SCRIPT_STATEMENT;
+
+typedef struct {
+  UINTN                   ForIndex;         ///< The 'for' statement of the loop.
+  CHAR16                  Variable;         ///< Letter of the loop variable.
+  BOOLEAN                 Range;            ///< TRUE for 'for %a run (Start End [Step])'.
+  UINTN                   Position;         ///< Next token of 'for %a in ...'.
+  INT64                   Current;
+  INT64                   End;
+  INT64                   Step;
+  CHAR16                  *Value;           ///< Current value of the loop variable.
+} SCRIPT_LOOP;
+
+typedef struct {
+  CONST CHAR16            *Name;
+  UINTN                   Argc;
+  CONST CHAR16            **Argv;
+  SCRIPT_STATEMENT        *Statements;
+  UINTN                   Count;
+  SCRIPT_LOOP             Loops[CONSOLE_SCRIPT_MAX_NESTING];
+  UINTN                   LoopDepth;
+  EFI_STATUS              LastError;
+} SCRIPT_CONTEXT;
+
+//
+// Output of a pipeline stage.  Protocol must stay the first member, the
+// protocol functions cast This back to the capture.
+//
+typedef struct {
+  EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL   Protocol;
+  EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL   *Original;
+  CHAR16                            *Buffer;
+  UINTN                             Length;
+  UINTN                             Capacity;
+  BOOLEAN                           Truncated;
+} PIPE_CAPTURE;
+
+STATIC CHAR16  *mPipeInput   = NULL;
+STATIC UINTN   mScriptDepth  = 0;
+
+/**
+  Compare two strings without regard to case.
+
+  @param[in] First    The first string.
+  @param[in] Second   The second string.
+
+  @return 0 if the strings are equal, otherwise the difference of the first
+          mismatching upper case characters.
+**/
+STATIC
+INTN
+ScriptStriCmp (
+  IN CONST CHAR16  *First,
+  IN CONST CHAR16  *Second
+  )
+{
+  while (*First != CHAR_NULL && CharToUpper (*First) == CharToUpper (*Second)) {
+    First++;
+    Second++;
+  }
+  return (INTN) CharToUpper (*First) - (INTN) CharToUpper (*Second);
+}
+
+/**
+  Skip a prefix of a string, without regard to case.
+
+  @param[in] String   The string.
+  @param[in] Prefix   The prefix.
+
+  @return The rest of String, or NULL if String does not start with Prefix.
+**/
+STATIC
+CONST CHAR16 *
+ScriptSkipPrefix (
+  IN CONST CHAR16  *String,
+  IN CONST CHAR16  *Prefix
+  )
+{
+  while (*Prefix != CHAR_NULL && CharToUpper (*String) == CharToUpper (*Prefix)) {
+    String++;
+    Prefix++;
+  }
+  return (*Prefix == CHAR_NULL) ? String : NULL;
+}
+
+/**
+  Check whether the first word of a line is a keyword.
+
+  @param[in] Line     The line.
+  @param[in] Keyword  The keyword.
+
+  @retval TRUE    The line starts with Keyword followed by a blank or the end.
+  @retval FALSE   It does not.
+**/
+STATIC
+BOOLEAN
+ScriptFirstWordIs (
+  IN CONST CHAR16  *Line,
+  IN CONST CHAR16  *Keyword
+  )
+{
+  Line = ScriptSkipPrefix (Line, Keyword);
+  return (BOOLEAN) (Line != NULL && (*Line == CHAR_NULL || *Line == L' ' || *Line == L'\t'));
+}
+
+/**
+  Convert a decimal or 0x-prefixed hexadecimal string, with an optional
+  minus sign, to a signed number.
+
+  @param[in]  String  The string.
+  @param[out] Value   The number.
+
+  @retval TRUE    String is a number.
+  @retval FALSE   String is not a number.
+**/
+STATIC
+BOOLEAN
+ScriptStrToInt64 (
+  IN  CONST CHAR16  *String,
+  OUT INT64         *Value
+  )
+{
+  BOOLEAN  Negative;
+  UINT64   Magnitude;
+
+  Negative = (BOOLEAN) (*String == L'-');
+  if (Negative) {
+    String++;
+  }
+
+  if (*String == CHAR_NULL ||
+      !ConsoleIsHexOrDecimalNumber (String, FALSE, FALSE) ||
+      EFI_ERROR (ConsoleConvertStringToUint64 (String, &Magnitude, FALSE, FALSE)) ||
+      Magnitude > MAX_INT64) {
+    return FALSE;
+  }
+
+  *Value = Negative ? -(INT64) Magnitude : (INT64) Magnitude;
+  return TRUE;
+}
+
+/**
+  Split a flow control statement into tokens in place.  Tokens are separated
+  by blanks, double quotes group blanks into a token and '^' escapes the
+  next character.  The tokens are left one after another at the start of
+  Line, each NULL-terminated.
+
+  @param[in, out] Line  The statement.
+
+  @return The number of tokens.
+**/
+STATIC
+UINTN
+ScriptTokenize (
+  IN OUT CHAR16  *Line
+  )
+{
+  CHAR16   *Read;
+  CHAR16   *Write;
+  UINTN    Count;
+  BOOLEAN  Quoted;
+  BOOLEAN  EndOfLine;
+
+  Read  = Line;
+  Write = Line;
+  Count = 0;
+
+  for (;;) {
+    while (*Read == L' ' || *Read == L'\t') {
+      Read++;
+    }
+    if (*Read == CHAR_NULL) {
+      break;
+    }
+
+    Quoted = FALSE;
+    while (*Read != CHAR_NULL && (Quoted || (*Read != L' ' && *Read != L'\t'))) {
+      if (*Read == L'"') {
+        Quoted = (BOOLEAN) !Quoted;
+        Read++;
+        continue;
+      }
+      if (*Read == L'^' && Read[1] != CHAR_NULL) {
+        Read++;
+      }
+      *Write++ = *Read++;
+    }
+
+    //
+    // Write never passes Read, so the terminator lands on a consumed character
+    //
+    EndOfLine = (BOOLEAN) (*Read == CHAR_NULL);
+    if (!EndOfLine) {
+      Read++;
+    }
+    *Write++ = CHAR_NULL;
+    Count++;
+    if (EndOfLine) {
+      break;
+    }
+  }
+
+  return Count;
+}
+
+/**
+  Tokenize a flow control statement and build its argument vector.
+
+  @param[in, out] Statement   The statement; Text is tokenized.
+
+  @retval EFI_SUCCESS           Argc and Argv are set.
+  @retval EFI_OUT_OF_RESOURCES  Argv could not be allocated.
+**/
+STATIC
+EFI_STATUS
+ScriptSplitStatement (
+  IN OUT SCRIPT_STATEMENT  *Statement
+  )
+{
+  CHAR16  *Token;
+  UINTN   Index;
+
+  Statement->Argc = ScriptTokenize (Statement->Text);
+  if (Statement->Argc == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Statement->Argv = AllocatePool (Statement->Argc * sizeof (CHAR16 *));
+  if (Statement->Argv == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Token = Statement->Text;
+  for (Index = 0; Index < Statement->Argc; Index++) {
+    Statement->Argv[Index] = Token;
+    Token += StrLen (Token) + 1;
+  }
+  return EFI_SUCCESS;
+}
+
+/**
+  Report an error in a script statement.
+
+  @param[in] Ctx        The script.
+  @param[in] Statement  The statement in error.
+  @param[in] Message    What is wrong.
+**/
+STATIC
+VOID
+ScriptError (
+  IN CONST SCRIPT_CONTEXT    *Ctx,
+  IN CONST SCRIPT_STATEMENT  *Statement,
+  IN CONST CHAR16            *Message
+  )
+{
+  Print (L"%s(%d): %s\n", Ctx->Name, Statement->LineNumber, Message);
+}
+
+/**
+  Locate the parts of an 'if' statement:
+    if [/i] [not] Left Operator Right [then]
+  where Operator is ==, eq, ne, lt, gt, le or ge.
+
+  @param[in]  Statement         The 'if' statement.
+  @param[out] CaseInsensitive   TRUE if /i was given.
+  @param[out] Not               TRUE if not was given.
+  @param[out] Left              Index of the left operand token.
+
+  @retval TRUE    The statement is well formed.
+  @retval FALSE   It is not.
+**/
+STATIC
+BOOLEAN
+ScriptConditionLayout (
+  IN  CONST SCRIPT_STATEMENT  *Statement,
+  OUT BOOLEAN                 *CaseInsensitive,
+  OUT BOOLEAN                 *Not,
+  OUT UINTN                   *Left
+  )
+{
+  UINTN         Index;
+  CONST CHAR16  *Operator;
+
+  Index            = 1;
+  *CaseInsensitive = FALSE;
+  *Not             = FALSE;
+
+  if (Index < Statement->Argc && ScriptStriCmp (Statement->Argv[Index], L"/i") == 0) {
+    *CaseInsensitive = TRUE;
+    Index++;
+  }
+  if (Index < Statement->Argc && ScriptStriCmp (Statement->Argv[Index], L"not") == 0) {
+    *Not = TRUE;
+    Index++;
+  }
+
+  if (Index + 3 != Statement->Argc &&
+      !(Index + 4 == Statement->Argc && ScriptStriCmp (Statement->Argv[Index + 3], L"then") == 0)) {
+    return FALSE;
+  }
+
+  *Left    = Index;
+  Operator = Statement->Argv[Index + 1];
+  return (BOOLEAN) (StrCmp (Operator, L"==") == 0 ||
+                    ScriptStriCmp (Operator, L"eq") == 0 ||
+                    ScriptStriCmp (Operator, L"ne") == 0 ||
+                    ScriptStriCmp (Operator, L"lt") == 0 ||
+                    ScriptStriCmp (Operator, L"gt") == 0 ||
+                    ScriptStriCmp (Operator, L"le") == 0 ||
+                    ScriptStriCmp (Operator, L"ge") == 0);
+}
+
+/**
+  Split the script into statements and resolve every jump.
+
+  @param[in, out] Ctx     The script; Statements and Count are set.
+  @param[in, out] Script  The script text.  Lines are terminated in place.
+
+  @retval EFI_SUCCESS             The script is well formed.
+  @retval EFI_INVALID_PARAMETER   The script is malformed; the error has been
+                                  reported.
+  @retval EFI_OUT_OF_RESOURCES    The statements could not be allocated.
+**/
+STATIC
+EFI_STATUS
+ScriptParse (
+  IN OUT SCRIPT_CONTEXT  *Ctx,
+  IN OUT CHAR16          *Script
+  )
+{
+  EFI_STATUS        Status;
+  CHAR16            *Line;
+  CHAR16            *Next;
+  UINTN             Lines;
+  UINTN             LineNumber;
+  UINTN             Length;
+  UINTN             Blocks[CONSOLE_SCRIPT_MAX_NESTING];
+  UINTN             Depth;
+  UINTN             Index;
+  UINTN             Label;
+  SCRIPT_STATEMENT  *Statement;
+  SCRIPT_STATEMENT  *Block;
+  BOOLEAN           CaseInsensitive;
+  BOOLEAN           Not;
+  UINTN             Left;
+
+  Lines = 1;
+  for (Line = Script; *Line != CHAR_NULL; Line++) {
+    if (*Line == L'\n') {
+      Lines++;
+    }
+  }
+
+  Ctx->Statements = AllocateZeroPool (Lines * sizeof (SCRIPT_STATEMENT));
+  if (Ctx->Statements == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Depth      = 0;
+  LineNumber = 0;
+  for (Line = Script; Line != NULL; Line = Next) {
+    LineNumber++;
+    for (Next = Line; *Next != CHAR_NULL && *Next != L'\n'; Next++) {
+    }
+    if (*Next == CHAR_NULL) {
+      Next = NULL;
+    } else {
+      *Next++ = CHAR_NULL;
+    }
+
+    //
+    // Trim the line; skip blank lines and comments
+    //
+    while (*Line == L' ' || *Line == L'\t') {
+      Line++;
+    }
+    Length = StrLen (Line);
+    while (Length > 0 && (Line[Length - 1] == L'\r' || Line[Length - 1] == L' ' || Line[Length - 1] == L'\t')) {
+      Line[--Length] = CHAR_NULL;
+    }
+    if (*Line == CHAR_NULL || *Line == L'#') {
+      continue;
+    }
+
+    Statement             = &Ctx->Statements[Ctx->Count];
+    Statement->LineNumber = LineNumber;
+    Statement->Echo       = TRUE;
+    if (*Line == L'@') {
+      Statement->Echo = FALSE;
+      for (Line++; *Line == L' ' || *Line == L'\t'; Line++) {
+      }
+      if (*Line == CHAR_NULL) {
+        continue;
+      }
+    }
+    Statement->Text = Line;
+
+    if (*Line == L':') {
+      Statement->Type = ScriptLabel;
+      Statement->Text = Line + 1;
+    } else if (ScriptFirstWordIs (Line, L"for")) {
+      Statement->Type = ScriptFor;
+    } else if (ScriptFirstWordIs (Line, L"endfor")) {
+      Statement->Type = ScriptEndFor;
+    } else if (ScriptFirstWordIs (Line, L"if")) {
+      Statement->Type = ScriptIf;
+    } else if (ScriptFirstWordIs (Line, L"else")) {
+      Statement->Type = ScriptElse;
+    } else if (ScriptFirstWordIs (Line, L"endif")) {
+      Statement->Type = ScriptEndIf;
+    } else if (ScriptFirstWordIs (Line, L"goto")) {
+      Statement->Type = ScriptGoto;
+    } else {
+      Statement->Type = ScriptCommand;
+    }
+    Ctx->Count++;
+
+    if (Statement->Type == ScriptCommand) {
+      continue;
+    }
+
+    Status = ScriptSplitStatement (Statement);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    switch (Statement->Type) {
+    case ScriptLabel:
+      if (Statement->Argc != 1) {
+        ScriptError (Ctx, Statement, L"Invalid label.");
+        return EFI_INVALID_PARAMETER;
+      }
+      break;
+
+    case ScriptGoto:
+      if (Statement->Argc != 2) {
+        ScriptError (Ctx, Statement, L"Usage: goto Label");
+        return EFI_INVALID_PARAMETER;
+      }
+      break;
+
+    case ScriptFor:
+      if (Statement->Argc < 3 ||
+          StrLen (Statement->Argv[1]) != 2 || Statement->Argv[1][0] != L'%' ||
+          CharToUpper (Statement->Argv[1][1]) < L'A' || CharToUpper (Statement->Argv[1][1]) > L'Z' ||
+          (ScriptStriCmp (Statement->Argv[2], L"in") != 0 && ScriptStriCmp (Statement->Argv[2], L"run") != 0)) {
+        ScriptError (Ctx, Statement, L"Usage: for %x in Value... | for %x run (Start End [Step])");
+        return EFI_INVALID_PARAMETER;
+      }
+      //
+      // Fall through
+      //
+    case ScriptIf:
+      if (Statement->Type == ScriptIf && !ScriptConditionLayout (Statement, &CaseInsensitive, &Not, &Left)) {
+        ScriptError (Ctx, Statement, L"Usage: if [/i] [not] Left ==|eq|ne|lt|gt|le|ge Right [then]");
+        return EFI_INVALID_PARAMETER;
+      }
+      if (Depth == CONSOLE_SCRIPT_MAX_NESTING) {
+        ScriptError (Ctx, Statement, L"Blocks nested too deeply.");
+        return EFI_INVALID_PARAMETER;
+      }
+      Blocks[Depth++] = Ctx->Count - 1;
+      break;
+
+    case ScriptEndFor:
+      if (Depth == 0 || Ctx->Statements[Blocks[Depth - 1]].Type != ScriptFor) {
+        ScriptError (Ctx, Statement, L"endfor without for.");
+        return EFI_INVALID_PARAMETER;
+      }
+      Block             = &Ctx->Statements[Blocks[--Depth]];
+      Block->Target     = Ctx->Count - 1;
+      Statement->Target = Blocks[Depth];
+      break;
+
+    case ScriptElse:
+      if (Depth == 0 || Ctx->Statements[Blocks[Depth - 1]].Type != ScriptIf) {
+        ScriptError (Ctx, Statement, L"else without if.");
+        return EFI_INVALID_PARAMETER;
+      }
+      Ctx->Statements[Blocks[Depth - 1]].Target = Ctx->Count - 1;
+      Blocks[Depth - 1] = Ctx->Count - 1;
+      break;
+
+    case ScriptEndIf:
+      if (Depth == 0 ||
+          (Ctx->Statements[Blocks[Depth - 1]].Type != ScriptIf &&
+           Ctx->Statements[Blocks[Depth - 1]].Type != ScriptElse)) {
+        ScriptError (Ctx, Statement, L"endif without if.");
+        return EFI_INVALID_PARAMETER;
+      }
+      Ctx->Statements[Blocks[--Depth]].Target = Ctx->Count - 1;
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  if (Depth != 0) {
+    ScriptError (
+      Ctx,
+      &Ctx->Statements[Blocks[Depth - 1]],
+      (Ctx->Statements[Blocks[Depth - 1]].Type == ScriptFor) ? L"for without endfor." : L"if without endif."
+      );
+    return EFI_INVALID_PARAMETER;
+  }
+
+  for (Index = 0; Index < Ctx->Count; Index++) {
+    Statement = &Ctx->Statements[Index];
+    if (Statement->Type != ScriptGoto) {
+      continue;
+    }
+    for (Label = 0; Label < Ctx->Count; Label++) {
+      if (Ctx->Statements[Label].Type == ScriptLabel &&
+          ScriptStriCmp (Ctx->Statements[Label].Argv[0], Statement->Argv[1]) == 0) {
+        break;
+      }
+    }
+    if (Label == Ctx->Count) {
+      ScriptError (Ctx, Statement, L"Label not found.");
+      return EFI_INVALID_PARAMETER;
+    }
+    Statement->Target = Label;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Expand the %-variables of a string: %0 to %9 are the script arguments,
+  %a to %z the loop variables, %lasterror% the status of the last command
+  and %% a single %.
+
+  @param[in]  Ctx     The script.
+  @param[in]  Text    The string to expand.
+  @param[out] Output  The expanded string, or NULL to only measure it.
+
+  @return The length of the expanded string, in characters.
+**/
+STATIC
+UINTN
+ScriptExpandTo (
+  IN  CONST SCRIPT_CONTEXT  *Ctx,
+  IN  CONST CHAR16          *Text,
+  OUT CHAR16                *Output OPTIONAL
+  )
+{
+  UINTN         Length;
+  UINTN         ValueLength;
+  UINTN         Skip;
+  UINTN         Index;
+  CONST CHAR16  *Value;
+  CHAR16        Number[20];
+
+  Length = 0;
+  while (*Text != CHAR_NULL) {
+    Value = NULL;
+    Skip  = 2;
+    if (*Text == L'%') {
+      if (Text[1] == L'%') {
+        Value = L"%";
+      } else if (Text[1] >= L'0' && Text[1] <= L'9') {
+        Index = Text[1] - L'0';
+        Value = (Index < Ctx->Argc) ? Ctx->Argv[Index] : L"";
+      } else if (ScriptSkipPrefix (Text + 1, L"lasterror%") != NULL) {
+        UnicodeSPrint (Number, sizeof (Number), L"0x%lx", (UINT64) (Ctx->LastError & ~MAX_BIT));
+        Value = Number;
+        Skip  = 11;
+      } else {
+        for (Index = Ctx->LoopDepth; Index > 0; Index--) {
+          if (CharToUpper (Ctx->Loops[Index - 1].Variable) == CharToUpper (Text[1])) {
+            Value = Ctx->Loops[Index - 1].Value;
+            break;
+          }
+        }
+      }
+    }
+
+    if (Value == NULL) {
+      if (Output != NULL) {
+        Output[Length] = *Text;
+      }
+      Length++;
+      Text++;
+      continue;
+    }
+
+    ValueLength = StrLen (Value);
+    if (Output != NULL) {
+      CopyMem (Output + Length, Value, ValueLength * sizeof (CHAR16));
+    }
+    Length += ValueLength;
+    Text   += Skip;
+  }
+
+  if (Output != NULL) {
+    Output[Length] = CHAR_NULL;
+  }
+  return Length;
+}
+
+/**
+  Expand the %-variables of a string into the scratch arena.
+
+  @param[in] Ctx    The script.
+  @param[in] Text   The string to expand.
+
+  @return The expanded string, to be freed with ConsoleArenaFree(), or NULL
+          if it could not be allocated.
+**/
+STATIC
+CHAR16 *
+ScriptExpand (
+  IN CONST SCRIPT_CONTEXT  *Ctx,
+  IN CONST CHAR16          *Text
+  )
+{
+  CHAR16  *Output;
+
+  Output = ConsoleArenaAllocateZero ((ScriptExpandTo (Ctx, Text, NULL) + 1) * sizeof (CHAR16));
+  if (Output != NULL) {
+    ScriptExpandTo (Ctx, Text, Output);
+  }
+  return Output;
+}
+
+/**
+  Evaluate the condition of an 'if' statement.  Operands that are both
+  numbers are compared as numbers, anything else as strings.
+
+  @param[in]  Ctx         The script.
+  @param[in]  Statement   The 'if' statement.
+  @param[out] Result      The value of the condition.
+
+  @retval EFI_SUCCESS           The condition was evaluated.
+  @retval EFI_OUT_OF_RESOURCES  An operand could not be expanded.
+**/
+STATIC
+EFI_STATUS
+ScriptEvaluateCondition (
+  IN  CONST SCRIPT_CONTEXT    *Ctx,
+  IN  CONST SCRIPT_STATEMENT  *Statement,
+  OUT BOOLEAN                 *Result
+  )
+{
+  BOOLEAN       CaseInsensitive;
+  BOOLEAN       Not;
+  UINTN         Left;
+  CHAR16        *LeftValue;
+  CHAR16        *RightValue;
+  CONST CHAR16  *Operator;
+  INT64         LeftNumber;
+  INT64         RightNumber;
+  INTN          Compare;
+
+  ScriptConditionLayout (Statement, &CaseInsensitive, &Not, &Left);
+  LeftValue  = ScriptExpand (Ctx, Statement->Argv[Left]);
+  RightValue = ScriptExpand (Ctx, Statement->Argv[Left + 2]);
+  if (LeftValue == NULL || RightValue == NULL) {
+    ConsoleArenaFree (LeftValue);
+    ConsoleArenaFree (RightValue);
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Operator = Statement->Argv[Left + 1];
+
+  if (StrCmp (Operator, L"==") != 0 &&
+      ScriptStrToInt64 (LeftValue, &LeftNumber) &&
+      ScriptStrToInt64 (RightValue, &RightNumber)) {
+    Compare = (LeftNumber < RightNumber) ? -1 : (LeftNumber > RightNumber) ? 1 : 0;
+  } else if (CaseInsensitive) {
+    Compare = ScriptStriCmp (LeftValue, RightValue);
+  } else {
+    Compare = StrCmp (LeftValue, RightValue);
+  }
+
+  if (StrCmp (Operator, L"==") == 0 || ScriptStriCmp (Operator, L"eq") == 0) {
+    *Result = (BOOLEAN) (Compare == 0);
+  } else if (ScriptStriCmp (Operator, L"ne") == 0) {
+    *Result = (BOOLEAN) (Compare != 0);
+  } else if (ScriptStriCmp (Operator, L"lt") == 0) {
+    *Result = (BOOLEAN) (Compare < 0);
+  } else if (ScriptStriCmp (Operator, L"gt") == 0) {
+    *Result = (BOOLEAN) (Compare > 0);
+  } else if (ScriptStriCmp (Operator, L"le") == 0) {
+    *Result = (BOOLEAN) (Compare <= 0);
+  } else {
+    *Result = (BOOLEAN) (Compare >= 0);
+  }
+
+  if (Not) {
+    *Result = (BOOLEAN) !*Result;
+  }
+
+  ConsoleArenaFree (LeftValue);
+  ConsoleArenaFree (RightValue);
+  return EFI_SUCCESS;
+}
+
+/**
+  Move a loop to its next value.
+
+  @param[in]      Ctx   The script.
+  @param[in, out] Loop  The loop; Value is replaced.
+
+  @retval EFI_SUCCESS           The loop variable has its next value.
+  @retval EFI_END_OF_FILE       The loop is over.
+  @retval EFI_OUT_OF_RESOURCES  The value could not be allocated.
+**/
+STATIC
+EFI_STATUS
+ScriptLoopNext (
+  IN     CONST SCRIPT_CONTEXT  *Ctx,
+  IN OUT SCRIPT_LOOP           *Loop
+  )
+{
+  CONST SCRIPT_STATEMENT  *For;
+  CHAR16                  *Value;
+
+  SHELL_FREE_NON_NULL (Loop->Value);
+  For = &Ctx->Statements[Loop->ForIndex];
+
+  if (Loop->Range) {
+    if ((Loop->Step > 0) ? (Loop->Current > Loop->End) : (Loop->Current < Loop->End)) {
+      return EFI_END_OF_FILE;
+    }
+    Loop->Value = AllocateZeroPool (24 * sizeof (CHAR16));
+    if (Loop->Value == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    UnicodeSPrint (Loop->Value, 24 * sizeof (CHAR16), L"%ld", Loop->Current);
+    Loop->Current += Loop->Step;
+    return EFI_SUCCESS;
+  }
+
+  if (Loop->Position >= For->Argc) {
+    return EFI_END_OF_FILE;
+  }
+  Value = ScriptExpand (Ctx, For->Argv[Loop->Position++]);
+  if (Value == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Loop->Value = AllocateCopyPool (StrSize (Value), Value);
+  ConsoleArenaFree (Value);
+  return (Loop->Value == NULL) ? EFI_OUT_OF_RESOURCES : EFI_SUCCESS;
+}
+
+/**
+  Start the loop of a 'for' statement.
+
+  @param[in, out] Ctx       The script; the loop is pushed.
+  @param[in]      ForIndex  The 'for' statement.
+
+  @retval EFI_SUCCESS             The loop variable has its first value.
+  @retval EFI_END_OF_FILE         The loop has no value; it is not pushed.
+  @retval EFI_INVALID_PARAMETER   The range is invalid or the loops are
+                                  nested too deeply; the error has been
+                                  reported.
+  @retval EFI_OUT_OF_RESOURCES    The value could not be allocated.
+**/
+STATIC
+EFI_STATUS
+ScriptLoopStart (
+  IN OUT SCRIPT_CONTEXT  *Ctx,
+  IN     UINTN           ForIndex
+  )
+{
+  EFI_STATUS              Status;
+  CONST SCRIPT_STATEMENT  *For;
+  SCRIPT_LOOP             *Loop;
+  INT64                   Range[3];
+  UINTN                   Count;
+  UINTN                   Index;
+  CHAR16                  *Expanded;
+  CHAR16                  *Value;
+  UINTN                   Length;
+  BOOLEAN                 Valid;
+
+  For = &Ctx->Statements[ForIndex];
+  if (Ctx->LoopDepth == CONSOLE_SCRIPT_MAX_NESTING) {
+    ScriptError (Ctx, For, L"Loops nested too deeply.");
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Loop = &Ctx->Loops[Ctx->LoopDepth];
+  ZeroMem (Loop, sizeof (SCRIPT_LOOP));
+  Loop->ForIndex = ForIndex;
+  Loop->Variable = For->Argv[1][1];
+  Loop->Position = 3;
+  Loop->Range    = (BOOLEAN) (ScriptStriCmp (For->Argv[2], L"run") == 0);
+
+  if (Loop->Range) {
+    //
+    // (Start End [Step]), the parentheses may touch the numbers
+    //
+    Count = 0;
+    for (Index = 3; Index < For->Argc; Index++) {
+      Expanded = ScriptExpand (Ctx, For->Argv[Index]);
+      if (Expanded == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+      }
+      Value = Expanded;
+      if (*Value == L'(') {
+        Value++;
+      }
+      Length = StrLen (Value);
+      if (Length > 0 && Value[Length - 1] == L')') {
+        Value[--Length] = CHAR_NULL;
+      }
+      Valid = TRUE;
+      if (Length != 0) {
+        Valid = (BOOLEAN) (Count < ARRAY_SIZE (Range) && ScriptStrToInt64 (Value, &Range[Count]));
+        Count++;
+      }
+      ConsoleArenaFree (Expanded);
+      if (!Valid) {
+        Count = 0;
+        break;
+      }
+    }
+    if (Count < 2) {
+      ScriptError (Ctx, For, L"Invalid range.");
+      return EFI_INVALID_PARAMETER;
+    }
+    Loop->Current = Range[0];
+    Loop->End     = Range[1];
+    Loop->Step    = (Count == 3) ? Range[2] : ((Range[1] >= Range[0]) ? 1 : -1);
+    if (Loop->Step == 0) {
+      ScriptError (Ctx, For, L"Invalid range.");
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  Status = ScriptLoopNext (Ctx, Loop);
+  if (!EFI_ERROR (Status)) {
+    Ctx->LoopDepth++;
+  }
+  return Status;
+}
+
+/**
+  Pop the innermost loop.
+
+  @param[in, out] Ctx   The script.
+**/
+STATIC
+VOID
+ScriptLoopPop (
+  IN OUT SCRIPT_CONTEXT  *Ctx
+  )
+{
+  ASSERT (Ctx->LoopDepth > 0);
+  Ctx->LoopDepth--;
+  SHELL_FREE_NON_NULL (Ctx->Loops[Ctx->LoopDepth].Value);
+}
+
+/**
+  Run the statements of a parsed script.
+
+  @param[in, out] Ctx   The script.
+  @param[in]      Echo  TRUE to echo command lines.
+
+  @retval EFI_SUCCESS           The script ran to its end or to 'exit'.
+  @retval EFI_ABORTED           The script was stopped.
+**/
+STATIC
+EFI_STATUS
+ScriptExecute (
+  IN OUT SCRIPT_CONTEXT  *Ctx,
+  IN     BOOLEAN         Echo
+  )
+{
+  EFI_STATUS        Status;
+  EFI_STATUS        CommandStatus;
+  UINTN             Index;
+  UINTN             ArenaMark;
+  SCRIPT_STATEMENT  *Statement;
+  SCRIPT_LOOP       *Loop;
+  CHAR16            *CmdLine;
+  BOOLEAN           Result;
+
+  Status = EFI_SUCCESS;
+  Result = FALSE;
+  Index  = 0;
+  while (Index < Ctx->Count && !EFI_ERROR (Status) && !ConsoleCommandGetExit ()) {
+    if (ConsoleCheckEscape ()) {
+      Print (L"%s: Aborted.\n", Ctx->Name);
+      Status = EFI_ABORTED;
+      break;
+    }
+
+    Statement = &Ctx->Statements[Index];
+    ArenaMark = ConsoleArenaMark ();
+
+    switch (Statement->Type) {
+    case ScriptCommand:
+      CmdLine = ScriptExpand (Ctx, Statement->Text);
+      if (CmdLine == NULL) {
+        Status = EFI_OUT_OF_RESOURCES;
+        break;
+      }
+      if (Echo && Statement->Echo) {
+        Print (L"> %s\n", CmdLine);
+      }
+      CommandStatus = EFI_SUCCESS;
+      Status        = RunShellCommand (CmdLine, &CommandStatus);
+      ConsoleArenaFree (CmdLine);
+      if (Status == EFI_NOT_FOUND) {
+        ScriptError (Ctx, Statement, L"Unknown command.");
+        CommandStatus = Status;
+        Status        = EFI_SUCCESS;
+      }
+      Ctx->LastError = CommandStatus;
+      Index++;
+      break;
+
+    case ScriptGoto:
+      //
+      // Leaving a loop by goto ends it
+      //
+      while (Ctx->LoopDepth > 0) {
+        Loop = &Ctx->Loops[Ctx->LoopDepth - 1];
+        if (Statement->Target > Loop->ForIndex && Statement->Target < Ctx->Statements[Loop->ForIndex].Target) {
+          break;
+        }
+        ScriptLoopPop (Ctx);
+      }
+      Index = Statement->Target + 1;
+      break;
+
+    case ScriptFor:
+      Status = ScriptLoopStart (Ctx, Index);
+      if (Status == EFI_END_OF_FILE) {
+        Status = EFI_SUCCESS;
+        Index  = Statement->Target + 1;
+      } else {
+        Index++;
+      }
+      break;
+
+    case ScriptEndFor:
+      if (Ctx->LoopDepth == 0 || Ctx->Loops[Ctx->LoopDepth - 1].ForIndex != Statement->Target) {
+        ScriptError (Ctx, Statement, L"endfor reached outside its loop.");
+        Status = EFI_ABORTED;
+        break;
+      }
+      Status = ScriptLoopNext (Ctx, &Ctx->Loops[Ctx->LoopDepth - 1]);
+      if (Status == EFI_END_OF_FILE) {
+        ScriptLoopPop (Ctx);
+        Status = EFI_SUCCESS;
+        Index++;
+      } else {
+        Index = Statement->Target + 1;
+      }
+      break;
+
+    case ScriptIf:
+      Status = ScriptEvaluateCondition (Ctx, Statement, &Result);
+      Index  = Result ? Index + 1 : Statement->Target + 1;
+      break;
+
+    case ScriptElse:
+      //
+      // The 'if' branch is done, skip to the endif
+      //
+      Index = Statement->Target;
+      break;
+
+    default:
+      Index++;
+      break;
+    }
+
+    ConsoleArenaReset (ArenaMark);
+  }
+
+  while (Ctx->LoopDepth > 0) {
+    ScriptLoopPop (Ctx);
+  }
+
+  return EFI_ERROR (Status) ? EFI_ABORTED : EFI_SUCCESS;
+}
+
+/**
+  Run a script.
+
+  The script is split into statements once: 'for'/'endfor', 'if'/'else'/
+  'endif', 'goto' and ':label' lines are classified and their jump targets
+  resolved before anything runs, so a malformed script runs no command at
+  all.  Every other line is a command line, expanded and run through
+  RunShellCommand().
+
+  @param[in]      Name    Name of the script, for messages and %0.
+  @param[in, out] Script  The NULL-terminated script text.  It is modified.
+  @param[in]      Argc    Number of script arguments, including %0.
+  @param[in]      Argv    Script arguments; Argv[0] is %0.
+  @param[in]      Echo    TRUE to echo each command line before it runs.
+
+  @retval EFI_SUCCESS             The script ran to its end or to 'exit'.
+                                  'exit' only leaves this script.
+  @retval EFI_INVALID_PARAMETER   The script is malformed.
+  @retval EFI_ABORTED             The script was stopped with ESC or failed
+                                  at run time.
+  @retval EFI_OUT_OF_RESOURCES    The script could not be prepared.
+**/
+EFI_STATUS
+ConsoleRunScript (
+  IN     CONST CHAR16  *Name,
+  IN OUT CHAR16        *Script,
+  IN     UINTN         Argc,
+  IN     CONST CHAR16  **Argv,
+  IN     BOOLEAN       Echo
+  )
+{
+  EFI_STATUS      Status;
+  SCRIPT_CONTEXT  *Ctx;
+  UINTN           Index;
+
+  if (mScriptDepth == CONSOLE_SCRIPT_MAX_NESTING) {
+    Print (L"%s: Scripts nested too deeply.\n", Name);
+    return EFI_ABORTED;
+  }
+
+  Ctx = AllocateZeroPool (sizeof (SCRIPT_CONTEXT));
+  if (Ctx == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Ctx->Name = Name;
+  Ctx->Argc = Argc;
+  Ctx->Argv = Argv;
+
+  Status = ScriptParse (Ctx, Script);
+  if (!EFI_ERROR (Status)) {
+    mScriptDepth++;
+    Status = ScriptExecute (Ctx, Echo);
+    mScriptDepth--;
+
+    //
+    // 'exit' in a script leaves the script, not the scripts that called it
+    // or the console session
+    //
+    if (ConsoleCommandGetExit ()) {
+      ConsoleCommandClearExit ();
+    }
+  }
+
+  if (Ctx->Statements != NULL) {
+    for (Index = 0; Index < Ctx->Count; Index++) {
+      SHELL_FREE_NON_NULL (Ctx->Statements[Index].Argv);
+    }
+    FreePool (Ctx->Statements);
+  }
+  FreePool (Ctx);
+  return Status;
+}
+
+/**
+  Convert script file contents to a NULL-terminated string.  UCS-2 text
+  must start with a byte order mark; anything else is taken as ASCII.
+
+  @param[in]  Data      The file contents.
+  @param[in]  Size      Size of Data in bytes.
+  @param[out] Script    The script text; free with FreePool().
+
+  @retval EFI_SUCCESS           The text was converted.
+  @retval EFI_OUT_OF_RESOURCES  The text could not be allocated.
+**/
+STATIC
+EFI_STATUS
+ScriptTextToUnicode (
+  IN  CONST VOID  *Data,
+  IN  UINTN       Size,
+  OUT CHAR16      **Script
+  )
+{
+  CONST UINT8  *Bytes;
+  CHAR16       *Text;
+  UINTN        Length;
+  UINTN        Index;
+
+  Bytes = Data;
+  if (Size >= sizeof (CHAR16) && ReadUnaligned16 ((CONST UINT16 *) Bytes) == 0xFEFF) {
+    Length = (Size - sizeof (CHAR16)) / sizeof (CHAR16);
+    Text   = AllocatePool ((Length + 1) * sizeof (CHAR16));
+    if (Text == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    CopyMem (Text, Bytes + sizeof (CHAR16), Length * sizeof (CHAR16));
+  } else {
+    Length = Size;
+    Text   = AllocatePool ((Length + 1) * sizeof (CHAR16));
+    if (Text == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    for (Index = 0; Index < Length; Index++) {
+      Text[Index] = Bytes[Index];
+    }
+  }
+
+  Text[Length] = CHAR_NULL;
+  *Script      = Text;
+  return EFI_SUCCESS;
+}
+
+/**
+  Load a script stored in the first EFI_SECTION_RAW section of an FFS file.
+
+  @param[in]  FileName  Name of the FFS file.
+  @param[out] Script    The NULL-terminated script text; free with FreePool().
+
+  @retval EFI_SUCCESS           The script was loaded.
+  @retval EFI_NOT_FOUND         The file or its raw section was not found.
+  @retval EFI_OUT_OF_RESOURCES  The script could not be converted.
+**/
+EFI_STATUS
+ConsoleLoadScriptFromFv (
+  IN  CONST EFI_GUID  *FileName,
+  OUT CHAR16          **Script
+  )
+{
+  EFI_STATUS  Status;
+  VOID        *Data;
+  UINTN       Size;
+
+  Status = GetSectionFromAnyFv (FileName, EFI_SECTION_RAW, 0, &Data, &Size);
+  if (EFI_ERROR (Status)) {
+    return EFI_NOT_FOUND;
+  }
+
+  Status = ScriptTextToUnicode (Data, Size, Script);
+  FreePool (Data);
+  return Status;
+}
+
+/**
+  Read a script from one file system.
+
+  @param[in]  Handle    Handle of the simple file system.
+  @param[in]  FileName  Path of the file in the file system.
+  @param[out] Script    The NULL-terminated script text; free with FreePool().
+
+  @retval EFI_SUCCESS           The script was read.
+  @retval EFI_NOT_FOUND         The file could not be opened.
+  @retval EFI_BAD_BUFFER_SIZE   The file is larger than CONSOLE_SCRIPT_MAX_SIZE.
+  @retval other                 The file could not be read.
+**/
+STATIC
+EFI_STATUS
+ScriptReadFile (
+  IN  EFI_HANDLE  Handle,
+  IN  CHAR16      *FileName,
+  OUT CHAR16      **Script
+  )
+{
+  EFI_STATUS                       Status;
+  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *FileSystem;
+  EFI_FILE_PROTOCOL                *Root;
+  EFI_FILE_PROTOCOL                *File;
+  UINT64                           FileSize;
+  UINTN                            Size;
+  VOID                             *Data;
+
+  Status = gBS->HandleProtocol (Handle, &gEfiSimpleFileSystemProtocolGuid, (VOID **) &FileSystem);
+  if (EFI_ERROR (Status)) {
+    return EFI_NOT_FOUND;
+  }
+  Status = FileSystem->OpenVolume (FileSystem, &Root);
+  if (EFI_ERROR (Status)) {
+    return EFI_NOT_FOUND;
+  }
+  Status = Root->Open (Root, &File, FileName, EFI_FILE_MODE_READ, 0);
+  Root->Close (Root);
+  if (EFI_ERROR (Status)) {
+    return EFI_NOT_FOUND;
+  }
+
+  //
+  // Seeking to MAX_UINT64 moves to the end of the file
+  //
+  Status = File->SetPosition (File, MAX_UINT64);
+  if (!EFI_ERROR (Status)) {
+    Status = File->GetPosition (File, &FileSize);
+  }
+  if (!EFI_ERROR (Status)) {
+    Status = File->SetPosition (File, 0);
+  }
+  if (EFI_ERROR (Status)) {
+    File->Close (File);
+    return Status;
+  }
+  if (FileSize > CONSOLE_SCRIPT_MAX_SIZE) {
+    File->Close (File);
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  Size = (UINTN) FileSize;
+  Data = AllocatePool (Size + 1);
+  if (Data == NULL) {
+    File->Close (File);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = File->Read (File, &Size, Data);
+  File->Close (File);
+  if (!EFI_ERROR (Status)) {
+    Status = ScriptTextToUnicode (Data, Size, Script);
+  }
+  FreePool (Data);
+  return Status;
+}
+
+/**
+  Load a script from a file system.
+
+  Path is either "fsN:\dir\file.nsh", naming the N-th simple file system
+  handle, or "\dir\file.nsh", in which case every file system is searched.
+
+  @param[in]  Path      Path of the script.
+  @param[out] Script    The NULL-terminated script text; free with FreePool().
+
+  @retval EFI_SUCCESS           The script was loaded.
+  @retval EFI_NOT_FOUND         No file system holds the file.
+  @retval EFI_BAD_BUFFER_SIZE   The file is larger than CONSOLE_SCRIPT_MAX_SIZE.
+  @retval EFI_OUT_OF_RESOURCES  The script could not be read.
+**/
+EFI_STATUS
+ConsoleLoadScriptFromFile (
+  IN  CONST CHAR16  *Path,
+  OUT CHAR16        **Script
+  )
+{
+  EFI_STATUS    Status;
+  CONST CHAR16  *FilePath;
+  CONST CHAR16  *Walker;
+  CHAR16        *FileName;
+  UINTN         FileSystemIndex;
+  EFI_HANDLE    *Handles;
+  UINTN         HandleCount;
+  UINTN         Index;
+
+  //
+  // An "fsN:" prefix selects one file system
+  //
+  FileSystemIndex = MAX_UINTN;
+  FilePath        = StrStr (Path, L":");
+  if (FilePath != NULL) {
+    if (FilePath - Path < 3 || CharToUpper (Path[0]) != L'F' || CharToUpper (Path[1]) != L'S') {
+      return EFI_NOT_FOUND;
+    }
+    FileSystemIndex = 0;
+    for (Walker = Path + 2; Walker < FilePath; Walker++) {
+      if (!ConsoleIsDecimalDigitCharacter (*Walker)) {
+        return EFI_NOT_FOUND;
+      }
+      FileSystemIndex = FileSystemIndex * 10 + (*Walker - L'0');
+    }
+    FilePath++;
+  } else {
+    FilePath = Path;
+  }
+
+  FileName = AllocateCopyPool (StrSize (FilePath), FilePath);
+  if (FileName == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  for (Index = 0; FileName[Index] != CHAR_NULL; Index++) {
+    if (FileName[Index] == L'/') {
+      FileName[Index] = L'\\';
+    }
+  }
+
+  Status = gBS->LocateHandleBuffer (
+                  ByProtocol,
+                  &gEfiSimpleFileSystemProtocolGuid,
+                  NULL,
+                  &HandleCount,
+                  &Handles
+                  );
+  if (EFI_ERROR (Status)) {
+    FreePool (FileName);
+    return EFI_NOT_FOUND;
+  }
+
+  Status = EFI_NOT_FOUND;
+  for (Index = 0; Index < HandleCount; Index++) {
+    if (FileSystemIndex != MAX_UINTN && Index != FileSystemIndex) {
+      continue;
+    }
+    Status = ScriptReadFile (Handles[Index], FileName, Script);
+    if (Status != EFI_NOT_FOUND) {
+      break;
+    }
+  }
+
+  FreePool (Handles);
+  FreePool (FileName);
+  return Status;
+}
+
+/**
+  Reset the capture; there is nothing to reset.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+PipeCaptureReset (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN BOOLEAN                          ExtendedVerification
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Append a string to the captured output.  Output beyond
+  CONSOLE_PIPE_MAX_LENGTH characters is dropped.
+
+  @param[in] This     The capture.
+  @param[in] String   The string.
+
+  @retval EFI_SUCCESS   The string was captured or dropped.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+PipeCaptureOutputString (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN CHAR16                           *String
+  )
+{
+  PIPE_CAPTURE  *Capture;
+  CHAR16        *NewBuffer;
+  UINTN         NewCapacity;
+  UINTN         Length;
+
+  Capture = (PIPE_CAPTURE *) This;
+  Length  = StrLen (String);
+
+  if (Capture->Length + Length + 1 > Capture->Capacity) {
+    if (Capture->Length + Length + 1 > CONSOLE_PIPE_MAX_LENGTH) {
+      Capture->Truncated = TRUE;
+      return EFI_SUCCESS;
+    }
+    NewCapacity = MAX (MAX (Capture->Capacity * 2, SIZE_4KB), Capture->Length + Length + 1);
+    NewCapacity = MIN (NewCapacity, CONSOLE_PIPE_MAX_LENGTH);
+    NewBuffer   = ReallocatePool (
+                    Capture->Capacity * sizeof (CHAR16),
+                    NewCapacity * sizeof (CHAR16),
+                    Capture->Buffer
+                    );
+    if (NewBuffer == NULL) {
+      Capture->Truncated = TRUE;
+      return EFI_SUCCESS;
+    }
+    Capture->Buffer   = NewBuffer;
+    Capture->Capacity = NewCapacity;
+  }
+
+  CopyMem (Capture->Buffer + Capture->Length, String, Length * sizeof (CHAR16));
+  Capture->Length += Length;
+  Capture->Buffer[Capture->Length] = CHAR_NULL;
+  return EFI_SUCCESS;
+}
+
+/**
+  Check whether the console can display a string.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+PipeCaptureTestString (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN CHAR16                           *String
+  )
+{
+  PIPE_CAPTURE  *Capture;
+
+  Capture = (PIPE_CAPTURE *) This;
+  return Capture->Original->TestString (Capture->Original, String);
+}
+
+/**
+  Report the geometry of a mode of the console.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+PipeCaptureQueryMode (
+  IN  EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN  UINTN                            ModeNumber,
+  OUT UINTN                            *Columns,
+  OUT UINTN                            *Rows
+  )
+{
+  PIPE_CAPTURE  *Capture;
+
+  Capture = (PIPE_CAPTURE *) This;
+  return Capture->Original->QueryMode (Capture->Original, ModeNumber, Columns, Rows);
+}
+
+/**
+  Ignore a mode change.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+PipeCaptureSetMode (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN UINTN                            ModeNumber
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Ignore a color change.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+PipeCaptureSetAttribute (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN UINTN                            Attribute
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Ignore a clear screen request.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+PipeCaptureClearScreen (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Ignore a cursor move.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+PipeCaptureSetCursorPosition (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN UINTN                            Column,
+  IN UINTN                            Row
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Ignore a cursor visibility change.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+PipeCaptureEnableCursor (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN BOOLEAN                          Visible
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Redirect the console output into a capture.  Screen control requests are
+  ignored, a captured command only produces text.
+
+  @param[out] Capture   The capture to install.
+**/
+STATIC
+VOID
+PipeCaptureStart (
+  OUT PIPE_CAPTURE  *Capture
+  )
+{
+  ZeroMem (Capture, sizeof (PIPE_CAPTURE));
+  Capture->Protocol.Reset             = PipeCaptureReset;
+  Capture->Protocol.OutputString      = PipeCaptureOutputString;
+  Capture->Protocol.TestString        = PipeCaptureTestString;
+  Capture->Protocol.QueryMode         = PipeCaptureQueryMode;
+  Capture->Protocol.SetMode           = PipeCaptureSetMode;
+  Capture->Protocol.SetAttribute      = PipeCaptureSetAttribute;
+  Capture->Protocol.ClearScreen       = PipeCaptureClearScreen;
+  Capture->Protocol.SetCursorPosition = PipeCaptureSetCursorPosition;
+  Capture->Protocol.EnableCursor      = PipeCaptureEnableCursor;
+  Capture->Protocol.Mode              = gST->ConOut->Mode;
+  Capture->Original                   = gST->ConOut;
+
+  gST->ConOut = &Capture->Protocol;
+  ConsoleUpdateSystemTableCrc ();
+}
+
+/**
+  Restore the console output replaced by PipeCaptureStart().
+
+  @param[in, out] Capture   The installed capture.  Buffer always holds a
+                            string afterwards, unless it is NULL because
+                            memory ran out.
+**/
+STATIC
+VOID
+PipeCaptureStop (
+  IN OUT PIPE_CAPTURE  *Capture
+  )
+{
+  gST->ConOut = Capture->Original;
+  ConsoleUpdateSystemTableCrc ();
+
+  if (Capture->Truncated) {
+    Print (L"Pipe output truncated to %d characters.\n", Capture->Length);
+  }
+  if (Capture->Buffer == NULL) {
+    Capture->Buffer = AllocateZeroPool (sizeof (CHAR16));
+  }
+}
+
+/**
+  Run a command line made of commands separated by '|'.  The console output
+  of each command is captured and handed to the next one, which reads it
+  with ConsoleGetPipeInput().  A '|' escaped as '^|' is not a separator.
+
+  @param[in]  CmdLine         The command line.
+  @param[out] CommandStatus   The status of the last command.
+
+  @retval EFI_SUCCESS   The pipeline was run.
+  @retval other         A command could not be run.
+**/
+EFI_STATUS
+ConsoleRunPipeline (
+  IN  CONST CHAR16  *CmdLine,
+  OUT EFI_STATUS    *CommandStatus OPTIONAL
+  )
+{
+  EFI_STATUS    Status;
+  CHAR16        *Line;
+  CHAR16        *Stage;
+  CHAR16        *Next;
+  CHAR16        *Input;
+  CHAR16        *SavedInput;
+  PIPE_CAPTURE  Capture;
+
+  Line = ConsoleArenaAllocateCopy (StrSize (CmdLine), CmdLine);
+  if (Line == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status     = EFI_SUCCESS;
+  Input      = NULL;
+  SavedInput = mPipeInput;
+
+  for (Stage = Line; Stage != NULL; Stage = Next) {
+    Next = (CHAR16 *) FindFirstCharacter (Stage, L"|", L'^');
+    if (*Next == CHAR_NULL) {
+      Next = NULL;
+    } else {
+      *Next++ = CHAR_NULL;
+    }
+
+    if (Next != NULL) {
+      PipeCaptureStart (&Capture);
+    }
+
+    mPipeInput = Input;
+    Status     = RunShellCommand (Stage, CommandStatus);
+    mPipeInput = SavedInput;
+
+    SHELL_FREE_NON_NULL (Input);
+    if (Next != NULL) {
+      PipeCaptureStop (&Capture);
+      Input = Capture.Buffer;
+    }
+
+    if (EFI_ERROR (Status) || ConsoleCommandGetExit ()) {
+      SHELL_FREE_NON_NULL (Input);
+      break;
+    }
+  }
+
+  ConsoleArenaFree (Line);
+  return Status;
+}
+
+/**
+  Get the output of the previous command of the pipeline.
+
+  @return The NULL-terminated output, or NULL if the running command is not
+          the target of a pipe.
+**/
+CHAR16 *
+ConsoleGetPipeInput (
+  VOID
+  )
+{
+  return mPipeInput;
+}
@@ -0,0 +1,123 @@
+/** @file
+  Script files and command pipelines of the UEFI console.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#ifndef _CONSOLE_SCRIPT_H_
+#define _CONSOLE_SCRIPT_H_
+
+//
+// Largest script file accepted, and deepest nesting of for and if blocks.
+//
+#define CONSOLE_SCRIPT_MAX_SIZE     SIZE_1MB
+#define CONSOLE_SCRIPT_MAX_NESTING  16
+
+//
+// Largest output, in characters, a pipeline stage may hand to the next one.
+//
+#define CONSOLE_PIPE_MAX_LENGTH     SIZE_1MB
+
+/**
+  Load a script stored in the first EFI_SECTION_RAW section of an FFS file.
+
+  @param[in]  FileName  Name of the FFS file.
+  @param[out] Script    The NULL-terminated script text; free with FreePool().
+
+  @retval EFI_SUCCESS           The script was loaded.
+  @retval EFI_NOT_FOUND         The file or its raw section was not found.
+  @retval EFI_OUT_OF_RESOURCES  The script could not be converted.
+**/
+EFI_STATUS
+ConsoleLoadScriptFromFv (
+  IN  CONST EFI_GUID  *FileName,
+  OUT CHAR16          **Script
+  );
+
+/**
+  Load a script from a file system.
+
+  Path is either "fsN:\dir\file.nsh", naming the N-th simple file system
+  handle, or "\dir\file.nsh", in which case every file system is searched.
+
+  @param[in]  Path      Path of the script.
+  @param[out] Script    The NULL-terminated script text; free with FreePool().
+
+  @retval EFI_SUCCESS           The script was loaded.
+  @retval EFI_NOT_FOUND         No file system holds the file.
+  @retval EFI_BAD_BUFFER_SIZE   The file is larger than CONSOLE_SCRIPT_MAX_SIZE.
+  @retval EFI_OUT_OF_RESOURCES  The script could not be read.
+**/
+EFI_STATUS
+ConsoleLoadScriptFromFile (
+  IN  CONST CHAR16  *Path,
+  OUT CHAR16        **Script
+  );
+
+/**
+  Run a script.
+
+  The script is split into statements once: 'for'/'endfor', 'if'/'else'/
+  'endif', 'goto' and ':label' lines are classified and their jump targets
+  resolved before anything runs, so a malformed script runs no command at
+  all.  Every other line is a command line, expanded and run through
+  RunShellCommand().
+
+  @param[in]      Name    Name of the script, for messages and %0.
+  @param[in, out] Script  The NULL-terminated script text.  It is modified.
+  @param[in]      Argc    Number of script arguments, including %0.
+  @param[in]      Argv    Script arguments; Argv[0] is %0.
+  @param[in]      Echo    TRUE to echo each command line before it runs.
+
+  @retval EFI_SUCCESS             The script ran to its end or to 'exit'.
+                                  'exit' only leaves this script.
+  @retval EFI_INVALID_PARAMETER   The script is malformed.
+  @retval EFI_ABORTED             The script was stopped with ESC or failed
+                                  at run time.
+  @retval EFI_OUT_OF_RESOURCES    The script could not be prepared.
+**/
+EFI_STATUS
+ConsoleRunScript (
+  IN     CONST CHAR16  *Name,
+  IN OUT CHAR16        *Script,
+  IN     UINTN         Argc,
+  IN     CONST CHAR16  **Argv,
+  IN     BOOLEAN       Echo
+  );
+
+/**
+  Run a command line made of commands separated by '|'.  The console output
+  of each command is captured and handed to the next one, which reads it
+  with ConsoleGetPipeInput().  A '|' escaped as '^|' is not a separator.
+
+  @param[in]  CmdLine         The command line.
+  @param[out] CommandStatus   The status of the last command.
+
+  @retval EFI_SUCCESS   The pipeline was run.
+  @retval other         A command could not be run.
+**/
+EFI_STATUS
+ConsoleRunPipeline (
+  IN  CONST CHAR16  *CmdLine,
+  OUT EFI_STATUS    *CommandStatus OPTIONAL
+  );
+
+/**
+  Get the output of the previous command of the pipeline.
+
+  @return The NULL-terminated output, or NULL if the running command is not
+          the target of a pipe.
+**/
+CHAR16 *
+ConsoleGetPipeInput (
+  VOID
+  );
+
+#endif
@@ -0,0 +1,975 @@
+/** @file
+  Direct serial transport of the UEFI console.
+
+  A serial session uses two small protocol instances, in place of ConIn and
+  ConOut of the system table, that talk to one SerialIo port:
+  output is converted to ASCII and written with one SerialIo call per
+  string, cursor control is sent as VT100 escape sequences, and VT100 key
+  sequences are decoded back into EFI scan codes.  The line editor of the
+  console runs on top of them unchanged.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include "UefiConsole.h"
+
+#define SERIAL_ENTER_KEY          0x12        // Ctrl-R
+#define SERIAL_ESC                0x1B
+#define SERIAL_FIFO_SIZE          64
+#define SERIAL_OUTPUT_SIZE        512
+#define SERIAL_BYTE_TIMEOUT       50          // ms to wait for the rest of an escape sequence
+#define SERIAL_REPORT_POLLS       4           // polls to wait for the terminal size report (200ms)
+#define SERIAL_DEFAULT_COLUMNS    80
+#define SERIAL_DEFAULT_ROWS       25
+
+//
+// Progress of the terminal size report ESC [ Rows ; Columns R
+//
+typedef enum {
+  SerialReportNone,         ///< No report is expected.
+  SerialReportEsc,          ///< Waiting for the ESC; other bytes are skipped.
+  SerialReportBracket,      ///< Waiting for the '['.
+  SerialReportRows,         ///< Reading Rows, up to the ';'.
+  SerialReportColumns       ///< Reading Columns, up to the 'R'.
+} SERIAL_REPORT_STATE;
+
+typedef struct {
+  EFI_SIMPLE_TEXT_INPUT_PROTOCOL    Protocol;
+  UINT8                             Fifo[SERIAL_FIFO_SIZE];
+  UINTN                             Head;
+  UINTN                             Count;
+  BOOLEAN                           LastWasCr;      ///< Swallow the LF of a CR LF pair.
+} SERIAL_TEXT_IN;
+
+typedef struct {
+  EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL   Protocol;
+  EFI_SIMPLE_TEXT_OUTPUT_MODE       Mode;
+  UINTN                             Columns;
+  UINTN                             Rows;
+  UINT8                             Buffer[SERIAL_OUTPUT_SIZE];
+  UINTN                             Length;
+} SERIAL_TEXT_OUT;
+
+typedef struct {
+  SERIAL_REPORT_STATE               State;
+  UINTN                             Value[2];       ///< Rows and Columns read so far.
+  UINTN                             PollsLeft;
+} SERIAL_SIZE_REPORT;
+
+STATIC EFI_SERIAL_IO_PROTOCOL    *mSerialIo         = NULL;
+STATIC EFI_DEVICE_PATH_PROTOCOL  *mSerialDevicePath = NULL;
+STATIC EFI_EVENT                 mSerialIoEvent     = NULL;
+STATIC VOID                      *mSerialIoRegistration;
+STATIC EFI_EVENT                 mSerialPollEvent   = NULL;
+STATIC SERIAL_TEXT_IN            mSerialIn;
+STATIC SERIAL_TEXT_OUT           mSerialOut;
+STATIC SERIAL_SIZE_REPORT        mSerialReport;
+
+//
+// ANSI color number of each EFI color
+//
+STATIC CONST UINT8  mAnsiColor[8] = { 0, 4, 2, 6, 1, 5, 3, 7 };
+
+/**
+  Move the bytes received by the port into the input FIFO, without waiting.
+**/
+STATIC
+VOID
+SerialFill (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Control;
+  UINTN       Size;
+  UINT8       Byte;
+
+  while (mSerialIn.Count < SERIAL_FIFO_SIZE) {
+    //
+    // Ports that cannot report an empty receive buffer rely on the short
+    // read timeout set by ConsoleSerialStartMonitor()
+    //
+    Status = mSerialIo->GetControl (mSerialIo, &Control);
+    if (!EFI_ERROR (Status) && (Control & EFI_SERIAL_INPUT_BUFFER_EMPTY) != 0) {
+      break;
+    }
+
+    Size   = 1;
+    Status = mSerialIo->Read (mSerialIo, &Size, &Byte);
+    if (EFI_ERROR (Status) || Size == 0) {
+      break;
+    }
+
+    mSerialIn.Fifo[(mSerialIn.Head + mSerialIn.Count) % SERIAL_FIFO_SIZE] = Byte;
+    mSerialIn.Count++;
+  }
+}
+
+/**
+  Take a byte from the input FIFO, waiting up to Timeout milliseconds.
+
+  @param[out] Byte      The byte.
+  @param[in]  Timeout   Milliseconds to wait; 0 does not wait.
+
+  @retval TRUE    A byte was taken.
+  @retval FALSE   No byte arrived in time.
+**/
+STATIC
+BOOLEAN
+SerialGetByte (
+  OUT UINT8  *Byte,
+  IN  UINTN  Timeout
+  )
+{
+  for (;;) {
+    if (mSerialIn.Count == 0) {
+      SerialFill ();
+    }
+    if (mSerialIn.Count != 0) {
+      *Byte          = mSerialIn.Fifo[mSerialIn.Head];
+      mSerialIn.Head = (mSerialIn.Head + 1) % SERIAL_FIFO_SIZE;
+      mSerialIn.Count--;
+      return TRUE;
+    }
+    if (Timeout == 0) {
+      return FALSE;
+    }
+    gBS->Stall (1000);
+    Timeout--;
+  }
+}
+
+/**
+  Send the buffered output to the port.
+**/
+STATIC
+VOID
+SerialFlush (
+  VOID
+  )
+{
+  UINTN  Size;
+
+  if (mSerialOut.Length != 0) {
+    Size = mSerialOut.Length;
+    mSerialIo->Write (mSerialIo, &Size, mSerialOut.Buffer);
+    mSerialOut.Length = 0;
+  }
+}
+
+/**
+  Buffer one byte of output.
+
+  @param[in] Byte   The byte.
+**/
+STATIC
+VOID
+SerialPutByte (
+  IN UINT8  Byte
+  )
+{
+  if (mSerialOut.Length == SERIAL_OUTPUT_SIZE) {
+    SerialFlush ();
+  }
+  mSerialOut.Buffer[mSerialOut.Length++] = Byte;
+}
+
+/**
+  Buffer a formatted escape sequence and send the output.
+
+  @param[in] Format   ASCII format string of the sequence, without the ESC.
+  @param[in] ...      Arguments of Format.
+**/
+STATIC
+VOID
+SerialSendSequence (
+  IN CONST CHAR8  *Format,
+  ...
+  )
+{
+  VA_LIST  Marker;
+  CHAR8    Sequence[32];
+  UINTN    Length;
+  UINTN    Index;
+
+  VA_START (Marker, Format);
+  Length = AsciiVSPrint (Sequence, sizeof (Sequence), Format, Marker);
+  VA_END (Marker);
+
+  SerialPutByte (SERIAL_ESC);
+  for (Index = 0; Index < Length; Index++) {
+    SerialPutByte ((UINT8) Sequence[Index]);
+  }
+  SerialFlush ();
+}
+
+/**
+  Decode the rest of a VT100 key sequence whose ESC has been read.  A lone
+  ESC, or ESC followed by anything unknown, is the ESC key.
+
+  @param[out] Key   The decoded key.
+**/
+STATIC
+VOID
+SerialDecodeEscape (
+  OUT EFI_INPUT_KEY  *Key
+  )
+{
+  UINT8  Byte;
+  UINTN  Number;
+
+  Key->ScanCode = SCAN_ESC;
+
+  if (!SerialGetByte (&Byte, SERIAL_BYTE_TIMEOUT) || (Byte != '[' && Byte != 'O')) {
+    return;
+  }
+  if (!SerialGetByte (&Byte, SERIAL_BYTE_TIMEOUT)) {
+    return;
+  }
+
+  switch (Byte) {
+  case 'A':
+    Key->ScanCode = SCAN_UP;
+    return;
+  case 'B':
+    Key->ScanCode = SCAN_DOWN;
+    return;
+  case 'C':
+    Key->ScanCode = SCAN_RIGHT;
+    return;
+  case 'D':
+    Key->ScanCode = SCAN_LEFT;
+    return;
+  case 'H':
+    Key->ScanCode = SCAN_HOME;
+    return;
+  case 'F':
+    Key->ScanCode = SCAN_END;
+    return;
+  default:
+    break;
+  }
+
+  //
+  // ESC [ n ~
+  //
+  Number = 0;
+  while (Byte >= '0' && Byte <= '9') {
+    Number = Number * 10 + (Byte - '0');
+    if (!SerialGetByte (&Byte, SERIAL_BYTE_TIMEOUT)) {
+      return;
+    }
+  }
+  if (Byte != '~') {
+    return;
+  }
+
+  switch (Number) {
+  case 1:
+  case 7:
+    Key->ScanCode = SCAN_HOME;
+    break;
+  case 2:
+    Key->ScanCode = SCAN_INSERT;
+    break;
+  case 3:
+    Key->ScanCode = SCAN_DELETE;
+    break;
+  case 4:
+  case 8:
+    Key->ScanCode = SCAN_END;
+    break;
+  case 5:
+    Key->ScanCode = SCAN_PAGE_UP;
+    break;
+  case 6:
+    Key->ScanCode = SCAN_PAGE_DOWN;
+    break;
+  default:
+    break;
+  }
+}
+
+/**
+  Reset the input; the FIFO is emptied.
+
+  @param[in] This                   The serial input.
+  @param[in] ExtendedVerification   Ignored.
+
+  @retval EFI_SUCCESS   The input was reset.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+SerialInReset (
+  IN EFI_SIMPLE_TEXT_INPUT_PROTOCOL  *This,
+  IN BOOLEAN                         ExtendedVerification
+  )
+{
+  mSerialIn.Head      = 0;
+  mSerialIn.Count     = 0;
+  mSerialIn.LastWasCr = FALSE;
+  return EFI_SUCCESS;
+}
+
+/**
+  Read the next key from the port.
+
+  @param[in]  This  The serial input.
+  @param[out] Key   The key.
+
+  @retval EFI_SUCCESS     A key was read.
+  @retval EFI_NOT_READY   No key is waiting.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+SerialInReadKeyStroke (
+  IN  EFI_SIMPLE_TEXT_INPUT_PROTOCOL  *This,
+  OUT EFI_INPUT_KEY                   *Key
+  )
+{
+  UINT8    Byte;
+  BOOLEAN  LastWasCr;
+
+  do {
+    if (!SerialGetByte (&Byte, 0)) {
+      return EFI_NOT_READY;
+    }
+    LastWasCr           = mSerialIn.LastWasCr;
+    mSerialIn.LastWasCr = (BOOLEAN) (Byte == CHAR_CARRIAGE_RETURN);
+  } while (Byte == CHAR_LINEFEED && LastWasCr);
+
+  Key->ScanCode    = SCAN_NULL;
+  Key->UnicodeChar = CHAR_NULL;
+
+  switch (Byte) {
+  case SERIAL_ESC:
+    SerialDecodeEscape (Key);
+    break;
+  case 0x7F:
+    Key->UnicodeChar = CHAR_BACKSPACE;
+    break;
+  case CHAR_LINEFEED:
+    Key->UnicodeChar = CHAR_CARRIAGE_RETURN;
+    break;
+  default:
+    Key->UnicodeChar = Byte;
+    break;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Signal WaitForKey when a key is waiting.
+
+  @param[in] Event    The WaitForKey event.
+  @param[in] Context  Not used.
+**/
+STATIC
+VOID
+EFIAPI
+SerialInWaitForKey (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  if (mSerialIn.Count == 0) {
+    SerialFill ();
+  }
+  if (mSerialIn.Count != 0) {
+    gBS->SignalEvent (Event);
+  }
+}
+
+/**
+  Reset the terminal to the default colors and clear it.
+
+  @param[in] This                   The serial output.
+  @param[in] ExtendedVerification   Ignored.
+
+  @retval EFI_SUCCESS   The terminal was reset.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+SerialOutReset (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN BOOLEAN                          ExtendedVerification
+  )
+{
+  This->SetAttribute (This, EFI_TEXT_ATTR (EFI_LIGHTGRAY, EFI_BLACK));
+  return This->ClearScreen (This);
+}
+
+/**
+  Write a string to the port.  Characters outside ASCII are written as '?'.
+  The cursor position is tracked the way the terminal moves it.
+
+  @param[in] This     The serial output.
+  @param[in] String   The string.
+
+  @retval EFI_SUCCESS   The string was written.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+SerialOutOutputString (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN CHAR16                           *String
+  )
+{
+  EFI_SIMPLE_TEXT_OUTPUT_MODE  *Mode;
+
+  Mode = &mSerialOut.Mode;
+  for (; *String != CHAR_NULL; String++) {
+    switch (*String) {
+    case CHAR_CARRIAGE_RETURN:
+      Mode->CursorColumn = 0;
+      break;
+    case CHAR_LINEFEED:
+      if ((UINTN) Mode->CursorRow < mSerialOut.Rows - 1) {
+        Mode->CursorRow++;
+      }
+      break;
+    case CHAR_BACKSPACE:
+      if (Mode->CursorColumn > 0) {
+        Mode->CursorColumn--;
+      }
+      break;
+    default:
+      if (*String < L' ') {
+        continue;
+      }
+      Mode->CursorColumn++;
+      if ((UINTN) Mode->CursorColumn >= mSerialOut.Columns) {
+        Mode->CursorColumn = 0;
+        if ((UINTN) Mode->CursorRow < mSerialOut.Rows - 1) {
+          Mode->CursorRow++;
+        }
+      }
+      break;
+    }
+    SerialPutByte ((*String < 0x7F) ? (UINT8) *String : '?');
+  }
+
+  SerialFlush ();
+  return EFI_SUCCESS;
+}
+
+/**
+  Check whether a string can be written.  Every character can, possibly
+  as '?'.
+
+  @param[in] This     The serial output.
+  @param[in] String   The string.
+
+  @retval EFI_SUCCESS   The string can be written.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+SerialOutTestString (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN CHAR16                           *String
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Report the size of the terminal, the only mode.
+
+  @param[in]  This        The serial output.
+  @param[in]  ModeNumber  The mode; only 0 exists.
+  @param[out] Columns     The number of columns.
+  @param[out] Rows        The number of rows.
+
+  @retval EFI_SUCCESS       The size was reported.
+  @retval EFI_UNSUPPORTED   ModeNumber is not 0.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+SerialOutQueryMode (
+  IN  EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN  UINTN                            ModeNumber,
+  OUT UINTN                            *Columns,
+  OUT UINTN                            *Rows
+  )
+{
+  if (ModeNumber != 0) {
+    return EFI_UNSUPPORTED;
+  }
+  *Columns = mSerialOut.Columns;
+  *Rows    = mSerialOut.Rows;
+  return EFI_SUCCESS;
+}
+
+/**
+  Select a mode; only mode 0 exists.
+
+  @param[in] This         The serial output.
+  @param[in] ModeNumber   The mode.
+
+  @retval EFI_SUCCESS       The terminal was cleared.
+  @retval EFI_UNSUPPORTED   ModeNumber is not 0.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+SerialOutSetMode (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN UINTN                            ModeNumber
+  )
+{
+  if (ModeNumber != 0) {
+    return EFI_UNSUPPORTED;
+  }
+  return This->ClearScreen (This);
+}
+
+/**
+  Set the colors with an SGR sequence.
+
+  @param[in] This       The serial output.
+  @param[in] Attribute  EFI foreground and background colors.
+
+  @retval EFI_SUCCESS   The colors were set.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+SerialOutSetAttribute (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN UINTN                            Attribute
+  )
+{
+  mSerialOut.Mode.Attribute = (INT32) Attribute;
+  SerialSendSequence (
+    "[0;%a3%d;4%dm",
+    ((Attribute & EFI_BRIGHT) != 0) ? "1;" : "",
+    mAnsiColor[Attribute & 0x07],
+    mAnsiColor[(Attribute >> 4) & 0x07]
+    );
+  return EFI_SUCCESS;
+}
+
+/**
+  Clear the terminal and home the cursor.
+
+  @param[in] This   The serial output.
+
+  @retval EFI_SUCCESS   The terminal was cleared.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+SerialOutClearScreen (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This
+  )
+{
+  SerialSendSequence ("[2J\x1B[H");
+  mSerialOut.Mode.CursorColumn = 0;
+  mSerialOut.Mode.CursorRow    = 0;
+  return EFI_SUCCESS;
+}
+
+/**
+  Move the cursor with a CUP sequence.
+
+  @param[in] This     The serial output.
+  @param[in] Column   The column, from 0.
+  @param[in] Row      The row, from 0.
+
+  @retval EFI_SUCCESS       The cursor was moved.
+  @retval EFI_UNSUPPORTED   The position is outside the terminal.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+SerialOutSetCursorPosition (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN UINTN                            Column,
+  IN UINTN                            Row
+  )
+{
+  if (Column >= mSerialOut.Columns || Row >= mSerialOut.Rows) {
+    return EFI_UNSUPPORTED;
+  }
+  SerialSendSequence ("[%d;%dH", (UINT32) (Row + 1), (UINT32) (Column + 1));
+  mSerialOut.Mode.CursorColumn = (INT32) Column;
+  mSerialOut.Mode.CursorRow    = (INT32) Row;
+  return EFI_SUCCESS;
+}
+
+/**
+  Show or hide the cursor.
+
+  @param[in] This     The serial output.
+  @param[in] Visible  TRUE to show the cursor.
+
+  @retval EFI_SUCCESS   The cursor was shown or hidden.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+SerialOutEnableCursor (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN BOOLEAN                          Visible
+  )
+{
+  SerialSendSequence (Visible ? "[?25h" : "[?25l");
+  mSerialOut.Mode.CursorVisible = Visible;
+  return EFI_SUCCESS;
+}
+
+/**
+  Ask the terminal for its size: the cursor is moved to the far bottom right
+  corner, which the terminal clamps, and its position is requested.  The
+  report is collected by SerialPollNotify() without waiting; 80x25 is used
+  if the terminal does not answer.
+**/
+STATIC
+VOID
+SerialRequestTerminalSize (
+  VOID
+  )
+{
+  mSerialOut.Columns = SERIAL_DEFAULT_COLUMNS;
+  mSerialOut.Rows    = SERIAL_DEFAULT_ROWS;
+
+  SerialSendSequence ("7\x1B[999;999H\x1B[6n\x1B" "8");
+
+  mSerialReport.State     = SerialReportEsc;
+  mSerialReport.PollsLeft = SERIAL_REPORT_POLLS;
+}
+
+/**
+  Feed one received byte to the terminal size report.  Bytes before the
+  ESC, such as keys typed meanwhile, are skipped; a malformed report ends
+  the wait with the default size.
+
+  @param[in] Byte   The byte.
+**/
+STATIC
+VOID
+SerialParseTerminalSize (
+  IN UINT8  Byte
+  )
+{
+  UINTN  *Value;
+
+  switch (mSerialReport.State) {
+  case SerialReportEsc:
+    if (Byte == SERIAL_ESC) {
+      mSerialReport.State = SerialReportBracket;
+    }
+    return;
+
+  case SerialReportBracket:
+    mSerialReport.Value[0] = 0;
+    mSerialReport.Value[1] = 0;
+    mSerialReport.State    = (Byte == '[') ? SerialReportRows : SerialReportNone;
+    return;
+
+  case SerialReportRows:
+  case SerialReportColumns:
+    Value = &mSerialReport.Value[(mSerialReport.State == SerialReportRows) ? 0 : 1];
+    if (Byte >= '0' && Byte <= '9') {
+      *Value = *Value * 10 + (Byte - '0');
+    } else if (Byte == ';' && mSerialReport.State == SerialReportRows) {
+      mSerialReport.State = SerialReportColumns;
+    } else {
+      if (Byte == 'R' && mSerialReport.State == SerialReportColumns &&
+          mSerialReport.Value[0] >= 10 && mSerialReport.Value[1] >= 40) {
+        mSerialOut.Rows    = mSerialReport.Value[0];
+        mSerialOut.Columns = mSerialReport.Value[1];
+      }
+      mSerialReport.State = SerialReportNone;
+    }
+    return;
+
+  default:
+    return;
+  }
+}
+
+/**
+  Start a console session over the serial port, with the terminal size
+  found by SerialRequestTerminalSize().
+**/
+STATIC
+VOID
+SerialStartSession (
+  VOID
+  )
+{
+  mSerialOut.Mode.CursorVisible = TRUE;
+  mSerialOut.Mode.Attribute     = EFI_TEXT_ATTR (EFI_LIGHTGRAY, EFI_BLACK);
+
+  ConsoleStartSession (&mSerialIn.Protocol, &mSerialOut.Protocol);
+}
+
+/**
+  Timer notification: ask the terminal for its size when Ctrl-R arrives on
+  the port, and open a session once the report has been received or a few
+  polls have passed without it.  Nothing here waits for the port.
+  Anything else received outside a session is dropped; during a session
+  the port belongs to the session.
+
+  @param[in] Event    The poll timer.
+  @param[in] Context  Not used.
+**/
+STATIC
+VOID
+EFIAPI
+SerialPollNotify (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  UINT8   Byte;
+
+  if (ConsoleSessionActive ()) {
+    return;
+  }
+
+  if (mSerialReport.State != SerialReportNone) {
+    while (mSerialReport.State != SerialReportNone && SerialGetByte (&Byte, 0)) {
+      SerialParseTerminalSize (Byte);
+    }
+    if (mSerialReport.State != SerialReportNone && --mSerialReport.PollsLeft != 0) {
+      return;
+    }
+    mSerialReport.State = SerialReportNone;
+    SerialStartSession ();
+    return;
+  }
+
+  while (SerialGetByte (&Byte, 0)) {
+    if (Byte == SERIAL_ENTER_KEY) {
+      SerialInReset (&mSerialIn.Protocol, FALSE);
+      SerialRequestTerminalSize ();
+      break;
+    }
+  }
+}
+
+/**
+  Check whether a SerialIo handle is the configured port: its device path
+  starts with the nodes of PcdConsoleSerialDevicePath.
+
+  @param[in] Handle   The SerialIo handle.
+
+  @retval TRUE    The handle is the configured port.
+  @retval FALSE   It is another port.
+**/
+STATIC
+BOOLEAN
+SerialIsConfiguredPort (
+  IN EFI_HANDLE  Handle
+  )
+{
+  EFI_DEVICE_PATH_PROTOCOL  *DevicePath;
+  UINTN                     Size;
+
+  DevicePath = DevicePathFromHandle (Handle);
+  if (DevicePath == NULL) {
+    return FALSE;
+  }
+
+  Size = GetDevicePathSize (mSerialDevicePath) - END_DEVICE_PATH_LENGTH;
+  return (BOOLEAN) (GetDevicePathSize (DevicePath) >= Size + END_DEVICE_PATH_LENGTH &&
+                    CompareMem (DevicePath, mSerialDevicePath, Size) == 0);
+}
+
+/**
+  Protocol notification of SerialIo: take the configured port once it is
+  installed, then start polling it for Ctrl-R.  Ports that were installed
+  before the notification was registered are reported on its first signal.
+
+  @param[in] Event    The SerialIo protocol notification.
+  @param[in] Context  Not used.
+**/
+STATIC
+VOID
+EFIAPI
+SerialIoNotify (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EFI_STATUS              Status;
+  EFI_HANDLE              Handle;
+  UINTN                   Size;
+  EFI_SERIAL_IO_PROTOCOL  *SerialIo;
+  EFI_SERIAL_IO_MODE      *Mode;
+
+  for (;;) {
+    Size   = sizeof (Handle);
+    Status = gBS->LocateHandle (ByRegisterNotify, NULL, mSerialIoRegistration, &Size, &Handle);
+    if (EFI_ERROR (Status)) {
+      return;
+    }
+    if (mSerialIo == NULL && SerialIsConfiguredPort (Handle)) {
+      Status = gBS->HandleProtocol (Handle, &gEfiSerialIoProtocolGuid, (VOID **) &SerialIo);
+      if (!EFI_ERROR (Status)) {
+        break;
+      }
+    }
+  }
+
+  //
+  // Keep the line settings, but make a read of an idle port return at once
+  //
+  Mode = SerialIo->Mode;
+  SerialIo->SetAttributes (
+              SerialIo,
+              Mode->BaudRate,
+              Mode->ReceiveFifoDepth,
+              1000,
+              (EFI_PARITY_TYPE) Mode->Parity,
+              (UINT8) Mode->DataBits,
+              (EFI_STOP_BITS_TYPE) Mode->StopBits
+              );
+
+  Status = gBS->SetTimer (mSerialPollEvent, TimerPeriodic, CONSOLE_SERIAL_POLL_INTERVAL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "Console serial transport unavailable: %r\n", Status));
+    return;
+  }
+
+  mSerialIo = SerialIo;
+  gBS->CloseEvent (mSerialIoEvent);
+  mSerialIoEvent = NULL;
+}
+
+/**
+  Start watching the serial port selected by PcdConsoleSerialDevicePath for
+  Ctrl-R.  A Ctrl-R received on the port opens a console session that reads
+  and writes the port directly, with VT100 escape sequences for cursor
+  control, instead of going through ConIn and ConOut.
+
+  The port is usually installed after this driver has been dispatched, so
+  it is taken from a SerialIo protocol notification whenever it appears.
+  It should not also be bound to the terminal driver, or the terminal
+  driver and the console compete for its input.
+
+  @retval EFI_SUCCESS             The port is being watched, or waited for.
+  @retval EFI_UNSUPPORTED         The serial transport is disabled.
+  @retval EFI_INVALID_PARAMETER   PcdConsoleSerialDevicePath is not a
+                                  device path.
+  @retval other                   The events could not be created.
+**/
+EFI_STATUS
+ConsoleSerialStartMonitor (
+  VOID
+  )
+{
+  EFI_STATUS              Status;
+  CONST CHAR16            *PortPath;
+
+  PortPath = (CONST CHAR16 *) PcdGetPtr (PcdConsoleSerialDevicePath);
+  if (PortPath == NULL || *PortPath == CHAR_NULL) {
+    return EFI_UNSUPPORTED;
+  }
+
+  mSerialDevicePath = ConvertTextToDevicePath (PortPath);
+  if (mSerialDevicePath == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  ZeroMem (&mSerialIn, sizeof (mSerialIn));
+  mSerialIn.Protocol.Reset         = SerialInReset;
+  mSerialIn.Protocol.ReadKeyStroke = SerialInReadKeyStroke;
+  Status = gBS->CreateEvent (
+                  EVT_NOTIFY_WAIT,
+                  TPL_NOTIFY,
+                  SerialInWaitForKey,
+                  NULL,
+                  &mSerialIn.Protocol.WaitForKey
+                  );
+  if (EFI_ERROR (Status)) {
+    ConsoleSerialStopMonitor ();
+    return Status;
+  }
+
+  ZeroMem (&mSerialOut, sizeof (mSerialOut));
+  mSerialOut.Protocol.Reset             = SerialOutReset;
+  mSerialOut.Protocol.OutputString      = SerialOutOutputString;
+  mSerialOut.Protocol.TestString        = SerialOutTestString;
+  mSerialOut.Protocol.QueryMode         = SerialOutQueryMode;
+  mSerialOut.Protocol.SetMode           = SerialOutSetMode;
+  mSerialOut.Protocol.SetAttribute      = SerialOutSetAttribute;
+  mSerialOut.Protocol.ClearScreen       = SerialOutClearScreen;
+  mSerialOut.Protocol.SetCursorPosition = SerialOutSetCursorPosition;
+  mSerialOut.Protocol.EnableCursor      = SerialOutEnableCursor;
+  mSerialOut.Protocol.Mode              = &mSerialOut.Mode;
+  mSerialOut.Mode.MaxMode               = 1;
+  mSerialOut.Columns                    = SERIAL_DEFAULT_COLUMNS;
+  mSerialOut.Rows                       = SERIAL_DEFAULT_ROWS;
+
+  ZeroMem (&mSerialReport, sizeof (mSerialReport));
+
+  Status = gBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  SerialPollNotify,
+                  NULL,
+                  &mSerialPollEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    ConsoleSerialStopMonitor ();
+    return Status;
+  }
+
+  mSerialIoEvent = EfiCreateProtocolNotifyEvent (
+                     &gEfiSerialIoProtocolGuid,
+                     TPL_CALLBACK,
+                     SerialIoNotify,
+                     NULL,
+                     &mSerialIoRegistration
+                     );
+  if (mSerialIoEvent == NULL) {
+    ConsoleSerialStopMonitor ();
+    return EFI_OUT_OF_RESOURCES;
+  }
+  return EFI_SUCCESS;
+}
+
+/**
+  Stop watching the serial port.
+**/
+VOID
+ConsoleSerialStopMonitor (
+  VOID
+  )
+{
+  if (mSerialIoEvent != NULL) {
+    gBS->CloseEvent (mSerialIoEvent);
+    mSerialIoEvent = NULL;
+  }
+  if (mSerialPollEvent != NULL) {
+    gBS->SetTimer (mSerialPollEvent, TimerCancel, 0);
+    gBS->CloseEvent (mSerialPollEvent);
+    mSerialPollEvent = NULL;
+  }
+  if (mSerialIn.Protocol.WaitForKey != NULL) {
+    gBS->CloseEvent (mSerialIn.Protocol.WaitForKey);
+    mSerialIn.Protocol.WaitForKey = NULL;
+  }
+  if (mSerialDevicePath != NULL) {
+    FreePool (mSerialDevicePath);
+    mSerialDevicePath = NULL;
+  }
+  mSerialIo = NULL;
+}
@@ -0,0 +1,52 @@
+/** @file
+  Direct serial transport of the UEFI console.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#ifndef _CONSOLE_SERIAL_H_
+#define _CONSOLE_SERIAL_H_
+
+//
+// Interval of the Ctrl-R poll of the serial port, in 100ns units (50ms).
+//
+#define CONSOLE_SERIAL_POLL_INTERVAL  (50 * 1000 * 10)
+
+/**
+  Start watching the serial port selected by PcdConsoleSerialDevicePath for
+  Ctrl-R.  A Ctrl-R received on the port opens a console session that reads
+  and writes the port directly, with VT100 escape sequences for cursor
+  control, instead of going through ConIn and ConOut.
+
+  The port is usually installed after this driver has been dispatched, so
+  it is taken from a SerialIo protocol notification whenever it appears.
+  It should not also be bound to the terminal driver, or the terminal
+  driver and the console compete for its input.
+
+  @retval EFI_SUCCESS             The port is being watched, or waited for.
+  @retval EFI_UNSUPPORTED         The serial transport is disabled.
+  @retval EFI_INVALID_PARAMETER   PcdConsoleSerialDevicePath is not a
+                                  device path.
+  @retval other                   The events could not be created.
+**/
+EFI_STATUS
+ConsoleSerialStartMonitor (
+  VOID
+  );
+
+/**
+  Stop watching the serial port.
+**/
+VOID
+ConsoleSerialStopMonitor (
+  VOID
+  );
+
+#endif
@@ -0,0 +1,47 @@
+/** @file
+  Main file for 'echo' console command.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include "UefiConsole.h"
+
+extern EFI_SHELL_PARAMETERS_PROTOCOL *NewShellParametersProtocol;
+
+/**
+  Function for 'echo' command.
+
+  Usage: echo [Text...]
+
+  The arguments are printed as they are, so text starting with '-' is not
+  taken as a flag.
+
+  @param[in] ImageHandle  Handle to the Image (NULL if Internal).
+  @param[in] SystemTable  Pointer to the System Table (NULL if Internal).
+**/
+SHELL_STATUS
+EFIAPI
+ShellCommandRunEcho (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  UINTN  Index;
+
+  for (Index = 1; Index < NewShellParametersProtocol->Argc; Index++) {
+    if (Index > 1) {
+      gST->ConOut->OutputString (gST->ConOut, L" ");
+    }
+    gST->ConOut->OutputString (gST->ConOut, NewShellParametersProtocol->Argv[Index]);
+  }
+  gST->ConOut->OutputString (gST->ConOut, L"\r\n");
+
+  return SHELL_SUCCESS;
+}
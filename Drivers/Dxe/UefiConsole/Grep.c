@@ -0,0 +1,156 @@
+/** @file
+  Main file for 'grep' console command.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include "UefiConsole.h"
+
+STATIC CONST SHELL_PARAM_ITEM GrepParamList[] = {
+  {L"-i", TypeFlag},
+  {L"-v", TypeFlag},
+  {L"-c", TypeFlag},
+  {L"-n", TypeFlag},
+  {NULL,  TypeMax}
+};
+
+/**
+  Check whether a line contains a pattern.
+
+  @param[in] Line         The line.
+  @param[in] Pattern      The pattern.
+  @param[in] IgnoreCase   TRUE to compare without regard to case.
+
+  @retval TRUE    The line contains the pattern.
+  @retval FALSE   It does not.
+**/
+STATIC
+BOOLEAN
+GrepMatch (
+  IN CONST CHAR16  *Line,
+  IN CONST CHAR16  *Pattern,
+  IN BOOLEAN       IgnoreCase
+  )
+{
+  UINTN  Index;
+
+  if (!IgnoreCase) {
+    return (BOOLEAN) (StrStr (Line, Pattern) != NULL);
+  }
+
+  for (; *Line != CHAR_NULL; Line++) {
+    for (Index = 0; Pattern[Index] != CHAR_NULL && CharToUpper (Line[Index]) == CharToUpper (Pattern[Index]); Index++) {
+    }
+    if (Pattern[Index] == CHAR_NULL) {
+      return TRUE;
+    }
+  }
+  return (BOOLEAN) (*Pattern == CHAR_NULL);
+}
+
+/**
+  Function for 'grep' command.
+
+  Usage: Command | grep [-i] [-v] [-c] [-n] Pattern
+
+  Print the lines of the output of Command that contain Pattern: -i ignores
+  case, -v selects the lines that do not contain it, -c only prints the
+  number of lines selected and -n prefixes each line with its number.
+
+  @param[in] ImageHandle  Handle to the Image (NULL if Internal).
+  @param[in] SystemTable  Pointer to the System Table (NULL if Internal).
+
+  @retval SHELL_SUCCESS     At least one line was selected.
+  @retval SHELL_NOT_FOUND   No line was selected.
+**/
+SHELL_STATUS
+EFIAPI
+ShellCommandRunGrep (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS          Status;
+  LIST_ENTRY          *Package;
+  CHAR16              *ProblemParam;
+  CONST CHAR16        *Pattern;
+  CHAR16              *Input;
+  CHAR16              *Line;
+  CHAR16              *End;
+  CHAR16              *Terminator;
+  CHAR16              Saved;
+  BOOLEAN             IgnoreCase;
+  BOOLEAN             Invert;
+  BOOLEAN             CountOnly;
+  BOOLEAN             Number;
+  UINTN               LineNumber;
+  UINTN               Matches;
+
+  ProblemParam = NULL;
+
+  Status = ConsoleCommandLineParse (GrepParamList, &Package, &ProblemParam, TRUE);
+  if (EFI_ERROR (Status)) {
+    if (Status == EFI_VOLUME_CORRUPTED && ProblemParam != NULL) {
+      Print (L"grep: Unknown flag - '%s'\n", ProblemParam);
+      FreePool (ProblemParam);
+      return SHELL_INVALID_PARAMETER;
+    }
+    ASSERT (FALSE);
+    return SHELL_INVALID_PARAMETER;
+  }
+
+  Input   = ConsoleGetPipeInput ();
+  Pattern = ConsoleCommandLineGetRawValue (Package, 1);
+  if (Input == NULL || Pattern == NULL || ConsoleCommandLineGetCount (Package) != 2) {
+    Print (L"grep: Usage: Command | grep [-i] [-v] [-c] [-n] Pattern\n");
+    ConsoleCommandLineFreeVarList (Package);
+    return SHELL_INVALID_PARAMETER;
+  }
+
+  IgnoreCase = ConsoleCommandLineGetFlag (Package, L"-i");
+  Invert     = ConsoleCommandLineGetFlag (Package, L"-v");
+  CountOnly  = ConsoleCommandLineGetFlag (Package, L"-c");
+  Number     = ConsoleCommandLineGetFlag (Package, L"-n");
+  LineNumber = 0;
+  Matches    = 0;
+
+  for (Line = Input; *Line != CHAR_NULL; Line = (*End == CHAR_NULL) ? End : End + 1) {
+    for (End = Line; *End != CHAR_NULL && *End != L'\n'; End++) {
+    }
+    LineNumber++;
+
+    //
+    // Terminate the line in place, without its CR, for the match and output
+    //
+    Terminator  = (End > Line && End[-1] == L'\r') ? End - 1 : End;
+    Saved       = *Terminator;
+    *Terminator = CHAR_NULL;
+
+    if (GrepMatch (Line, Pattern, IgnoreCase) != Invert) {
+      Matches++;
+      if (!CountOnly) {
+        if (Number) {
+          Print (L"%d:", LineNumber);
+        }
+        gST->ConOut->OutputString (gST->ConOut, Line);
+        gST->ConOut->OutputString (gST->ConOut, L"\r\n");
+      }
+    }
+
+    *Terminator = Saved;
+  }
+
+  if (CountOnly) {
+    Print (L"%d\n", Matches);
+  }
+
+  ConsoleCommandLineFreeVarList (Package);
+  return (Matches != 0) ? SHELL_SUCCESS : SHELL_NOT_FOUND;
+}
@@ -15,7 +15,6 @@
 **/
 
 #include "UefiConsole.h"
-#include <Protocol/PciRootBridgeIo.h>
 
 /**
   Make a printable character.
@@ -40,13 +39,18 @@ MakePrintable (
 /**
   Display some Memory-Mapped-IO memory.
 
+  The range is read with one root bridge call at the requested width, so
+  registers that only decode full-width accesses read correctly.
+
   @param[in] Address    The starting address to display.
   @param[in] Size       The length of memory to display.
+  @param[in] Width      The access width.
 **/
 SHELL_STATUS
 DisplayMmioMemory (
-  IN CONST VOID   *Address,
-  IN CONST UINTN  Size
+  IN CONST VOID                             *Address,
+  IN CONST UINTN                            Size,
+  IN EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_WIDTH  Width
   )
 {
   EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL *PciRbIo;
@@ -66,13 +70,13 @@ DisplayMmioMemory (
     return SHELL_OUT_OF_RESOURCES;
   }
 
-  Status = PciRbIo->Mem.Read (PciRbIo, EfiPciWidthUint8, (UINT64) (UINTN) Address, Size, Buffer);
+  Status = PciRbIo->Mem.Read (PciRbIo, Width, (UINT64) (UINTN) Address, Size >> Width, Buffer);
   if (EFI_ERROR (Status)) {
     Print (L"mem: Problem accessing the data using Protocol - PciRootBridgeIo\n");
     ShellStatus = SHELL_NOT_FOUND;
   } else {
     Print (L"Memory Mapped IO Address %016LX %X Bytes\n", (UINT64) (UINTN) Address, Size);
-    DumpHex (2, (UINTN)Address, Size, Buffer);
+    HexDump (2, (UINTN)Address, Size, Buffer);
   }
 
   FreePool (Buffer);
@@ -81,11 +85,14 @@ DisplayMmioMemory (
 
 STATIC CONST SHELL_PARAM_ITEM ParamList[] = {
   {L"-mmio", TypeFlag},
+  {L"-w", TypeValue},
   {NULL, TypeMax}
 };
 
 /**
-  Function for 'mem' command.
+  Function for 'mem' and 'dmem' commands.
+
+  Usage: mem [Address] [Size] [-mmio [-w 1|2|4|8]]
 
   @param[in] ImageHandle  Handle to the Image (NULL if Internal).
   @param[in] SystemTable  Pointer to the System Table (NULL if Internal).
@@ -104,6 +111,7 @@ ShellCommandRunMem (
   VOID                *Address;
   UINT64              Size;
   CONST CHAR16        *Temp1;
+  EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_WIDTH Width;
 
   ShellStatus         = SHELL_SUCCESS;
   Status              = EFI_SUCCESS;
@@ -150,12 +158,24 @@ ShellCommandRunMem (
       }
     }
 
+    if (ShellStatus == SHELL_SUCCESS) {
+      Temp1 = ConsoleCommandLineGetValue (Package, L"-w");
+      if (!ConsoleParseAccessWidth (Temp1, &Width)) {
+        Print (L"mem: Invalid width - '%s'\n", Temp1);
+        ShellStatus = SHELL_INVALID_PARAMETER;
+      } else if (ConsoleCommandLineGetFlag (Package, L"-mmio") &&
+                 ((((UINTN) Address | (UINTN) Size) & ((1 << Width) - 1)) != 0)) {
+        Print (L"mem: Address and size must be multiples of the width.\n");
+        ShellStatus = SHELL_INVALID_PARAMETER;
+      }
+    }
+
     if (ShellStatus == SHELL_SUCCESS) {
       if (!ConsoleCommandLineGetFlag (Package, L"-mmio")) {
         Print (L"Memory Address %016LX %X Bytes\n", (UINT64) (UINTN) Address, Size);
-        DumpHex (2, (UINTN) Address, (UINTN) Size, Address);
+        HexDump (2, (UINTN) Address, (UINTN) Size, Address);
       } else {
-        ShellStatus = DisplayMmioMemory (Address, (UINTN)Size);
+        ShellStatus = DisplayMmioMemory (Address, (UINTN)Size, Width);
       }
     }
 
@@ -0,0 +1,353 @@
+/** @file
+  Main file for 'mm' console command.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include "UefiConsole.h"
+
+typedef enum {
+  MmAccessMemory,
+  MmAccessMmio,
+  MmAccessIo,
+  MmAccessPci,
+  MmAccessPcie
+} MM_ACCESS_TYPE;
+
+STATIC CONST CHAR16 *mMmAccessName[] = {
+  L"MEM",
+  L"MMIO",
+  L"IO",
+  L"PCI",
+  L"PCIE"
+};
+
+STATIC CONST SHELL_PARAM_ITEM MmParamList[] = {
+  {L"-mem",  TypeFlag},
+  {L"-mmio", TypeFlag},
+  {L"-io",   TypeFlag},
+  {L"-pci",  TypeFlag},
+  {L"-pcie", TypeFlag},
+  {L"-w",    TypeValue},
+  {L"-n",    TypeValue},
+  {NULL,     TypeMax}
+};
+
+/**
+  Convert an access width of 1, 2, 4 or 8 bytes to a root bridge width.
+
+  @param[in]  String    The width in bytes; NULL selects 1.
+  @param[out] Width     The root bridge access width.
+
+  @retval TRUE    String is a valid width.
+  @retval FALSE   String is not a valid width.
+**/
+BOOLEAN
+ConsoleParseAccessWidth (
+  IN  CONST CHAR16                           *String,
+  OUT EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_WIDTH  *Width
+  )
+{
+  UINT64  Bytes;
+
+  if (String == NULL) {
+    *Width = EfiPciWidthUint8;
+    return TRUE;
+  }
+
+  if (EFI_ERROR (ConsoleConvertStringToUint64 (String, &Bytes, FALSE, FALSE))) {
+    return FALSE;
+  }
+
+  switch (Bytes) {
+  case 1:
+    *Width = EfiPciWidthUint8;
+    return TRUE;
+  case 2:
+    *Width = EfiPciWidthUint16;
+    return TRUE;
+  case 4:
+    *Width = EfiPciWidthUint32;
+    return TRUE;
+  case 8:
+    *Width = EfiPciWidthUint64;
+    return TRUE;
+  default:
+    return FALSE;
+  }
+}
+
+/**
+  Access system memory with a fixed width.
+
+  @param[in]      Width     The access width.
+  @param[in]      Address   The first address.
+  @param[in]      Count     Number of items.
+  @param[in]      Read      TRUE to read, FALSE to fill with Buffer[0].
+  @param[in, out] Buffer    Count items read, or the value to write.
+**/
+STATIC
+VOID
+MmAccessSystemMemory (
+  IN     EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_WIDTH  Width,
+  IN     UINT64                                 Address,
+  IN     UINTN                                  Count,
+  IN     BOOLEAN                                Read,
+  IN OUT VOID                                   *Buffer
+  )
+{
+  UINTN  Index;
+  UINTN  Item;
+
+  for (Index = 0; Index < Count; Index++) {
+    Item = Read ? Index : 0;
+    switch (Width) {
+    case EfiPciWidthUint8:
+      if (Read) {
+        ((UINT8 *) Buffer)[Item] = ((volatile UINT8 *) (UINTN) Address)[Index];
+      } else {
+        ((volatile UINT8 *) (UINTN) Address)[Index] = ((UINT8 *) Buffer)[Item];
+      }
+      break;
+    case EfiPciWidthUint16:
+      if (Read) {
+        ((UINT16 *) Buffer)[Item] = ((volatile UINT16 *) (UINTN) Address)[Index];
+      } else {
+        ((volatile UINT16 *) (UINTN) Address)[Index] = ((UINT16 *) Buffer)[Item];
+      }
+      break;
+    case EfiPciWidthUint32:
+      if (Read) {
+        ((UINT32 *) Buffer)[Item] = ((volatile UINT32 *) (UINTN) Address)[Index];
+      } else {
+        ((volatile UINT32 *) (UINTN) Address)[Index] = ((UINT32 *) Buffer)[Item];
+      }
+      break;
+    default:
+      if (Read) {
+        ((UINT64 *) Buffer)[Item] = ((volatile UINT64 *) (UINTN) Address)[Index];
+      } else {
+        ((volatile UINT64 *) (UINTN) Address)[Index] = ((UINT64 *) Buffer)[Item];
+      }
+      break;
+    }
+  }
+}
+
+/**
+  Read Count items, or fill Count items with one value, in an address space.
+
+  Root bridge accesses are issued as a single call at the requested width;
+  a write uses the fill form of the width so the value is not repeated in a
+  buffer.
+
+  @param[in]      AccessType  The address space.
+  @param[in]      Width       The access width.
+  @param[in]      Address     The address, in the format of the address space.
+  @param[in]      Count       Number of items.
+  @param[in]      Read        TRUE to read, FALSE to write.
+  @param[in, out] Buffer      Count items read, or the value to write.
+
+  @retval EFI_SUCCESS   The access was done.
+  @retval other         The root bridge could not be found or failed.
+**/
+STATIC
+EFI_STATUS
+MmAccess (
+  IN     MM_ACCESS_TYPE                         AccessType,
+  IN     EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_WIDTH  Width,
+  IN     UINT64                                 Address,
+  IN     UINTN                                  Count,
+  IN     BOOLEAN                                Read,
+  IN OUT VOID                                   *Buffer
+  )
+{
+  EFI_STATUS                                   Status;
+  EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL              *PciRbIo;
+  EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_ACCESS       *Access;
+  UINT32                                       Segment;
+  UINT8                                        Bus;
+  UINT64                                       PciAddress;
+
+  if (AccessType == MmAccessMemory) {
+    MmAccessSystemMemory (Width, Address, Count, Read, Buffer);
+    return EFI_SUCCESS;
+  }
+
+  //
+  // PCI addresses are [ssss]bbddffrr for -pci and [ssss]bbdfrrr (ECAM
+  // offset) for -pcie; MMIO and I/O go through the segment 0 root bridge.
+  //
+  Segment    = 0;
+  Bus        = 0;
+  PciAddress = Address;
+  if (AccessType == MmAccessPci) {
+    Segment    = (UINT32) RShiftU64 (Address, 32);
+    Bus        = (UINT8) ((UINT32) Address >> 24);
+    PciAddress = EFI_PCI_ADDRESS (Bus, ((UINT32) Address >> 16) & 0x1F, ((UINT32) Address >> 8) & 0x7, (UINT32) Address & 0xFF);
+  } else if (AccessType == MmAccessPcie) {
+    Segment    = (UINT32) RShiftU64 (Address, 32);
+    Bus        = (UINT8) ((UINT32) Address >> 20);
+    PciAddress = EFI_PCI_ADDRESS (Bus, ((UINT32) Address >> 15) & 0x1F, ((UINT32) Address >> 12) & 0x7, (UINT32) Address & 0xFFF);
+  }
+
+  Status = ConsoleGetPciRootBridgeIo (Segment, Bus, &PciRbIo);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  switch (AccessType) {
+  case MmAccessMmio:
+    Access = &PciRbIo->Mem;
+    break;
+  case MmAccessIo:
+    Access = &PciRbIo->Io;
+    break;
+  default:
+    Access = &PciRbIo->Pci;
+    break;
+  }
+
+  if (Read) {
+    return Access->Read (PciRbIo, Width, PciAddress, Count, Buffer);
+  }
+  return Access->Write (PciRbIo, (EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_WIDTH) (Width + EfiPciWidthFillUint8), PciAddress, Count, Buffer);
+}
+
+/**
+  Function for 'mm' command.
+
+  Usage: mm Address [Value] [-w 1|2|4|8] [-n Count] [-mem|-mmio|-io|-pci|-pcie]
+
+  Without Value, Count items are read and displayed; with Value, Count items
+  are written with it.
+
+  @param[in] ImageHandle  Handle to the Image (NULL if Internal).
+  @param[in] SystemTable  Pointer to the System Table (NULL if Internal).
+**/
+SHELL_STATUS
+EFIAPI
+ShellCommandRunMm (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS                             Status;
+  LIST_ENTRY                             *Package;
+  CHAR16                                 *ProblemParam;
+  SHELL_STATUS                           ShellStatus;
+  CONST CHAR16                           *Temp;
+  MM_ACCESS_TYPE                         AccessType;
+  EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_WIDTH  Width;
+  UINTN                                  Bytes;
+  UINT64                                 Address;
+  UINT64                                 Value;
+  UINT64                                 Count;
+  UINT8                                  *Buffer;
+  UINTN                                  Index;
+  UINT64                                 Item;
+
+  ShellStatus  = SHELL_SUCCESS;
+  ProblemParam = NULL;
+  Buffer       = NULL;
+  Width        = EfiPciWidthUint8;
+  Count        = 1;
+
+  Status = ConsoleCommandLineParse (MmParamList, &Package, &ProblemParam, TRUE);
+  if (EFI_ERROR (Status)) {
+    if (Status == EFI_VOLUME_CORRUPTED && ProblemParam != NULL) {
+      Print (L"mm: Unknown flag - '%s'\n", ProblemParam);
+      FreePool (ProblemParam);
+      return SHELL_INVALID_PARAMETER;
+    }
+    ASSERT (FALSE);
+    return SHELL_INVALID_PARAMETER;
+  }
+
+  AccessType = MmAccessMemory;
+  if (ConsoleCommandLineGetFlag (Package, L"-mmio")) {
+    AccessType = MmAccessMmio;
+  } else if (ConsoleCommandLineGetFlag (Package, L"-io")) {
+    AccessType = MmAccessIo;
+  } else if (ConsoleCommandLineGetFlag (Package, L"-pci")) {
+    AccessType = MmAccessPci;
+  } else if (ConsoleCommandLineGetFlag (Package, L"-pcie")) {
+    AccessType = MmAccessPcie;
+  }
+
+  Temp = ConsoleCommandLineGetValue (Package, L"-w");
+  if (!ConsoleParseAccessWidth (Temp, &Width)) {
+    Print (L"mm: Invalid width - '%s'\n", Temp);
+    ShellStatus = SHELL_INVALID_PARAMETER;
+  }
+  Bytes = (UINTN) 1 << Width;
+
+  Temp = ConsoleCommandLineGetValue (Package, L"-n");
+  if (Temp != NULL &&
+      (EFI_ERROR (ConsoleConvertStringToUint64 (Temp, &Count, TRUE, FALSE)) || Count == 0 || Count > SIZE_1MB)) {
+    Print (L"mm: Invalid count - '%s'\n", Temp);
+    ShellStatus = SHELL_INVALID_PARAMETER;
+  }
+
+  Temp = ConsoleCommandLineGetRawValue (Package, 1);
+  if (ShellStatus == SHELL_SUCCESS &&
+      (Temp == NULL || ConsoleCommandLineGetCount (Package) > 3 ||
+       EFI_ERROR (ConsoleConvertStringToUint64 (Temp, &Address, TRUE, FALSE)))) {
+    Print (L"mm: Usage: mm Address [Value] [-w 1|2|4|8] [-n Count] [-mem|-mmio|-io|-pci|-pcie]\n");
+    ShellStatus = SHELL_INVALID_PARAMETER;
+  }
+
+  if (ShellStatus == SHELL_SUCCESS) {
+    Temp = ConsoleCommandLineGetRawValue (Package, 2);
+    if (Temp != NULL) {
+      //
+      // Write: fill Count items with Value
+      //
+      if (EFI_ERROR (ConsoleConvertStringToUint64 (Temp, &Value, TRUE, FALSE)) ||
+          (Bytes < sizeof (UINT64) && RShiftU64 (Value, Bytes * 8) != 0)) {
+        Print (L"mm: Invalid value - '%s'\n", Temp);
+        ShellStatus = SHELL_INVALID_PARAMETER;
+      } else {
+        Status = MmAccess (AccessType, Width, Address, (UINTN) Count, FALSE, &Value);
+        if (EFI_ERROR (Status)) {
+          Print (L"mm: %s write failed - %r\n", mMmAccessName[AccessType], Status);
+          ShellStatus = SHELL_DEVICE_ERROR;
+        }
+      }
+    } else {
+      Buffer = AllocateZeroPool ((UINTN) Count * Bytes);
+      if (Buffer == NULL) {
+        ShellStatus = SHELL_OUT_OF_RESOURCES;
+      } else {
+        Status = MmAccess (AccessType, Width, Address, (UINTN) Count, TRUE, Buffer);
+        if (EFI_ERROR (Status)) {
+          Print (L"mm: %s read failed - %r\n", mMmAccessName[AccessType], Status);
+          ShellStatus = SHELL_DEVICE_ERROR;
+        } else {
+          for (Index = 0; Index < Count; Index++) {
+            Item = 0;
+            CopyMem (&Item, Buffer + Index * Bytes, Bytes);
+            Print (
+              L"%-4s 0x%016lx : 0x%0*lx\n",
+              mMmAccessName[AccessType],
+              Address + Index * Bytes,
+              Bytes * 2,
+              Item
+              );
+          }
+        }
+        FreePool (Buffer);
+      }
+    }
+  }
+
+  ConsoleCommandLineFreeVarList (Package);
+  return ShellStatus;
+}
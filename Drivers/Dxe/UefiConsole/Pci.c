@@ -0,0 +1,472 @@
+/** @file
+  Main file for 'pci' console command.
+
+  The first 'pci' command scans every bus decoded by every PCI root bridge
+  and keeps the devices found in a table, so later listings do not touch the
+  hardware again.  'pci -r' discards the table and scans again.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include "UefiConsole.h"
+#include <IndustryStandard/Acpi.h>
+#include <IndustryStandard/Pci.h>
+
+typedef struct {
+  UINT32    Segment;
+  UINT8     Bus;
+  UINT8     Device;
+  UINT8     Function;
+  UINT8     HeaderType;
+  UINT16    VendorId;
+  UINT16    DeviceId;
+  UINT8     ClassCode[3];           ///< Programming interface, sub class, base class.
+} CONSOLE_PCI_DEVICE;
+
+STATIC CONSOLE_PCI_DEVICE  *mPciDevices        = NULL;
+STATIC UINTN               mPciDeviceCount     = 0;
+STATIC UINTN               mPciDeviceCapacity  = 0;
+STATIC BOOLEAN             mPciDevicesScanned  = FALSE;
+
+STATIC CONST SHELL_PARAM_ITEM PciParamList[] = {
+  {L"-r", TypeFlag},
+  {L"-s", TypeValue},
+  {L"-e", TypeFlag},
+  {NULL,  TypeMax}
+};
+
+/**
+  Get the range of bus numbers decoded by a PCI root bridge.
+
+  @param[in]  PciRbIo   The root bridge.
+  @param[out] MinBus    The first bus number.
+  @param[out] MaxBus    The last bus number.
+**/
+STATIC
+VOID
+GetRootBridgeBusRange (
+  IN  EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL  *PciRbIo,
+  OUT UINT16                           *MinBus,
+  OUT UINT16                           *MaxBus
+  )
+{
+  EFI_ACPI_ADDRESS_SPACE_DESCRIPTOR  *Descriptor;
+
+  *MinBus = 0;
+  *MaxBus = PCI_MAX_BUS;
+
+  if (EFI_ERROR (PciRbIo->Configuration (PciRbIo, (VOID **) &Descriptor))) {
+    return;
+  }
+
+  for (; Descriptor->Desc == ACPI_ADDRESS_SPACE_DESCRIPTOR; Descriptor++) {
+    if (Descriptor->ResType == ACPI_ADDRESS_SPACE_TYPE_BUS) {
+      *MinBus = (UINT16) Descriptor->AddrRangeMin;
+      *MaxBus = (UINT16) Descriptor->AddrRangeMax;
+      return;
+    }
+  }
+}
+
+/**
+  Find the PCI root bridge that decodes a bus of a segment.
+
+  @param[in]  Segment   The PCI segment number.
+  @param[in]  Bus       The bus number.
+  @param[out] PciRbIo   The root bridge.
+
+  @retval EFI_SUCCESS     The root bridge was found.
+  @retval EFI_NOT_FOUND   No root bridge decodes the bus.
+**/
+EFI_STATUS
+ConsoleGetPciRootBridgeIo (
+  IN  UINT32                           Segment,
+  IN  UINT8                            Bus,
+  OUT EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL  **PciRbIo
+  )
+{
+  EFI_STATUS                       Status;
+  EFI_HANDLE                       *Handles;
+  UINTN                            HandleCount;
+  UINTN                            Index;
+  EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL  *RootBridge;
+  UINT16                           MinBus;
+  UINT16                           MaxBus;
+
+  Status = gBS->LocateHandleBuffer (
+                  ByProtocol,
+                  &gEfiPciRootBridgeIoProtocolGuid,
+                  NULL,
+                  &HandleCount,
+                  &Handles
+                  );
+  if (EFI_ERROR (Status)) {
+    return EFI_NOT_FOUND;
+  }
+
+  Status = EFI_NOT_FOUND;
+  for (Index = 0; Index < HandleCount; Index++) {
+    if (EFI_ERROR (gBS->HandleProtocol (Handles[Index], &gEfiPciRootBridgeIoProtocolGuid, (VOID **) &RootBridge))) {
+      continue;
+    }
+    if (RootBridge->SegmentNumber != Segment) {
+      continue;
+    }
+    GetRootBridgeBusRange (RootBridge, &MinBus, &MaxBus);
+    if (Bus >= MinBus && Bus <= MaxBus) {
+      *PciRbIo = RootBridge;
+      Status   = EFI_SUCCESS;
+      break;
+    }
+  }
+
+  FreePool (Handles);
+  return Status;
+}
+
+/**
+  Append a device to the device table.
+
+  @param[in] Device   The device to append.
+
+  @retval EFI_SUCCESS           The device was appended.
+  @retval EFI_OUT_OF_RESOURCES  The table could not be grown.
+**/
+STATIC
+EFI_STATUS
+AddPciDevice (
+  IN CONST CONSOLE_PCI_DEVICE  *Device
+  )
+{
+  CONSOLE_PCI_DEVICE  *NewTable;
+  UINTN               NewCapacity;
+
+  if (mPciDeviceCount == mPciDeviceCapacity) {
+    NewCapacity = (mPciDeviceCapacity == 0) ? 32 : mPciDeviceCapacity * 2;
+    NewTable    = ReallocatePool (
+                    mPciDeviceCapacity * sizeof (CONSOLE_PCI_DEVICE),
+                    NewCapacity * sizeof (CONSOLE_PCI_DEVICE),
+                    mPciDevices
+                    );
+    if (NewTable == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    mPciDevices        = NewTable;
+    mPciDeviceCapacity = NewCapacity;
+  }
+
+  CopyMem (&mPciDevices[mPciDeviceCount++], Device, sizeof (CONSOLE_PCI_DEVICE));
+  return EFI_SUCCESS;
+}
+
+/**
+  Free the cached device table.
+**/
+VOID
+ConsolePciFreeCache (
+  VOID
+  )
+{
+  SHELL_FREE_NON_NULL (mPciDevices);
+  mPciDeviceCount    = 0;
+  mPciDeviceCapacity = 0;
+  mPciDevicesScanned = FALSE;
+}
+
+/**
+  Scan the buses of one root bridge and add the devices found to the table.
+
+  @param[in] PciRbIo    The root bridge.
+
+  @retval EFI_SUCCESS           The buses were scanned.
+  @retval EFI_OUT_OF_RESOURCES  The table could not be grown.
+**/
+STATIC
+EFI_STATUS
+ScanRootBridge (
+  IN EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL  *PciRbIo
+  )
+{
+  EFI_STATUS          Status;
+  UINT16              MinBus;
+  UINT16              MaxBus;
+  UINT16              Bus;
+  UINT8               Device;
+  UINT8               Function;
+  UINT32              Id;
+  UINT32              ClassRevision;
+  UINT8               HeaderType;
+  CONSOLE_PCI_DEVICE  Entry;
+
+  GetRootBridgeBusRange (PciRbIo, &MinBus, &MaxBus);
+
+  for (Bus = MinBus; Bus <= MaxBus; Bus++) {
+    for (Device = 0; Device <= PCI_MAX_DEVICE; Device++) {
+      for (Function = 0; Function <= PCI_MAX_FUNC; Function++) {
+        Status = PciRbIo->Pci.Read (
+                                PciRbIo,
+                                EfiPciWidthUint32,
+                                EFI_PCI_ADDRESS (Bus, Device, Function, PCI_VENDOR_ID_OFFSET),
+                                1,
+                                &Id
+                                );
+        if (EFI_ERROR (Status) || (UINT16) Id == 0xFFFF) {
+          //
+          // Function 0 must exist for the other functions to be decoded
+          //
+          if (Function == 0) {
+            break;
+          }
+          continue;
+        }
+
+        PciRbIo->Pci.Read (PciRbIo, EfiPciWidthUint32, EFI_PCI_ADDRESS (Bus, Device, Function, PCI_REVISION_ID_OFFSET), 1, &ClassRevision);
+        PciRbIo->Pci.Read (PciRbIo, EfiPciWidthUint8, EFI_PCI_ADDRESS (Bus, Device, Function, PCI_HEADER_TYPE_OFFSET), 1, &HeaderType);
+
+        Entry.Segment      = PciRbIo->SegmentNumber;
+        Entry.Bus          = (UINT8) Bus;
+        Entry.Device       = Device;
+        Entry.Function     = Function;
+        Entry.HeaderType   = HeaderType;
+        Entry.VendorId     = (UINT16) Id;
+        Entry.DeviceId     = (UINT16) (Id >> 16);
+        Entry.ClassCode[0] = (UINT8) (ClassRevision >> 8);
+        Entry.ClassCode[1] = (UINT8) (ClassRevision >> 16);
+        Entry.ClassCode[2] = (UINT8) (ClassRevision >> 24);
+
+        Status = AddPciDevice (&Entry);
+        if (EFI_ERROR (Status)) {
+          return Status;
+        }
+
+        if (Function == 0 && (HeaderType & HEADER_TYPE_MULTI_FUNCTION) == 0) {
+          break;
+        }
+      }
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Build the device table by scanning every PCI root bridge.
+
+  @retval EFI_SUCCESS           The table was built.
+  @retval EFI_NOT_FOUND         There is no PCI root bridge.
+  @retval EFI_OUT_OF_RESOURCES  The table could not be grown.
+**/
+STATIC
+EFI_STATUS
+ScanPciDevices (
+  VOID
+  )
+{
+  EFI_STATUS                       Status;
+  EFI_HANDLE                       *Handles;
+  UINTN                            HandleCount;
+  UINTN                            Index;
+  EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL  *PciRbIo;
+
+  ConsolePciFreeCache ();
+
+  Status = gBS->LocateHandleBuffer (
+                  ByProtocol,
+                  &gEfiPciRootBridgeIoProtocolGuid,
+                  NULL,
+                  &HandleCount,
+                  &Handles
+                  );
+  if (EFI_ERROR (Status)) {
+    return EFI_NOT_FOUND;
+  }
+
+  for (Index = 0; Index < HandleCount; Index++) {
+    if (EFI_ERROR (gBS->HandleProtocol (Handles[Index], &gEfiPciRootBridgeIoProtocolGuid, (VOID **) &PciRbIo))) {
+      continue;
+    }
+    Status = ScanRootBridge (PciRbIo);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+  }
+
+  FreePool (Handles);
+  mPciDevicesScanned = (BOOLEAN) !EFI_ERROR (Status);
+  return Status;
+}
+
+/**
+  Dump the configuration space of one PCI function.
+
+  @param[in] Segment    The PCI segment number.
+  @param[in] Bus        The bus number.
+  @param[in] Device     The device number.
+  @param[in] Function   The function number.
+  @param[in] Extended   TRUE to dump the 4KB extended configuration space.
+
+  @retval SHELL_SUCCESS   The configuration space was dumped.
+  @retval other           The function could not be accessed.
+**/
+STATIC
+SHELL_STATUS
+DumpPciConfigSpace (
+  IN UINT32   Segment,
+  IN UINT8    Bus,
+  IN UINT8    Device,
+  IN UINT8    Function,
+  IN BOOLEAN  Extended
+  )
+{
+  EFI_STATUS                       Status;
+  EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL  *PciRbIo;
+  UINT32                           *Config;
+  UINTN                            Size;
+
+  Status = ConsoleGetPciRootBridgeIo (Segment, Bus, &PciRbIo);
+  if (EFI_ERROR (Status)) {
+    Print (L"pci: No root bridge for segment %x bus %x.\n", Segment, Bus);
+    return SHELL_NOT_FOUND;
+  }
+
+  Size   = Extended ? SIZE_4KB : 0x100;
+  Config = AllocatePool (Size);
+  if (Config == NULL) {
+    return SHELL_OUT_OF_RESOURCES;
+  }
+
+  //
+  // One call reads the whole space a dword at a time
+  //
+  Status = PciRbIo->Pci.Read (
+                          PciRbIo,
+                          EfiPciWidthUint32,
+                          EFI_PCI_ADDRESS (Bus, Device, Function, 0),
+                          Size / sizeof (UINT32),
+                          Config
+                          );
+  if (EFI_ERROR (Status) || (UINT16) Config[0] == 0xFFFF) {
+    Print (L"pci: No device at %04x:%02x:%02x.%x.\n", Segment, Bus, Device, Function);
+    FreePool (Config);
+    return SHELL_NOT_FOUND;
+  }
+
+  Print (L"PCI Segment %04x Bus %02x Device %02x Function %x\n", Segment, Bus, Device, Function);
+  HexDump (2, 0, Size, Config);
+
+  FreePool (Config);
+  return SHELL_SUCCESS;
+}
+
+/**
+  Function for 'pci' command.
+
+  Usage: pci [-r]                          List the PCI devices.
+         pci [-s Seg] Bus Dev Func [-e]    Dump a configuration space.
+
+  @param[in] ImageHandle  Handle to the Image (NULL if Internal).
+  @param[in] SystemTable  Pointer to the System Table (NULL if Internal).
+**/
+SHELL_STATUS
+EFIAPI
+ShellCommandRunPci (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS          Status;
+  LIST_ENTRY          *Package;
+  CHAR16              *ProblemParam;
+  SHELL_STATUS        ShellStatus;
+  CONST CHAR16        *Temp;
+  UINT64              Value[4];
+  UINTN               Index;
+  CONSOLE_PCI_DEVICE  *Entry;
+
+  ShellStatus  = SHELL_SUCCESS;
+  ProblemParam = NULL;
+
+  Status = ConsoleCommandLineParse (PciParamList, &Package, &ProblemParam, TRUE);
+  if (EFI_ERROR (Status)) {
+    if (Status == EFI_VOLUME_CORRUPTED && ProblemParam != NULL) {
+      Print (L"pci: Unknown flag - '%s'\n", ProblemParam);
+      FreePool (ProblemParam);
+      return SHELL_INVALID_PARAMETER;
+    }
+    ASSERT (FALSE);
+    return SHELL_INVALID_PARAMETER;
+  }
+
+  if (ConsoleCommandLineGetCount (Package) == 4) {
+    //
+    // Segment defaults to 0; bus, device and function are positional
+    //
+    Value[0] = 0;
+    Temp     = ConsoleCommandLineGetValue (Package, L"-s");
+    if (Temp != NULL && EFI_ERROR (ConsoleConvertStringToUint64 (Temp, &Value[0], TRUE, FALSE))) {
+      Print (L"pci: Invalid argument - '%s'\n", Temp);
+      ShellStatus = SHELL_INVALID_PARAMETER;
+    }
+    for (Index = 1; Index <= 3 && ShellStatus == SHELL_SUCCESS; Index++) {
+      Temp = ConsoleCommandLineGetRawValue (Package, Index);
+      if (!ConsoleIsHexOrDecimalNumber (Temp, TRUE, FALSE) ||
+          EFI_ERROR (ConsoleConvertStringToUint64 (Temp, &Value[Index], TRUE, FALSE))) {
+        Print (L"pci: Invalid argument - '%s'\n", Temp);
+        ShellStatus = SHELL_INVALID_PARAMETER;
+      }
+    }
+    if (ShellStatus == SHELL_SUCCESS &&
+        (Value[0] > MAX_UINT32 || Value[1] > PCI_MAX_BUS || Value[2] > PCI_MAX_DEVICE || Value[3] > PCI_MAX_FUNC)) {
+      Print (L"pci: Address out of range.\n");
+      ShellStatus = SHELL_INVALID_PARAMETER;
+    }
+    if (ShellStatus == SHELL_SUCCESS) {
+      ShellStatus = DumpPciConfigSpace (
+                      (UINT32) Value[0],
+                      (UINT8) Value[1],
+                      (UINT8) Value[2],
+                      (UINT8) Value[3],
+                      ConsoleCommandLineGetFlag (Package, L"-e")
+                      );
+    }
+  } else if (ConsoleCommandLineGetCount (Package) == 1) {
+    if (!mPciDevicesScanned || ConsoleCommandLineGetFlag (Package, L"-r")) {
+      Status = ScanPciDevices ();
+      if (EFI_ERROR (Status)) {
+        Print (L"pci: Enumeration failed - %r\n", Status);
+        ShellStatus = SHELL_NOT_FOUND;
+      }
+    }
+    if (ShellStatus == SHELL_SUCCESS) {
+      Print (L"  Seg  Bus Dev Func  Vendor Device  Class\n");
+      for (Index = 0; Index < mPciDeviceCount; Index++) {
+        Entry = &mPciDevices[Index];
+        Print (
+          L"  %04x  %02x  %02x   %x    %04x   %04x   %02x %02x %02x\n",
+          Entry->Segment,
+          Entry->Bus,
+          Entry->Device,
+          Entry->Function,
+          Entry->VendorId,
+          Entry->DeviceId,
+          Entry->ClassCode[2],
+          Entry->ClassCode[1],
+          Entry->ClassCode[0]
+          );
+      }
+    }
+  } else {
+    Print (L"pci: Usage: pci [-r] | pci [-s Seg] Bus Dev Func [-e]\n");
+    ShellStatus = SHELL_INVALID_PARAMETER;
+  }
+
+  ConsoleCommandLineFreeVarList (Package);
+  return ShellStatus;
+}
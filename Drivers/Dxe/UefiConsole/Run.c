@@ -0,0 +1,124 @@
+/** @file
+  Main file for 'run' console command.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include "UefiConsole.h"
+
+STATIC CONST SHELL_PARAM_ITEM RunParamList[] = {
+  {L"-fv", TypeFlag},
+  {L"-q",  TypeFlag},
+  {NULL,   TypeMax}
+};
+
+/**
+  Function for 'run' command.
+
+  Usage: run [-q] Path [Argument...]        Run a script from a file system.
+         run [-q] -fv Guid [Argument...]    Run a script from an FV raw section.
+
+  Path is "fsN:\dir\file.nsh" or "\dir\file.nsh"; see ConsoleLoadScriptFromFile().
+  -q does not echo the command lines.
+
+  @param[in] ImageHandle  Handle to the Image (NULL if Internal).
+  @param[in] SystemTable  Pointer to the System Table (NULL if Internal).
+**/
+SHELL_STATUS
+EFIAPI
+ShellCommandRunRun (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS          Status;
+  LIST_ENTRY          *Package;
+  CHAR16              *ProblemParam;
+  SHELL_STATUS        ShellStatus;
+  CONST CHAR16        *Name;
+  CONST CHAR16        **Argv;
+  UINTN               Argc;
+  UINTN               Index;
+  EFI_GUID            FileName;
+  CHAR16              *Script;
+
+  ProblemParam = NULL;
+  Script       = NULL;
+
+  Status = ConsoleCommandLineParse (RunParamList, &Package, &ProblemParam, TRUE);
+  if (EFI_ERROR (Status)) {
+    if (Status == EFI_VOLUME_CORRUPTED && ProblemParam != NULL) {
+      Print (L"run: Unknown flag - '%s'\n", ProblemParam);
+      FreePool (ProblemParam);
+      return SHELL_INVALID_PARAMETER;
+    }
+    ASSERT (FALSE);
+    return SHELL_INVALID_PARAMETER;
+  }
+
+  Name = ConsoleCommandLineGetRawValue (Package, 1);
+  if (Name == NULL) {
+    Print (L"run: Usage: run [-q] Path|-fv Guid [Argument...]\n");
+    ConsoleCommandLineFreeVarList (Package);
+    return SHELL_INVALID_PARAMETER;
+  }
+
+  if (ConsoleCommandLineGetFlag (Package, L"-fv")) {
+    Status = StrToGuid (Name, &FileName);
+    if (EFI_ERROR (Status)) {
+      Print (L"run: Invalid GUID - '%s'\n", Name);
+      ConsoleCommandLineFreeVarList (Package);
+      return SHELL_INVALID_PARAMETER;
+    }
+    Status = ConsoleLoadScriptFromFv (&FileName, &Script);
+  } else {
+    Status = ConsoleLoadScriptFromFile (Name, &Script);
+  }
+  if (EFI_ERROR (Status)) {
+    Print (L"run: Cannot load '%s' - %r\n", Name, Status);
+    ConsoleCommandLineFreeVarList (Package);
+    return SHELL_NOT_FOUND;
+  }
+
+  //
+  // %0 is the script name, %1 onwards the arguments that follow it
+  //
+  Argc = ConsoleCommandLineGetCount (Package) - 1;
+  Argv = AllocatePool (Argc * sizeof (CHAR16 *));
+  if (Argv == NULL) {
+    FreePool (Script);
+    ConsoleCommandLineFreeVarList (Package);
+    return SHELL_OUT_OF_RESOURCES;
+  }
+  for (Index = 0; Index < Argc; Index++) {
+    Argv[Index] = ConsoleCommandLineGetRawValue (Package, Index + 1);
+  }
+
+  Status = ConsoleRunScript (Name, Script, Argc, Argv, (BOOLEAN) !ConsoleCommandLineGetFlag (Package, L"-q"));
+  switch (Status) {
+  case EFI_SUCCESS:
+    ShellStatus = SHELL_SUCCESS;
+    break;
+  case EFI_INVALID_PARAMETER:
+    ShellStatus = SHELL_INVALID_PARAMETER;
+    break;
+  case EFI_OUT_OF_RESOURCES:
+    ShellStatus = SHELL_OUT_OF_RESOURCES;
+    break;
+  default:
+    ShellStatus = SHELL_ABORTED;
+    break;
+  }
+
+  FreePool (Argv);
+  FreePool (Script);
+  ConsoleCommandLineFreeVarList (Package);
+  return ShellStatus;
+}
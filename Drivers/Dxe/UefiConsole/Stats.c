@@ -0,0 +1,104 @@
+/** @file
+  Main file for 'stats' console command.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include "UefiConsole.h"
+
+STATIC CONST SHELL_PARAM_ITEM StatsParamList[] = {
+  {L"-r", TypeFlag},
+  {NULL,  TypeMax}
+};
+
+/**
+  Function for 'stats' command.
+
+  Usage: stats [-r]
+
+  Lists how many times each command ran and its shortest, average and
+  longest run time, then the time spent in console key notifications and
+  session ticks, which is the time the console held up boot.  A run is
+  accounted when it ends, so the running 'stats' and the current tick are
+  not included yet.  -r clears the counters after they are listed.
+
+  @param[in] ImageHandle  Handle to the Image (NULL if Internal).
+  @param[in] SystemTable  Pointer to the System Table (NULL if Internal).
+**/
+SHELL_STATUS
+EFIAPI
+ShellCommandRunStats (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS                         Status;
+  LIST_ENTRY                         *Package;
+  CHAR16                             *ProblemParam;
+  CONST LIST_ENTRY                   *List;
+  LIST_ENTRY                         *Link;
+  SHELL_COMMAND_INTERNAL_LIST_ENTRY  *Node;
+  BOOLEAN                            Reset;
+
+  Status = ConsoleCommandLineParse (StatsParamList, &Package, &ProblemParam, TRUE);
+  if (EFI_ERROR (Status)) {
+    if (Status == EFI_VOLUME_CORRUPTED && ProblemParam != NULL) {
+      Print (L"stats: Unknown flag - '%s'\n", ProblemParam);
+      FreePool (ProblemParam);
+      return SHELL_INVALID_PARAMETER;
+    }
+    ASSERT (FALSE);
+    return SHELL_INVALID_PARAMETER;
+  }
+
+  if (ConsoleCommandLineGetCount (Package) > 1) {
+    Print (L"stats: Too many arguments\n");
+    ConsoleCommandLineFreeVarList (Package);
+    return SHELL_INVALID_PARAMETER;
+  }
+  Reset = ConsoleCommandLineGetFlag (Package, L"-r");
+  ConsoleCommandLineFreeVarList (Package);
+
+  Print (L"Command     Count      Min(us)      Avg(us)      Max(us)\n");
+
+  List = ConsoleCommandGetList ();
+  for (Link = GetFirstNode (List); !IsNull (List, Link); Link = GetNextNode (List, Link)) {
+    Node = (SHELL_COMMAND_INTERNAL_LIST_ENTRY *) Link;
+    if (Node->Invocations != 0) {
+      Print (
+        L"%-10s %6Lu %12Lu %12Lu %12Lu\n",
+        Node->CommandString,
+        Node->Invocations,
+        DivU64x32 (Node->MinNs, 1000),
+        DivU64x32 (DivU64x64Remainder (Node->TotalNs, Node->Invocations, NULL), 1000),
+        DivU64x32 (Node->MaxNs, 1000)
+        );
+    }
+    if (Reset) {
+      Node->Invocations = 0;
+      Node->TotalNs     = 0;
+      Node->MinNs       = 0;
+      Node->MaxNs       = 0;
+    }
+  }
+
+  Print (
+    L"\nConsole: %Lu callbacks, %Lu sessions, %Lu ms total, %Lu ms longest\n",
+    mSessionStats.Notifications,
+    mSessionStats.Sessions,
+    DivU64x32 (mSessionStats.TotalNs, 1000000),
+    DivU64x32 (mSessionStats.MaxNs, 1000000)
+    );
+  if (Reset) {
+    ZeroMem (&mSessionStats, sizeof (mSessionStats));
+  }
+
+  return SHELL_SUCCESS;
+}
@@ -15,24 +15,98 @@
 
 #define CONSOLE_KEY          L'r'
 
+//
+// Ctrl-R as reported by SimpleTextIn while the console is reading a line.
+// The same key opens a session, so the input is reset when one starts.
+//
+#define HISTORY_SEARCH_KEY   ((CHAR16) 0x12)
+#define HISTORY_SEARCH_MAX   64
+
+//
+// Command history kept as a ring of fixed-size line slots in one allocation.
+// Age 0 is the most recent line.
+//
 typedef struct {
-  LIST_ENTRY    Link;
-  VOID          *Buffer;
-} BUFFER_LIST;
+  CHAR16                      *Arena;               ///< Capacity * LineLength characters.
+  UINTN                       Capacity;             ///< Number of line slots.
+  UINTN                       LineLength;           ///< Characters per slot, including the NULL.
+  UINTN                       Head;                 ///< Slot the next line is written to.
+  UINTN                       Count;                ///< Number of slots in use.
+} CONSOLE_HISTORY;
 
 typedef struct {
-  BUFFER_LIST                 CommandHistory;
+  CONSOLE_HISTORY             CommandHistory;
   UINTN                       VisibleRowNumber;
   UINTN                       OriginalVisibleRowNumber;
   BOOLEAN                     InsertMode;           ///< Is the current typing mode insert (FALSE = overwrite).
 } SHELL_VIEWING_SETTINGS;
 
+//
+// State of a reverse incremental search through the command history
+//
+typedef struct {
+  CHAR16                      Pattern[HISTORY_SEARCH_MAX];
+  UINTN                       PatternLen;
+  UINTN                       MatchAge;             ///< Age of Match in the history.
+  CONST CHAR16                *Match;               ///< Matching line, NULL if none.
+  BOOLEAN                     Failed;               ///< Pattern has no (older) match.
+  UINTN                       Shown;                ///< Characters of the prompt on the screen.
+  UINTN                       StartColumn;          ///< Column where the prompt is drawn.
+  UINTN                       StartRow;             ///< Row where the prompt is drawn.
+  UINTN                       MaxShow;              ///< Characters that fit from the prompt start.
+} HISTORY_SEARCH;
+
+//
+// State of the line being read, fed one key at a time
+//
+typedef struct {
+  CHAR16                      *Buffer;              ///< The line.
+  UINTN                       MaxStr;               ///< Maximum possible line length.
+  UINTN                       Column;               ///< Column of the cursor.
+  UINTN                       Row;                  ///< Row of the cursor.
+  UINTN                       StartColumn;          ///< Column at the beginning of the line.
+  UINTN                       TotalColumn;          ///< Num of columns in the console.
+  UINTN                       TotalRow;             ///< Num of rows in the console.
+  UINTN                       StringLen;            ///< Total length of the line.
+  UINTN                       StringCurPos;         ///< Line index corresponding to the cursor.
+  UINTN                       Update;               ///< Line index for update.
+  UINTN                       Delete;               ///< Num of chars to delete from console after update.
+  UINTN                       OutputLength;         ///< Length of the update string.
+  UINTN                       HistoryPos;           ///< 1 + age of the recalled line, 0 for none.
+  CONST CHAR16                *Recall;              ///< History line to show instead of the input.
+  BOOLEAN                     Searching;            ///< Keys go to Search.
+  HISTORY_SEARCH              Search;
+} LINE_EDITOR;
+
+typedef enum {
+  ConsoleSessionIdle,
+  ConsoleSessionWelcome,                            ///< Clear the screen and greet.
+  ConsoleSessionPrompt,                             ///< Print the prompt and start a line.
+  ConsoleSessionReading                             ///< Feed keys to the line editor.
+} CONSOLE_SESSION_STATE;
+
+//
+// A console session.  It advances on a periodic timer, a bounded number of
+// keys at a time, so that boot keeps going while the console is open.
+//
+typedef struct {
+  CONSOLE_SESSION_STATE             State;
+  EFI_SIMPLE_TEXT_INPUT_PROTOCOL    *ConIn;         ///< Console of the session, NULL for the system one.
+  EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL   *ConOut;
+  CHAR16                            *CmdLine;       ///< Buffer of the line being read, kept across prompts.
+  UINTN                             CmdLineSize;    ///< Size of CmdLine in bytes.
+  LINE_EDITOR                       Editor;
+} CONSOLE_SESSION;
+
 SHELL_VIEWING_SETTINGS        ViewingSettings;
 EFI_SHELL_PARAMETERS_PROTOCOL *NewShellParametersProtocol;
 
 extern BOOLEAN                mExitRequested;
 
 STATIC EFI_EVENT              mTimerEvent    = NULL;
+STATIC EFI_EVENT              mSessionEvent  = NULL;
+STATIC CONSOLE_SESSION        mSession;
+CONSOLE_SESSION_STATS         mSessionStats;
 STATIC VOID                   *NotifyHandle0 = NULL;
 STATIC VOID                   *NotifyHandle1 = NULL;
 STATIC VOID                   *NotifyHandle2 = NULL;
@@ -43,9 +117,81 @@ STATIC VOID                   *NotifyHandle3 = NULL;
 //
 #define CONSOLE_REQUEST_DELAY  (1 * 1000 * 1000 * 10)
 
+//
+// Period of the session timer, 10ms in 100ns units, and the most keys
+// handled in one tick.
+//
+#define CONSOLE_SESSION_TICK            (10 * 1000 * 10)
+#define CONSOLE_SESSION_KEYS_PER_TICK   16
+
+//
+// Keys read ahead by ConsoleCheckEscape() and not yet fed to the line editor.
+// Further keys are left in ConIn while the queue is full.
+//
+#define CONSOLE_TYPEAHEAD_KEYS          16
+
+typedef struct {
+  EFI_INPUT_KEY                     Keys[CONSOLE_TYPEAHEAD_KEYS];
+  UINTN                             Head;
+  UINTN                             Count;
+} CONSOLE_TYPEAHEAD;
+
+STATIC CONSOLE_TYPEAHEAD      mTypeAhead;
+
+/**
+  Allocate the command history arena.  The capacity comes from
+  PcdConsoleHistoryCount; zero disables the history.
+
+  @retval EFI_SUCCESS           The history is ready to use.
+  @retval EFI_OUT_OF_RESOURCES  The arena could not be allocated.
+**/
+EFI_STATUS
+InitCommandHistory (
+  VOID
+  )
+{
+  CONSOLE_HISTORY  *History;
+
+  History             = &ViewingSettings.CommandHistory;
+  History->Capacity   = PcdGet16 (PcdConsoleHistoryCount);
+  History->LineLength = PcdGet16 (PcdConsoleHistoryLineLength);
+  History->Head       = 0;
+  History->Count      = 0;
+  History->Arena      = NULL;
+
+  if (History->Capacity == 0 || History->LineLength < 2) {
+    History->Capacity = 0;
+    return EFI_SUCCESS;
+  }
+
+  History->Arena = AllocateZeroPool (History->Capacity * History->LineLength * sizeof (CHAR16));
+  if (History->Arena == NULL) {
+    History->Capacity = 0;
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Free the command history arena.
+**/
+VOID
+FreeCommandHistory (
+  VOID
+  )
+{
+  SHELL_FREE_NON_NULL (ViewingSettings.CommandHistory.Arena);
+  ViewingSettings.CommandHistory.Capacity = 0;
+  ViewingSettings.CommandHistory.Count    = 0;
+}
+
 /**
   Add a buffer to the Line History List
 
+  When the history is full the oldest line is overwritten.  Lines longer
+  than a slot are truncated.
+
   @param Buffer     The line buffer to add.
 
 **/
@@ -54,47 +200,259 @@ AddLineToCommandHistory (
   IN CONST CHAR16 *Buffer
   )
 {
-  BUFFER_LIST *Node;
-  BUFFER_LIST *Walker;
-  UINT16       MaxHistoryCmdCount;
-  UINT16       Count;
-
-  Count = 0;
-  MaxHistoryCmdCount = 0x20;
+  CONSOLE_HISTORY  *History;
 
-  if (MaxHistoryCmdCount == 0) {
+  History = &ViewingSettings.CommandHistory;
+  if (History->Capacity == 0) {
     return ;
   }
 
+  StrnCpyS (
+    History->Arena + History->Head * History->LineLength,
+    History->LineLength,
+    Buffer,
+    History->LineLength - 1
+    );
 
-  Node = AllocateZeroPool (sizeof (BUFFER_LIST));
-  if (Node == NULL) {
-    return;
+  History->Head = (History->Head + 1) % History->Capacity;
+  if (History->Count < History->Capacity) {
+    History->Count++;
   }
+}
 
-  Node->Buffer = AllocateCopyPool (StrSize (Buffer), Buffer);
-  if (Node->Buffer == NULL) {
-    FreePool (Node);
-    return;
+/**
+  Get a line from the command history.
+
+  @param[in] Age    Age of the line; 0 is the most recent one.
+
+  @return The line, or NULL if there is no line of that age.
+**/
+CONST CHAR16 *
+GetLineFromCommandHistory (
+  IN UINTN Age
+  )
+{
+  CONSOLE_HISTORY  *History;
+  UINTN            Slot;
+
+  History = &ViewingSettings.CommandHistory;
+  if (Age >= History->Count) {
+    return NULL;
   }
 
-  for (Walker = (BUFFER_LIST*) GetFirstNode (&ViewingSettings.CommandHistory.Link)
-      ; !IsNull(&ViewingSettings.CommandHistory.Link, &Walker->Link)
-      ; Walker = (BUFFER_LIST*) GetNextNode (&ViewingSettings.CommandHistory.Link, &Walker->Link)
-   ) {
-    Count++;
+  Slot = (History->Head + History->Capacity - 1 - Age) % History->Capacity;
+  return History->Arena + Slot * History->LineLength;
+}
+
+/**
+  Find the most recent history line at or older than Age containing Pattern.
+
+  @param[in]      Pattern   The string to look for.
+  @param[in, out] Age       On input, the age to start from.  On output, the
+                            age of the matching line.
+
+  @return The matching line, or NULL if no line matched.
+**/
+CONST CHAR16 *
+FindLineInCommandHistory (
+  IN     CONST CHAR16 *Pattern,
+  IN OUT UINTN        *Age
+  )
+{
+  CONST CHAR16  *Line;
+  UINTN         Index;
+
+  for (Index = *Age; (Line = GetLineFromCommandHistory (Index)) != NULL; Index++) {
+    if (StrStr (Line, Pattern) != NULL) {
+      *Age = Index;
+      return Line;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Print as much of a string as fits in the remaining space.
+
+  @param[in] String     The string to print.
+  @param[in] Shown      Number of characters already printed.
+  @param[in] MaxShow    Maximum number of characters to print in total.
+
+  @return The number of characters printed in total.
+**/
+STATIC
+UINTN
+PrintClipped (
+  IN CONST CHAR16 *String,
+  IN UINTN        Shown,
+  IN UINTN        MaxShow
+  )
+{
+  UINTN  Length;
+
+  if (Shown >= MaxShow) {
+    return Shown;
+  }
+
+  Length = StrLen (String);
+  if (Length > MaxShow - Shown) {
+    Length = MaxShow - Shown;
+  }
+  Print (L"%.*s", Length, String);
+  return Shown + Length;
+}
+
+/**
+  Draw the search prompt over the input line, blanking whatever is left of
+  the previous one.
+
+  @param[in, out] Search    The search.
+**/
+STATIC
+VOID
+SearchDraw (
+  IN OUT HISTORY_SEARCH  *Search
+  )
+{
+  UINTN  Length;
+
+  gST->ConOut->SetCursorPosition (gST->ConOut, Search->StartColumn, Search->StartRow);
+  Length = PrintClipped (Search->Failed ? L"(failed reverse-i-search)`" : L"(reverse-i-search)`", 0, Search->MaxShow);
+  Length = PrintClipped (Search->Pattern, Length, Search->MaxShow);
+  Length = PrintClipped (L"': ", Length, Search->MaxShow);
+  if (Search->Match != NULL) {
+    Length = PrintClipped (Search->Match, Length, Search->MaxShow);
+  }
+  if (Search->Shown > Length) {
+    Print (L"%*s", Search->Shown - Length, L"");
+  }
+  Search->Shown = Length;
+}
+
+/**
+  Erase the search prompt.
+
+  @param[in] Search   The search.
+**/
+STATIC
+VOID
+SearchErase (
+  IN HISTORY_SEARCH  *Search
+  )
+{
+  gST->ConOut->SetCursorPosition (gST->ConOut, Search->StartColumn, Search->StartRow);
+  Print (L"%*s", Search->Shown, L"");
+  gST->ConOut->SetCursorPosition (gST->ConOut, Search->StartColumn, Search->StartRow);
+}
+
+/**
+  Start a reverse incremental search through the command history (Ctrl-R).
+
+  The search prompt is drawn over the input line.  Typing extends the
+  pattern, BACKSPACE shortens it, Ctrl-R moves to the next older match,
+  ENTER or a cursor key accepts the match and ESC cancels.
+
+  @param[out] Search        The search.
+  @param[in]  StartColumn   Column where the input line starts.
+  @param[in]  StartRow      Row where the input line starts.
+  @param[in]  MaxShow       Number of characters that fit on the screen
+                            from the start of the input line.
+**/
+STATIC
+VOID
+SearchStart (
+  OUT HISTORY_SEARCH  *Search,
+  IN  UINTN           StartColumn,
+  IN  UINTN           StartRow,
+  IN  UINTN           MaxShow
+  )
+{
+  ZeroMem (Search, sizeof (*Search));
+  Search->Match       = GetLineFromCommandHistory (0);
+  Search->StartColumn = StartColumn;
+  Search->StartRow    = StartRow;
+  Search->MaxShow     = MaxShow;
+  SearchDraw (Search);
+}
+
+/**
+  Feed a key to the search.  When the search ends its prompt is erased and
+  Search->Match holds the accepted line, or NULL if the search was cancelled
+  or nothing matched.
+
+  @param[in, out] Search  The search.
+  @param[in]      Key     The key.
+
+  @retval TRUE    The search has ended.
+  @retval FALSE   The search goes on.
+**/
+STATIC
+BOOLEAN
+SearchProcessKey (
+  IN OUT HISTORY_SEARCH  *Search,
+  IN     EFI_INPUT_KEY   *Key
+  )
+{
+  BOOLEAN  Accept;
+
+  Accept = FALSE;
+
+  if (Key->UnicodeChar == HISTORY_SEARCH_KEY) {
+    //
+    // Next older line matching the same pattern
+    //
+    if (Search->Match != NULL) {
+      Search->MatchAge++;
+      Search->Match = FindLineInCommandHistory (Search->Pattern, &Search->MatchAge);
+      if (Search->Match == NULL) {
+        Search->MatchAge--;
+        Search->Match  = GetLineFromCommandHistory (Search->MatchAge);
+        Search->Failed = TRUE;
+      }
+    }
+  } else if (Key->UnicodeChar == CHAR_BACKSPACE) {
+    if (Search->PatternLen != 0) {
+      Search->Pattern[--Search->PatternLen] = CHAR_NULL;
+      Search->MatchAge = 0;
+      Search->Match    = FindLineInCommandHistory (Search->Pattern, &Search->MatchAge);
+      Search->Failed   = (BOOLEAN) (Search->Match == NULL);
+    }
+  } else if (Key->UnicodeChar == CHAR_CARRIAGE_RETURN) {
+    Accept = TRUE;
+  } else if (Key->UnicodeChar >= L' ') {
+    if (Search->PatternLen < HISTORY_SEARCH_MAX - 1) {
+      Search->Pattern[Search->PatternLen++] = Key->UnicodeChar;
+      Search->Pattern[Search->PatternLen]   = CHAR_NULL;
+      //
+      // A longer pattern can only match the current line or an older one
+      //
+      if (!Search->Failed) {
+        Search->Match  = FindLineInCommandHistory (Search->Pattern, &Search->MatchAge);
+        Search->Failed = (BOOLEAN) (Search->Match == NULL);
+      }
+    }
+  } else if (Key->UnicodeChar == CHAR_NULL) {
+    if (Key->ScanCode == SCAN_ESC) {
+      Search->Match = NULL;
+      SearchErase (Search);
+      return TRUE;
+    }
+    Accept = (BOOLEAN) (Key->ScanCode == SCAN_LEFT || Key->ScanCode == SCAN_RIGHT ||
+                        Key->ScanCode == SCAN_HOME || Key->ScanCode == SCAN_END  ||
+                        Key->ScanCode == SCAN_UP   || Key->ScanCode == SCAN_DOWN);
   }
-  if (Count < MaxHistoryCmdCount) {
-    InsertTailList (&ViewingSettings.CommandHistory.Link, &Node->Link);
-  } else {
-    Walker = (BUFFER_LIST *) GetFirstNode (&ViewingSettings.CommandHistory.Link);
-    RemoveEntryList (&Walker->Link);
-    if (Walker->Buffer != NULL) {
-      FreePool (Walker->Buffer);
+
+  if (Accept) {
+    if (Search->Failed) {
+      Search->Match = NULL;
     }
-    FreePool (Walker);
-    InsertTailList (&ViewingSettings.CommandHistory.Link, &Node->Link);
+    SearchErase (Search);
+    return TRUE;
   }
+
+  SearchDraw (Search);
+  return FALSE;
 }
 
 /**
@@ -155,337 +513,386 @@ MoveCursorForward (
   }
 }
 
+/**
+  Start reading a line at the cursor position.
+
+  @param[out] Editor      The line editor.
+  @param[in]  Buffer      Buffer of the line.
+  @param[in]  BufferSize  Size of Buffer in bytes.
+
+  @retval EFI_SUCCESS           The editor is ready for keys.
+  @retval EFI_BUFFER_TOO_SMALL  Buffer cannot hold a character.
+**/
+STATIC
 EFI_STATUS
-EFIAPI
-UefiConsoleInRead (
-  IN OUT UINTN        *BufferSize,
-  OUT VOID            *Buffer
+LineEditorStart (
+  OUT LINE_EDITOR  *Editor,
+  IN  CHAR16       *Buffer,
+  IN  UINTN        BufferSize
   )
 {
-  CHAR16              *CurrentString;
-  BOOLEAN             Done;
-  UINTN               Column;         // Column of current cursor
-  UINTN               Row;            // Row of current cursor
-  UINTN               StartColumn;    // Column at the beginning of the line
-  UINTN               Update;         // Line index for update
-  UINTN               Delete;         // Num of chars to delete from console after update
-  UINTN               StringLen;      // Total length of the line
-  UINTN               StringCurPos;   // Line index corresponding to the cursor
-  UINTN               MaxStr;         // Maximum possible line length
-  UINTN               TotalColumn;     // Num of columns in the console
-  UINTN               TotalRow;       // Num of rows in the console
-  UINTN               SkipLength;
-  UINTN               OutputLength;   // Length of the update string
-  UINTN               TailRow;        // Row of end of line
-  UINTN               TailColumn;     // Column of end of line
-  EFI_INPUT_KEY       Key;
-
-  BUFFER_LIST         *LinePos;
-  BUFFER_LIST         *NewPos;
-  EFI_STATUS          Status;
-  UINTN               EventIndex;
-
   //
-  // If buffer is not large enough to hold a CHAR16, return minimum buffer size
+  // If buffer is not large enough to hold a CHAR16, fail
   //
-  if (*BufferSize < sizeof (CHAR16) * 2) {
-    *BufferSize = sizeof (CHAR16) * 2;
+  if (BufferSize < sizeof (CHAR16) * 2) {
     return (EFI_BUFFER_TOO_SMALL);
   }
 
-  Done              = FALSE;
-  CurrentString     = Buffer;
-  StringLen         = 0;
-  StringCurPos      = 0;
-  OutputLength      = 0;
-  Update            = 0;
-  Delete            = 0;
-  LinePos           = NewPos = (BUFFER_LIST *) (&ViewingSettings.CommandHistory);
-  Status            = EFI_SUCCESS;
+  ZeroMem (Editor, sizeof (*Editor));
+  Editor->Buffer = Buffer;
 
   //
   // Get the screen setting and the current cursor location
   //
-  Column      = StartColumn = gST->ConOut->Mode->CursorColumn;
-  Row         = gST->ConOut->Mode->CursorRow;
-  gST->ConOut->QueryMode (gST->ConOut, gST->ConOut->Mode->Mode, &TotalColumn, &TotalRow);
+  Editor->Column = Editor->StartColumn = gST->ConOut->Mode->CursorColumn;
+  Editor->Row    = gST->ConOut->Mode->CursorRow;
+  gST->ConOut->QueryMode (gST->ConOut, gST->ConOut->Mode->Mode, &Editor->TotalColumn, &Editor->TotalRow);
 
   //
   // Limit the line length to the buffer size or the minimun size of the
   // screen. (The smaller takes effect)
   //
-  MaxStr = TotalColumn * (TotalRow - 1) - StartColumn;
-  if (MaxStr > *BufferSize / sizeof (CHAR16)) {
-    MaxStr = *BufferSize / sizeof (CHAR16);
+  Editor->MaxStr = Editor->TotalColumn * (Editor->TotalRow - 1) - Editor->StartColumn;
+  if (Editor->MaxStr > BufferSize / sizeof (CHAR16)) {
+    Editor->MaxStr = BufferSize / sizeof (CHAR16);
   }
-  ZeroMem (CurrentString, MaxStr * sizeof (CHAR16));
-  do {
-    //
-    // Read a key
-    //
-    gBS->WaitForEvent (1, &gST->ConIn->WaitForKey, &EventIndex);
-    Status = gST->ConIn->ReadKeyStroke (gST->ConIn, &Key);
-    if (EFI_ERROR (Status)) {
+  ZeroMem (Buffer, Editor->MaxStr * sizeof (CHAR16));
+  return EFI_SUCCESS;
+}
 
-      if (Status == EFI_NOT_READY) {
-        continue;
-      }
+/**
+  Redraw what the last key changed and place the cursor.
 
-      ZeroMem (CurrentString, MaxStr * sizeof (CHAR16));
-      StringLen = 0;
-      break;
-    }
+  @param[in, out] Editor  The line editor.
+  @param[in]      Key     The last key.
+**/
+STATIC
+VOID
+LineEditorRefresh (
+  IN OUT LINE_EDITOR    *Editor,
+  IN     EFI_INPUT_KEY  *Key
+  )
+{
+  CHAR16  *CurrentString;
+  UINTN   SkipLength;
+  UINTN   TailRow;
+  UINTN   TailColumn;
+
+  CurrentString = Editor->Buffer;
+
+  //
+  // If we have a line to recall, we are preparing to print a previous or
+  // next command.
+  //
+  if (Editor->Recall != NULL) {
+    Editor->Column = Editor->StartColumn;
+    Editor->Row   -= (Editor->StringCurPos + Editor->StartColumn) / Editor->TotalColumn;
+
+    Editor->OutputLength = StrLen (Editor->Recall) < Editor->MaxStr - 1 ? StrLen (Editor->Recall) : Editor->MaxStr - 1;
+    CopyMem (CurrentString, Editor->Recall, Editor->OutputLength * sizeof (CHAR16));
+    Editor->Recall = NULL;
+    CurrentString[Editor->OutputLength] = CHAR_NULL;
 
-    switch (Key.UnicodeChar) {
-    case CHAR_CARRIAGE_RETURN:
+    Editor->StringCurPos = Editor->OutputLength;
+
+    //
+    // Draw new input string
+    //
+    Editor->Update = 0;
+    if (Editor->StringLen > Editor->OutputLength) {
       //
-      // All done, print a newline at the end of the string
+      // If old string was longer, blank its tail
       //
-      TailRow     = Row + (StringLen - StringCurPos + Column) / TotalColumn;
-      TailColumn  = (StringLen - StringCurPos + Column) % TotalColumn;
-      if (Column != -1 && Row != -1) {
-        Status = gST->ConOut->SetCursorPosition (gST->ConOut, TailColumn, TailRow);
-        Print (L"\n");
-      }
-      Done = TRUE;
-      break;
+      Editor->Delete = Editor->StringLen - Editor->OutputLength;
+    }
+  }
+  //
+  // If we need to update the output do so now
+  //
+  if (Editor->Update != (UINTN) - 1) {
+    gST->ConOut->SetCursorPosition (gST->ConOut, Editor->Column, Editor->Row);
+    Print (L"%s%.*s", CurrentString + Editor->Update, Editor->Delete, L"");
+    Editor->StringLen = StrLen (CurrentString);
 
-    case CHAR_BACKSPACE:
-      if (StringCurPos != 0) {
-        //
-        // If not move back beyond string beginning, move all characters behind
-        // the current position one character forward
-        //
-        StringCurPos--;
-        Update  = StringCurPos;
-        Delete  = 1;
-        CopyMem (CurrentString + StringCurPos, CurrentString + StringCurPos + 1, sizeof (CHAR16) * (StringLen - StringCurPos));
+    if (Editor->Delete != 0) {
+      SetMem (CurrentString + Editor->StringLen, Editor->Delete * sizeof (CHAR16), CHAR_NULL);
+    }
 
-        //
-        // Adjust the current column and row
-        //
-        MoveCursorBackward (TotalColumn, &Column, &Row);
-      }
-      break;
+    if (Editor->StringCurPos > Editor->StringLen) {
+      Editor->StringCurPos = Editor->StringLen;
+    }
 
-    default:
-      if (Key.UnicodeChar >= ' ') {
-        //
-        // If we are at the buffer's end, drop the key
-        //
-        if (StringLen == MaxStr - 1 && (StringCurPos == StringLen)) {
-          break;
-        }
+    Editor->Update = (UINTN) - 1;
 
-        CurrentString[StringCurPos] = Key.UnicodeChar;
-        Update      = StringCurPos;
+    //
+    // After using print to reflect newly updates, if we're not using
+    // BACKSPACE and DELETE, we need to move the cursor position forward,
+    // so adjust row and column here.
+    //
+    if (Key->UnicodeChar != CHAR_BACKSPACE && ! (Key->UnicodeChar == 0 && Key->ScanCode == SCAN_DELETE)) {
+      //
+      // Calulate row and column of the tail of current string
+      //
+      TailRow     = Editor->Row + (Editor->StringLen - Editor->StringCurPos + Editor->Column + Editor->OutputLength) / Editor->TotalColumn;
+      TailColumn  = (Editor->StringLen - Editor->StringCurPos + Editor->Column + Editor->OutputLength) % Editor->TotalColumn;
 
-        StringCurPos += 1;
-        OutputLength = 1;
+      //
+      // If the tail of string reaches screen end, screen rolls up, so if
+      // Row does not equal TailRow, Row should be decremented
+      //
+      // (if we are recalling commands using UPPER and DOWN key, and if the
+      // old command is too long to fit the screen, TailColumn must be 79.
+      //
+      if (TailColumn == 0 && TailRow >= Editor->TotalRow && Editor->Row != TailRow) {
+        Editor->Row--;
       }
-      break;
+      //
+      // Calculate the cursor position after current operation. If cursor
+      // reaches line end, update both row and column, otherwise, only
+      // column will be changed.
+      //
+      if (Editor->Column + Editor->OutputLength >= Editor->TotalColumn) {
+        SkipLength = Editor->OutputLength - (Editor->TotalColumn - Editor->Column);
 
-    case 0:
-      switch (Key.ScanCode) {
-      case SCAN_DELETE:
-        //
-        // Move characters behind current position one character forward
-        //
-        if (StringLen != 0) {
-          Update  = StringCurPos;
-          Delete  = 1;
-          CopyMem (CurrentString + StringCurPos, CurrentString + StringCurPos + 1, sizeof (CHAR16) * (StringLen - StringCurPos));
+        Editor->Row += SkipLength / Editor->TotalColumn + 1;
+        if (Editor->Row > Editor->TotalRow - 1) {
+          Editor->Row = Editor->TotalRow - 1;
         }
-        break;
 
-      case SCAN_UP:
-        //
-        // Prepare to print the previous command
-        //
-        NewPos = (BUFFER_LIST *)GetPreviousNode (&ViewingSettings.CommandHistory.Link, &LinePos->Link);
-        if (IsNull (&ViewingSettings.CommandHistory.Link, &LinePos->Link)) {
-          NewPos = (BUFFER_LIST *) GetPreviousNode (&ViewingSettings.CommandHistory.Link, &LinePos->Link);
-        }
-        break;
+        Editor->Column = SkipLength % Editor->TotalColumn;
+      } else {
+        Editor->Column += Editor->OutputLength;
+      }
+    }
 
-      case SCAN_DOWN:
-        //
-        // Prepare to print the next command
-        //
-        NewPos = (BUFFER_LIST *) GetNextNode (&ViewingSettings.CommandHistory.Link, &LinePos->Link);
-        if (NewPos == (BUFFER_LIST *) (&ViewingSettings.CommandHistory)) {
-          NewPos = (BUFFER_LIST *) GetNextNode (&ViewingSettings.CommandHistory.Link, &LinePos->Link);
-        }
-        break;
+    Editor->Delete = 0;
+  }
+  //
+  // Set the cursor position for this key
+  //
+  gST->ConOut->SetCursorPosition (gST->ConOut, Editor->Column, Editor->Row);
+}
 
-      case SCAN_LEFT:
-        //
-        // Adjust current cursor position
-        //
-        if (StringCurPos != 0) {
-          --StringCurPos;
-          MoveCursorBackward (TotalColumn, &Column, &Row);
-        }
-        break;
+/**
+  Feed a key to the line editor.  When ENTER completes the line, it is added
+  to the command history and Editor->StringLen is its length.
 
-      case SCAN_RIGHT:
-        //
-        // Adjust current cursor position
-        //
-        if (StringCurPos < StringLen) {
-          ++StringCurPos;
-          MoveCursorForward (TotalColumn, TotalRow, &Column, &Row);
-        }
-        break;
+  @param[in, out] Editor  The line editor.
+  @param[in]      Key     The key.
 
-      case SCAN_HOME:
-        //
-        // Move current cursor position to the beginning of the command line
-        //
-        Row -= (StringCurPos + StartColumn) / TotalColumn;
-        Column  = StartColumn;
-        StringCurPos  = 0;
-        break;
+  @retval TRUE    The line is complete.
+  @retval FALSE   More keys are needed.
+**/
+STATIC
+BOOLEAN
+LineEditorProcessKey (
+  IN OUT LINE_EDITOR    *Editor,
+  IN     EFI_INPUT_KEY  *Key
+  )
+{
+  CHAR16          *CurrentString;
+  UINTN           TailRow;
+  UINTN           TailColumn;
+  EFI_INPUT_KEY   SearchKey;
 
-      case SCAN_END:
-        //
-        // Move current cursor position to the end of the command line
-        //
-        TailRow       = Row + (StringLen - StringCurPos + Column) / TotalColumn;
-        TailColumn    = (StringLen - StringCurPos + Column) % TotalColumn;
-        Row           = TailRow;
-        Column        = TailColumn;
-        StringCurPos  = StringLen;
-        break;
+  CurrentString = Editor->Buffer;
 
-      case SCAN_ESC:
-        //
-        // Prepare to clear the current command line
-        //
-        CurrentString[0]  = 0;
-        Update  = 0;
-        Delete  = StringLen;
-        Row -= (StringCurPos + StartColumn) / TotalColumn;
-        Column        = StartColumn;
-        OutputLength  = 0;
-        break;
-      }
+  if (Editor->Searching) {
+    if (!SearchProcessKey (&Editor->Search, Key)) {
+      return FALSE;
     }
-
-    if (Done) {
-      break;
+    Editor->Searching = FALSE;
+    if (Editor->Search.Match != NULL) {
+      Editor->Recall     = Editor->Search.Match;
+      Editor->HistoryPos = Editor->Search.MatchAge + 1;
+    } else {
+      //
+      // Cancelled: redraw what was typed
+      //
+      Editor->Recall = CurrentString;
     }
+    SearchKey.ScanCode    = SCAN_NULL;
+    SearchKey.UnicodeChar = HISTORY_SEARCH_KEY;
+    LineEditorRefresh (Editor, &SearchKey);
+    return FALSE;
+  }
 
+  switch (Key->UnicodeChar) {
+  case CHAR_CARRIAGE_RETURN:
     //
-    // If we have a new position, we are preparing to print a previous or
-    // next command.
+    // All done, print a newline at the end of the string
     //
-    if (NewPos != (BUFFER_LIST *) (&ViewingSettings.CommandHistory)) {
-      Column = StartColumn;
-      Row -= (StringCurPos + StartColumn) / TotalColumn;
+    TailRow     = Editor->Row + (Editor->StringLen - Editor->StringCurPos + Editor->Column) / Editor->TotalColumn;
+    TailColumn  = (Editor->StringLen - Editor->StringCurPos + Editor->Column) % Editor->TotalColumn;
+    gST->ConOut->SetCursorPosition (gST->ConOut, TailColumn, TailRow);
+    Print (L"\n");
 
-      LinePos       = NewPos;
-      NewPos        = (BUFFER_LIST *) (&ViewingSettings.CommandHistory);
-
-      OutputLength  = StrLen (LinePos->Buffer) < MaxStr - 1 ? StrLen (LinePos->Buffer) : MaxStr - 1;
-      CopyMem (CurrentString, LinePos->Buffer, OutputLength * sizeof (CHAR16));
-      CurrentString[OutputLength] = CHAR_NULL;
+    if (StrLen (CurrentString) > 0) {
+      //
+      // add the line to the history buffer
+      //
+      AddLineToCommandHistory (CurrentString);
+    }
+    return TRUE;
 
-      StringCurPos            = OutputLength;
+  case CHAR_BACKSPACE:
+    if (Editor->StringCurPos != 0) {
+      //
+      // If not move back beyond string beginning, move all characters behind
+      // the current position one character forward
+      //
+      Editor->StringCurPos--;
+      Editor->Update  = Editor->StringCurPos;
+      Editor->Delete  = 1;
+      CopyMem (CurrentString + Editor->StringCurPos, CurrentString + Editor->StringCurPos + 1, sizeof (CHAR16) * (Editor->StringLen - Editor->StringCurPos));
 
       //
-      // Draw new input string
+      // Adjust the current column and row
       //
-      Update = 0;
-      if (StringLen > OutputLength) {
-        //
-        // If old string was longer, blank its tail
-        //
-        Delete = StringLen - OutputLength;
-      }
+      MoveCursorBackward (Editor->TotalColumn, &Editor->Column, &Editor->Row);
     }
+    break;
+
+  case HISTORY_SEARCH_KEY:
     //
-    // If we need to update the output do so now
+    // Draw the search prompt over the input line, clipped so that the
+    // screen does not scroll.
     //
-    if (Update != (UINTN) - 1) {
-      if (Column != -1 && Row != -1) {
-        Status = gST->ConOut->SetCursorPosition (gST->ConOut, Column, Row);
-        Print (L"%s%.*s", CurrentString + Update, Delete);
+    TailRow = Editor->Row - (Editor->StringCurPos + Editor->StartColumn) / Editor->TotalColumn;
+    SearchStart (
+      &Editor->Search,
+      Editor->StartColumn,
+      TailRow,
+      Editor->TotalColumn * (Editor->TotalRow - TailRow) - Editor->StartColumn - 1
+      );
+    Editor->Searching = TRUE;
+    return FALSE;
+
+  default:
+    if (Key->UnicodeChar >= ' ') {
+      //
+      // If we are at the buffer's end, drop the key
+      //
+      if (Editor->StringLen == Editor->MaxStr - 1 && (Editor->StringCurPos == Editor->StringLen)) {
+        break;
       }
-      StringLen = StrLen (CurrentString);
 
-      if (Delete != 0) {
-        SetMem (CurrentString + StringLen, Delete * sizeof (CHAR16), CHAR_NULL);
+      CurrentString[Editor->StringCurPos] = Key->UnicodeChar;
+      Editor->Update = Editor->StringCurPos;
+
+      Editor->StringCurPos += 1;
+      Editor->OutputLength  = 1;
+    }
+    break;
+
+  case 0:
+    switch (Key->ScanCode) {
+    case SCAN_DELETE:
+      //
+      // Move characters behind current position one character forward
+      //
+      if (Editor->StringLen != 0) {
+        Editor->Update  = Editor->StringCurPos;
+        Editor->Delete  = 1;
+        CopyMem (CurrentString + Editor->StringCurPos, CurrentString + Editor->StringCurPos + 1, sizeof (CHAR16) * (Editor->StringLen - Editor->StringCurPos));
       }
+      break;
 
-      if (StringCurPos > StringLen) {
-        StringCurPos = StringLen;
+    case SCAN_UP:
+      //
+      // Prepare to print the previous command
+      //
+      Editor->Recall = GetLineFromCommandHistory (Editor->HistoryPos);
+      if (Editor->Recall != NULL) {
+        Editor->HistoryPos++;
       }
+      break;
 
-      Update = (UINTN) - 1;
+    case SCAN_DOWN:
+      //
+      // Prepare to print the next command
+      //
+      if (Editor->HistoryPos > 1) {
+        Editor->HistoryPos--;
+        Editor->Recall = GetLineFromCommandHistory (Editor->HistoryPos - 1);
+      }
+      break;
 
+    case SCAN_LEFT:
       //
-      // After using print to reflect newly updates, if we're not using
-      // BACKSPACE and DELETE, we need to move the cursor position forward,
-      // so adjust row and column here.
+      // Adjust current cursor position
       //
-      if (Key.UnicodeChar != CHAR_BACKSPACE && ! (Key.UnicodeChar == 0 && Key.ScanCode == SCAN_DELETE)) {
-        //
-        // Calulate row and column of the tail of current string
-        //
-        TailRow     = Row + (StringLen - StringCurPos + Column + OutputLength) / TotalColumn;
-        TailColumn  = (StringLen - StringCurPos + Column + OutputLength) % TotalColumn;
+      if (Editor->StringCurPos != 0) {
+        --Editor->StringCurPos;
+        MoveCursorBackward (Editor->TotalColumn, &Editor->Column, &Editor->Row);
+      }
+      break;
 
-        //
-        // If the tail of string reaches screen end, screen rolls up, so if
-        // Row does not equal TailRow, Row should be decremented
-        //
-        // (if we are recalling commands using UPPER and DOWN key, and if the
-        // old command is too long to fit the screen, TailColumn must be 79.
-        //
-        if (TailColumn == 0 && TailRow >= TotalRow && Row != TailRow) {
-          Row--;
-        }
-        //
-        // Calculate the cursor position after current operation. If cursor
-        // reaches line end, update both row and column, otherwise, only
-        // column will be changed.
-        //
-        if (Column + OutputLength >= TotalColumn) {
-          SkipLength = OutputLength - (TotalColumn - Column);
+    case SCAN_RIGHT:
+      //
+      // Adjust current cursor position
+      //
+      if (Editor->StringCurPos < Editor->StringLen) {
+        ++Editor->StringCurPos;
+        MoveCursorForward (Editor->TotalColumn, Editor->TotalRow, &Editor->Column, &Editor->Row);
+      }
+      break;
 
-          Row += SkipLength / TotalColumn + 1;
-          if (Row > TotalRow - 1) {
-            Row = TotalRow - 1;
-          }
+    case SCAN_HOME:
+      //
+      // Move current cursor position to the beginning of the command line
+      //
+      Editor->Row         -= (Editor->StringCurPos + Editor->StartColumn) / Editor->TotalColumn;
+      Editor->Column       = Editor->StartColumn;
+      Editor->StringCurPos = 0;
+      break;
 
-          Column = SkipLength % TotalColumn;
-        } else {
-          Column += OutputLength;
-        }
-      }
+    case SCAN_END:
+      //
+      // Move current cursor position to the end of the command line
+      //
+      TailRow              = Editor->Row + (Editor->StringLen - Editor->StringCurPos + Editor->Column) / Editor->TotalColumn;
+      TailColumn           = (Editor->StringLen - Editor->StringCurPos + Editor->Column) % Editor->TotalColumn;
+      Editor->Row          = TailRow;
+      Editor->Column       = TailColumn;
+      Editor->StringCurPos = Editor->StringLen;
+      break;
 
-      Delete = 0;
+    case SCAN_ESC:
+      //
+      // Prepare to clear the current command line
+      //
+      CurrentString[0]      = 0;
+      Editor->Update        = 0;
+      Editor->Delete        = Editor->StringLen;
+      Editor->Row          -= (Editor->StringCurPos + Editor->StartColumn) / Editor->TotalColumn;
+      Editor->Column        = Editor->StartColumn;
+      Editor->OutputLength  = 0;
+      break;
     }
-    //
-    // Set the cursor position for this key
-    //
-    gST->ConOut->SetCursorPosition (gST->ConOut, Column, Row);
-  } while (!Done);
-
-  if (CurrentString != NULL && StrLen (CurrentString) > 0) {
-    //
-    // add the line to the history buffer
-    //
-    AddLineToCommandHistory (CurrentString);
   }
 
-  //
-  // Return the data to the caller
-  //
-  *BufferSize = StringLen * sizeof (CHAR16);
+  LineEditorRefresh (Editor, Key);
+  return FALSE;
+}
 
-  return Status;
+/**
+  Drop the line being read, after the console input failed.
+
+  @param[in, out] Editor  The line editor.
+**/
+STATIC
+VOID
+LineEditorCancel (
+  IN OUT LINE_EDITOR  *Editor
+  )
+{
+  if (Editor->Searching) {
+    SearchErase (&Editor->Search);
+    Editor->Searching = FALSE;
+  }
+  ZeroMem (Editor->Buffer, Editor->MaxStr * sizeof (CHAR16));
+  Editor->StringLen = 0;
 }
 
 /**
@@ -621,13 +1028,13 @@ RunInternalCommand (
   CHAR16                    *Walker;
   CHAR16                    *NewCmdLine;
 
-  NewCmdLine = AllocateCopyPool (StrSize (CmdLine), CmdLine);
+  NewCmdLine = ConsoleArenaAllocateCopy (StrSize (CmdLine), CmdLine);
   if (NewCmdLine == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
 
   for (Walker = NewCmdLine; Walker != NULL && *Walker != CHAR_NULL ; Walker++) {
-    if (*Walker == L'^' && * (Walker + 1) == L'#') {
+    if (*Walker == L'^' && (* (Walker + 1) == L'#' || * (Walker + 1) == L'|')) {
       CopyMem (Walker, Walker + 1, StrSize (Walker) - sizeof (Walker[0]));
     }
   }
@@ -669,7 +1076,7 @@ RunInternalCommand (
   //
   RestoreArgcArgv (ParamProtocol, &Argv, &Argc);
 
-  FreePool (NewCmdLine);
+  ConsoleArenaFree (NewCmdLine);
   return (Status);
 }
 
@@ -695,16 +1102,24 @@ RunShellCommand (
   CHAR16                    *CleanOriginal;
   CHAR16                    *FirstParameter;
   CHAR16                    *TempWalker;
+  UINTN                     ArenaMark;
+  UINT64                    StartTicks;
+  UINT64                    ElapsedNs;
 
   ASSERT (CmdLine != NULL);
   if (StrLen (CmdLine) == 0) {
     return (EFI_SUCCESS);
   }
 
+  //
+  // Everything allocated for this command line, down to the parameter list
+  // built by the command handler, comes from the scratch arena and is
+  // released at once when the command returns.
+  //
+  ArenaMark           = ConsoleArenaMark ();
   Status              = EFI_SUCCESS;
-  CleanOriginal       = NULL;
 
-  CleanOriginal = ConsoleStrnCatGrow (&CleanOriginal, NULL, CmdLine, 0);
+  CleanOriginal = ConsoleArenaAllocateCopy (StrSize (CmdLine), CmdLine);
   if (CleanOriginal == NULL) {
     return (EFI_OUT_OF_RESOURCES);
   }
@@ -733,16 +1148,49 @@ RunShellCommand (
   // Handle case that passed in command line is just 1 or more " " characters.
   //
   if (StrLen (CleanOriginal) == 0) {
-    SHELL_FREE_NON_NULL (CleanOriginal);
+    ConsoleArenaFree (CleanOriginal);
+    ConsoleArenaReset (ArenaMark);
     return (EFI_SUCCESS);
   }
 
+  //
+  // 'time' runs the rest of the line, pipeline included, and reports how
+  // long it took
+  //
+  if (StrnCmp (CleanOriginal, L"time", 4) == 0 &&
+      (CleanOriginal[4] == CHAR_NULL || CleanOriginal[4] == L' ' || CleanOriginal[4] == L'\t')) {
+    TempWalker = CleanOriginal + 4;
+    TrimSpaces (&TempWalker);
+    if (*TempWalker == CHAR_NULL) {
+      Print (L"time: Too few arguments\n");
+    } else {
+      StartTicks = GetPerformanceCounter ();
+      Status     = RunShellCommand (TempWalker, CommandStatus);
+      ElapsedNs  = ConsoleGetElapsedTime (StartTicks);
+      Print (L"time: %Lu.%03u ms\n", DivU64x32 (ElapsedNs, 1000000), (UINT32) ModU64x32 (DivU64x32 (ElapsedNs, 1000), 1000));
+    }
+    ConsoleArenaFree (CleanOriginal);
+    ConsoleArenaReset (ArenaMark);
+    return (Status);
+  }
+
+  //
+  // A pipeline runs each of its commands back through here
+  //
+  if (*FindFirstCharacter (CleanOriginal, L"|", L'^') != CHAR_NULL) {
+    Status = ConsoleRunPipeline (CleanOriginal, CommandStatus);
+    ConsoleArenaFree (CleanOriginal);
+    ConsoleArenaReset (ArenaMark);
+    return (Status);
+  }
+
   //
   // We need the first parameter information so we can determine the operation type
   //
-  FirstParameter = AllocateZeroPool (StrSize (CleanOriginal));
+  FirstParameter = ConsoleArenaAllocateZero (StrSize (CleanOriginal));
   if (FirstParameter == NULL) {
-    SHELL_FREE_NON_NULL (CleanOriginal);
+    ConsoleArenaFree (CleanOriginal);
+    ConsoleArenaReset (ArenaMark);
     return (EFI_OUT_OF_RESOURCES);
   }
 
@@ -751,8 +1199,9 @@ RunShellCommand (
     Status = RunInternalCommand (CleanOriginal, FirstParameter, NewShellParametersProtocol, CommandStatus);
   }
 
-  SHELL_FREE_NON_NULL (CleanOriginal);
-  SHELL_FREE_NON_NULL (FirstParameter);
+  ConsoleArenaFree (CleanOriginal);
+  ConsoleArenaFree (FirstParameter);
+  ConsoleArenaReset (ArenaMark);
 
   return (Status);
 }
@@ -776,29 +1225,41 @@ RunCommand (
   return (RunShellCommand (CmdLine, NULL));
 }
 
+/**
+  Print the prompt and start reading a command line.
+
+  @retval EFI_SUCCESS           The line editor waits for keys.
+  @retval EFI_OUT_OF_RESOURCES  There is no memory for the command line.
+**/
+STATIC
 EFI_STATUS
-EFIAPI
-DoConsolePrompt (
+ConsolePromptStart (
   VOID
   )
 {
   UINTN         Column;
   UINTN         Row;
-  CHAR16        *CmdLine;
   CHAR16        *CurDir;
   UINTN         BufferSize;
-  EFI_STATUS    Status;
 
   CurDir  = L"Console:/ # ";
 
   //
-  // Get screen setting to decide size of the command line buffer
+  // Get screen setting to decide size of the command line buffer.  The
+  // buffer is reused at every prompt and only grows with the screen.
   //
   gST->ConOut->QueryMode (gST->ConOut, gST->ConOut->Mode->Mode, &Column, &Row);
-  BufferSize  = Column * Row * sizeof (CHAR16);
-  CmdLine     = AllocateZeroPool (BufferSize);
-  if (CmdLine == NULL) {
-    return EFI_OUT_OF_RESOURCES;
+  BufferSize = Column * Row * sizeof (CHAR16);
+  if (BufferSize > mSession.CmdLineSize) {
+    if (mSession.CmdLine != NULL) {
+      FreePool (mSession.CmdLine);
+    }
+    mSession.CmdLineSize = 0;
+    mSession.CmdLine     = AllocatePool (BufferSize);
+    if (mSession.CmdLine == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    mSession.CmdLineSize = BufferSize;
   }
 
   //
@@ -810,29 +1271,298 @@ DoConsolePrompt (
     gST->ConOut->OutputString (gST->ConOut, CurDir);
   }
 
-  //
-  // Read a line from the console
-  //
-  Status = UefiConsoleInRead (&BufferSize, CmdLine);
+  return LineEditorStart (&mSession.Editor, mSession.CmdLine, BufferSize);
+}
 
-  //
-  // Null terminate the string and parse it
-  //
-  if (!EFI_ERROR (Status)) {
-    CmdLine[BufferSize / sizeof (CHAR16)] = CHAR_NULL;
+/**
+  Update the checksum of the system table after ConIn or ConOut has been
+  replaced.
+**/
+VOID
+ConsoleUpdateSystemTableCrc (
+  VOID
+  )
+{
+  gST->Hdr.CRC32 = 0;
+  gBS->CalculateCrc32 ((UINT8 *) &gST->Hdr, gST->Hdr.HeaderSize, &gST->Hdr.CRC32);
+}
 
-    Status = RunCommand (CmdLine);
+/**
+  Exchange the console of the session with the one of the system table.
+  Called in pairs around the work of a tick, so that a session on its own
+  console does not take over the system console between ticks.
+**/
+STATIC
+VOID
+ConsoleSessionSwapConsole (
+  VOID
+  )
+{
+  EFI_SIMPLE_TEXT_INPUT_PROTOCOL   *ConIn;
+  EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *ConOut;
+
+  if (mSession.ConIn == NULL) {
+    return;
+  }
+
+  ConIn           = gST->ConIn;
+  ConOut          = gST->ConOut;
+  gST->ConIn      = mSession.ConIn;
+  gST->ConOut     = mSession.ConOut;
+  mSession.ConIn  = ConIn;
+  mSession.ConOut = ConOut;
+  ConsoleUpdateSystemTableCrc ();
+}
+
+/**
+  Check, without waiting, whether ESC has been pressed on the console input
+  of a running command.  Keys typed ahead of ESC are kept, in order, for the
+  line editor.
+
+  @retval TRUE    ESC was pressed; it has been consumed.
+  @retval FALSE   No ESC is waiting.
+**/
+BOOLEAN
+ConsoleCheckEscape (
+  VOID
+  )
+{
+  EFI_INPUT_KEY  Key;
+
+  while (mTypeAhead.Count < CONSOLE_TYPEAHEAD_KEYS &&
+         gBS->CheckEvent (gST->ConIn->WaitForKey) == EFI_SUCCESS) {
+    if (EFI_ERROR (gST->ConIn->ReadKeyStroke (gST->ConIn, &Key))) {
+      break;
+    }
+    if (Key.ScanCode == SCAN_ESC) {
+      return TRUE;
+    }
+    mTypeAhead.Keys[(mTypeAhead.Head + mTypeAhead.Count) % CONSOLE_TYPEAHEAD_KEYS] = Key;
+    mTypeAhead.Count++;
+  }
+
+  return FALSE;
+}
+
+/**
+  Read the next key for the line editor: a key typed ahead while a command
+  ran, or the next key of the console input.
+
+  @param[out] Key   The key.
+
+  @retval EFI_SUCCESS     A key was read.
+  @retval EFI_NOT_READY   No key is waiting.
+  @retval other           The console input failed.
+**/
+STATIC
+EFI_STATUS
+ConsoleReadKey (
+  OUT EFI_INPUT_KEY  *Key
+  )
+{
+  if (mTypeAhead.Count != 0) {
+    *Key            = mTypeAhead.Keys[mTypeAhead.Head];
+    mTypeAhead.Head = (mTypeAhead.Head + 1) % CONSOLE_TYPEAHEAD_KEYS;
+    mTypeAhead.Count--;
+    return EFI_SUCCESS;
   }
 
+  return gST->ConIn->ReadKeyStroke (gST->ConIn, Key);
+}
+
+/**
+  End the session after 'exit'.
+**/
+STATIC
+VOID
+ConsoleSessionEnd (
+  VOID
+  )
+{
+  gBS->SetTimer (mSessionEvent, TimerCancel, 0);
+  mSession.State = ConsoleSessionIdle;
+  mSessionStats.Sessions++;
+
   //
-  // Done with this command
+  // Ignore future Console requests for some period.
   //
-  FreePool (CmdLine);
-  return Status;
+  gBS->SetTimer (mTimerEvent, TimerRelative, CONSOLE_REQUEST_DELAY);
+
+  gST->ConOut->OutputString (gST->ConOut, L"Console mode exited.\n");
+  gST->ConOut->SetCursorPosition (gST->ConOut, 0, gST->ConOut->Mode->CursorRow);
+}
+
+/**
+  Timer notification that advances the session: the screen is prepared,
+  the prompt printed, and pending keys are fed to the line editor, at most
+  CONSOLE_SESSION_KEYS_PER_TICK of them.  A completed line is run before
+  returning.
+
+  The command runs synchronously in this notification, at TPL_CALLBACK, so
+  BDS and any other code below TPL_CALLBACK wait until it finishes.
+
+  @param[in] Event    The session timer.
+  @param[in] Context  Not used.
+**/
+STATIC
+VOID
+EFIAPI
+ConsoleSessionTick (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  UINT64          StartTicks;
+  UINTN           Keys;
+  EFI_INPUT_KEY   Key;
+  EFI_STATUS      Status;
+  BOOLEAN         Done;
+
+  if (mSession.State == ConsoleSessionIdle) {
+    return;
+  }
+
+  StartTicks = GetPerformanceCounter ();
+  ConsoleSessionSwapConsole ();
+
+  for (Keys = 0; Keys < CONSOLE_SESSION_KEYS_PER_TICK && mSession.State != ConsoleSessionIdle; ) {
+    if (mSession.State == ConsoleSessionWelcome) {
+      //
+      // The key notify does not consume the Ctrl-R that opened the session,
+      // which is also HISTORY_SEARCH_KEY; start from an empty input
+      //
+      gST->ConIn->Reset (gST->ConIn, FALSE);
+      ZeroMem (&mTypeAhead, sizeof (mTypeAhead));
+      gST->ConOut->ClearScreen (gST->ConOut);
+      gST->ConOut->OutputString (gST->ConOut, L"\nWelcome to UEFI Console\n\n");
+      mExitRequested = FALSE;
+      mSession.State = ConsoleSessionPrompt;
+    }
+
+    if (mSession.State == ConsoleSessionPrompt) {
+      if (EFI_ERROR (ConsolePromptStart ())) {
+        //
+        // Try again on the next tick
+        //
+        break;
+      }
+      mSession.State = ConsoleSessionReading;
+    }
+
+    Status = ConsoleReadKey (&Key);
+    if (Status == EFI_NOT_READY) {
+      break;
+    }
+    Keys++;
+
+    if (EFI_ERROR (Status)) {
+      LineEditorCancel (&mSession.Editor);
+      Done = TRUE;
+    } else {
+      Done = LineEditorProcessKey (&mSession.Editor, &Key);
+    }
+    if (!Done) {
+      continue;
+    }
+
+    //
+    // Null terminate the string and run it
+    //
+    mSession.CmdLine[mSession.Editor.StringLen] = CHAR_NULL;
+    RunCommand (mSession.CmdLine);
+
+    if (ConsoleCommandGetExit ()) {
+      ConsoleSessionEnd ();
+    } else {
+      mSession.State = ConsoleSessionPrompt;
+    }
+  }
+
+  ConsoleSessionSwapConsole ();
+  ConsoleRecordNotifyTime (StartTicks);
 }
 
 /**
-  Notification function for keystrokes.
+  Start a console session.  The session runs from a periodic timer at
+  TPL_CALLBACK until 'exit'; this returns at once.  Boot continues while
+  the session waits for keys, but is held while a command runs.
+
+  @param[in] ConIn    Console input of the session, or NULL to use the
+                      system console.
+  @param[in] ConOut   Console output of the session; NULL if ConIn is NULL.
+
+  @retval EFI_SUCCESS           The session was started.
+  @retval EFI_ALREADY_STARTED   A session is already running.
+  @retval EFI_NOT_READY         A session ended too recently.
+  @retval other                 The session timer could not be started.
+**/
+EFI_STATUS
+ConsoleStartSession (
+  IN EFI_SIMPLE_TEXT_INPUT_PROTOCOL   *ConIn  OPTIONAL,
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *ConOut OPTIONAL
+  )
+{
+  EFI_STATUS          Status;
+
+  if (mSession.State != ConsoleSessionIdle) {
+    return EFI_ALREADY_STARTED;
+  }
+
+  Status = gBS->CheckEvent (mTimerEvent);
+  if (Status == EFI_NOT_READY) {
+    DEBUG ((DEBUG_INFO, "Console request ignored\n"));
+    return EFI_NOT_READY;
+  }
+
+  Status = gBS->SetTimer (mSessionEvent, TimerPeriodic, CONSOLE_SESSION_TICK);
+  if (EFI_ERROR (Status)) {
+    gBS->SignalEvent (mTimerEvent);
+    return Status;
+  }
+
+  mSession.ConIn  = ConIn;
+  mSession.ConOut = ConOut;
+  mSession.State  = ConsoleSessionWelcome;
+  return EFI_SUCCESS;
+}
+
+/**
+  Check whether a console session is running.
+
+  @retval TRUE    A session is running.
+  @retval FALSE   No session is running.
+**/
+BOOLEAN
+ConsoleSessionActive (
+  VOID
+  )
+{
+  return (BOOLEAN) (mSession.State != ConsoleSessionIdle);
+}
+
+/**
+  Account the time of a console callback in mSessionStats.
+
+  @param[in] StartTicks   Performance counter value at callback entry.
+**/
+VOID
+ConsoleRecordNotifyTime (
+  IN UINT64  StartTicks
+  )
+{
+  UINT64  ElapsedNs;
+
+  ElapsedNs = ConsoleGetElapsedTime (StartTicks);
+  mSessionStats.Notifications++;
+  mSessionStats.TotalNs += ElapsedNs;
+  if (ElapsedNs > mSessionStats.MaxNs) {
+    mSessionStats.MaxNs = ElapsedNs;
+  }
+}
+
+/**
+  Notification function for keystrokes.  The session it starts runs from
+  its own timer, so the notification returns at once.
 
   @param[in] KeyData    The key that was pressed.
 
@@ -845,41 +1575,19 @@ NotificationFunction (
   IN EFI_KEY_DATA *KeyData
   )
 {
-  EFI_STATUS          Status;
+  UINT64              StartTicks;
+
+  StartTicks = GetPerformanceCounter ();
 
   if (((KeyData->Key.UnicodeChar == CONSOLE_KEY) &&
        (KeyData->KeyState.KeyShiftState == (EFI_SHIFT_STATE_VALID | EFI_LEFT_CONTROL_PRESSED) ||
         KeyData->KeyState.KeyShiftState  == (EFI_SHIFT_STATE_VALID | EFI_RIGHT_CONTROL_PRESSED))) ||
       (KeyData->Key.UnicodeChar == CONSOLE_KEY - L'a' + 1)) {
 
-    Status = gBS->CheckEvent (mTimerEvent);
-    if (Status == EFI_NOT_READY) {
-      DEBUG ((DEBUG_INFO, "Console request ignored\n"));
-      return EFI_SUCCESS;
-    }
-
-    gST->ConOut->ClearScreen (gST->ConOut);
-    gST->ConOut->OutputString (gST->ConOut, L"\nWelcome to UEFI Console\n\n");
-
-    mExitRequested = FALSE;
-
-    do {
-      //
-      // Display Prompt
-      //
-      Status = DoConsolePrompt ();
-
-    } while (!ConsoleCommandGetExit ());
-
-    //
-    // Ignore future Console requests for some period.
-    //
-    Status = gBS->SetTimer (mTimerEvent, TimerRelative, CONSOLE_REQUEST_DELAY);
-
-    gST->ConOut->OutputString (gST->ConOut, L"Console mode exited.\n");
-    gST->ConOut->SetCursorPosition (gST->ConOut, 0, gST->ConOut->Mode->CursorRow);
+    ConsoleStartSession (NULL, NULL);
   }
 
+  ConsoleRecordNotifyTime (StartTicks);
   return EFI_SUCCESS;
 }
 
@@ -980,6 +1688,19 @@ UefiConsoleStartMonitor (
     }
   }
 
+  if (!EFI_ERROR (Status)) {
+    //
+    // Create the timer the sessions run from
+    //
+    Status = gBS->CreateEvent (
+                    EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                    TPL_CALLBACK,
+                    ConsoleSessionTick,
+                    NULL,
+                    &mSessionEvent
+                    );
+  }
+
   return Status;
 }
 
@@ -1014,6 +1735,17 @@ UefiConsoleStopMonitor (
     Status = SimpleEx->UnregisterKeyNotify (SimpleEx, NotifyHandle3);
   }
 
+  if (mSessionEvent != NULL) {
+    gBS->SetTimer (mSessionEvent, TimerCancel, 0);
+    gBS->CloseEvent (mSessionEvent);
+  }
+  if (mSession.CmdLine != NULL) {
+    FreePool (mSession.CmdLine);
+    mSession.CmdLine     = NULL;
+    mSession.CmdLineSize = 0;
+  }
+  mSession.State = ConsoleSessionIdle;
+
   if (mTimerEvent != NULL) {
     gBS->SetTimer (mTimerEvent, TimerCancel, 0);
     gBS->CloseEvent (mTimerEvent);
@@ -1043,9 +1775,17 @@ UefiConsoleEntry (
 
   ConsoleCommandsConstructor (ImageHandle, SystemTable);
 
+  Status = ConsoleArenaInit ();
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "Console scratch arena unavailable, using pool\n"));
+  }
+
   ZeroMem (&ViewingSettings, sizeof (SHELL_VIEWING_SETTINGS));
   ViewingSettings.InsertMode = FALSE;
-  InitializeListHead (&ViewingSettings.CommandHistory.Link);
+  Status = InitCommandHistory ();
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "Console command history disabled\n"));
+  }
 
   //
   // Allocate the new structure
@@ -1061,6 +1801,11 @@ UefiConsoleEntry (
     return Status;
   }
 
+  Status = ConsoleSerialStartMonitor ();
+  if (EFI_ERROR (Status) && Status != EFI_UNSUPPORTED) {
+    DEBUG ((DEBUG_WARN, "Console serial transport unavailable: %r\n", Status));
+  }
+
   return EFI_SUCCESS;
 }
 
@@ -1085,12 +1830,17 @@ UefiConsoleUnload (
     FreePool (NewShellParametersProtocol);
   }
 
+  ConsoleSerialStopMonitor ();
+
   Status = UefiConsoleStopMonitor ();
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "Console monitor stop failed."));
     return Status;
   }
 
+  FreeCommandHistory ();
+  ConsoleArenaDestroy ();
+
   Status = ConsoleCommandsDestructor ();
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "Console command free failed."));
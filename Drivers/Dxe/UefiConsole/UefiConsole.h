@@ -26,10 +26,21 @@
 #include <Library/MemoryAllocationLib.h>
 #include <Library/PrintLib.h>
 #include <Library/SortLib.h>
+#include <Library/PcdLib.h>
+#include <Library/TimerLib.h>
+#include <Library/DxeServicesLib.h>
+#include <Library/DevicePathLib.h>
+#include <Library/HexDumpLib.h>
 #include <Protocol/UnicodeCollation.h>
+#include <Protocol/PciRootBridgeIo.h>
+#include <Protocol/SimpleFileSystem.h>
+#include <Protocol/SerialIo.h>
 #include <Guid/GlobalVariable.h>
+#include "ConsoleArena.h"
 #include "ConsoleParameters.h"
 #include "ConsoleCommand.h"
+#include "ConsoleScript.h"
+#include "ConsoleSerial.h"
 
 /**
   Return the pointer to the first occurrence of any character from a list of characters.
@@ -58,6 +69,98 @@ TrimSpaces (
   IN CHAR16 **String
   );
 
+/**
+  Function will process and run a command line.
+
+  This will determine if the command line represents an internal shell
+  command or dispatch an external application.
+
+  @param[in] CmdLine      The command line to parse.
+  @param[out] CommandStatus   The status from the command line.
+
+  @retval EFI_SUCCESS     The command was completed.
+  @retval EFI_ABORTED     The command's operation was aborted.
+**/
+EFI_STATUS
+RunShellCommand (
+  IN CONST CHAR16   *CmdLine,
+  OUT EFI_STATUS    *CommandStatus
+  );
+
+//
+// Time the console has held up boot, for 'stats'.
+//
+typedef struct {
+  UINT64    Notifications;      ///< Key notifications and session ticks handled.
+  UINT64    Sessions;           ///< Sessions run to 'exit'.
+  UINT64    TotalNs;            ///< Total time spent in them.
+  UINT64    MaxNs;              ///< Longest of them.
+} CONSOLE_SESSION_STATS;
+
+extern CONSOLE_SESSION_STATS  mSessionStats;
+
+/**
+  Account the time of a console callback in mSessionStats.
+
+  @param[in] StartTicks   Performance counter value at callback entry.
+**/
+VOID
+ConsoleRecordNotifyTime (
+  IN UINT64  StartTicks
+  );
+
+/**
+  Update the checksum of the system table after ConIn or ConOut has been
+  replaced.
+**/
+VOID
+ConsoleUpdateSystemTableCrc (
+  VOID
+  );
+
+/**
+  Start a console session.  The session runs from a periodic timer at
+  TPL_CALLBACK until 'exit'; this returns at once.
+
+  @param[in] ConIn    Console input of the session, or NULL to use the
+                      system console.
+  @param[in] ConOut   Console output of the session; NULL if ConIn is NULL.
+
+  @retval EFI_SUCCESS           The session was started.
+  @retval EFI_ALREADY_STARTED   A session is already running.
+  @retval EFI_NOT_READY         A session ended too recently.
+  @retval other                 The session timer could not be started.
+**/
+EFI_STATUS
+ConsoleStartSession (
+  IN EFI_SIMPLE_TEXT_INPUT_PROTOCOL   *ConIn  OPTIONAL,
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *ConOut OPTIONAL
+  );
+
+/**
+  Check, without waiting, whether ESC has been pressed on the console input
+  of a running command.  Keys typed ahead of ESC are kept, in order, for the
+  line editor.
+
+  @retval TRUE    ESC was pressed; it has been consumed.
+  @retval FALSE   No ESC is waiting.
+**/
+BOOLEAN
+ConsoleCheckEscape (
+  VOID
+  );
+
+/**
+  Check whether a console session is running.
+
+  @retval TRUE    A session is running.
+  @retval FALSE   No session is running.
+**/
+BOOLEAN
+ConsoleSessionActive (
+  VOID
+  );
+
 /**
   The entry point for UEFI console feature.
 
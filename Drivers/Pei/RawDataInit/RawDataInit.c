@@ -19,6 +19,7 @@
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
+#include <Library/HexDumpLib.h>
 #include <Library/HobLib.h>
 #include <Library/UefiLib.h>
 #include <Library/MemoryAllocationLib.h>
@@ -42,58 +43,6 @@ STATIC EFI_PEI_NOTIFY_DESCRIPTOR mRawDataNotifyDesc = {
 };
 
 
-STATIC CONST CHAR8 Hex[] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
-
-/**
-  Dump some hexadecimal data to the screen.
-
-  @param[in] Indent     How many spaces to indent the output.
-  @param[in] Offset     The offset of the printing.
-  @param[in] DataSize   The size in bytes of UserData.
-  @param[in] UserData   The data to print out.
-
-**/
-VOID
-EFIAPI
-DumpHex (
-  IN UINTN        Indent,
-  IN UINTN        Offset,
-  IN UINTN        DataSize,
-  IN VOID         *UserData
-  )
-{
-  UINT8           *Data;
-  CHAR8           Val[50];
-  CHAR8           Str[20];
-  UINT8           TempByte;
-  UINTN           Size;
-  UINTN           Index;
-
-  Data = UserData;
-  while (DataSize != 0) {
-    Size = 16;
-    if (Size > DataSize) {
-      Size = DataSize;
-    }
-
-    for (Index = 0; Index < Size; Index += 1) {
-      TempByte            = Data[Index];
-      Val[Index * 3 + 0]  = Hex[TempByte >> 4];
-      Val[Index * 3 + 1]  = Hex[TempByte & 0xF];
-      Val[Index * 3 + 2]  = (CHAR8) ((Index == 7) ? '-' : ' ');
-      Str[Index]          = (CHAR8) ((TempByte < ' ' || TempByte > '~') ? '.' : TempByte);
-    }
-
-    Val[Index * 3]  = 0;
-    Str[Index]      = 0;
-    DEBUG ((DEBUG_ERROR,"%*a%08X: %-48a *%a*\r\n", Indent, "", Offset, Val, Str));
-
-    Data += Size;
-    Offset += Size;
-    DataSize -= Size;
-  }
-}
-
 UINTN
 EFIAPI
 GetSectionSize (
@@ -192,7 +141,7 @@ RawDataInitAtEndOfPei (
   } else {
     DEBUG ((DEBUG_INFO, "RAW data size: 0x%x\n", RawSize));
 
-    DumpHex (2, 0, 0x100, Buffer);
+    HexDump (2, 0, 0x100, Buffer);
   }
 
   return Status;
@@ -22,11 +22,53 @@
   types "exit".  All I/O is performed through SerialPortLib primitives
   so the function is safe to call before permanent memory exists.
 
-  Supported built-in commands:
-    readmsr  <index>         - Read a 64-bit MSR (hexadecimal index)
-    writemsr <index> <value> - Write a 64-bit MSR (hexadecimal index and value)
-    help                     - Print the command list
-    exit                     - Return to the caller
+  Supported built-in commands (all numbers hexadecimal, W = 1, 2, 4 or 8):
+    readmsr  [-a | -p P] <index>          - Read a 64-bit MSR
+    writemsr [-a | -p P] [-r] <index> <value>
+                                          - Write a 64-bit MSR, -r to read it back
+    dump     [-w W] <addr> <len>          - Hex dump system memory
+    mmio     [-w W] [-n N] <addr> [value] - Read N MMIO registers, or fill them with value
+    io       [-w W] [-n N] <port> [value] - Read N I/O ports, or fill them with value
+    pci      [-w W] [-n N] <bus> <dev> <func> <reg> [value]
+                                          - Read N PCI config registers, or fill them with value
+    bindump  [-w W] <addr> <len>          - Send a memory range as binary frames
+    script   <addr> <len>                 - Run the command script stored in memory
+    repeat   <N> <command>                - Run command N times
+    watch    <ms> <command>               - Run command every ms milliseconds, with a
+                                            timestamp, until ESC or Ctrl-C
+    help                                  - Print the command list
+    exit                                  - Return to the caller
+
+  The MSR commands run on the BSP by default, on processor P with -p, or on
+  all processors with -a.  With -a the APs are started concurrently and one
+  line per processor is printed, followed by a consistency summary.  The
+  PEI and DXE library instances reach the APs through the MP services of
+  that phase; the BASE instance supports the BSP only.
+
+  "repeat" and "watch" combine, so "repeat N watch ms command" takes N
+  timestamped samples scheduled against the start time.
+
+  "bindump" emits frames made of a 12-byte header (signature "DSBF",
+  sequence number, payload length), up to 1KB of payload and a CRC32 of the
+  payload, all little-endian.  A frame with a zero payload length ends the
+  transfer.  When -w is given the payload is read with MMIO accesses of that
+  width; otherwise the range is copied as ordinary memory.
+
+  A line of the form ":<seq> <command>" is a machine request from a host
+  tool (see Tools/Python/DebugShell).  It is not echoed and no prompt is
+  printed after it.  The response is framed as
+    {<seq>
+    <body lines>
+    }<seq> <status>
+  where seq is 8 hex digits and status is 16 hex digits: the RETURN_STATUS
+  of the command with its error bit moved to bit 63, so that an error such
+  as 8000000000000001 can be told from a warning such as 0000000000000001.
+  Body lines of the form key=value carry the results (for example
+  cpu.0000=..., data.<addr>=..., time=...); any other body line is a
+  message.  In a machine request "bindump" prints a frame=<payload size>
+  line and sends its binary frames right after it, before the end line.
+  Frame N holds the bytes at offset N * payload size, so a host can request
+  the range of a frame with a bad CRC32 again.
 
   @param[in]  Prompt  Optional NUL-terminated ASCII string used as the
                       command prompt.  Pass NULL to use the default "> ".
@@ -37,4 +79,41 @@ RunDebugShell (
   IN CONST CHAR8  *Prompt  OPTIONAL
   );
 
+/**
+  Run a debug shell command script without user interaction.
+
+  The script holds one command per line, terminated by LF or CR LF.  Empty
+  lines and lines starting with '#' are ignored, and each executed line is
+  echoed to the serial port before its output.  Execution stops at the end
+  of the script, at a NUL byte or at an "exit" command.
+
+  @param[in]  Script      Script text; need not be NUL-terminated.
+  @param[in]  ScriptSize  Size of Script in bytes.
+
+  @retval TRUE   The script executed "exit".
+  @retval FALSE  The end of the script was reached.
+**/
+BOOLEAN
+EFIAPI
+RunDebugShellScript (
+  IN CONST CHAR8  *Script,
+  IN UINTN        ScriptSize
+  );
+
+/**
+  Run the debug shell command script stored in the first EFI_SECTION_RAW
+  section of an FFS file, as RunDebugShellScript() does.
+
+  @param[in]  FileName  Name of the FFS file holding the script.
+
+  @retval RETURN_SUCCESS      The script has been run.
+  @retval RETURN_NOT_FOUND    The file or its raw section was not found.
+  @retval RETURN_UNSUPPORTED  The library instance cannot read firmware volumes.
+**/
+RETURN_STATUS
+EFIAPI
+RunDebugShellScriptFromFv (
+  IN CONST GUID  *FileName
+  );
+
 #endif  // DEBUG_SHELL_LIB_H_
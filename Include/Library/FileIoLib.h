@@ -0,0 +1,326 @@
+/** @file
+  File I/O library public API.
+  Streams files through the Shell in fixed size chunks, so that tools moving
+  large images between files, disks and memory need chunk sized buffers
+  instead of file sized ones.
+
+  A reader hands out the file one chunk at a time.  With FILE_IO_DOUBLE_BUFFER
+  the next chunk is read asynchronously (EFI_FILE_PROTOCOL.ReadEx) while the
+  caller works on the current one; a writer likewise writes a full chunk while
+  the caller fills the other.  File systems without ReadEx/WriteEx are used
+  synchronously.
+
+  A writer opens the file in place and truncates it instead of deleting and
+  recreating it.  With FILE_IO_PREALLOCATE the file is first set to its
+  expected size through SetInfo so the file system allocates it in one go;
+  note that FAT zero-fills a file grown this way.  Closing a writer trims the
+  file to the bytes written.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#ifndef _FILE_IO_LIB_H_
+#define _FILE_IO_LIB_H_
+
+//
+// Chunk size used when 0 is passed to FileIoOpenReader or FileIoOpenWriter.
+//
+#define FILE_IO_DEFAULT_CHUNK_SIZE     SIZE_1MB
+
+//
+// Stream options.
+//
+#define FILE_IO_DOUBLE_BUFFER          BIT0   // Overlap file I/O with the caller's work
+#define FILE_IO_PREALLOCATE            BIT1   // Writer only: set the expected size up front
+
+typedef struct _FILE_IO_STREAM  FILE_IO_STREAM;
+
+/**
+  Open a file for reading in chunks.
+
+  @param[in]  FileName      The file to read, as the Shell resolves it.
+  @param[in]  ChunkSize     Bytes read at a time; 0 for FILE_IO_DEFAULT_CHUNK_SIZE.
+  @param[in]  Options       FILE_IO_DOUBLE_BUFFER or 0.
+  @param[out] Stream        The new stream.
+
+  @retval EFI_SUCCESS           The file is open and its first chunk is read.
+  @retval EFI_OUT_OF_RESOURCES  No enough buffer to allocate.
+  @retval Others                The file could not be opened or read.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoOpenReader (
+  IN  CONST CHAR16      *FileName,
+  IN  UINTN             ChunkSize,
+  IN  UINT32            Options,
+  OUT FILE_IO_STREAM    **Stream
+  );
+
+/**
+  Create or truncate a file for writing in chunks.
+
+  @param[in]  FileName      The file to write, as the Shell resolves it.
+  @param[in]  ExpectedSize  The size the file is expected to have, used by
+                            FILE_IO_PREALLOCATE; 0 if unknown.
+  @param[in]  ChunkSize     Bytes written at a time; 0 for FILE_IO_DEFAULT_CHUNK_SIZE.
+  @param[in]  Options       FILE_IO_DOUBLE_BUFFER and FILE_IO_PREALLOCATE, or 0.
+  @param[out] Stream        The new stream.
+
+  @retval EFI_SUCCESS           The file is open and empty, or preallocated.
+  @retval EFI_OUT_OF_RESOURCES  No enough buffer to allocate.
+  @retval Others                The file could not be created.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoOpenWriter (
+  IN  CONST CHAR16      *FileName,
+  IN  UINT64            ExpectedSize,
+  IN  UINTN             ChunkSize,
+  IN  UINT32            Options,
+  OUT FILE_IO_STREAM    **Stream
+  );
+
+/**
+  Get the size of a reader's file, or the bytes written so far to a writer.
+
+  @param[in]  Stream        The stream.
+
+  @return The size in bytes.
+
+**/
+UINT64
+EFIAPI
+FileIoGetSize (
+  IN FILE_IO_STREAM     *Stream
+  );
+
+/**
+  Get the next chunk of a reader without copying it.  The chunk stays valid
+  until the next call on the stream.
+
+  @param[in]  Stream        The reader.
+  @param[out] Data          The chunk.
+  @param[out] Length        Bytes in the chunk; 0 at the end of the file.
+
+  @retval EFI_SUCCESS       Data and Length are valid.
+  @retval Others            The file could not be read.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoReadChunk (
+  IN  FILE_IO_STREAM    *Stream,
+  OUT VOID              **Data,
+  OUT UINTN             *Length
+  );
+
+/**
+  Get up to MaxLength bytes of a reader's next chunk without copying them.
+  The bytes stay valid until the next call on the stream.
+
+  @param[in]  Stream        The reader.
+  @param[in]  MaxLength     The most bytes wanted.
+  @param[out] Data          The bytes.
+  @param[out] Length        Bytes returned; 0 at the end of the file.
+
+  @retval EFI_SUCCESS       Data and Length are valid.
+  @retval Others            The file could not be read.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoReadChunkEx (
+  IN  FILE_IO_STREAM    *Stream,
+  IN  UINTN             MaxLength,
+  OUT VOID              **Data,
+  OUT UINTN             *Length
+  );
+
+/**
+  Copy the next bytes of a reader.
+
+  @param[in]      Stream    The reader.
+  @param[in, out] Size      On input, the bytes wanted.  On output, the bytes
+                            copied, fewer only at the end of the file.
+  @param[out]     Buffer    Receives the bytes.
+
+  @retval EFI_SUCCESS       Size bytes were copied.
+  @retval Others            The file could not be read.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoRead (
+  IN     FILE_IO_STREAM  *Stream,
+  IN OUT UINTN           *Size,
+  OUT    VOID            *Buffer
+  );
+
+/**
+  Copy the next bytes of a reader without consuming them.  Only the bytes
+  already in the current chunk can be peeked at.
+
+  @param[in]      Stream    The reader.
+  @param[in, out] Size      On input, the bytes wanted.  On output, the bytes
+                            copied, fewer at the end of the file or of the
+                            current chunk.
+  @param[out]     Buffer    Receives the bytes.
+
+  @retval EFI_SUCCESS       Size bytes were copied.
+  @retval Others            The file could not be read.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoPeek (
+  IN     FILE_IO_STREAM  *Stream,
+  IN OUT UINTN           *Size,
+  OUT    VOID            *Buffer
+  );
+
+/**
+  Read the next line of a text reader.  The line ends at LF, CR LF or the end
+  of the file; the line break is not returned.
+
+  @param[in]      Stream    The reader.
+  @param[out]     Line      Receives the line, NUL terminated.
+  @param[in, out] LineSize  On input, the size of Line.  On output, the
+                            length of the line, or the size needed with
+                            EFI_BUFFER_TOO_SMALL.
+
+  @retval EFI_SUCCESS           The line was read.
+  @retval EFI_END_OF_FILE       There are no more lines.
+  @retval EFI_BUFFER_TOO_SMALL  The line does not fit; it is skipped.
+  @retval Others                The file could not be read.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoReadLine (
+  IN     FILE_IO_STREAM  *Stream,
+  OUT    CHAR8           *Line,
+  IN OUT UINTN           *LineSize
+  );
+
+/**
+  Get the free part of a writer's current chunk, to fill in place.  Commit
+  the bytes filled with FileIoCommitWrite.
+
+  @param[in]  Stream        The writer.
+  @param[out] Buffer        The free space.
+  @param[out] Size          Bytes of free space, at least 1.
+
+  @retval EFI_SUCCESS       Buffer and Size are valid.
+  @retval Others            An earlier chunk could not be written.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoGetWriteBuffer (
+  IN  FILE_IO_STREAM    *Stream,
+  OUT VOID              **Buffer,
+  OUT UINTN             *Size
+  );
+
+/**
+  Commit bytes filled in the buffer given by FileIoGetWriteBuffer.  A full
+  chunk is written to the file.
+
+  @param[in]  Stream        The writer.
+  @param[in]  Size          Bytes filled.
+
+  @retval EFI_SUCCESS       The bytes were committed.
+  @retval Others            The file could not be written.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoCommitWrite (
+  IN FILE_IO_STREAM     *Stream,
+  IN UINTN              Size
+  );
+
+/**
+  Copy bytes to a writer.
+
+  @param[in]  Stream        The writer.
+  @param[in]  Size          Bytes to write.
+  @param[in]  Buffer        The bytes.
+
+  @retval EFI_SUCCESS       The bytes were written or buffered.
+  @retval Others            The file could not be written.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoWrite (
+  IN FILE_IO_STREAM     *Stream,
+  IN UINTN              Size,
+  IN CONST VOID         *Buffer
+  );
+
+/**
+  Close a stream.  A writer writes what is buffered and trims the file to the
+  bytes written.
+
+  @param[in]  Stream        The stream.
+
+  @retval EFI_SUCCESS       Every chunk was transferred.
+  @retval Others            The first error of the stream.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoClose (
+  IN FILE_IO_STREAM     *Stream
+  );
+
+/**
+  Read a whole file into a new pool buffer.
+
+  @param[in]  FileName      The file to read.
+  @param[out] BufferSize    Bytes read.
+  @param[out] Buffer        The file contents; free with FreePool.
+
+  @retval EFI_SUCCESS           The file was read.
+  @retval EFI_OUT_OF_RESOURCES  No enough buffer to allocate.
+  @retval Others                The file could not be read.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoReadFile (
+  IN  CONST CHAR16      *FileName,
+  OUT UINTN             *BufferSize,
+  OUT VOID              **Buffer
+  );
+
+/**
+  Write a buffer to a file, replacing its contents.
+
+  @param[in]  FileName      The file to write.
+  @param[in]  BufferSize    Bytes to write.
+  @param[in]  Buffer        The bytes.
+
+  @retval EFI_SUCCESS       The file was written.
+  @retval Others            The file could not be written.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoWriteFile (
+  IN CONST CHAR16       *FileName,
+  IN UINTN              BufferSize,
+  IN CONST VOID         *Buffer
+  );
+
+#endif
@@ -0,0 +1,76 @@
+/** @file
+  Hex dump library public API.
+  Dumps memory as lines of an offset, the bytes in hexadecimal and the bytes
+  as ASCII:
+
+    00000000: 4D 5A 90 00 03 00 00 00-04 00 00 00 FF FF 00 00  *MZ..............*
+
+  Lines are formatted many at a time into one buffer and handed to the output
+  in a few large writes, instead of one formatted print per line.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#ifndef _HEX_DUMP_LIB_H_
+#define _HEX_DUMP_LIB_H_
+
+//
+// Layout used by HexDump, and by HexDumpEx for a Width or Group of 0.
+//
+#define HEX_DUMP_DEFAULT_WIDTH         16    // Bytes per line
+#define HEX_DUMP_DEFAULT_GROUP         8     // Bytes between '-' separators
+
+#define HEX_DUMP_MAX_WIDTH             64
+#define HEX_DUMP_MAX_INDENT            32
+
+/**
+  Dump some hexadecimal data, 16 bytes per line in two groups of 8.
+
+  @param[in] Indent     How many spaces to indent the output.
+  @param[in] Offset     The offset of the printing.
+  @param[in] DataSize   The size in bytes of UserData.
+  @param[in] UserData   The data to print out.
+
+**/
+VOID
+EFIAPI
+HexDump (
+  IN UINTN        Indent,
+  IN UINTN        Offset,
+  IN UINTN        DataSize,
+  IN CONST VOID   *UserData
+  );
+
+/**
+  Dump some hexadecimal data with a given line width and grouping.
+
+  @param[in] Indent     How many spaces to indent the output, at most
+                        HEX_DUMP_MAX_INDENT.
+  @param[in] Offset     The offset of the printing.
+  @param[in] DataSize   The size in bytes of UserData.
+  @param[in] UserData   The data to print out.
+  @param[in] Width      Bytes per line, at most HEX_DUMP_MAX_WIDTH; 0 for
+                        HEX_DUMP_DEFAULT_WIDTH.
+  @param[in] Group      Bytes between '-' separators; 0 for
+                        HEX_DUMP_DEFAULT_GROUP, Width or more for none.
+
+**/
+VOID
+EFIAPI
+HexDumpEx (
+  IN UINTN        Indent,
+  IN UINTN        Offset,
+  IN UINTN        DataSize,
+  IN CONST VOID   *UserData,
+  IN UINTN        Width,
+  IN UINTN        Group
+  );
+
+#endif
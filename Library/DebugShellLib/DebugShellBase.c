@@ -0,0 +1,149 @@
+/** @file
+  Debug Shell boot phase services for the BASE library instance.
+
+  No MP services are used, so every command runs on the BSP only, and
+  firmware volumes cannot be searched.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include "DebugShellLibInternal.h"
+
+/**
+  Locate the multi-processor services of the current boot phase.
+
+  @param[out] Mp  Filled with the services and processor counts.
+
+  @retval EFI_SUCCESS  Mp describes the BSP only.
+**/
+EFI_STATUS
+ShellMpInitialize (
+  OUT SHELL_MP  *Mp
+  )
+{
+  Mp->Services           = NULL;
+  Mp->NumberOfProcessors = 1;
+  Mp->BspNumber          = 0;
+  return EFI_SUCCESS;
+}
+
+/**
+  Return the processor number of the caller.
+
+  @param[in]  Mp  Initialized by ShellMpInitialize().
+
+  @return Always 0, the BSP.
+**/
+UINTN
+ShellMpWhoAmI (
+  IN SHELL_MP  *Mp
+  )
+{
+  return 0;
+}
+
+/**
+  Run Procedure on all enabled APs concurrently and wait for completion.
+
+  @param[in]  Mp         Initialized by ShellMpInitialize().
+  @param[in]  Procedure  Function to run on each AP.
+  @param[in]  Argument   Parameter passed to Procedure.
+
+  @retval EFI_NOT_STARTED  There is no AP.
+**/
+EFI_STATUS
+ShellMpStartupAllAPs (
+  IN SHELL_MP          *Mp,
+  IN EFI_AP_PROCEDURE  Procedure,
+  IN VOID              *Argument
+  )
+{
+  return EFI_NOT_STARTED;
+}
+
+/**
+  Run Procedure on one AP and wait for completion.
+
+  @param[in]  Mp               Initialized by ShellMpInitialize().
+  @param[in]  Procedure        Function to run on the AP.
+  @param[in]  ProcessorNumber  Target processor.
+  @param[in]  Argument         Parameter passed to Procedure.
+
+  @retval EFI_UNSUPPORTED  There is no AP.
+**/
+EFI_STATUS
+ShellMpStartupThisAP (
+  IN SHELL_MP          *Mp,
+  IN EFI_AP_PROCEDURE  Procedure,
+  IN UINTN             ProcessorNumber,
+  IN VOID              *Argument
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  Allocate a zeroed buffer.
+
+  @param[in]  Size  Number of bytes to allocate.
+
+  @return NULL, no memory services are used by this instance.
+**/
+VOID *
+ShellAllocateZeroPool (
+  IN UINTN  Size
+  )
+{
+  return NULL;
+}
+
+/**
+  Free a buffer returned by ShellAllocateZeroPool().
+
+  @param[in]  Buffer  Buffer to free.
+**/
+VOID
+ShellFreePool (
+  IN VOID  *Buffer
+  )
+{
+}
+
+/**
+  Find the first EFI_SECTION_RAW section of an FFS file in any firmware
+  volume.
+
+  @param[in]  FileName  FFS file name.
+  @param[out] Data      Section data.
+  @param[out] Size      Section data size in bytes.
+
+  @retval RETURN_UNSUPPORTED  The BASE instance cannot read firmware volumes.
+**/
+RETURN_STATUS
+ShellFindRawSection (
+  IN  CONST GUID  *FileName,
+  OUT VOID        **Data,
+  OUT UINTN       *Size
+  )
+{
+  return RETURN_UNSUPPORTED;
+}
+
+/**
+  Release section data returned by ShellFindRawSection().
+
+  @param[in]  Data  Section data.
+**/
+VOID
+ShellFreeRawSection (
+  IN VOID  *Data
+  )
+{
+}
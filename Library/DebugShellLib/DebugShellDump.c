@@ -0,0 +1,719 @@
+/** @file
+  Debug Shell memory, MMIO, I/O port and PCI configuration access commands.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Library/BaseMemoryLib.h>
+#include "DebugShellLibInternal.h"
+
+//
+// Bytes shown per dump line, and the line buffer that holds
+// "<label>: " + 16 x " XX" + "  " + 16 ASCII characters + CRLF.
+//
+#define SHELL_DUMP_BYTES_PER_LINE  16
+#define SHELL_DUMP_LINE_SIZE       96
+
+//
+// Upper bound for -n so that Count * Width can never overflow.
+//
+#define SHELL_MAX_ACCESS_COUNT     0x10000000ULL
+
+typedef enum {
+  ShellSpaceMemory,
+  ShellSpaceMmio,
+  ShellSpaceIo,
+  ShellSpacePci
+} SHELL_ACCESS_SPACE;
+
+typedef struct {
+  UINTN     Width;      ///< Access width in bytes: 1, 2, 4 or 8.
+  BOOLEAN   WidthSet;   ///< TRUE if -w was given explicitly.
+  UINT64    Count;      ///< Number of Width sized elements.
+  UINTN     FirstArg;   ///< Index of the first positional argument in Argv.
+} SHELL_ACCESS_OPTIONS;
+
+/**
+  Parse the leading "-w <width>" and "-n <count>" options of an access command.
+
+  @param[in]  Argc      Argument count.
+  @param[in]  Argv      Argument array.
+  @param[in]  MaxWidth  Largest access width the address space supports.
+  @param[out] Options   Parsed options; Width and Count default to 1.
+
+  @retval TRUE   Options parsed; Options->FirstArg indexes the first positional argument.
+  @retval FALSE  An option was malformed; an error message has been printed.
+**/
+STATIC BOOLEAN
+ShellParseAccessOptions (
+  IN  UINTN                 Argc,
+  IN  CHAR8                 *Argv[],
+  IN  UINTN                 MaxWidth,
+  OUT SHELL_ACCESS_OPTIONS  *Options
+  )
+{
+  UINTN   Index;
+  UINT64  Value;
+
+  Options->Width    = 1;
+  Options->WidthSet = FALSE;
+  Options->Count    = 1;
+
+  for (Index = 1; (Index < Argc) && (Argv[Index][0] == '-'); Index += 2) {
+    if (Index + 1 >= Argc) {
+      ShellPrintArgError ("missing value for option", Argv[Index]);
+      return FALSE;
+    }
+
+    if (AsciiStrCmp (Argv[Index], "-w") == 0) {
+      if (!ShellParseHex64 (Argv[Index + 1], &Value) ||
+          ((Value != 1) && (Value != 2) && (Value != 4) && (Value != 8)) ||
+          (Value > MaxWidth)) {
+        ShellPrintArgError ("invalid width", Argv[Index + 1]);
+        return FALSE;
+      }
+
+      Options->Width    = (UINTN)Value;
+      Options->WidthSet = TRUE;
+    } else if (AsciiStrCmp (Argv[Index], "-n") == 0) {
+      if (!ShellParseHex64 (Argv[Index + 1], &Value) ||
+          (Value == 0) || (Value > SHELL_MAX_ACCESS_COUNT)) {
+        ShellPrintArgError ("invalid count", Argv[Index + 1]);
+        return FALSE;
+      }
+
+      Options->Count = Value;
+    } else {
+      ShellPrintArgError ("unknown option", Argv[Index]);
+      return FALSE;
+    }
+  }
+
+  Options->FirstArg = Index;
+  return TRUE;
+}
+
+/**
+  Check that an access of Count elements of Width bytes starting at Address
+  is naturally aligned and stays within the addressable range.
+
+  @param[in]  Address  Start address.
+  @param[in]  Width    Access width in bytes.
+  @param[in]  Count    Number of elements.
+  @param[in]  Limit    Highest address that may be touched.
+
+  @retval TRUE   The range is usable.
+  @retval FALSE  The range is misaligned or out of bounds.
+**/
+STATIC BOOLEAN
+ShellCheckRange (
+  IN UINT64  Address,
+  IN UINTN   Width,
+  IN UINT64  Count,
+  IN UINT64  Limit
+  )
+{
+  UINT64  Length;
+
+  if ((Address & (Width - 1)) != 0) {
+    ShellPrint ("Error: address is not aligned to the access width\r\n");
+    return FALSE;
+  }
+
+  Length = MultU64x32 (Count, (UINT32)Width);
+  if ((Address > Limit) || (Length - 1 > Limit - Address)) {
+    ShellPrint ("Error: range exceeds the address space\r\n");
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+  Read one element from the selected address space.
+
+  @param[in]  Space    Address space to access.
+  @param[in]  Address  Memory address, I/O port or PCI_LIB_ADDRESS.
+  @param[in]  Width    Access width in bytes.
+
+  @return The value read, zero-extended to 64 bits.
+**/
+STATIC UINT64
+ShellReadUnit (
+  IN SHELL_ACCESS_SPACE  Space,
+  IN UINT64              Address,
+  IN UINTN               Width
+  )
+{
+  UINTN  Addr;
+
+  Addr = (UINTN)Address;
+
+  switch (Space) {
+    case ShellSpaceMemory:
+      switch (Width) {
+        case 1:  return *(volatile UINT8 *)Addr;
+        case 2:  return ReadUnaligned16 ((UINT16 *)Addr);
+        case 4:  return ReadUnaligned32 ((UINT32 *)Addr);
+        default: return ReadUnaligned64 ((UINT64 *)Addr);
+      }
+
+    case ShellSpaceMmio:
+      switch (Width) {
+        case 1:  return MmioRead8 (Addr);
+        case 2:  return MmioRead16 (Addr);
+        case 4:  return MmioRead32 (Addr);
+        default: return MmioRead64 (Addr);
+      }
+
+    case ShellSpaceIo:
+      switch (Width) {
+        case 1:  return IoRead8 (Addr);
+        case 2:  return IoRead16 (Addr);
+        default: return IoRead32 (Addr);
+      }
+
+    default:
+      switch (Width) {
+        case 1:  return PciRead8 (Addr);
+        case 2:  return PciRead16 (Addr);
+        case 4:  return PciRead32 (Addr);
+        default: return PciRead32 (Addr) | LShiftU64 (PciRead32 (Addr + 4), 32);
+      }
+  }
+}
+
+/**
+  Write one element to the selected address space.
+
+  @param[in]  Space    Address space to access.
+  @param[in]  Address  Memory address, I/O port or PCI_LIB_ADDRESS.
+  @param[in]  Width    Access width in bytes.
+  @param[in]  Value    Value to write; truncated to Width bytes.
+**/
+STATIC VOID
+ShellWriteUnit (
+  IN SHELL_ACCESS_SPACE  Space,
+  IN UINT64              Address,
+  IN UINTN               Width,
+  IN UINT64              Value
+  )
+{
+  UINTN  Addr;
+
+  Addr = (UINTN)Address;
+
+  switch (Space) {
+    case ShellSpaceMmio:
+      switch (Width) {
+        case 1:  MmioWrite8 (Addr, (UINT8)Value);   break;
+        case 2:  MmioWrite16 (Addr, (UINT16)Value); break;
+        case 4:  MmioWrite32 (Addr, (UINT32)Value); break;
+        default: MmioWrite64 (Addr, Value);         break;
+      }
+      break;
+
+    case ShellSpaceIo:
+      switch (Width) {
+        case 1:  IoWrite8 (Addr, (UINT8)Value);   break;
+        case 2:  IoWrite16 (Addr, (UINT16)Value); break;
+        default: IoWrite32 (Addr, (UINT32)Value); break;
+      }
+      break;
+
+    case ShellSpacePci:
+      switch (Width) {
+        case 1:  PciWrite8 (Addr, (UINT8)Value);   break;
+        case 2:  PciWrite16 (Addr, (UINT16)Value); break;
+        case 4:  PciWrite32 (Addr, (UINT32)Value); break;
+        default:
+          PciWrite32 (Addr, (UINT32)Value);
+          PciWrite32 (Addr + 4, (UINT32)RShiftU64 (Value, 32));
+          break;
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+/**
+  Dump Count elements as hex text, SHELL_DUMP_BYTES_PER_LINE bytes per line.
+
+  Each line is formatted into a local buffer and sent with a single
+  SerialPortWrite() call.  Byte wide dumps get an ASCII column.  Machine
+  responses carry one "data.<label>=<values>" line per dump line instead.
+
+  @param[in]  Ctx          Shell context.
+  @param[in]  Space        Address space to access.
+  @param[in]  Address      First address to read.
+  @param[in]  Label        Value printed at the start of the first line.
+  @param[in]  LabelDigits  Number of hex digits used for the line label.
+  @param[in]  Width        Access width in bytes.
+  @param[in]  Count        Number of elements to dump.
+**/
+STATIC VOID
+ShellDumpRange (
+  IN SHELL_CONTEXT       *Ctx,
+  IN SHELL_ACCESS_SPACE  Space,
+  IN UINT64              Address,
+  IN UINT64              Label,
+  IN UINTN               LabelDigits,
+  IN UINTN               Width,
+  IN UINT64              Count
+  )
+{
+  CHAR8   Line[SHELL_DUMP_LINE_SIZE];
+  CHAR8   Ascii[SHELL_DUMP_BYTES_PER_LINE];
+  CHAR8   *Ptr;
+  UINTN   PerLine;
+  UINTN   Items;
+  UINTN   Index;
+  UINT64  Value;
+
+  PerLine = SHELL_DUMP_BYTES_PER_LINE / Width;
+
+  while (Count > 0) {
+    Items = (Count < PerLine) ? (UINTN)Count : PerLine;
+
+    Ptr = Line;
+    if (Ctx->Machine) {
+      CopyMem (Ptr, "data.", 5);
+      Ptr += 5;
+    }
+
+    Ptr    = ShellFormatHex (Ptr, Label, LabelDigits);
+    *Ptr++ = Ctx->Machine ? '=' : ':';
+    for (Index = 0; Index < Items; Index++) {
+      Value = ShellReadUnit (Space, Address + Index * Width, Width);
+      if ((Index != 0) || !Ctx->Machine) {
+        *Ptr++ = ' ';
+      }
+
+      Ptr = ShellFormatHex (Ptr, Value, Width * 2);
+      if (Width == 1) {
+        Ascii[Index] = ((Value < 0x20) || (Value > 0x7E)) ? '.' : (CHAR8)Value;
+      }
+    }
+
+    if ((Width == 1) && !Ctx->Machine) {
+      for ( ; Index < PerLine; Index++) {
+        *Ptr++ = ' ';
+        *Ptr++ = ' ';
+        *Ptr++ = ' ';
+      }
+
+      *Ptr++ = ' ';
+      *Ptr++ = ' ';
+      for (Index = 0; Index < Items; Index++) {
+        *Ptr++ = Ascii[Index];
+      }
+    }
+
+    *Ptr++ = '\r';
+    *Ptr++ = '\n';
+    SerialPortWrite ((UINT8 *)Line, (UINTN)(Ptr - Line));
+
+    Address += Items * Width;
+    Label   += Items * Width;
+    Count   -= Items;
+  }
+}
+
+/**
+  Print "<Name>[<Address>] <- <Value> (written)", or "written=<Count>" in a
+  machine response.
+
+  @param[in]  Ctx      Shell context.
+  @param[in]  Name     Address space name.
+  @param[in]  Address  Address that was written.
+  @param[in]  Width    Access width in bytes.
+  @param[in]  Value    Value that was written.
+  @param[in]  Count    Number of consecutive elements written.
+**/
+STATIC VOID
+ShellPrintWritten (
+  IN SHELL_CONTEXT  *Ctx,
+  IN CONST CHAR8    *Name,
+  IN UINT64         Address,
+  IN UINTN          Width,
+  IN UINT64         Value,
+  IN UINT64         Count
+  )
+{
+  CHAR8  Buf[21];
+  CHAR8  *Ptr;
+
+  if (Ctx->Machine) {
+    ShellPrintKeyHex ("written", Count, 8);
+    return;
+  }
+
+  ShellPrint (Name);
+  ShellPrint ("[");
+  ShellPrintHex64 (Address);
+  ShellPrint ("] <- 0x");
+  Ptr  = ShellFormatHex (Buf, Value, Width * 2);
+  *Ptr = '\0';
+  ShellPrint (Buf);
+  if (Count > 1) {
+    ShellPrint (" x 0x");
+    Ptr  = ShellFormatHex (Buf, Count, 8);
+    *Ptr = '\0';
+    ShellPrint (Buf);
+  }
+
+  ShellPrint (" (written)\r\n");
+}
+
+/**
+  Common body of the "mmio" and "io" commands.
+
+  @param[in]  Ctx       Shell context.
+  @param[in]  Argc      Argument count.
+  @param[in]  Argv      Argument array.
+  @param[in]  Space     ShellSpaceMmio or ShellSpaceIo.
+  @param[in]  Name      Name used in usage and result messages.
+  @param[in]  MaxWidth  Largest access width the space supports.
+  @param[in]  Limit     Highest valid address in the space.
+
+  @retval RETURN_SUCCESS            The access completed.
+  @retval RETURN_INVALID_PARAMETER  The arguments are malformed.
+**/
+STATIC RETURN_STATUS
+ShellAccessCommand (
+  IN SHELL_CONTEXT       *Ctx,
+  IN UINTN               Argc,
+  IN CHAR8               *Argv[],
+  IN SHELL_ACCESS_SPACE  Space,
+  IN CONST CHAR8         *Name,
+  IN UINTN               MaxWidth,
+  IN UINT64              Limit
+  )
+{
+  SHELL_ACCESS_OPTIONS  Options;
+  UINT64                Address;
+  UINT64                Value;
+  UINT64                Index;
+  UINT64                Target;
+
+  if (!ShellParseAccessOptions (Argc, Argv, MaxWidth, &Options)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if ((Options.FirstArg >= Argc) || (Argc - Options.FirstArg > 2)) {
+    ShellPrint ("Usage: ");
+    ShellPrint (Argv[0]);
+    ShellPrint ((Space == ShellSpaceIo) ?
+                " [-w 1|2|4] [-n count] <port_hex> [value_hex]\r\n" :
+                " [-w 1|2|4|8] [-n count] <address_hex> [value_hex]\r\n");
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (!ShellParseHex64 (Argv[Options.FirstArg], &Address)) {
+    ShellPrintArgError ("invalid address", Argv[Options.FirstArg]);
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (!ShellCheckRange (Address, Options.Width, Options.Count, Limit)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (Argc - Options.FirstArg == 1) {
+    ShellDumpRange (Ctx, Space, Address, Address, (Space == ShellSpaceIo) ? 4 : 16, Options.Width, Options.Count);
+    return RETURN_SUCCESS;
+  }
+
+  if (!ShellParseHex64 (Argv[Options.FirstArg + 1], &Value)) {
+    ShellPrintArgError ("invalid value", Argv[Options.FirstArg + 1]);
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  for (Index = 0, Target = Address; Index < Options.Count; Index++, Target += Options.Width) {
+    ShellWriteUnit (Space, Target, Options.Width, Value);
+  }
+
+  ShellPrintWritten (Ctx, Name, Address, Options.Width, Value, Options.Count);
+  return RETURN_SUCCESS;
+}
+
+/**
+  Handle "dump" command to hex dump a range of system memory.
+
+  @param[in]  Ctx   Shell context.
+  @param[in]  Argc  Argument count.
+  @param[in]  Argv  Argument array.
+
+  @retval RETURN_SUCCESS            The command completed.
+  @retval RETURN_INVALID_PARAMETER  The arguments are malformed.
+**/
+RETURN_STATUS
+CmdDump (
+  IN SHELL_CONTEXT  *Ctx,
+  IN UINTN          Argc,
+  IN CHAR8          *Argv[]
+  )
+{
+  SHELL_ACCESS_OPTIONS  Options;
+  UINT64                Address;
+  UINT64                Length;
+
+  if (!ShellParseAccessOptions (Argc, Argv, 8, &Options)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (Argc - Options.FirstArg != 2) {
+    ShellPrint ("Usage: dump [-w 1|2|4|8] <address_hex> <length_hex>\r\n");
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (!ShellParseHex64 (Argv[Options.FirstArg], &Address)) {
+    ShellPrintArgError ("invalid address", Argv[Options.FirstArg]);
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (!ShellParseHex64 (Argv[Options.FirstArg + 1], &Length) || (Length == 0) ||
+      ((Length & (Options.Width - 1)) != 0) ||
+      (Length > MultU64x32 (SHELL_MAX_ACCESS_COUNT, (UINT32)Options.Width))) {
+    ShellPrintArgError ("invalid length", Argv[Options.FirstArg + 1]);
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Options.Count = RShiftU64 (Length, (UINTN)HighBitSet32 ((UINT32)Options.Width));
+  if (!ShellCheckRange (Address, Options.Width, Options.Count, MAX_ADDRESS)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  ShellDumpRange (Ctx, ShellSpaceMemory, Address, Address, 16, Options.Width, Options.Count);
+  return RETURN_SUCCESS;
+}
+
+/**
+  Handle "mmio" command to read or write memory mapped registers.
+
+  @param[in]  Ctx   Shell context.
+  @param[in]  Argc  Argument count.
+  @param[in]  Argv  Argument array.
+
+  @retval RETURN_SUCCESS            The command completed.
+  @retval RETURN_INVALID_PARAMETER  The arguments are malformed.
+**/
+RETURN_STATUS
+CmdMmio (
+  IN SHELL_CONTEXT  *Ctx,
+  IN UINTN          Argc,
+  IN CHAR8          *Argv[]
+  )
+{
+  return ShellAccessCommand (Ctx, Argc, Argv, ShellSpaceMmio, "MMIO", 8, MAX_ADDRESS);
+}
+
+/**
+  Handle "io" command to read or write I/O ports.
+
+  @param[in]  Ctx   Shell context.
+  @param[in]  Argc  Argument count.
+  @param[in]  Argv  Argument array.
+
+  @retval RETURN_SUCCESS            The command completed.
+  @retval RETURN_INVALID_PARAMETER  The arguments are malformed.
+**/
+RETURN_STATUS
+CmdIo (
+  IN SHELL_CONTEXT  *Ctx,
+  IN UINTN          Argc,
+  IN CHAR8          *Argv[]
+  )
+{
+  return ShellAccessCommand (Ctx, Argc, Argv, ShellSpaceIo, "IO", 4, MAX_UINT16);
+}
+
+/**
+  Handle "pci" command to read or write PCI configuration space.
+
+  @param[in]  Ctx   Shell context.
+  @param[in]  Argc  Argument count.
+  @param[in]  Argv  Argument array.
+
+  @retval RETURN_SUCCESS            The command completed.
+  @retval RETURN_INVALID_PARAMETER  The arguments are malformed.
+**/
+RETURN_STATUS
+CmdPci (
+  IN SHELL_CONTEXT  *Ctx,
+  IN UINTN          Argc,
+  IN CHAR8          *Argv[]
+  )
+{
+  SHELL_ACCESS_OPTIONS  Options;
+  UINT64                Bdfr[4];
+  UINT64                Value;
+  UINTN                 Index;
+  UINTN                 Address;
+  STATIC CONST UINT64   Limits[] = { 0xFF, 0x1F, 0x7, 0xFFF };
+  STATIC CONST CHAR8    *Names[] = { "invalid bus", "invalid device", "invalid function", "invalid register" };
+
+  if (!ShellParseAccessOptions (Argc, Argv, 8, &Options)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if ((Argc - Options.FirstArg < 4) || (Argc - Options.FirstArg > 5)) {
+    ShellPrint ("Usage: pci [-w 1|2|4|8] [-n count] <bus> <dev> <func> <reg> [value_hex]\r\n");
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  for (Index = 0; Index < 4; Index++) {
+    if (!ShellParseHex64 (Argv[Options.FirstArg + Index], &Bdfr[Index]) || (Bdfr[Index] > Limits[Index])) {
+      ShellPrintArgError (Names[Index], Argv[Options.FirstArg + Index]);
+      return RETURN_INVALID_PARAMETER;
+    }
+  }
+
+  if (!ShellCheckRange (Bdfr[3], Options.Width, Options.Count, 0xFFF)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Address = PCI_LIB_ADDRESS ((UINTN)Bdfr[0], (UINTN)Bdfr[1], (UINTN)Bdfr[2], (UINTN)Bdfr[3]);
+
+  if (Argc - Options.FirstArg == 4) {
+    ShellDumpRange (Ctx, ShellSpacePci, Address, Bdfr[3], 3, Options.Width, Options.Count);
+    return RETURN_SUCCESS;
+  }
+
+  if (!ShellParseHex64 (Argv[Options.FirstArg + 4], &Value)) {
+    ShellPrintArgError ("invalid value", Argv[Options.FirstArg + 4]);
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  for (Index = 0; Index < (UINTN)Options.Count; Index++) {
+    ShellWriteUnit (ShellSpacePci, Address + Index * Options.Width, Options.Width, Value);
+  }
+
+  ShellPrintWritten (Ctx, "PCI", Address, Options.Width, Value, Options.Count);
+  return RETURN_SUCCESS;
+}
+
+/**
+  Send one binary transfer frame.
+
+  @param[in]  Sequence  Frame sequence number.
+  @param[in]  Payload   Frame payload; ignored when Length is zero.
+  @param[in]  Length    Payload length in bytes.
+**/
+STATIC VOID
+ShellSendBinFrame (
+  IN UINT32  Sequence,
+  IN UINT8   *Payload,
+  IN UINT32  Length
+  )
+{
+  SHELL_BIN_FRAME_HEADER  Header;
+  UINT32                  Crc;
+
+  Header.Signature = SHELL_BIN_FRAME_SIGNATURE;
+  Header.Sequence  = Sequence;
+  Header.Length    = Length;
+  Crc              = (Length == 0) ? 0 : CalculateCrc32 (Payload, Length);
+
+  SerialPortWrite ((UINT8 *)&Header, sizeof (Header));
+  if (Length != 0) {
+    SerialPortWrite (Payload, Length);
+  }
+
+  SerialPortWrite ((UINT8 *)&Crc, sizeof (Crc));
+}
+
+/**
+  Handle "bindump" command to transfer a memory range as binary frames.
+
+  Without -w the range is copied as ordinary memory.  With -w each frame is
+  filled by MMIO reads of the requested width, so device memory is accessed
+  at its native width.
+
+  In a machine request a "frame=<payload size>" line announces the frames,
+  which follow it directly, before the end of the response.  A host that
+  finds a bad CRC32 requests the range of that frame again.
+
+  @param[in]  Ctx   Shell context.
+  @param[in]  Argc  Argument count.
+  @param[in]  Argv  Argument array.
+
+  @retval RETURN_SUCCESS            The command completed.
+  @retval RETURN_INVALID_PARAMETER  The arguments are malformed.
+**/
+RETURN_STATUS
+CmdBinDump (
+  IN SHELL_CONTEXT  *Ctx,
+  IN UINTN          Argc,
+  IN CHAR8          *Argv[]
+  )
+{
+  SHELL_ACCESS_OPTIONS  Options;
+  UINT64                Address;
+  UINT64                Length;
+  UINT32                Chunk;
+  UINT32                Sequence;
+  UINT64                Frame[SHELL_BIN_FRAME_SIZE / sizeof (UINT64)];
+
+  if (!ShellParseAccessOptions (Argc, Argv, 8, &Options)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (Argc - Options.FirstArg != 2) {
+    ShellPrint ("Usage: bindump [-w 1|2|4|8] <address_hex> <length_hex>\r\n");
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (!ShellParseHex64 (Argv[Options.FirstArg], &Address)) {
+    ShellPrintArgError ("invalid address", Argv[Options.FirstArg]);
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (!ShellParseHex64 (Argv[Options.FirstArg + 1], &Length) || (Length == 0) ||
+      ((Length & (Options.Width - 1)) != 0)) {
+    ShellPrintArgError ("invalid length", Argv[Options.FirstArg + 1]);
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if ((Address > MAX_ADDRESS) || (Length - 1 > MAX_ADDRESS - Address) ||
+      ((Address & (Options.Width - 1)) != 0)) {
+    ShellPrint ("Error: range is misaligned or exceeds the address space\r\n");
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (Ctx->Machine) {
+    ShellPrintKeyHex ("frame", SHELL_BIN_FRAME_SIZE, 8);
+  }
+
+  Sequence = 0;
+
+  while (Length > 0) {
+    Chunk = (Length < SHELL_BIN_FRAME_SIZE) ? (UINT32)Length : SHELL_BIN_FRAME_SIZE;
+
+    if (!Options.WidthSet) {
+      CopyMem (Frame, (VOID *)(UINTN)Address, Chunk);
+    } else {
+      switch (Options.Width) {
+        case 1:  MmioReadBuffer8 ((UINTN)Address, Chunk, (UINT8 *)Frame);   break;
+        case 2:  MmioReadBuffer16 ((UINTN)Address, Chunk, (UINT16 *)Frame);  break;
+        case 4:  MmioReadBuffer32 ((UINTN)Address, Chunk, (UINT32 *)Frame);  break;
+        default: MmioReadBuffer64 ((UINTN)Address, Chunk, (UINT64 *)Frame);  break;
+      }
+    }
+
+    ShellSendBinFrame (Sequence++, (UINT8 *)Frame, Chunk);
+    Address += Chunk;
+    Length  -= Chunk;
+  }
+
+  ShellSendBinFrame (Sequence, NULL, 0);
+  return RETURN_SUCCESS;
+}
@@ -0,0 +1,218 @@
+/** @file
+  Debug Shell boot phase services for the DXE library instance.
+
+  Processors are reached through EFI_MP_SERVICES_PROTOCOL and scripts are
+  read with the firmware volume protocol.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <PiDxe.h>
+#include "DebugShellLibInternal.h"
+#include <Protocol/MpService.h>
+#include <Library/DxeServicesLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+/**
+  Locate the multi-processor services of the current boot phase.
+
+  When the MP protocol has not been installed yet Mp describes the BSP only.
+
+  @param[out] Mp  Filled with the services and processor counts.
+
+  @retval EFI_SUCCESS  Mp has been initialized.
+  @retval Others       The MP protocol failed to report the processor count.
+**/
+EFI_STATUS
+ShellMpInitialize (
+  OUT SHELL_MP  *Mp
+  )
+{
+  EFI_STATUS                Status;
+  EFI_MP_SERVICES_PROTOCOL  *MpServices;
+  UINTN                     NumberOfProcessors;
+  UINTN                     NumberOfEnabledProcessors;
+
+  Mp->Services           = NULL;
+  Mp->NumberOfProcessors = 1;
+  Mp->BspNumber          = 0;
+
+  Status = gBS->LocateProtocol (&gEfiMpServiceProtocolGuid, NULL, (VOID **)&MpServices);
+  if (EFI_ERROR (Status)) {
+    return EFI_SUCCESS;
+  }
+
+  Status = MpServices->GetNumberOfProcessors (MpServices, &NumberOfProcessors, &NumberOfEnabledProcessors);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = MpServices->WhoAmI (MpServices, &Mp->BspNumber);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Mp->Services           = MpServices;
+  Mp->NumberOfProcessors = NumberOfProcessors;
+  return EFI_SUCCESS;
+}
+
+/**
+  Return the processor number of the caller.  May be called on any processor.
+
+  @param[in]  Mp  Initialized by ShellMpInitialize().
+
+  @return Processor number of the calling processor.
+**/
+UINTN
+ShellMpWhoAmI (
+  IN SHELL_MP  *Mp
+  )
+{
+  EFI_MP_SERVICES_PROTOCOL  *MpServices;
+  UINTN                     ProcessorNumber;
+
+  MpServices = (EFI_MP_SERVICES_PROTOCOL *)Mp->Services;
+  if ((MpServices == NULL) || EFI_ERROR (MpServices->WhoAmI (MpServices, &ProcessorNumber))) {
+    return Mp->BspNumber;
+  }
+
+  return ProcessorNumber;
+}
+
+/**
+  Run Procedure on all enabled APs concurrently and wait for completion.
+
+  @param[in]  Mp         Initialized by ShellMpInitialize().
+  @param[in]  Procedure  Function to run on each AP.
+  @param[in]  Argument   Parameter passed to Procedure.
+
+  @retval EFI_SUCCESS      All enabled APs have finished Procedure.
+  @retval EFI_NOT_STARTED  There is no enabled AP.
+  @retval Others           The APs could not be started.
+**/
+EFI_STATUS
+ShellMpStartupAllAPs (
+  IN SHELL_MP          *Mp,
+  IN EFI_AP_PROCEDURE  Procedure,
+  IN VOID              *Argument
+  )
+{
+  EFI_MP_SERVICES_PROTOCOL  *MpServices;
+
+  MpServices = (EFI_MP_SERVICES_PROTOCOL *)Mp->Services;
+  if (MpServices == NULL) {
+    return EFI_NOT_STARTED;
+  }
+
+  return MpServices->StartupAllAPs (MpServices, Procedure, FALSE, NULL, 0, Argument, NULL);
+}
+
+/**
+  Run Procedure on one AP and wait for completion.
+
+  @param[in]  Mp               Initialized by ShellMpInitialize().
+  @param[in]  Procedure        Function to run on the AP.
+  @param[in]  ProcessorNumber  Target processor; must not be the BSP.
+  @param[in]  Argument         Parameter passed to Procedure.
+
+  @retval EFI_SUCCESS      The AP has finished Procedure.
+  @retval EFI_UNSUPPORTED  The MP protocol is not available.
+  @retval Others           The AP could not be started.
+**/
+EFI_STATUS
+ShellMpStartupThisAP (
+  IN SHELL_MP          *Mp,
+  IN EFI_AP_PROCEDURE  Procedure,
+  IN UINTN             ProcessorNumber,
+  IN VOID              *Argument
+  )
+{
+  EFI_MP_SERVICES_PROTOCOL  *MpServices;
+
+  MpServices = (EFI_MP_SERVICES_PROTOCOL *)Mp->Services;
+  if (MpServices == NULL) {
+    return EFI_UNSUPPORTED;
+  }
+
+  return MpServices->StartupThisAP (MpServices, Procedure, ProcessorNumber, NULL, 0, Argument, NULL);
+}
+
+/**
+  Allocate a zeroed buffer from the boot services pool.
+
+  @param[in]  Size  Number of bytes to allocate.
+
+  @return Pointer to the buffer, or NULL if the pool is exhausted.
+**/
+VOID *
+ShellAllocateZeroPool (
+  IN UINTN  Size
+  )
+{
+  return AllocateZeroPool (Size);
+}
+
+/**
+  Free a buffer returned by ShellAllocateZeroPool().
+
+  @param[in]  Buffer  Buffer to free.
+**/
+VOID
+ShellFreePool (
+  IN VOID  *Buffer
+  )
+{
+  FreePool (Buffer);
+}
+
+/**
+  Find the first EFI_SECTION_RAW section of an FFS file in any firmware
+  volume.
+
+  @param[in]  FileName  FFS file name.
+  @param[out] Data      Section data, copied to pool memory.  Release with
+                        ShellFreeRawSection().
+  @param[out] Size      Section data size in bytes.
+
+  @retval RETURN_SUCCESS    The section was found.
+  @retval RETURN_NOT_FOUND  No such file or section.
+**/
+RETURN_STATUS
+ShellFindRawSection (
+  IN  CONST GUID  *FileName,
+  OUT VOID        **Data,
+  OUT UINTN       *Size
+  )
+{
+  EFI_STATUS  Status;
+
+  *Data  = NULL;
+  Status = GetSectionFromAnyFv (FileName, EFI_SECTION_RAW, 0, Data, Size);
+  if (EFI_ERROR (Status)) {
+    return RETURN_NOT_FOUND;
+  }
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Release section data returned by ShellFindRawSection().
+
+  @param[in]  Data  Section data.
+**/
+VOID
+ShellFreeRawSection (
+  IN VOID  *Data
+  )
+{
+  FreePool (Data);
+}
@@ -12,17 +12,7 @@
   WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 **/
 
-#include <PiPei.h>
-#include <Library/BaseLib.h>
-#include <Library/SerialPortLib.h>
-#include <Library/DebugShellLib.h>
-
-/*
-  Internal constants
-*/
-
-#define SHELL_CMD_BUF_SIZE  128
-#define SHELL_MAX_ARGS      8
+#include "DebugShellLibInternal.h"
 
 /*
   I/O helpers
@@ -33,7 +23,7 @@
 
   @param[in]  Str  NUL-terminated ASCII string.
 **/
-STATIC VOID
+VOID
 ShellPrint (
   IN CONST CHAR8  *Str
   )
@@ -48,32 +38,139 @@ ShellPrint (
   }
 }
 
+/**
+  Format the low Digits nibbles of Value as uppercase hex into Buf.
+  No prefix and no NUL terminator are written.
+
+  @param[out] Buf     Destination buffer, at least Digits bytes.
+  @param[in]  Value   Value to format.
+  @param[in]  Digits  Number of hex digits to emit (1 - 16).
+
+  @return Pointer to the byte following the last digit written.
+**/
+CHAR8 *
+ShellFormatHex (
+  OUT CHAR8   *Buf,
+  IN  UINT64  Value,
+  IN  UINTN   Digits
+  )
+{
+  INTN   i;
+  UINT8  Nibble;
+
+  for (i = (INTN)Digits - 1; i >= 0; i--) {
+    Nibble   = (UINT8)(Value & 0xF);
+    Buf[i]   = (Nibble < 10) ? (CHAR8)('0' + Nibble) : (CHAR8)('A' + Nibble - 10);
+    Value    = RShiftU64 (Value, 4);
+  }
+
+  return Buf + Digits;
+}
+
+/**
+  Format Value as decimal into Buf, right aligned in a field of at least
+  Width characters padded with PadChar.  No NUL terminator is written.
+
+  @param[out] Buf      Destination buffer, at least MAX (Width, 20) bytes.
+  @param[in]  Value    Value to format.
+  @param[in]  Width    Minimum field width.
+  @param[in]  PadChar  Character used for padding, ' ' or '0'.
+
+  @return Pointer to the byte following the last character written.
+**/
+CHAR8 *
+ShellFormatDec (
+  OUT CHAR8   *Buf,
+  IN  UINT64  Value,
+  IN  UINTN   Width,
+  IN  CHAR8   PadChar
+  )
+{
+  CHAR8   Digits[20];
+  UINTN   Count;
+  UINT32  Remainder;
+
+  Count = 0;
+  do {
+    Value           = DivU64x32Remainder (Value, 10, &Remainder);
+    Digits[Count++] = (CHAR8)('0' + Remainder);
+  } while (Value != 0);
+
+  for ( ; Width > Count; Width--) {
+    *Buf++ = PadChar;
+  }
+
+  while (Count > 0) {
+    *Buf++ = Digits[--Count];
+  }
+
+  return Buf;
+}
+
 /**
   Print Value as "0xXXXXXXXXXXXXXXXX" (always 16 uppercase hex digits).
 
   @param[in]  Value  64-bit value to print in hex format.
 **/
-STATIC VOID
+VOID
 ShellPrintHex64 (
   IN UINT64  Value
   )
 {
   CHAR8  Buf[19];   /* "0x" + 16 digits + NUL */
-  INT32  i;
 
   Buf[0] = '0';
   Buf[1] = 'x';
-  for (i = 15; i >= 0; i--) {
-    UINT8  Nibble;
-
-    Nibble         = (UINT8)(Value & 0xF);
-    Buf[2 + i]     = (Nibble < 10) ? (CHAR8)('0' + Nibble) : (CHAR8)('A' + Nibble - 10);
-    Value        >>= 4;
-  }
+  ShellFormatHex (&Buf[2], Value, 16);
   Buf[18] = '\0';
   ShellPrint (Buf);
 }
 
+/**
+  Print "Error: <What> '<Arg>'" followed by a line break.
+
+  @param[in]  What  Description of the rejected argument.
+  @param[in]  Arg   The offending argument text.
+**/
+VOID
+ShellPrintArgError (
+  IN CONST CHAR8  *What,
+  IN CONST CHAR8  *Arg
+  )
+{
+  ShellPrint ("Error: ");
+  ShellPrint (What);
+  ShellPrint (" '");
+  ShellPrint (Arg);
+  ShellPrint ("'\r\n");
+}
+
+/**
+  Print a "<Key>=<Value>\r\n" machine response line with Value formatted as
+  Digits hex digits.
+
+  @param[in]  Key     NUL-terminated key.
+  @param[in]  Value   Value to print.
+  @param[in]  Digits  Number of hex digits (1 - 16).
+**/
+VOID
+ShellPrintKeyHex (
+  IN CONST CHAR8  *Key,
+  IN UINT64       Value,
+  IN UINTN        Digits
+  )
+{
+  CHAR8  Buf[19];   /* "=" + 16 digits + CRLF */
+  CHAR8  *Ptr;
+
+  ShellPrint (Key);
+  Buf[0] = '=';
+  Ptr    = ShellFormatHex (&Buf[1], Value, Digits);
+  *Ptr++ = '\r';
+  *Ptr++ = '\n';
+  SerialPortWrite ((UINT8 *)Buf, (UINTN)(Ptr - Buf));
+}
+
 /**
   Parse an ASCII hex string (optional "0x"/"0X" prefix) into a UINT64.
 
@@ -83,7 +180,7 @@ ShellPrintHex64 (
   @retval TRUE   Parsed successfully; *Value is set.
   @retval FALSE  Empty string or contains non-hex characters.
 **/
-STATIC BOOLEAN
+BOOLEAN
 ShellParseHex64 (
   IN  CONST CHAR8  *Str,
   OUT UINT64       *Value
@@ -126,44 +223,65 @@ ShellParseHex64 (
 
 /**
   Read a line from the serial port with local echo and backspace support.
-  Blocks until CR or LF is received.
+  Blocks until CR or LF is received.  Machine requests are not echoed.
+  A byte typed ahead while "watch" was polling for a stop key comes first.
 
-  @param[out] Buf      Destination buffer for the NUL-terminated line.
-  @param[in]  BufSize  Size of Buf in bytes (including NUL terminator).
+  @param[in,out] Ctx      Shell context.
+  @param[out]    Buf      Destination buffer for the NUL-terminated line.
+  @param[in]     BufSize  Size of Buf in bytes (including NUL terminator).
 **/
 STATIC VOID
 ShellReadLine (
-  OUT CHAR8  *Buf,
-  IN  UINTN  BufSize
+  IN OUT SHELL_CONTEXT  *Ctx,
+  OUT    CHAR8          *Buf,
+  IN     UINTN          BufSize
   )
 {
-  UINTN  Pos;
-  UINT8  Ch;
-  UINT8  Bs[3];
+  UINTN    Pos;
+  UINT8    Ch;
+  UINT8    Bs[3];
+  BOOLEAN  Echo;
 
   Pos   = 0;
+  Echo  = TRUE;
   Bs[0] = '\b';
   Bs[1] = ' ';
   Bs[2] = '\b';
 
   while (TRUE) {
-    while (!SerialPortPoll ()) {
+    if (Ctx->HasPending) {
+      Ch              = Ctx->Pending;
+      Ctx->HasPending = FALSE;
+    } else {
+      while (!SerialPortPoll ()) {
+      }
+
+      SerialPortRead (&Ch, 1);
     }
 
-    SerialPortRead (&Ch, 1);
+    if ((Pos == 0) && (Ch == SHELL_MACHINE_REQUEST)) {
+      Echo = FALSE;
+    }
 
     if ((Ch == '\r') || (Ch == '\n')) {
-      ShellPrint ("\r\n");
+      if (Echo) {
+        ShellPrint ("\r\n");
+      }
+
       break;
     } else if ((Ch == '\b') || (Ch == 0x7F)) {
       if (Pos > 0) {
         Pos--;
-        SerialPortWrite (Bs, 3);
+        if (Echo) {
+          SerialPortWrite (Bs, 3);
+        }
       }
     } else if ((Ch >= 0x20) && (Ch < 0x7F)) {
       if (Pos < BufSize - 1) {
         Buf[Pos++] = (CHAR8)Ch;
-        SerialPortWrite (&Ch, 1);
+        if (Echo) {
+          SerialPortWrite (&Ch, 1);
+        }
       }
     }
   }
@@ -220,136 +338,198 @@ ShellTokenize (
 
 /**
   Display help message with available commands.
+
+  @param[in]  Ctx   Shell context.
+  @param[in]  Argc  Argument count.
+  @param[in]  Argv  Argument array.
+
+  @retval RETURN_SUCCESS  Always.
 **/
-STATIC VOID
+STATIC RETURN_STATUS
 CmdHelp (
-  VOID
+  IN SHELL_CONTEXT  *Ctx,
+  IN UINTN          Argc,
+  IN CHAR8          *Argv[]
   )
 {
   ShellPrint ("Available commands:\r\n");
-  ShellPrint ("  readmsr  <index>         - Read 64-bit MSR (hex index)\r\n");
-  ShellPrint ("  writemsr <index> <value> - Write 64-bit MSR (hex index and value)\r\n");
-  ShellPrint ("  help                     - Show this message\r\n");
-  ShellPrint ("  exit                     - Leave debug shell and continue boot\r\n");
+  ShellPrint ("  readmsr  [-a|-p P] <index>          - Read 64-bit MSR on the BSP, all CPUs or CPU P\r\n");
+  ShellPrint ("  writemsr [-a|-p P] [-r] <index> <value>\r\n");
+  ShellPrint ("                                      - Write 64-bit MSR on the BSP, all CPUs or CPU P,\r\n");
+  ShellPrint ("                                        -r reads it back (not for write-only MSRs)\r\n");
+  ShellPrint ("  dump    [-w W] <addr> <len>         - Hex dump system memory\r\n");
+  ShellPrint ("  mmio    [-w W] [-n N] <addr> [val]  - Read N or write (fill) MMIO registers\r\n");
+  ShellPrint ("  io      [-w W] [-n N] <port> [val]  - Read N or write (fill) I/O ports\r\n");
+  ShellPrint ("  pci     [-w W] [-n N] <b> <d> <f> <reg> [val]\r\n");
+  ShellPrint ("                                      - Read N or write (fill) PCI config space\r\n");
+  ShellPrint ("  bindump [-w W] <addr> <len>         - Send memory as CRC32 framed binary\r\n");
+  ShellPrint ("  script  <addr> <len>                - Run the command script stored in memory\r\n");
+  ShellPrint ("  repeat  <N> <command>               - Run command N times\r\n");
+  ShellPrint ("  watch   <ms> <command>              - Run command every ms milliseconds with a\r\n");
+  ShellPrint ("                                        timestamp until ESC or Ctrl-C\r\n");
+  ShellPrint ("  help                                - Show this message\r\n");
+  ShellPrint ("  exit                                - Leave debug shell and continue boot\r\n");
+  ShellPrint ("All numbers are hex.  W is the access width 1, 2, 4 or 8 (default 1).\r\n");
+  ShellPrint ("repeat and watch combine: 'repeat 10 watch 64 readmsr -a 1B'.\r\n");
+  ShellPrint ("Prefix a command with ':<seq> ' for a framed, machine readable response.\r\n");
+  return RETURN_SUCCESS;
 }
 
+//
+// Command table, searched in order by ShellDispatchCommand().
+//
+typedef RETURN_STATUS (*SHELL_COMMAND_HANDLER) (
+  IN SHELL_CONTEXT  *Ctx,
+  IN UINTN          Argc,
+  IN CHAR8          *Argv[]
+  );
+
+typedef struct {
+  CONST CHAR8              *Name;
+  SHELL_COMMAND_HANDLER    Handler;
+} SHELL_COMMAND;
+
+STATIC CONST SHELL_COMMAND  mShellCommands[] = {
+  { "help",     CmdHelp     },
+  { "readmsr",  CmdReadMsr  },
+  { "writemsr", CmdWriteMsr },
+  { "dump",     CmdDump     },
+  { "mmio",     CmdMmio     },
+  { "io",       CmdIo       },
+  { "pci",      CmdPci      },
+  { "bindump",  CmdBinDump  },
+  { "repeat",   CmdLoop     },
+  { "watch",    CmdLoop     },
+  { "script",   CmdScript   }
+};
+
 /**
-  Handle "readmsr" command to read a 64-bit MSR.
+  Execute one already tokenized command.
 
-  @param[in]  Argc  Argument count.
-  @param[in]  Argv  Argument array.
+  @param[in,out] Ctx   Shell context; Ctx->Exit is set by "exit".
+  @param[in]     Argc  Argument count; must be at least 1.
+  @param[in]     Argv  Argument array; Argv[0] is the command name.
+
+  @retval RETURN_SUCCESS    The command completed.
+  @retval RETURN_NOT_FOUND  Argv[0] is not a command.
+  @retval Others            Status returned by the command.
 **/
-STATIC VOID
-CmdReadMsr (
-  IN UINTN   Argc,
-  IN CHAR8  *Argv[]
+RETURN_STATUS
+ShellDispatchCommand (
+  IN OUT SHELL_CONTEXT  *Ctx,
+  IN     UINTN          Argc,
+  IN     CHAR8          *Argv[]
   )
 {
-  UINT64  Index;
-  UINT64  Value;
+  UINTN  Index;
 
-  if (Argc < 2) {
-    ShellPrint ("Usage: readmsr <index_hex>\r\n");
-    return;
+  for (Index = 0; Index < ARRAY_SIZE (mShellCommands); Index++) {
+    if (AsciiStrCmp (Argv[0], mShellCommands[Index].Name) == 0) {
+      return mShellCommands[Index].Handler (Ctx, Argc, Argv);
+    }
   }
 
-  if ((!ShellParseHex64 (Argv[1], &Index)) || (Index > 0xFFFFFFFFULL)) {
-    ShellPrint ("Error: invalid MSR index '");
-    ShellPrint (Argv[1]);
-    ShellPrint ("'\r\n");
-    return;
+  if (AsciiStrCmp (Argv[0], "exit") == 0) {
+    ShellPrint ("Exiting debug shell...\r\n");
+    Ctx->Exit = TRUE;
+    return RETURN_SUCCESS;
   }
 
-  Value = AsmReadMsr64 ((UINT32)Index);
-
-  ShellPrint ("MSR[");
-  ShellPrintHex64 (Index);
-  ShellPrint ("] = ");
-  ShellPrintHex64 (Value);
-  ShellPrint ("\r\n");
+  ShellPrint ("Unknown command: '");
+  ShellPrint (Argv[0]);
+  ShellPrint ("'. Type 'help' for available commands.\r\n");
+  return RETURN_NOT_FOUND;
 }
 
 /**
-  Handle "writemsr" command to write a 64-bit MSR.
-
-  @param[in]  Argc  Argument count.
-  @param[in]  Argv  Argument array.
+  Print the "{<seq>" or "}<seq> <status>" line that opens or closes a
+  machine response.
+
+  @param[in]  Marker    SHELL_MACHINE_BEGIN or SHELL_MACHINE_END.
+  @param[in]  Sequence  Sequence number of the request.
+  @param[in]  Status    Completion status; only printed with SHELL_MACHINE_END,
+                        as 16 hex digits with the error bit moved to bit 63
+                        so that it reads the same from 32-bit and 64-bit
+                        firmware.
 **/
 STATIC VOID
-CmdWriteMsr (
-  IN UINTN   Argc,
-  IN CHAR8  *Argv[]
+ShellPrintFrameMarker (
+  IN CHAR8          Marker,
+  IN UINT32         Sequence,
+  IN RETURN_STATUS  Status
   )
 {
-  UINT64  Index;
-  UINT64  Value;
-
-  if (Argc < 3) {
-    ShellPrint ("Usage: writemsr <index_hex> <value_hex>\r\n");
-    return;
-  }
-
-  if ((!ShellParseHex64 (Argv[1], &Index)) || (Index > 0xFFFFFFFFULL)) {
-    ShellPrint ("Error: invalid MSR index '");
-    ShellPrint (Argv[1]);
-    ShellPrint ("'\r\n");
-    return;
-  }
+  CHAR8   Line[32];
+  CHAR8   *Ptr;
+  UINT64  Code;
+
+  Line[0] = Marker;
+  Ptr     = ShellFormatHex (&Line[1], Sequence, 8);
+  if (Marker == SHELL_MACHINE_END) {
+    Code = (UINT64)(Status & ~MAX_BIT);
+    if (RETURN_ERROR (Status)) {
+      Code |= BIT63;
+    }
 
-  if (!ShellParseHex64 (Argv[2], &Value)) {
-    ShellPrint ("Error: invalid value '");
-    ShellPrint (Argv[2]);
-    ShellPrint ("'\r\n");
-    return;
+    *Ptr++ = ' ';
+    Ptr    = ShellFormatHex (Ptr, Code, 16);
   }
 
-  AsmWriteMsr64 ((UINT32)Index, Value);
-
-  ShellPrint ("MSR[");
-  ShellPrintHex64 (Index);
-  ShellPrint ("] <- ");
-  ShellPrintHex64 (Value);
-  ShellPrint (" (written)\r\n");
+  *Ptr++ = '\r';
+  *Ptr++ = '\n';
+  SerialPortWrite ((UINT8 *)Line, (UINTN)(Ptr - Line));
 }
 
 /**
-  Dispatch one tokenized command line.
-
-  @param[in]  Line  Command line to process.
+  Tokenize and execute one command line, framing the output when the line
+  is a machine request.
 
-  @retval TRUE   The caller should exit the shell loop ("exit" command).
-  @retval FALSE  Continue the shell loop.
+  @param[in,out] Ctx   Shell context; Ctx->Exit is set by "exit".
+  @param[in,out] Line  NUL-terminated command line; modified by tokenizing.
 **/
-STATIC BOOLEAN
+VOID
 ShellProcessCommand (
-  IN CHAR8  *Line
+  IN OUT SHELL_CONTEXT  *Ctx,
+  IN OUT CHAR8          *Line
   )
 {
-  CHAR8  *Argv[SHELL_MAX_ARGS];
-  UINTN   Argc;
+  CHAR8          *Argv[SHELL_MAX_ARGS];
+  UINTN          Argc;
+  UINT64         Sequence;
+  BOOLEAN        Machine;
+  UINT32         OuterSequence;
+  RETURN_STATUS  Status;
 
   Argc = ShellTokenize (Line, Argv, SHELL_MAX_ARGS);
 
   if (Argc == 0) {
-    return FALSE;
+    return;
   }
 
-  if (AsciiStrCmp (Argv[0], "help") == 0) {
-    CmdHelp ();
-  } else if (AsciiStrCmp (Argv[0], "readmsr") == 0) {
-    CmdReadMsr (Argc, Argv);
-  } else if (AsciiStrCmp (Argv[0], "writemsr") == 0) {
-    CmdWriteMsr (Argc, Argv);
-  } else if (AsciiStrCmp (Argv[0], "exit") == 0) {
-    ShellPrint ("Exiting debug shell...\r\n");
-    return TRUE;
-  } else {
-    ShellPrint ("Unknown command: '");
-    ShellPrint (Argv[0]);
-    ShellPrint ("'. Type 'help' for available commands.\r\n");
+  if (Argv[0][0] != SHELL_MACHINE_REQUEST) {
+    ShellDispatchCommand (Ctx, Argc, Argv);
+    return;
+  }
+
+  if (!ShellParseHex64 (&Argv[0][1], &Sequence) || (Sequence > MAX_UINT32)) {
+    ShellPrintArgError ("invalid sequence number", Argv[0]);
+    return;
   }
 
-  return FALSE;
+  //
+  // Machine requests may nest through "script"; restore the outer state.
+  //
+  Machine       = Ctx->Machine;
+  OuterSequence = Ctx->Sequence;
+  Ctx->Machine  = TRUE;
+  Ctx->Sequence = (UINT32)Sequence;
+
+  ShellPrintFrameMarker (SHELL_MACHINE_BEGIN, Ctx->Sequence, RETURN_SUCCESS);
+  Status = (Argc > 1) ? ShellDispatchCommand (Ctx, Argc - 1, &Argv[1]) : RETURN_SUCCESS;
+  ShellPrintFrameMarker (SHELL_MACHINE_END, Ctx->Sequence, Status);
+
+  Ctx->Machine  = Machine;
+  Ctx->Sequence = OuterSequence;
 }
 
 /*
@@ -368,19 +548,36 @@ RunDebugShell (
   IN CONST CHAR8  *Prompt  OPTIONAL
   )
 {
-  CHAR8        CmdBuf[SHELL_CMD_BUF_SIZE];
-  CONST CHAR8  *ActivePrompt;
-
-  ActivePrompt = (Prompt != NULL) ? Prompt : "> ";
+  CHAR8          CmdBuf[SHELL_CMD_BUF_SIZE];
+  CONST CHAR8    *ActivePrompt;
+  SHELL_CONTEXT  Ctx;
+  BOOLEAN        Quiet;
+
+  ActivePrompt    = (Prompt != NULL) ? Prompt : "> ";
+  Ctx.Machine     = FALSE;
+  Ctx.Exit        = FALSE;
+  Ctx.Sequence    = 0;
+  Ctx.HasPending  = FALSE;
+  Ctx.ScriptDepth = 0;
+  Quiet           = FALSE;
 
   ShellPrint ("\r\n*** Debug Shell ***\r\n");
   ShellPrint ("Type 'help' for available commands.\r\n\r\n");
 
-  while (TRUE) {
-    ShellPrint (ActivePrompt);
-    ShellReadLine (CmdBuf, sizeof (CmdBuf));
-    if (ShellProcessCommand (CmdBuf)) {
-      break;
+  while (!Ctx.Exit) {
+    //
+    // A host sending machine requests does not wait for prompts, so stop
+    // printing them until a person types an ordinary command again.
+    //
+    if (!Quiet) {
+      ShellPrint (ActivePrompt);
     }
+
+    ShellReadLine (&Ctx, CmdBuf, sizeof (CmdBuf));
+    if (CmdBuf[0] != '\0') {
+      Quiet = (BOOLEAN)(CmdBuf[0] == SHELL_MACHINE_REQUEST);
+    }
+
+    ShellProcessCommand (&Ctx, CmdBuf);
   }
 }
@@ -0,0 +1,521 @@
+/** @file
+  Internal definitions shared by the Debug Shell Library source files.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#ifndef DEBUG_SHELL_LIB_INTERNAL_H_
+#define DEBUG_SHELL_LIB_INTERNAL_H_
+
+#include <PiPei.h>
+#include <Library/BaseLib.h>
+#include <Library/IoLib.h>
+#include <Library/PciLib.h>
+#include <Library/SerialPortLib.h>
+#include <Library/TimerLib.h>
+#include <Library/DebugShellLib.h>
+
+/*
+  Internal constants
+*/
+
+#define SHELL_CMD_BUF_SIZE  128
+#define SHELL_MAX_ARGS      16
+
+//
+// Scripts run by "script" from a script, counting the outermost one.  Each
+// level keeps a command line buffer on the stack, and PEI stacks are small.
+//
+#define SHELL_MAX_SCRIPT_DEPTH  4
+
+//
+// Binary transfer frame layout (all fields little-endian):
+//
+//   SHELL_BIN_FRAME_HEADER  Signature 'D','S','B','F', sequence number and
+//                           payload length.
+//   UINT8[Length]           Payload, at most SHELL_BIN_FRAME_SIZE bytes.
+//   UINT32                  CRC32 of the payload.
+//
+// A frame with Length == 0 terminates the transfer.  In a machine request
+// the frames follow a "frame=<SHELL_BIN_FRAME_SIZE>" result line and come
+// before the end of the response; frame N holds the payload at offset
+// N * SHELL_BIN_FRAME_SIZE of the range.
+//
+#define SHELL_BIN_FRAME_SIGNATURE  SIGNATURE_32 ('D', 'S', 'B', 'F')
+#define SHELL_BIN_FRAME_SIZE       1024
+
+#pragma pack (1)
+typedef struct {
+  UINT32    Signature;
+  UINT32    Sequence;
+  UINT32    Length;
+} SHELL_BIN_FRAME_HEADER;
+#pragma pack ()
+
+//
+// Machine request framing.  A command line starting with
+// SHELL_MACHINE_REQUEST is a machine request ":<seq> <command> [args]".
+// Its output is enclosed in
+//
+//   {<seq>                       begin of response <seq>
+//   <key>=<value>                results, one per line
+//   <any other line>             informational text
+//   }<seq> <status>              end of response and command status
+//
+// with <seq> as 8 hex digits and <status> as 16 hex digits: the code of the
+// RETURN_STATUS with its error bit moved to bit 63, so that errors and
+// warnings with the same code differ on both 32-bit and 64-bit firmware.
+// No prompt is printed and the request is not echoed, so a host can send
+// the next request without waiting for the previous response.
+//
+#define SHELL_MACHINE_REQUEST  ':'
+#define SHELL_MACHINE_BEGIN    '{'
+#define SHELL_MACHINE_END      '}'
+
+//
+// Per-session state.  It lives on the stack of RunDebugShell() or
+// RunDebugShellScript() so that the library keeps no writable globals and
+// works from XIP flash before permanent memory is available.
+//
+typedef struct {
+  BOOLEAN  Machine;     ///< TRUE while a machine request is being served.
+  BOOLEAN  Exit;        ///< Set by the "exit" command.
+  UINT32   Sequence;    ///< Sequence number of the current machine request.
+  BOOLEAN  HasPending;  ///< TRUE if Pending holds a byte typed ahead.
+  UINT8    Pending;     ///< Byte read while polling for a stop key.
+  UINT8    ScriptDepth; ///< Scripts currently running, nested by "script".
+} SHELL_CONTEXT;
+
+/*
+  I/O helpers (DebugShellLib.c)
+*/
+
+/**
+  Write a NUL-terminated ASCII string to the serial port.
+
+  @param[in]  Str  NUL-terminated ASCII string.
+**/
+VOID
+ShellPrint (
+  IN CONST CHAR8  *Str
+  );
+
+/**
+  Print Value as "0xXXXXXXXXXXXXXXXX" (always 16 uppercase hex digits).
+
+  @param[in]  Value  64-bit value to print in hex format.
+**/
+VOID
+ShellPrintHex64 (
+  IN UINT64  Value
+  );
+
+/**
+  Format the low Digits nibbles of Value as uppercase hex into Buf.
+  No prefix and no NUL terminator are written.
+
+  @param[out] Buf     Destination buffer, at least Digits bytes.
+  @param[in]  Value   Value to format.
+  @param[in]  Digits  Number of hex digits to emit (1 - 16).
+
+  @return Pointer to the byte following the last digit written.
+**/
+CHAR8 *
+ShellFormatHex (
+  OUT CHAR8   *Buf,
+  IN  UINT64  Value,
+  IN  UINTN   Digits
+  );
+
+/**
+  Format Value as decimal into Buf, right aligned in a field of at least
+  Width characters padded with PadChar.  No NUL terminator is written.
+
+  @param[out] Buf      Destination buffer, at least MAX (Width, 20) bytes.
+  @param[in]  Value    Value to format.
+  @param[in]  Width    Minimum field width.
+  @param[in]  PadChar  Character used for padding, ' ' or '0'.
+
+  @return Pointer to the byte following the last character written.
+**/
+CHAR8 *
+ShellFormatDec (
+  OUT CHAR8   *Buf,
+  IN  UINT64  Value,
+  IN  UINTN   Width,
+  IN  CHAR8   PadChar
+  );
+
+/**
+  Print a "<Key>=<Value>\r\n" machine response line with Value formatted as
+  Digits hex digits.
+
+  @param[in]  Key     NUL-terminated key.
+  @param[in]  Value   Value to print.
+  @param[in]  Digits  Number of hex digits (1 - 16).
+**/
+VOID
+ShellPrintKeyHex (
+  IN CONST CHAR8  *Key,
+  IN UINT64       Value,
+  IN UINTN        Digits
+  );
+
+/**
+  Parse an ASCII hex string (optional "0x"/"0X" prefix) into a UINT64.
+
+  @param[in]  Str    Input ASCII hex string.
+  @param[out] Value  Pointer to output UINT64 value.
+
+  @retval TRUE   Parsed successfully; *Value is set.
+  @retval FALSE  Empty string or contains non-hex characters.
+**/
+BOOLEAN
+ShellParseHex64 (
+  IN  CONST CHAR8  *Str,
+  OUT UINT64       *Value
+  );
+
+/**
+  Print "Error: <What> '<Arg>'" followed by a line break.
+
+  @param[in]  What  Description of the rejected argument.
+  @param[in]  Arg   The offending argument text.
+**/
+VOID
+ShellPrintArgError (
+  IN CONST CHAR8  *What,
+  IN CONST CHAR8  *Arg
+  );
+
+/**
+  Tokenize and execute one command line, framing the output when the line
+  is a machine request.
+
+  @param[in,out] Ctx   Shell context; Ctx->Exit is set by "exit".
+  @param[in,out] Line  NUL-terminated command line; modified by tokenizing.
+**/
+VOID
+ShellProcessCommand (
+  IN OUT SHELL_CONTEXT  *Ctx,
+  IN OUT CHAR8          *Line
+  );
+
+/**
+  Execute one already tokenized command.
+
+  @param[in,out] Ctx   Shell context; Ctx->Exit is set by "exit".
+  @param[in]     Argc  Argument count; must be at least 1.
+  @param[in]     Argv  Argument array; Argv[0] is the command name.
+
+  @retval RETURN_SUCCESS    The command completed.
+  @retval RETURN_NOT_FOUND  Argv[0] is not a command.
+  @retval Others            Status returned by the command.
+**/
+RETURN_STATUS
+ShellDispatchCommand (
+  IN OUT SHELL_CONTEXT  *Ctx,
+  IN     UINTN          Argc,
+  IN     CHAR8          *Argv[]
+  );
+
+/*
+  Boot phase services (DebugShellBase.c, DebugShellPei.c or DebugShellDxe.c,
+  depending on the library instance)
+*/
+
+typedef struct {
+  VOID   *Services;             ///< MP PPI or protocol; NULL when only the BSP is usable.
+  UINTN  NumberOfProcessors;    ///< Total number of logical processors.
+  UINTN  BspNumber;             ///< Processor number of the BSP.
+} SHELL_MP;
+
+/**
+  Locate the multi-processor services of the current boot phase.
+
+  When no MP services are available Mp describes a single processor, the
+  BSP, and the function still succeeds.
+
+  @param[out] Mp  Filled with the services and processor counts.
+
+  @retval EFI_SUCCESS  Mp has been initialized.
+  @retval Others       The MP services failed to report the processor count.
+**/
+EFI_STATUS
+ShellMpInitialize (
+  OUT SHELL_MP  *Mp
+  );
+
+/**
+  Return the processor number of the caller.  May be called on any processor.
+
+  @param[in]  Mp  Initialized by ShellMpInitialize().
+
+  @return Processor number of the calling processor.
+**/
+UINTN
+ShellMpWhoAmI (
+  IN SHELL_MP  *Mp
+  );
+
+/**
+  Run Procedure on all enabled APs concurrently and wait for completion.
+
+  @param[in]  Mp         Initialized by ShellMpInitialize().
+  @param[in]  Procedure  Function to run on each AP.
+  @param[in]  Argument   Parameter passed to Procedure.
+
+  @retval EFI_SUCCESS      All enabled APs have finished Procedure.
+  @retval EFI_NOT_STARTED  There is no enabled AP.
+  @retval Others           The APs could not be started.
+**/
+EFI_STATUS
+ShellMpStartupAllAPs (
+  IN SHELL_MP          *Mp,
+  IN EFI_AP_PROCEDURE  Procedure,
+  IN VOID              *Argument
+  );
+
+/**
+  Run Procedure on one AP and wait for completion.
+
+  @param[in]  Mp               Initialized by ShellMpInitialize().
+  @param[in]  Procedure        Function to run on the AP.
+  @param[in]  ProcessorNumber  Target processor; must not be the BSP.
+  @param[in]  Argument         Parameter passed to Procedure.
+
+  @retval EFI_SUCCESS  The AP has finished Procedure.
+  @retval Others       The AP could not be started.
+**/
+EFI_STATUS
+ShellMpStartupThisAP (
+  IN SHELL_MP          *Mp,
+  IN EFI_AP_PROCEDURE  Procedure,
+  IN UINTN             ProcessorNumber,
+  IN VOID              *Argument
+  );
+
+/**
+  Allocate a zeroed buffer from the memory services of the current phase.
+
+  @param[in]  Size  Number of bytes to allocate.
+
+  @return Pointer to the buffer, or NULL if no memory services are available.
+**/
+VOID *
+ShellAllocateZeroPool (
+  IN UINTN  Size
+  );
+
+/**
+  Free a buffer returned by ShellAllocateZeroPool().
+
+  @param[in]  Buffer  Buffer to free.
+**/
+VOID
+ShellFreePool (
+  IN VOID  *Buffer
+  );
+
+/**
+  Find the first EFI_SECTION_RAW section of an FFS file in any firmware
+  volume.  In PEI a file of type EFI_FV_FILETYPE_RAW is returned as a whole.
+
+  @param[in]  FileName  FFS file name.
+  @param[out] Data      Section data.  Release with ShellFreeRawSection().
+  @param[out] Size      Section data size in bytes.
+
+  @retval RETURN_SUCCESS      The section was found.
+  @retval RETURN_NOT_FOUND    No such file or section.
+  @retval RETURN_UNSUPPORTED  The library instance cannot read firmware volumes.
+**/
+RETURN_STATUS
+ShellFindRawSection (
+  IN  CONST GUID  *FileName,
+  OUT VOID        **Data,
+  OUT UINTN       *Size
+  );
+
+/**
+  Release section data returned by ShellFindRawSection().
+
+  @param[in]  Data  Section data.
+**/
+VOID
+ShellFreeRawSection (
+  IN VOID  *Data
+  );
+
+/*
+  Batch execution, repeat and watch (DebugShellScript.c)
+*/
+
+/**
+  Handle the "repeat" and "watch" prefixes and run the command after them.
+
+  @param[in]  Ctx   Shell context.
+  @param[in]  Argc  Argument count.
+  @param[in]  Argv  Argument array, starting with "repeat" or "watch".
+
+  @retval RETURN_SUCCESS  All runs of the command completed.
+  @retval Others          Status of the first failing run.
+**/
+RETURN_STATUS
+CmdLoop (
+  IN SHELL_CONTEXT  *Ctx,
+  IN UINTN          Argc,
+  IN CHAR8          *Argv[]
+  );
+
+/**
+  Handle "script" command to run a command script stored in memory.
+
+  @param[in]  Ctx   Shell context.
+  @param[in]  Argc  Argument count.
+  @param[in]  Argv  Argument array.
+
+  @retval RETURN_SUCCESS            The script has been run.
+  @retval RETURN_INVALID_PARAMETER  The arguments are malformed.
+**/
+RETURN_STATUS
+CmdScript (
+  IN SHELL_CONTEXT  *Ctx,
+  IN UINTN          Argc,
+  IN CHAR8          *Argv[]
+  );
+
+/*
+  MSR commands (DebugShellMsr.c)
+*/
+
+/**
+  Handle "readmsr" command to read a 64-bit MSR.
+
+  @param[in]  Ctx   Shell context.
+  @param[in]  Argc  Argument count.
+  @param[in]  Argv  Argument array.
+
+  @retval RETURN_SUCCESS            The command completed.
+  @retval RETURN_INVALID_PARAMETER  The arguments are malformed.
+**/
+RETURN_STATUS
+CmdReadMsr (
+  IN SHELL_CONTEXT  *Ctx,
+  IN UINTN          Argc,
+  IN CHAR8          *Argv[]
+  );
+
+/**
+  Handle "writemsr" command to write a 64-bit MSR.
+
+  @param[in]  Ctx   Shell context.
+  @param[in]  Argc  Argument count.
+  @param[in]  Argv  Argument array.
+
+  @retval RETURN_SUCCESS            The command completed.
+  @retval RETURN_INVALID_PARAMETER  The arguments are malformed.
+**/
+RETURN_STATUS
+CmdWriteMsr (
+  IN SHELL_CONTEXT  *Ctx,
+  IN UINTN          Argc,
+  IN CHAR8          *Argv[]
+  );
+
+/*
+  Register and memory access commands (DebugShellDump.c)
+*/
+
+/**
+  Handle "dump" command to hex dump a range of system memory.
+
+  @param[in]  Ctx   Shell context.
+  @param[in]  Argc  Argument count.
+  @param[in]  Argv  Argument array.
+
+  @retval RETURN_SUCCESS            The command completed.
+  @retval RETURN_INVALID_PARAMETER  The arguments are malformed.
+**/
+RETURN_STATUS
+CmdDump (
+  IN SHELL_CONTEXT  *Ctx,
+  IN UINTN          Argc,
+  IN CHAR8          *Argv[]
+  );
+
+/**
+  Handle "mmio" command to read or write memory mapped registers.
+
+  @param[in]  Ctx   Shell context.
+  @param[in]  Argc  Argument count.
+  @param[in]  Argv  Argument array.
+
+  @retval RETURN_SUCCESS            The command completed.
+  @retval RETURN_INVALID_PARAMETER  The arguments are malformed.
+**/
+RETURN_STATUS
+CmdMmio (
+  IN SHELL_CONTEXT  *Ctx,
+  IN UINTN          Argc,
+  IN CHAR8          *Argv[]
+  );
+
+/**
+  Handle "io" command to read or write I/O ports.
+
+  @param[in]  Ctx   Shell context.
+  @param[in]  Argc  Argument count.
+  @param[in]  Argv  Argument array.
+
+  @retval RETURN_SUCCESS            The command completed.
+  @retval RETURN_INVALID_PARAMETER  The arguments are malformed.
+**/
+RETURN_STATUS
+CmdIo (
+  IN SHELL_CONTEXT  *Ctx,
+  IN UINTN          Argc,
+  IN CHAR8          *Argv[]
+  );
+
+/**
+  Handle "pci" command to read or write PCI configuration space.
+
+  @param[in]  Ctx   Shell context.
+  @param[in]  Argc  Argument count.
+  @param[in]  Argv  Argument array.
+
+  @retval RETURN_SUCCESS            The command completed.
+  @retval RETURN_INVALID_PARAMETER  The arguments are malformed.
+**/
+RETURN_STATUS
+CmdPci (
+  IN SHELL_CONTEXT  *Ctx,
+  IN UINTN          Argc,
+  IN CHAR8          *Argv[]
+  );
+
+/**
+  Handle "bindump" command to transfer a memory range as binary frames.
+
+  @param[in]  Ctx   Shell context.
+  @param[in]  Argc  Argument count.
+  @param[in]  Argv  Argument array.
+
+  @retval RETURN_SUCCESS            The command completed.
+  @retval RETURN_INVALID_PARAMETER  The arguments are malformed.
+**/
+RETURN_STATUS
+CmdBinDump (
+  IN SHELL_CONTEXT  *Ctx,
+  IN UINTN          Argc,
+  IN CHAR8          *Argv[]
+  );
+
+#endif  // DEBUG_SHELL_LIB_INTERNAL_H_
@@ -0,0 +1,454 @@
+/** @file
+  Debug Shell MSR commands, executed on the BSP, on one processor or on all
+  processors at once.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Library/BaseMemoryLib.h>
+#include "DebugShellLibInternal.h"
+
+//
+// Processor selector values meaning "every processor" and "no selector
+// given".  The latter runs on the BSP and keeps the single-CPU output format
+// of the commands without a selector.
+//
+#define SHELL_MSR_ALL_CPUS     MAX_UINTN
+#define SHELL_MSR_DEFAULT_CPU  (MAX_UINTN - 1)
+
+typedef struct {
+  UINT64   Value;   ///< MSR value read on the processor, if Read is set.
+  BOOLEAN  Done;    ///< TRUE once the processor has run the access.
+} SHELL_MSR_RESULT;
+
+typedef struct {
+  SHELL_MP          *Mp;
+  UINT32            Index;
+  BOOLEAN           Write;
+  BOOLEAN           Read;         ///< Read the MSR, after the write if any.
+  UINT64            Value;
+  UINTN             FirstCpu;     ///< Processor number of Results[0].
+  UINTN             ResultCount;  ///< Number of entries in Results.
+  SHELL_MSR_RESULT  *Results;
+} SHELL_MSR_CONTEXT;
+
+/**
+  Perform the MSR access on the calling processor and record the result in
+  the slot of that processor.  Runs on the BSP and, concurrently, on the APs.
+
+  A write is not read back unless asked for: write-only MSRs such as
+  PRED_CMD, FLUSH_CMD or the x2APIC EOI and ICR raise #GP on a read.
+
+  @param[in,out]  Buffer  Pointer to SHELL_MSR_CONTEXT.
+**/
+STATIC VOID
+EFIAPI
+ShellMsrProcedure (
+  IN OUT VOID  *Buffer
+  )
+{
+  SHELL_MSR_CONTEXT  *Context;
+  UINTN              Cpu;
+
+  Context = (SHELL_MSR_CONTEXT *)Buffer;
+  Cpu     = ShellMpWhoAmI (Context->Mp);
+  if ((Cpu < Context->FirstCpu) || (Cpu - Context->FirstCpu >= Context->ResultCount)) {
+    return;
+  }
+
+  Cpu -= Context->FirstCpu;
+
+  if (Context->Write) {
+    AsmWriteMsr64 (Context->Index, Context->Value);
+  }
+
+  if (Context->Read) {
+    Context->Results[Cpu].Value = AsmReadMsr64 (Context->Index);
+  }
+
+  Context->Results[Cpu].Done = TRUE;
+}
+
+/**
+  Parse "[-a | -p <cpu>] [-r] <index>" at the start of an MSR command line.
+
+  @param[in]  Argc      Argument count.
+  @param[in]  Argv      Argument array.
+  @param[out] Cpu       Selected processor number, SHELL_MSR_ALL_CPUS for -a,
+                        or SHELL_MSR_DEFAULT_CPU when no selector is given.
+  @param[out] ReadBack  Set to TRUE by -r; NULL if -r is not accepted.
+  @param[out] Index     Parsed MSR index.
+  @param[out] NextArg   Index in Argv of the argument following the MSR index.
+  @param[out] Mp        Initialized multi-processor services.
+
+  @retval TRUE   Arguments parsed.
+  @retval FALSE  Arguments are malformed; an error message has been printed.
+**/
+STATIC BOOLEAN
+ShellMsrParseTarget (
+  IN  UINTN     Argc,
+  IN  CHAR8     *Argv[],
+  OUT UINTN     *Cpu,
+  OUT BOOLEAN   *ReadBack  OPTIONAL,
+  OUT UINT32    *Index,
+  OUT UINTN     *NextArg,
+  OUT SHELL_MP  *Mp
+  )
+{
+  UINTN   Arg;
+  UINT64  Value;
+
+  if (EFI_ERROR (ShellMpInitialize (Mp))) {
+    ShellPrint ("Error: failed to query the processors\r\n");
+    return FALSE;
+  }
+
+  *Cpu = SHELL_MSR_DEFAULT_CPU;
+  if (ReadBack != NULL) {
+    *ReadBack = FALSE;
+  }
+
+  for (Arg = 1; (Arg < Argc) && (Argv[Arg][0] == '-'); Arg++) {
+    if (AsciiStrCmp (Argv[Arg], "-a") == 0) {
+      *Cpu = SHELL_MSR_ALL_CPUS;
+    } else if (AsciiStrCmp (Argv[Arg], "-p") == 0) {
+      if (Arg + 1 >= Argc) {
+        ShellPrintArgError ("missing value for option", Argv[Arg]);
+        return FALSE;
+      }
+
+      if (!ShellParseHex64 (Argv[Arg + 1], &Value) || (Value >= Mp->NumberOfProcessors)) {
+        ShellPrintArgError ("invalid processor number", Argv[Arg + 1]);
+        return FALSE;
+      }
+
+      *Cpu = (UINTN)Value;
+      Arg++;
+    } else if ((ReadBack != NULL) && (AsciiStrCmp (Argv[Arg], "-r") == 0)) {
+      *ReadBack = TRUE;
+    } else {
+      ShellPrintArgError ("unknown option", Argv[Arg]);
+      return FALSE;
+    }
+  }
+
+  if (Arg >= Argc) {
+    return FALSE;
+  }
+
+  if (!ShellParseHex64 (Argv[Arg], &Value) || (Value > MAX_UINT32)) {
+    ShellPrintArgError ("invalid MSR index", Argv[Arg]);
+    return FALSE;
+  }
+
+  *Index   = (UINT32)Value;
+  *NextArg = Arg + 1;
+  return TRUE;
+}
+
+/**
+  Print one "CPU[<n>] MSR[<index>] = <value>" line with a single serial write,
+  or "CPU[<n>] MSR[<index>] written" for a write that is not read back.
+  Machine responses get "cpu.<n>=<value>" instead, and nothing for a
+  processor that did not run the access or for a write without a read.
+
+  @param[in]  Ctx     Shell context.
+  @param[in]  Cpu     Processor number.
+  @param[in]  Index   MSR index.
+  @param[in]  Result  Result recorded for the processor.
+  @param[in]  Read    TRUE if the MSR was read.
+  @param[in]  IsBsp   TRUE if Cpu is the BSP.
+**/
+STATIC VOID
+ShellMsrPrintResult (
+  IN SHELL_CONTEXT     *Ctx,
+  IN UINTN             Cpu,
+  IN UINT32            Index,
+  IN SHELL_MSR_RESULT  *Result,
+  IN BOOLEAN           Read,
+  IN BOOLEAN           IsBsp
+  )
+{
+  CHAR8  Line[64];
+  CHAR8  *Ptr;
+
+  if (Ctx->Machine) {
+    if (Result->Done && Read) {
+      CopyMem (Line, "cpu.", 4);
+      Ptr  = ShellFormatHex (&Line[4], Cpu, 4);
+      *Ptr = '\0';
+      ShellPrintKeyHex (Line, Result->Value, 16);
+    }
+
+    return;
+  }
+
+  Ptr = Line;
+  CopyMem (Ptr, "CPU[", 4);
+  Ptr = ShellFormatHex (Ptr + 4, Cpu, 4);
+  CopyMem (Ptr, "] MSR[", 6);
+  Ptr = ShellFormatHex (Ptr + 6, Index, 8);
+  if (!Result->Done) {
+    CopyMem (Ptr, "] not run", 9);
+    Ptr += 9;
+  } else if (Read) {
+    CopyMem (Ptr, "] = 0x", 6);
+    Ptr = ShellFormatHex (Ptr + 6, Result->Value, 16);
+  } else {
+    CopyMem (Ptr, "] written", 9);
+    Ptr += 9;
+  }
+
+  if (IsBsp) {
+    CopyMem (Ptr, " (BSP)", 6);
+    Ptr += 6;
+  }
+
+  *Ptr++ = '\r';
+  *Ptr++ = '\n';
+  SerialPortWrite ((UINT8 *)Line, (UINTN)(Ptr - Line));
+}
+
+/**
+  Run an MSR access on the selected processors and print the per-processor
+  results in one pass.
+
+  With SHELL_MSR_ALL_CPUS all APs are started concurrently and the BSP does
+  its own access as soon as they have finished.  A summary line reports
+  whether all processors returned the same value.
+
+  @param[in]  Ctx    Shell context.
+  @param[in]  Mp     Initialized multi-processor services.
+  @param[in]  Cpu    Target processor number, SHELL_MSR_ALL_CPUS or
+                     SHELL_MSR_DEFAULT_CPU.
+  @param[in]  Index  MSR index.
+  @param[in]  Write  TRUE to write Value.
+  @param[in]  Read   TRUE to read the MSR, after the write if any.
+  @param[in]  Value  Value to write.
+
+  @retval RETURN_SUCCESS           All selected processors ran the access.
+  @retval RETURN_OUT_OF_RESOURCES  No memory for the per-processor results.
+  @retval RETURN_DEVICE_ERROR      Some processors did not run the access.
+**/
+STATIC RETURN_STATUS
+ShellMsrRun (
+  IN SHELL_CONTEXT  *Ctx,
+  IN SHELL_MP       *Mp,
+  IN UINTN          Cpu,
+  IN UINT32         Index,
+  IN BOOLEAN        Write,
+  IN BOOLEAN        Read,
+  IN UINT64         Value
+  )
+{
+  SHELL_MSR_CONTEXT  Context;
+  SHELL_MSR_RESULT   Single;
+  EFI_STATUS         Status;
+  UINTN              Number;
+  UINTN              Done;
+  UINT64             First;
+  BOOLEAN            Same;
+  BOOLEAN            Default;
+  CHAR8              Line[48];
+  CHAR8              *Ptr;
+
+  Context.Mp    = Mp;
+  Context.Index = Index;
+  Context.Write = Write;
+  Context.Read  = Read;
+  Context.Value = Value;
+
+  Default = (BOOLEAN)(Cpu == SHELL_MSR_DEFAULT_CPU);
+  if (Default) {
+    Cpu = Mp->BspNumber;
+  }
+
+  //
+  // Only the all-processor case needs a result slot per processor.  Keep the
+  // single processor case on the stack so it also works without a memory
+  // allocator.
+  //
+  ZeroMem (&Single, sizeof (Single));
+  Context.Results     = &Single;
+  Context.ResultCount = 1;
+  Context.FirstCpu    = Cpu;
+
+  if (Cpu == SHELL_MSR_ALL_CPUS) {
+    Context.FirstCpu = 0;
+    if (Mp->NumberOfProcessors > 1) {
+      Context.Results = ShellAllocateZeroPool (Mp->NumberOfProcessors * sizeof (SHELL_MSR_RESULT));
+      if (Context.Results == NULL) {
+        ShellPrint ("Error: out of memory\r\n");
+        return RETURN_OUT_OF_RESOURCES;
+      }
+
+      Context.ResultCount = Mp->NumberOfProcessors;
+    }
+
+    Status = ShellMpStartupAllAPs (Mp, ShellMsrProcedure, &Context);
+    ShellMsrProcedure (&Context);
+    if (Status == EFI_NOT_STARTED) {
+      Status = EFI_SUCCESS;
+    }
+  } else if (Cpu == Mp->BspNumber) {
+    ShellMsrProcedure (&Context);
+    Status = EFI_SUCCESS;
+  } else {
+    Status = ShellMpStartupThisAP (Mp, ShellMsrProcedure, Cpu, &Context);
+  }
+
+  if (EFI_ERROR (Status)) {
+    ShellPrint ("Error: failed to start the application processors\r\n");
+  }
+
+  //
+  // Without a selector keep the original "MSR[<index>] = <value>" and
+  // "MSR[<index>] <- <value> (written)" lines, which logs are parsed for.
+  //
+  if (Default && !Ctx->Machine) {
+    if (Write) {
+      ShellPrint ("MSR[");
+      ShellPrintHex64 (Index);
+      ShellPrint ("] <- ");
+      ShellPrintHex64 (Value);
+      ShellPrint (" (written)\r\n");
+    }
+
+    if (Read) {
+      ShellPrint ("MSR[");
+      ShellPrintHex64 (Index);
+      ShellPrint ("] = ");
+      ShellPrintHex64 (Single.Value);
+      ShellPrint ("\r\n");
+    }
+
+    return RETURN_SUCCESS;
+  }
+
+  if (Cpu != SHELL_MSR_ALL_CPUS) {
+    ShellMsrPrintResult (Ctx, Cpu, Index, &Single, Read, (BOOLEAN)(Cpu == Mp->BspNumber));
+    return Single.Done ? RETURN_SUCCESS : RETURN_DEVICE_ERROR;
+  }
+
+  Done  = 0;
+  First = 0;
+  Same  = TRUE;
+  for (Number = 0; Number < Context.ResultCount; Number++) {
+    ShellMsrPrintResult (Ctx, Number, Index, &Context.Results[Number], Read, (BOOLEAN)(Number == Mp->BspNumber));
+    if (Context.Results[Number].Done) {
+      if (Done == 0) {
+        First = Context.Results[Number].Value;
+      } else if (Context.Results[Number].Value != First) {
+        Same = FALSE;
+      }
+
+      Done++;
+    }
+  }
+
+  if (Context.Results != &Single) {
+    ShellFreePool (Context.Results);
+  }
+
+  if (Ctx->Machine) {
+    ShellPrintKeyHex ("responded", Done, 4);
+    if (Read) {
+      ShellPrintKeyHex ("consistent", Same ? 1 : 0, 1);
+    }
+
+    return (Done == Mp->NumberOfProcessors) ? RETURN_SUCCESS : RETURN_DEVICE_ERROR;
+  }
+
+  Ptr = Line;
+  if (!Read) {
+    CopyMem (Ptr, "Written on ", 11);
+    Ptr += 11;
+  } else if (Same) {
+    CopyMem (Ptr, "Consistent on ", 14);
+    Ptr += 14;
+  } else {
+    CopyMem (Ptr, "MISMATCH across ", 16);
+    Ptr += 16;
+  }
+
+  Ptr = ShellFormatHex (Ptr, Done, 4);
+  CopyMem (Ptr, " of ", 4);
+  Ptr = ShellFormatHex (Ptr + 4, Mp->NumberOfProcessors, 4);
+  CopyMem (Ptr, " CPUs\r\n", 7);
+  SerialPortWrite ((UINT8 *)Line, (UINTN)(Ptr + 7 - Line));
+  return (Done == Mp->NumberOfProcessors) ? RETURN_SUCCESS : RETURN_DEVICE_ERROR;
+}
+
+/**
+  Handle "readmsr" command to read a 64-bit MSR.
+
+  @param[in]  Ctx   Shell context.
+  @param[in]  Argc  Argument count.
+  @param[in]  Argv  Argument array.
+
+  @retval RETURN_SUCCESS            The command completed.
+  @retval RETURN_INVALID_PARAMETER  The arguments are malformed.
+**/
+RETURN_STATUS
+CmdReadMsr (
+  IN SHELL_CONTEXT  *Ctx,
+  IN UINTN          Argc,
+  IN CHAR8          *Argv[]
+  )
+{
+  SHELL_MP  Mp;
+  UINTN     Cpu;
+  UINT32    Index;
+  UINTN     NextArg;
+
+  if (!ShellMsrParseTarget (Argc, Argv, &Cpu, NULL, &Index, &NextArg, &Mp) || (NextArg != Argc)) {
+    ShellPrint ("Usage: readmsr [-a | -p <cpu_hex>] <index_hex>\r\n");
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  return ShellMsrRun (Ctx, &Mp, Cpu, Index, FALSE, TRUE, 0);
+}
+
+/**
+  Handle "writemsr" command to write a 64-bit MSR.
+
+  @param[in]  Ctx   Shell context.
+  @param[in]  Argc  Argument count.
+  @param[in]  Argv  Argument array.
+
+  @retval RETURN_SUCCESS            The command completed.
+  @retval RETURN_INVALID_PARAMETER  The arguments are malformed.
+**/
+RETURN_STATUS
+CmdWriteMsr (
+  IN SHELL_CONTEXT  *Ctx,
+  IN UINTN          Argc,
+  IN CHAR8          *Argv[]
+  )
+{
+  SHELL_MP  Mp;
+  UINTN     Cpu;
+  UINT32    Index;
+  UINTN     NextArg;
+  UINT64    Value;
+  BOOLEAN   ReadBack;
+
+  if (!ShellMsrParseTarget (Argc, Argv, &Cpu, &ReadBack, &Index, &NextArg, &Mp) || (NextArg + 1 != Argc)) {
+    ShellPrint ("Usage: writemsr [-a | -p <cpu_hex>] [-r] <index_hex> <value_hex>\r\n");
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (!ShellParseHex64 (Argv[NextArg], &Value)) {
+    ShellPrintArgError ("invalid value", Argv[NextArg]);
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  return ShellMsrRun (Ctx, &Mp, Cpu, Index, TRUE, ReadBack, Value);
+}
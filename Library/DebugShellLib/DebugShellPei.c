@@ -0,0 +1,268 @@
+/** @file
+  Debug Shell boot phase services for the PEI library instance.
+
+  Processors are reached through EDKII_PEI_MP_SERVICES2_PPI and scripts are
+  read from the firmware volumes published to the PEI Foundation.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include "DebugShellLibInternal.h"
+#include <Ppi/EdkiiMpServices2.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PeiServicesLib.h>
+
+/**
+  Locate the multi-processor services of the current boot phase.
+
+  When the MP PPI has not been installed yet Mp describes the BSP only.
+
+  @param[out] Mp  Filled with the services and processor counts.
+
+  @retval EFI_SUCCESS  Mp has been initialized.
+  @retval Others       The MP PPI failed to report the processor count.
+**/
+EFI_STATUS
+ShellMpInitialize (
+  OUT SHELL_MP  *Mp
+  )
+{
+  EFI_STATUS                   Status;
+  EDKII_PEI_MP_SERVICES2_PPI   *MpServices;
+  UINTN                        NumberOfProcessors;
+  UINTN                        NumberOfEnabledProcessors;
+
+  Mp->Services           = NULL;
+  Mp->NumberOfProcessors = 1;
+  Mp->BspNumber          = 0;
+
+  Status = PeiServicesLocatePpi (&gEdkiiPeiMpServices2PpiGuid, 0, NULL, (VOID **)&MpServices);
+  if (EFI_ERROR (Status)) {
+    return EFI_SUCCESS;
+  }
+
+  Status = MpServices->GetNumberOfProcessors (MpServices, &NumberOfProcessors, &NumberOfEnabledProcessors);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = MpServices->WhoAmI (MpServices, &Mp->BspNumber);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Mp->Services           = MpServices;
+  Mp->NumberOfProcessors = NumberOfProcessors;
+  return EFI_SUCCESS;
+}
+
+/**
+  Return the processor number of the caller.  May be called on any processor.
+
+  @param[in]  Mp  Initialized by ShellMpInitialize().
+
+  @return Processor number of the calling processor.
+**/
+UINTN
+ShellMpWhoAmI (
+  IN SHELL_MP  *Mp
+  )
+{
+  EDKII_PEI_MP_SERVICES2_PPI  *MpServices;
+  UINTN                       ProcessorNumber;
+
+  MpServices = (EDKII_PEI_MP_SERVICES2_PPI *)Mp->Services;
+  if ((MpServices == NULL) || EFI_ERROR (MpServices->WhoAmI (MpServices, &ProcessorNumber))) {
+    return Mp->BspNumber;
+  }
+
+  return ProcessorNumber;
+}
+
+/**
+  Run Procedure on all enabled APs concurrently and wait for completion.
+
+  @param[in]  Mp         Initialized by ShellMpInitialize().
+  @param[in]  Procedure  Function to run on each AP.
+  @param[in]  Argument   Parameter passed to Procedure.
+
+  @retval EFI_SUCCESS      All enabled APs have finished Procedure.
+  @retval EFI_NOT_STARTED  There is no enabled AP.
+  @retval Others           The APs could not be started.
+**/
+EFI_STATUS
+ShellMpStartupAllAPs (
+  IN SHELL_MP          *Mp,
+  IN EFI_AP_PROCEDURE  Procedure,
+  IN VOID              *Argument
+  )
+{
+  EDKII_PEI_MP_SERVICES2_PPI  *MpServices;
+
+  MpServices = (EDKII_PEI_MP_SERVICES2_PPI *)Mp->Services;
+  if (MpServices == NULL) {
+    return EFI_NOT_STARTED;
+  }
+
+  return MpServices->StartupAllAPs (MpServices, Procedure, FALSE, 0, Argument);
+}
+
+/**
+  Run Procedure on one AP and wait for completion.
+
+  @param[in]  Mp               Initialized by ShellMpInitialize().
+  @param[in]  Procedure        Function to run on the AP.
+  @param[in]  ProcessorNumber  Target processor; must not be the BSP.
+  @param[in]  Argument         Parameter passed to Procedure.
+
+  @retval EFI_SUCCESS      The AP has finished Procedure.
+  @retval EFI_UNSUPPORTED  The MP PPI is not available.
+  @retval Others           The AP could not be started.
+**/
+EFI_STATUS
+ShellMpStartupThisAP (
+  IN SHELL_MP          *Mp,
+  IN EFI_AP_PROCEDURE  Procedure,
+  IN UINTN             ProcessorNumber,
+  IN VOID              *Argument
+  )
+{
+  EDKII_PEI_MP_SERVICES2_PPI  *MpServices;
+
+  MpServices = (EDKII_PEI_MP_SERVICES2_PPI *)Mp->Services;
+  if (MpServices == NULL) {
+    return EFI_UNSUPPORTED;
+  }
+
+  return MpServices->StartupThisAP (MpServices, Procedure, ProcessorNumber, 0, Argument);
+}
+
+/**
+  Allocate a zeroed buffer from the PEI memory services.
+
+  @param[in]  Size  Number of bytes to allocate.
+
+  @return Pointer to the buffer, or NULL if the PEI heap is exhausted.
+**/
+VOID *
+ShellAllocateZeroPool (
+  IN UINTN  Size
+  )
+{
+  return AllocateZeroPool (Size);
+}
+
+/**
+  Free a buffer returned by ShellAllocateZeroPool().
+
+  @param[in]  Buffer  Buffer to free.
+**/
+VOID
+ShellFreePool (
+  IN VOID  *Buffer
+  )
+{
+  FreePool (Buffer);
+}
+
+/**
+  Find the first EFI_SECTION_RAW section of an FFS file in any firmware
+  volume.  A file of type EFI_FV_FILETYPE_RAW is returned as a whole.
+
+  The section is looked up by the PEI Foundation, so it is also found inside
+  encapsulation sections such as compressed or GUID-defined ones.  The data
+  is returned in place or in a buffer the PEI Foundation extracted it to, so
+  it is only valid while the firmware volume stays mapped.
+
+  @param[in]  FileName  FFS file name.
+  @param[out] Data      Section data.  Release with ShellFreeRawSection().
+  @param[out] Size      Section data size in bytes.
+
+  @retval RETURN_SUCCESS    The section was found.
+  @retval RETURN_NOT_FOUND  No such file or section.
+**/
+RETURN_STATUS
+ShellFindRawSection (
+  IN  CONST GUID  *FileName,
+  OUT VOID        **Data,
+  OUT UINTN       *Size
+  )
+{
+  EFI_STATUS                  Status;
+  UINTN                       Instance;
+  EFI_PEI_FV_HANDLE           VolumeHandle;
+  EFI_PEI_FILE_HANDLE         FileHandle;
+  EFI_FV_FILE_INFO            FileInfo;
+  EFI_COMMON_SECTION_HEADER   *Section;
+  EFI_COMMON_SECTION_HEADER2  *Section2;
+  VOID                        *SectionData;
+
+  for (Instance = 0; ; Instance++) {
+    Status = PeiServicesFfsFindNextVolume (Instance, &VolumeHandle);
+    if (EFI_ERROR (Status)) {
+      return RETURN_NOT_FOUND;
+    }
+
+    Status = PeiServicesFfsFindFileByName (FileName, VolumeHandle, &FileHandle);
+    if (!EFI_ERROR (Status)) {
+      break;
+    }
+  }
+
+  Status = PeiServicesFfsGetFileInfo (FileHandle, &FileInfo);
+  if (EFI_ERROR (Status)) {
+    return RETURN_NOT_FOUND;
+  }
+
+  if (FileInfo.FileType == EFI_FV_FILETYPE_RAW) {
+    *Data = FileInfo.Buffer;
+    *Size = FileInfo.BufferSize;
+    return RETURN_SUCCESS;
+  }
+
+  Status = PeiServicesFfsFindSectionData (EFI_SECTION_RAW, FileHandle, &SectionData);
+  if (EFI_ERROR (Status)) {
+    return RETURN_NOT_FOUND;
+  }
+
+  //
+  // The section data follows its header.  A 4-byte header is checked first:
+  // in front of the data of a large section sits the extended size instead,
+  // whose top byte could only read as EFI_SECTION_RAW for a section of more
+  // than 400MB.
+  //
+  Section = (EFI_COMMON_SECTION_HEADER *)SectionData - 1;
+  if ((Section->Type == EFI_SECTION_RAW) && !IS_SECTION2 (Section)) {
+    *Size = SECTION_SIZE (Section) - sizeof (EFI_COMMON_SECTION_HEADER);
+  } else {
+    Section2 = (EFI_COMMON_SECTION_HEADER2 *)SectionData - 1;
+    if (!IS_SECTION2 (Section2) || (Section2->Type != EFI_SECTION_RAW)) {
+      return RETURN_NOT_FOUND;
+    }
+
+    *Size = SECTION2_SIZE (Section2) - sizeof (EFI_COMMON_SECTION_HEADER2);
+  }
+
+  *Data = SectionData;
+  return RETURN_SUCCESS;
+}
+
+/**
+  Release section data returned by ShellFindRawSection().
+
+  @param[in]  Data  Section data; it lives in the firmware volume, so there
+                    is nothing to free.
+**/
+VOID
+ShellFreeRawSection (
+  IN VOID  *Data
+  )
+{
+}
@@ -0,0 +1,456 @@
+/** @file
+  Debug Shell batch execution and the "repeat" / "watch" command prefixes.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Library/BaseMemoryLib.h>
+#include "DebugShellLibInternal.h"
+
+//
+// Longest busy wait between two reads of the performance counter.  Keeps a
+// fast wrapping counter (e.g. the 24-bit ACPI timer) from wrapping unseen
+// and lets a key press stop "watch" promptly.
+//
+#define SHELL_WAIT_SLICE_US  1000
+
+//
+// Keys that stop "watch".
+//
+#define SHELL_KEY_CTRL_C     0x03
+#define SHELL_KEY_ESC        0x1B
+
+//
+// Elapsed time tracker that survives performance counter wrap-around as
+// long as it is updated at least once per counter period.
+//
+typedef struct {
+  UINT64   CounterStart;
+  UINT64   CounterEnd;
+  UINT64   Last;
+  UINT64   Ticks;
+} SHELL_CLOCK;
+
+/**
+  Start a clock at the current performance counter value.
+
+  @param[out] Clock  Clock to start.
+**/
+STATIC VOID
+ShellClockStart (
+  OUT SHELL_CLOCK  *Clock
+  )
+{
+  GetPerformanceCounterProperties (&Clock->CounterStart, &Clock->CounterEnd);
+  Clock->Last  = GetPerformanceCounter ();
+  Clock->Ticks = 0;
+}
+
+/**
+  Return the nanoseconds elapsed since ShellClockStart().
+
+  @param[in,out] Clock  Started clock.
+
+  @return Elapsed time in nanoseconds.
+**/
+STATIC UINT64
+ShellClockElapsedNs (
+  IN OUT SHELL_CLOCK  *Clock
+  )
+{
+  UINT64  Now;
+
+  Now = GetPerformanceCounter ();
+  if (Clock->CounterEnd >= Clock->CounterStart) {
+    if (Now >= Clock->Last) {
+      Clock->Ticks += Now - Clock->Last;
+    } else {
+      Clock->Ticks += (Clock->CounterEnd - Clock->Last) + (Now - Clock->CounterStart) + 1;
+    }
+  } else {
+    if (Now <= Clock->Last) {
+      Clock->Ticks += Clock->Last - Now;
+    } else {
+      Clock->Ticks += (Clock->Last - Clock->CounterEnd) + (Clock->CounterStart - Now) + 1;
+    }
+  }
+
+  Clock->Last = Now;
+  return GetTimeInNanoSecond (Clock->Ticks);
+}
+
+/**
+  Print "[<seconds>.<microseconds>] " for a timestamp in nanoseconds, or a
+  "time=<nanoseconds>" line in a machine response.
+
+  @param[in]  Ctx          Shell context.
+  @param[in]  Nanoseconds  Timestamp to print.
+**/
+STATIC VOID
+ShellPrintTimestamp (
+  IN SHELL_CONTEXT  *Ctx,
+  IN UINT64         Nanoseconds
+  )
+{
+  CHAR8   Line[32];
+  CHAR8   *Ptr;
+  UINT32  Microseconds;
+  UINT64  Seconds;
+
+  if (Ctx->Machine) {
+    ShellPrintKeyHex ("time", Nanoseconds, 16);
+    return;
+  }
+
+  Seconds = DivU64x32Remainder (DivU64x32 (Nanoseconds, 1000), 1000000, &Microseconds);
+
+  Ptr    = Line;
+  *Ptr++ = '[';
+  Ptr    = ShellFormatDec (Ptr, Seconds, 5, ' ');
+  *Ptr++ = '.';
+  Ptr    = ShellFormatDec (Ptr, Microseconds, 6, '0');
+  *Ptr++ = ']';
+  *Ptr++ = ' ';
+  SerialPortWrite ((UINT8 *)Line, (UINTN)(Ptr - Line));
+}
+
+/**
+  Return TRUE if ESC or Ctrl-C has been typed on the serial port.
+
+  Serving a machine request nothing is read: the host may already have sent
+  its next request.  Any other byte is kept in Ctx for the next command line,
+  and no more input is read while it is held.
+
+  @param[in,out]  Ctx  Shell context.
+**/
+STATIC BOOLEAN
+ShellKeyPressed (
+  IN OUT SHELL_CONTEXT  *Ctx
+  )
+{
+  UINT8  Ch;
+
+  if (Ctx->Machine || Ctx->HasPending || !SerialPortPoll ()) {
+    return FALSE;
+  }
+
+  SerialPortRead (&Ch, 1);
+  if ((Ch == SHELL_KEY_ESC) || (Ch == SHELL_KEY_CTRL_C)) {
+    return TRUE;
+  }
+
+  Ctx->Pending    = Ch;
+  Ctx->HasPending = TRUE;
+  return FALSE;
+}
+
+/**
+  Handle the "repeat" and "watch" prefixes and run the command after them.
+
+    repeat <N> <command>   Run command N times back to back.
+    watch <ms> <command>   Run command every ms milliseconds, each run
+                           preceded by a timestamp, until ESC or Ctrl-C
+                           is typed.  A machine request is never stopped
+                           by a key, so it must give a repeat count.
+
+  The prefixes combine in any order, so "repeat N watch ms command" takes N
+  timestamped samples.  Samples are scheduled against the start time, not
+  the end of the previous run, so the sampling period does not drift with
+  the time the command itself takes.  The loop stops early when the
+  command fails or executes "exit".
+
+  @param[in]  Ctx   Shell context.
+  @param[in]  Argc  Argument count.
+  @param[in]  Argv  Argument array, starting with "repeat" or "watch".
+
+  @retval RETURN_SUCCESS  All runs of the command completed.
+  @retval Others          Status of the first failing run.
+**/
+RETURN_STATUS
+CmdLoop (
+  IN SHELL_CONTEXT  *Ctx,
+  IN UINTN          Argc,
+  IN CHAR8          *Argv[]
+  )
+{
+  UINTN          Arg;
+  UINT64         Value;
+  UINT64         Count;
+  UINT64         IntervalNs;
+  BOOLEAN        Watch;
+  UINT64         Iteration;
+  UINT64         DeadlineNs;
+  UINT64         NowNs;
+  SHELL_CLOCK    Clock;
+  RETURN_STATUS  Status;
+
+  Count      = 0;
+  IntervalNs = 0;
+  Watch      = FALSE;
+
+  for (Arg = 0; Arg + 1 < Argc; Arg += 2) {
+    if (AsciiStrCmp (Argv[Arg], "repeat") == 0) {
+      if (!ShellParseHex64 (Argv[Arg + 1], &Value) || (Value == 0)) {
+        ShellPrintArgError ("invalid repeat count", Argv[Arg + 1]);
+        return RETURN_INVALID_PARAMETER;
+      }
+
+      Count = Value;
+    } else if (AsciiStrCmp (Argv[Arg], "watch") == 0) {
+      if (!ShellParseHex64 (Argv[Arg + 1], &Value) || (Value > MAX_UINT32)) {
+        ShellPrintArgError ("invalid watch interval", Argv[Arg + 1]);
+        return RETURN_INVALID_PARAMETER;
+      }
+
+      IntervalNs = MultU64x32 (Value, 1000000);
+      Watch      = TRUE;
+    } else {
+      break;
+    }
+  }
+
+  if ((Arg >= Argc) || (AsciiStrCmp (Argv[Arg], "repeat") == 0) || (AsciiStrCmp (Argv[Arg], "watch") == 0)) {
+    ShellPrint ("Usage: repeat <count_hex> <command> | watch <ms_hex> <command>\r\n");
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  //
+  // Nothing stops a machine request once it runs, so it needs a count.
+  //
+  if (Ctx->Machine && (Count == 0)) {
+    ShellPrint ("Error: watch in a machine request needs a repeat count\r\n");
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  ShellClockStart (&Clock);
+  DeadlineNs = 0;
+
+  for (Iteration = 0; (Count == 0) || (Iteration < Count); Iteration++) {
+    if (Watch) {
+      ShellPrintTimestamp (Ctx, ShellClockElapsedNs (&Clock));
+    }
+
+    Status = ShellDispatchCommand (Ctx, Argc - Arg, &Argv[Arg]);
+    if (RETURN_ERROR (Status) || Ctx->Exit) {
+      return Status;
+    }
+
+    if (ShellKeyPressed (Ctx)) {
+      ShellPrint ("Stopped.\r\n");
+      break;
+    }
+
+    if ((Count != 0) && (Iteration + 1 == Count)) {
+      break;
+    }
+
+    //
+    // Wait for the next sample time in short slices.
+    //
+    DeadlineNs += IntervalNs;
+    for (NowNs = ShellClockElapsedNs (&Clock); NowNs < DeadlineNs; NowNs = ShellClockElapsedNs (&Clock)) {
+      if (ShellKeyPressed (Ctx)) {
+        ShellPrint ("Stopped.\r\n");
+        return RETURN_SUCCESS;
+      }
+
+      MicroSecondDelay ((UINTN)MIN (DivU64x32 (DeadlineNs - NowNs, 1000) + 1, SHELL_WAIT_SLICE_US));
+    }
+  }
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Run every line of a command script.
+
+  Lines end with LF or CR LF.  Empty lines and lines starting with '#' are
+  skipped.  Each executed line is echoed after a "script> " prompt so the
+  output log shows which command produced it.  Execution continues after
+  a failing line and stops when a line executes "exit".
+
+  @param[in,out] Ctx         Shell context.
+  @param[in]     Script      Script text; need not be NUL-terminated.
+  @param[in]     ScriptSize  Size of Script in bytes.
+**/
+STATIC VOID
+ShellRunScript (
+  IN OUT SHELL_CONTEXT  *Ctx,
+  IN     CONST CHAR8    *Script,
+  IN     UINTN          ScriptSize
+  )
+{
+  CHAR8        Line[SHELL_CMD_BUF_SIZE];
+  CONST CHAR8  *End;
+  CONST CHAR8  *Eol;
+  UINTN        Length;
+
+  End = Script + ScriptSize;
+  Ctx->ScriptDepth++;
+
+  while (Script < End) {
+    for (Eol = Script; (Eol < End) && (*Eol != '\n') && (*Eol != '\0'); Eol++) {
+    }
+
+    Length = (UINTN)(Eol - Script);
+    if ((Length > 0) && (Script[Length - 1] == '\r')) {
+      Length--;
+    }
+
+    while ((Length > 0) && ((*Script == ' ') || (*Script == '\t'))) {
+      Script++;
+      Length--;
+    }
+
+    if (Length >= sizeof (Line)) {
+      ShellPrint ("Error: script line too long, skipped\r\n");
+    } else if ((Length > 0) && (*Script != '#')) {
+      CopyMem (Line, Script, Length);
+      Line[Length] = '\0';
+
+      if (!Ctx->Machine) {
+        ShellPrint ("script> ");
+        ShellPrint (Line);
+        ShellPrint ("\r\n");
+      }
+
+      ShellProcessCommand (Ctx, Line);
+      if (Ctx->Exit) {
+        break;
+      }
+    }
+
+    if ((Eol < End) && (*Eol == '\0')) {
+      break;
+    }
+
+    Script = Eol + 1;
+  }
+
+  Ctx->ScriptDepth--;
+}
+
+/**
+  Handle "script" command to run a command script stored in memory.
+
+  @param[in]  Ctx   Shell context.
+  @param[in]  Argc  Argument count.
+  @param[in]  Argv  Argument array.
+
+  @retval RETURN_SUCCESS            The script has been run.
+  @retval RETURN_INVALID_PARAMETER  The arguments are invalid, or scripts are
+                                    nested more than SHELL_MAX_SCRIPT_DEPTH
+                                    deep.
+**/
+RETURN_STATUS
+CmdScript (
+  IN SHELL_CONTEXT  *Ctx,
+  IN UINTN          Argc,
+  IN CHAR8          *Argv[]
+  )
+{
+  UINT64  Address;
+  UINT64  Length;
+
+  if (Argc != 3) {
+    ShellPrint ("Usage: script <address_hex> <length_hex>\r\n");
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (!ShellParseHex64 (Argv[1], &Address)) {
+    ShellPrintArgError ("invalid address", Argv[1]);
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (!ShellParseHex64 (Argv[2], &Length) || (Length == 0) ||
+      (Address > MAX_ADDRESS) || (Length - 1 > MAX_ADDRESS - Address)) {
+    ShellPrintArgError ("invalid length", Argv[2]);
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (Ctx->ScriptDepth >= SHELL_MAX_SCRIPT_DEPTH) {
+    ShellPrint ("Error: scripts nested too deeply\r\n");
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  ShellRunScript (Ctx, (CONST CHAR8 *)(UINTN)Address, (UINTN)Length);
+  return RETURN_SUCCESS;
+}
+
+/*
+  Public API
+*/
+
+/**
+  Run a debug shell command script without user interaction.
+
+  @param[in]  Script      Script text, one command per line.
+  @param[in]  ScriptSize  Size of Script in bytes.
+
+  @retval TRUE   The script executed "exit".
+  @retval FALSE  The end of the script was reached.
+**/
+BOOLEAN
+EFIAPI
+RunDebugShellScript (
+  IN CONST CHAR8  *Script,
+  IN UINTN        ScriptSize
+  )
+{
+  SHELL_CONTEXT  Ctx;
+
+  if ((Script == NULL) || (ScriptSize == 0)) {
+    return FALSE;
+  }
+
+  Ctx.Machine     = FALSE;
+  Ctx.Exit        = FALSE;
+  Ctx.Sequence    = 0;
+  Ctx.HasPending  = FALSE;
+  Ctx.ScriptDepth = 0;
+  ShellRunScript (&Ctx, Script, ScriptSize);
+  return Ctx.Exit;
+}
+
+/**
+  Run the debug shell command script stored in the raw section of an FFS
+  file without user interaction.
+
+  @param[in]  FileName  Name of the FFS file holding the script.
+
+  @retval RETURN_SUCCESS      The script has been run.
+  @retval RETURN_NOT_FOUND    The file or its raw section was not found.
+  @retval RETURN_UNSUPPORTED  The library instance cannot read firmware volumes.
+**/
+RETURN_STATUS
+EFIAPI
+RunDebugShellScriptFromFv (
+  IN CONST GUID  *FileName
+  )
+{
+  RETURN_STATUS  Status;
+  SHELL_CONTEXT  Ctx;
+  VOID           *Data;
+  UINTN          Size;
+
+  Status = ShellFindRawSection (FileName, &Data, &Size);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  Ctx.Machine     = FALSE;
+  Ctx.Exit        = FALSE;
+  Ctx.Sequence    = 0;
+  Ctx.HasPending  = FALSE;
+  Ctx.ScriptDepth = 0;
+  ShellRunScript (&Ctx, (CONST CHAR8 *)Data, Size);
+  ShellFreeRawSection (Data);
+  return RETURN_SUCCESS;
+}
@@ -0,0 +1,1014 @@
+/** @file
+  File I/O library: chunked, optionally double buffered, file streams.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Uefi.h>
+#include <Guid/FileInfo.h>
+#include <Protocol/SimpleFileSystem.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/FileIoLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/ShellLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+#define FILE_IO_STREAM_SIGNATURE  SIGNATURE_32 ('F', 'I', 'O', 'S')
+
+typedef struct {
+  UINT8                *Data;
+  UINTN                Length;      // Reader: bytes read.  Writer: bytes filled.
+  EFI_FILE_IO_TOKEN    Token;
+  BOOLEAN              Pending;     // An asynchronous transfer is in flight
+} FILE_IO_BUFFER;
+
+struct _FILE_IO_STREAM {
+  UINT32               Signature;
+  SHELL_FILE_HANDLE    FileHandle;
+  BOOLEAN              Writer;
+  BOOLEAN              Async;       // Transfer with ReadEx/WriteEx
+  UINTN                ChunkSize;
+  UINTN                BufferCount; // 2 when double buffered
+  FILE_IO_BUFFER       Buffer[2];
+  UINTN                Current;     // The buffer the caller reads or fills
+  UINTN                Offset;      // Reader: bytes of the current buffer consumed
+  UINT64               Size;        // Reader: file size.  Writer: expected size.
+  UINT64               Position;    // Bytes requested from, or given to, the file
+  EFI_STATUS           Status;      // First error
+};
+
+/**
+  Start reading or writing a buffer, asynchronously if the stream can.
+
+  The Shell's file handles are EFI_FILE_PROTOCOL instances, so ReadEx and
+  WriteEx are called on them directly.  Only one transfer is in flight at a
+  time, which keeps the file position in order on every file system.
+
+  @param[in]  Stream    The stream.
+  @param[in]  Buffer    The buffer.
+  @param[in]  Length    Bytes to transfer.
+
+  @return The status of the stream.
+
+**/
+STATIC
+EFI_STATUS
+StartTransfer (
+  IN FILE_IO_STREAM     *Stream,
+  IN FILE_IO_BUFFER     *Buffer,
+  IN UINTN              Length
+  )
+{
+  EFI_STATUS           Status;
+  EFI_FILE_PROTOCOL    *File;
+  UINTN                Size;
+
+  if (EFI_ERROR (Stream->Status) || (Length == 0)) {
+    return Stream->Status;
+  }
+
+  if (Stream->Async) {
+    File = (EFI_FILE_PROTOCOL *) Stream->FileHandle;
+    Buffer->Token.Status     = EFI_SUCCESS;
+    Buffer->Token.BufferSize = Length;
+    Buffer->Token.Buffer     = Buffer->Data;
+    if (Stream->Writer) {
+      Status = File->WriteEx (File, &Buffer->Token);
+    } else {
+      Status = File->ReadEx (File, &Buffer->Token);
+    }
+    if (!EFI_ERROR (Status)) {
+      Buffer->Pending   = TRUE;
+      Stream->Position += Length;
+      return EFI_SUCCESS;
+    }
+    if (Status != EFI_UNSUPPORTED) {
+      Stream->Status = Status;
+      return Status;
+    }
+
+    //
+    // The file system has no asynchronous I/O; carry on synchronously.
+    //
+    Stream->Async = FALSE;
+  }
+
+  Size = Length;
+  if (Stream->Writer) {
+    Status = ShellWriteFile (Stream->FileHandle, &Size, Buffer->Data);
+    if (!EFI_ERROR (Status) && (Size != Length)) {
+      Status = EFI_VOLUME_FULL;
+    }
+  } else {
+    Status = ShellReadFile (Stream->FileHandle, &Size, Buffer->Data);
+    Buffer->Length = Size;
+  }
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: %r\n", __FUNCTION__, Status));
+    Stream->Status = Status;
+    return Status;
+  }
+
+  Stream->Position += Length;
+  return EFI_SUCCESS;
+}
+
+/**
+  Wait for the transfer of a buffer to complete.
+
+  @param[in]  Stream    The stream.
+  @param[in]  Buffer    The buffer.
+
+  @return The status of the stream.
+
+**/
+STATIC
+EFI_STATUS
+WaitTransfer (
+  IN FILE_IO_STREAM     *Stream,
+  IN FILE_IO_BUFFER     *Buffer
+  )
+{
+  UINTN                Index;
+
+  if (!Buffer->Pending) {
+    return Stream->Status;
+  }
+
+  gBS->WaitForEvent (1, &Buffer->Token.Event, &Index);
+  Buffer->Pending = FALSE;
+
+  if (EFI_ERROR (Buffer->Token.Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: %r\n", __FUNCTION__, Buffer->Token.Status));
+    if (!EFI_ERROR (Stream->Status)) {
+      Stream->Status = Buffer->Token.Status;
+    }
+  } else if (!Stream->Writer) {
+    Buffer->Length = Buffer->Token.BufferSize;
+  } else if ((Buffer->Token.BufferSize != Buffer->Length) && !EFI_ERROR (Stream->Status)) {
+    Stream->Status = EFI_VOLUME_FULL;
+  }
+
+  return Stream->Status;
+}
+
+/**
+  Start reading the next chunk of the file into a reader's buffer.
+
+  @param[in]  Stream    The reader.
+  @param[in]  Buffer    The buffer, not in use.
+
+  @return The status of the stream.
+
+**/
+STATIC
+EFI_STATUS
+FillBuffer (
+  IN FILE_IO_STREAM     *Stream,
+  IN FILE_IO_BUFFER     *Buffer
+  )
+{
+  Buffer->Length = 0;
+  if (Stream->Position >= Stream->Size) {
+    return Stream->Status;
+  }
+
+  return StartTransfer (Stream, Buffer, (UINTN) MIN (Stream->ChunkSize, Stream->Size - Stream->Position));
+}
+
+/**
+  Move a reader on to its next chunk once the current one is consumed.  When
+  double buffered the next chunk is already being read; the consumed buffer
+  then starts reading the chunk after it.
+
+  @param[in]  Stream    The reader.
+
+  @return The status of the stream.
+
+**/
+STATIC
+EFI_STATUS
+NextChunk (
+  IN FILE_IO_STREAM     *Stream
+  )
+{
+  UINTN                Next;
+
+  if (Stream->BufferCount == 2) {
+    Next = Stream->Current ^ 1;
+    WaitTransfer (Stream, &Stream->Buffer[Next]);
+    FillBuffer (Stream, &Stream->Buffer[Stream->Current]);
+    Stream->Current = Next;
+  } else {
+    FillBuffer (Stream, &Stream->Buffer[0]);
+    WaitTransfer (Stream, &Stream->Buffer[0]);
+  }
+  Stream->Offset = 0;
+
+  if (EFI_ERROR (Stream->Status)) {
+    Stream->Buffer[Stream->Current].Length = 0;
+  }
+  return Stream->Status;
+}
+
+/**
+  Write a writer's current buffer to the file.  When double buffered the
+  write is left in flight and the caller goes on filling the other buffer.
+
+  @param[in]  Stream    The writer.
+
+  @return The status of the stream.
+
+**/
+STATIC
+EFI_STATUS
+FlushChunk (
+  IN FILE_IO_STREAM     *Stream
+  )
+{
+  FILE_IO_BUFFER       *Buffer;
+  UINTN                Other;
+
+  Buffer = &Stream->Buffer[Stream->Current];
+  if (Buffer->Length == 0) {
+    return Stream->Status;
+  }
+
+  if (Stream->BufferCount == 2) {
+    Other = Stream->Current ^ 1;
+    WaitTransfer (Stream, &Stream->Buffer[Other]);
+    Stream->Buffer[Other].Length = 0;
+    StartTransfer (Stream, Buffer, Buffer->Length);
+    Stream->Current = Other;
+  } else {
+    StartTransfer (Stream, Buffer, Buffer->Length);
+    WaitTransfer (Stream, Buffer);
+    Buffer->Length = 0;
+  }
+
+  return Stream->Status;
+}
+
+/**
+  Open a file and set up the buffers of a stream.
+
+  @param[in]  FileName      The file.
+  @param[in]  OpenMode      The Shell open mode.
+  @param[in]  Writer        TRUE for a writer.
+  @param[in]  ChunkSize     Bytes per chunk, not 0.
+  @param[in]  Options       FILE_IO_DOUBLE_BUFFER or 0.
+  @param[out] Stream        The new stream.
+
+  @retval EFI_SUCCESS           The stream is ready.
+  @retval EFI_OUT_OF_RESOURCES  No enough buffer to allocate.
+  @retval Others                The file could not be opened.
+
+**/
+STATIC
+EFI_STATUS
+OpenStream (
+  IN  CONST CHAR16      *FileName,
+  IN  UINT64            OpenMode,
+  IN  BOOLEAN           Writer,
+  IN  UINTN             ChunkSize,
+  IN  UINT32            Options,
+  OUT FILE_IO_STREAM    **Stream
+  )
+{
+  EFI_STATUS           Status;
+  FILE_IO_STREAM       *NewStream;
+  UINTN                Index;
+  EFI_TPL              OldTpl;
+
+  NewStream = AllocateZeroPool (sizeof (FILE_IO_STREAM));
+  if (NewStream == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  NewStream->Signature = FILE_IO_STREAM_SIGNATURE;
+  NewStream->Writer    = Writer;
+
+  Status = ShellOpenFileByName (FileName, &NewStream->FileHandle, OpenMode, 0);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: Open %s failed: %r\n", __FUNCTION__, FileName, Status));
+    FreePool (NewStream);
+    return Status;
+  }
+
+  if (!Writer) {
+    Status = ShellGetFileSize (NewStream->FileHandle, &NewStream->Size);
+    if (EFI_ERROR (Status)) {
+      FileIoClose (NewStream);
+      return Status;
+    }
+    if (NewStream->Size < ChunkSize) {
+      ChunkSize = (UINTN) MAX (NewStream->Size, 1);
+    }
+    if (NewStream->Size <= ChunkSize) {
+      Options &= ~FILE_IO_DOUBLE_BUFFER;
+    }
+  }
+
+  //
+  // Completions are waited for with WaitForEvent, which needs TPL_APPLICATION.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  gBS->RestoreTPL (OldTpl);
+
+  NewStream->ChunkSize   = ChunkSize;
+  NewStream->BufferCount = ((Options & FILE_IO_DOUBLE_BUFFER) != 0) ? 2 : 1;
+  NewStream->Async       = (BOOLEAN) ((NewStream->BufferCount == 2) &&
+                                      (OldTpl == TPL_APPLICATION) &&
+                                      (((EFI_FILE_PROTOCOL *) NewStream->FileHandle)->Revision >= EFI_FILE_PROTOCOL_REVISION2));
+
+  for (Index = 0; Index < NewStream->BufferCount; Index++) {
+    NewStream->Buffer[Index].Data = AllocatePool (ChunkSize);
+    if (NewStream->Buffer[Index].Data == NULL) {
+      FileIoClose (NewStream);
+      return EFI_OUT_OF_RESOURCES;
+    }
+    if (NewStream->Async) {
+      Status = gBS->CreateEvent (0, TPL_CALLBACK, NULL, NULL, &NewStream->Buffer[Index].Token.Event);
+      if (EFI_ERROR (Status)) {
+        NewStream->Async = FALSE;
+      }
+    }
+  }
+
+  *Stream = NewStream;
+  return EFI_SUCCESS;
+}
+
+/**
+  Open a file for reading in chunks.
+
+  @param[in]  FileName      The file to read, as the Shell resolves it.
+  @param[in]  ChunkSize     Bytes read at a time; 0 for FILE_IO_DEFAULT_CHUNK_SIZE.
+  @param[in]  Options       FILE_IO_DOUBLE_BUFFER or 0.
+  @param[out] Stream        The new stream.
+
+  @retval EFI_SUCCESS           The file is open and its first chunk is read.
+  @retval EFI_OUT_OF_RESOURCES  No enough buffer to allocate.
+  @retval Others                The file could not be opened or read.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoOpenReader (
+  IN  CONST CHAR16      *FileName,
+  IN  UINTN             ChunkSize,
+  IN  UINT32            Options,
+  OUT FILE_IO_STREAM    **Stream
+  )
+{
+  EFI_STATUS           Status;
+  FILE_IO_STREAM       *NewStream;
+
+  Status = OpenStream (
+             FileName,
+             EFI_FILE_MODE_READ,
+             FALSE,
+             (ChunkSize != 0) ? ChunkSize : FILE_IO_DEFAULT_CHUNK_SIZE,
+             Options,
+             &NewStream
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Read the first chunk, and start on the second when double buffered.
+  //
+  FillBuffer (NewStream, &NewStream->Buffer[0]);
+  WaitTransfer (NewStream, &NewStream->Buffer[0]);
+  if (NewStream->BufferCount == 2) {
+    FillBuffer (NewStream, &NewStream->Buffer[1]);
+  }
+
+  Status = NewStream->Status;
+  if (EFI_ERROR (Status)) {
+    FileIoClose (NewStream);
+    return Status;
+  }
+
+  *Stream = NewStream;
+  return EFI_SUCCESS;
+}
+
+/**
+  Create or truncate a file for writing in chunks.
+
+  @param[in]  FileName      The file to write, as the Shell resolves it.
+  @param[in]  ExpectedSize  The size the file is expected to have, used by
+                            FILE_IO_PREALLOCATE; 0 if unknown.
+  @param[in]  ChunkSize     Bytes written at a time; 0 for FILE_IO_DEFAULT_CHUNK_SIZE.
+  @param[in]  Options       FILE_IO_DOUBLE_BUFFER and FILE_IO_PREALLOCATE, or 0.
+  @param[out] Stream        The new stream.
+
+  @retval EFI_SUCCESS           The file is open and empty, or preallocated.
+  @retval EFI_OUT_OF_RESOURCES  No enough buffer to allocate.
+  @retval Others                The file could not be created.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoOpenWriter (
+  IN  CONST CHAR16      *FileName,
+  IN  UINT64            ExpectedSize,
+  IN  UINTN             ChunkSize,
+  IN  UINT32            Options,
+  OUT FILE_IO_STREAM    **Stream
+  )
+{
+  EFI_STATUS           Status;
+  FILE_IO_STREAM       *NewStream;
+  EFI_FILE_INFO        *FileInfo;
+
+  if (ChunkSize == 0) {
+    ChunkSize = FILE_IO_DEFAULT_CHUNK_SIZE;
+  }
+  if ((ExpectedSize != 0) && (ExpectedSize < ChunkSize)) {
+    ChunkSize = (UINTN) ExpectedSize;
+    Options &= ~FILE_IO_DOUBLE_BUFFER;
+  }
+
+  Status = OpenStream (
+             FileName,
+             EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE,
+             TRUE,
+             ChunkSize,
+             Options,
+             &NewStream
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  NewStream->Size = ExpectedSize;
+
+  //
+  // Replace the contents in place: truncate the file, or size it for what
+  // is about to be written.
+  //
+  FileInfo = ShellGetFileInfo (NewStream->FileHandle);
+  if (FileInfo == NULL) {
+    FileIoClose (NewStream);
+    return EFI_DEVICE_ERROR;
+  }
+  FileInfo->FileSize = ((Options & FILE_IO_PREALLOCATE) != 0) ? ExpectedSize : 0;
+  Status = ShellSetFileInfo (NewStream->FileHandle, FileInfo);
+  FreePool (FileInfo);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: Set size of %s failed: %r\n", __FUNCTION__, FileName, Status));
+    FileIoClose (NewStream);
+    return Status;
+  }
+
+  *Stream = NewStream;
+  return EFI_SUCCESS;
+}
+
+/**
+  Get the size of a reader's file, or the bytes written so far to a writer.
+
+  @param[in]  Stream        The stream.
+
+  @return The size in bytes.
+
+**/
+UINT64
+EFIAPI
+FileIoGetSize (
+  IN FILE_IO_STREAM     *Stream
+  )
+{
+  ASSERT (Stream->Signature == FILE_IO_STREAM_SIGNATURE);
+
+  if (Stream->Writer) {
+    return Stream->Position + Stream->Buffer[Stream->Current].Length;
+  }
+  return Stream->Size;
+}
+
+/**
+  Get the next chunk of a reader without copying it.  The chunk stays valid
+  until the next call on the stream.
+
+  @param[in]  Stream        The reader.
+  @param[out] Data          The chunk.
+  @param[out] Length        Bytes in the chunk; 0 at the end of the file.
+
+  @retval EFI_SUCCESS       Data and Length are valid.
+  @retval Others            The file could not be read.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoReadChunk (
+  IN  FILE_IO_STREAM    *Stream,
+  OUT VOID              **Data,
+  OUT UINTN             *Length
+  )
+{
+  return FileIoReadChunkEx (Stream, MAX_UINTN, Data, Length);
+}
+
+/**
+  Get up to MaxLength bytes of a reader's next chunk without copying them.
+  The bytes stay valid until the next call on the stream.
+
+  @param[in]  Stream        The reader.
+  @param[in]  MaxLength     The most bytes wanted.
+  @param[out] Data          The bytes.
+  @param[out] Length        Bytes returned; 0 at the end of the file.
+
+  @retval EFI_SUCCESS       Data and Length are valid.
+  @retval Others            The file could not be read.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoReadChunkEx (
+  IN  FILE_IO_STREAM    *Stream,
+  IN  UINTN             MaxLength,
+  OUT VOID              **Data,
+  OUT UINTN             *Length
+  )
+{
+  EFI_STATUS           Status;
+  FILE_IO_BUFFER       *Buffer;
+
+  ASSERT (Stream->Signature == FILE_IO_STREAM_SIGNATURE && !Stream->Writer);
+
+  *Length = 0;
+  if (MaxLength == 0) {
+    return Stream->Status;
+  }
+
+  if (Stream->Offset == Stream->Buffer[Stream->Current].Length) {
+    Status = NextChunk (Stream);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  Buffer          = &Stream->Buffer[Stream->Current];
+  *Data           = Buffer->Data + Stream->Offset;
+  *Length         = MIN (Buffer->Length - Stream->Offset, MaxLength);
+  Stream->Offset += *Length;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Copy the next bytes of a reader.
+
+  @param[in]      Stream    The reader.
+  @param[in, out] Size      On input, the bytes wanted.  On output, the bytes
+                            copied, fewer only at the end of the file.
+  @param[out]     Buffer    Receives the bytes.
+
+  @retval EFI_SUCCESS       Size bytes were copied.
+  @retval Others            The file could not be read.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoRead (
+  IN     FILE_IO_STREAM  *Stream,
+  IN OUT UINTN           *Size,
+  OUT    VOID            *Buffer
+  )
+{
+  EFI_STATUS           Status;
+  FILE_IO_BUFFER       *Chunk;
+  UINTN                Copied;
+  UINTN                Length;
+
+  ASSERT (Stream->Signature == FILE_IO_STREAM_SIGNATURE && !Stream->Writer);
+
+  Status = EFI_SUCCESS;
+  Copied = 0;
+  while (Copied < *Size) {
+    Chunk = &Stream->Buffer[Stream->Current];
+    if (Stream->Offset == Chunk->Length) {
+      Status = NextChunk (Stream);
+      Chunk  = &Stream->Buffer[Stream->Current];
+      if (EFI_ERROR (Status) || (Chunk->Length == 0)) {
+        break;
+      }
+    }
+
+    Length = MIN (*Size - Copied, Chunk->Length - Stream->Offset);
+    CopyMem ((UINT8 *) Buffer + Copied, Chunk->Data + Stream->Offset, Length);
+    Stream->Offset += Length;
+    Copied         += Length;
+  }
+
+  *Size = Copied;
+  return Status;
+}
+
+/**
+  Copy the next bytes of a reader without consuming them.  Only the bytes
+  already in the current chunk can be peeked at.
+
+  @param[in]      Stream    The reader.
+  @param[in, out] Size      On input, the bytes wanted.  On output, the bytes
+                            copied, fewer at the end of the file or of the
+                            current chunk.
+  @param[out]     Buffer    Receives the bytes.
+
+  @retval EFI_SUCCESS       Size bytes were copied.
+  @retval Others            The file could not be read.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoPeek (
+  IN     FILE_IO_STREAM  *Stream,
+  IN OUT UINTN           *Size,
+  OUT    VOID            *Buffer
+  )
+{
+  EFI_STATUS           Status;
+  FILE_IO_BUFFER       *Chunk;
+
+  ASSERT (Stream->Signature == FILE_IO_STREAM_SIGNATURE && !Stream->Writer);
+
+  if (Stream->Offset == Stream->Buffer[Stream->Current].Length) {
+    Status = NextChunk (Stream);
+    if (EFI_ERROR (Status)) {
+      *Size = 0;
+      return Status;
+    }
+  }
+
+  Chunk = &Stream->Buffer[Stream->Current];
+  *Size = MIN (*Size, Chunk->Length - Stream->Offset);
+  CopyMem (Buffer, Chunk->Data + Stream->Offset, *Size);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Read the next line of a text reader.  The line ends at LF, CR LF or the end
+  of the file; the line break is not returned.
+
+  @param[in]      Stream    The reader.
+  @param[out]     Line      Receives the line, NUL terminated.
+  @param[in, out] LineSize  On input, the size of Line.  On output, the
+                            length of the line, or the size needed with
+                            EFI_BUFFER_TOO_SMALL.
+
+  @retval EFI_SUCCESS           The line was read.
+  @retval EFI_END_OF_FILE       There are no more lines.
+  @retval EFI_BUFFER_TOO_SMALL  The line does not fit; it is skipped.
+  @retval Others                The file could not be read.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoReadLine (
+  IN     FILE_IO_STREAM  *Stream,
+  OUT    CHAR8           *Line,
+  IN OUT UINTN           *LineSize
+  )
+{
+  EFI_STATUS           Status;
+  FILE_IO_BUFFER       *Chunk;
+  UINT8                *Start;
+  UINT8                *End;
+  UINTN                Available;
+  UINTN                Take;
+  UINTN                Length;
+  BOOLEAN              Found;
+  CHAR8                LastChar;
+
+  ASSERT (Stream->Signature == FILE_IO_STREAM_SIGNATURE && !Stream->Writer);
+  ASSERT (*LineSize > 0);
+
+  Length   = 0;
+  Found    = FALSE;
+  LastChar = '\0';
+  while (TRUE) {
+    Chunk = &Stream->Buffer[Stream->Current];
+    if (Stream->Offset == Chunk->Length) {
+      Status = NextChunk (Stream);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+      Chunk = &Stream->Buffer[Stream->Current];
+      if (Chunk->Length == 0) {
+        break;
+      }
+    }
+
+    Start     = Chunk->Data + Stream->Offset;
+    Available = Chunk->Length - Stream->Offset;
+    End       = ScanMem8 (Start, Available, '\n');
+    Take      = (End != NULL) ? (UINTN) (End - Start) : Available;
+
+    if (Length < *LineSize - 1) {
+      CopyMem (Line + Length, Start, MIN (Take, *LineSize - 1 - Length));
+    }
+    if (Take != 0) {
+      LastChar = (CHAR8) Start[Take - 1];
+    }
+    Length         += Take;
+    Stream->Offset += Take;
+
+    if (End != NULL) {
+      Stream->Offset++;
+      Found = TRUE;
+      break;
+    }
+  }
+
+  if (!Found && (Length == 0)) {
+    return EFI_END_OF_FILE;
+  }
+
+  if (LastChar == '\r') {
+    Length--;
+  }
+  if (Length >= *LineSize) {
+    *LineSize = Length + 1;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  Line[Length] = '\0';
+  *LineSize    = Length;
+  return EFI_SUCCESS;
+}
+
+/**
+  Get the free part of a writer's current chunk, to fill in place.  Commit
+  the bytes filled with FileIoCommitWrite.
+
+  @param[in]  Stream        The writer.
+  @param[out] Buffer        The free space.
+  @param[out] Size          Bytes of free space, at least 1.
+
+  @retval EFI_SUCCESS       Buffer and Size are valid.
+  @retval Others            An earlier chunk could not be written.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoGetWriteBuffer (
+  IN  FILE_IO_STREAM    *Stream,
+  OUT VOID              **Buffer,
+  OUT UINTN             *Size
+  )
+{
+  FILE_IO_BUFFER       *Chunk;
+
+  ASSERT (Stream->Signature == FILE_IO_STREAM_SIGNATURE && Stream->Writer);
+
+  if (Stream->Buffer[Stream->Current].Length == Stream->ChunkSize) {
+    FlushChunk (Stream);
+  }
+  if (EFI_ERROR (Stream->Status)) {
+    return Stream->Status;
+  }
+
+  Chunk   = &Stream->Buffer[Stream->Current];
+  *Buffer = Chunk->Data + Chunk->Length;
+  *Size   = Stream->ChunkSize - Chunk->Length;
+  return EFI_SUCCESS;
+}
+
+/**
+  Commit bytes filled in the buffer given by FileIoGetWriteBuffer.  A full
+  chunk is written to the file.
+
+  @param[in]  Stream        The writer.
+  @param[in]  Size          Bytes filled.
+
+  @retval EFI_SUCCESS       The bytes were committed.
+  @retval Others            The file could not be written.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoCommitWrite (
+  IN FILE_IO_STREAM     *Stream,
+  IN UINTN              Size
+  )
+{
+  FILE_IO_BUFFER       *Chunk;
+
+  ASSERT (Stream->Signature == FILE_IO_STREAM_SIGNATURE && Stream->Writer);
+
+  Chunk = &Stream->Buffer[Stream->Current];
+  ASSERT (Size <= Stream->ChunkSize - Chunk->Length);
+
+  Chunk->Length += Size;
+  if (Chunk->Length == Stream->ChunkSize) {
+    FlushChunk (Stream);
+  }
+  return Stream->Status;
+}
+
+/**
+  Copy bytes to a writer.
+
+  @param[in]  Stream        The writer.
+  @param[in]  Size          Bytes to write.
+  @param[in]  Buffer        The bytes.
+
+  @retval EFI_SUCCESS       The bytes were written or buffered.
+  @retval Others            The file could not be written.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoWrite (
+  IN FILE_IO_STREAM     *Stream,
+  IN UINTN              Size,
+  IN CONST VOID         *Buffer
+  )
+{
+  EFI_STATUS           Status;
+  VOID                 *Free;
+  UINTN                FreeSize;
+
+  while (Size != 0) {
+    Status = FileIoGetWriteBuffer (Stream, &Free, &FreeSize);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    FreeSize = MIN (FreeSize, Size);
+    CopyMem (Free, Buffer, FreeSize);
+    Buffer = (CONST UINT8 *) Buffer + FreeSize;
+    Size  -= FreeSize;
+
+    Status = FileIoCommitWrite (Stream, FreeSize);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Close a stream.  A writer writes what is buffered and trims the file to the
+  bytes written.
+
+  @param[in]  Stream        The stream.
+
+  @retval EFI_SUCCESS       Every chunk was transferred.
+  @retval Others            The first error of the stream.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoClose (
+  IN FILE_IO_STREAM     *Stream
+  )
+{
+  EFI_STATUS           Status;
+  EFI_FILE_INFO        *FileInfo;
+  UINTN                Index;
+
+  ASSERT (Stream->Signature == FILE_IO_STREAM_SIGNATURE);
+
+  if (Stream->Writer) {
+    FlushChunk (Stream);
+  }
+  for (Index = 0; Index < Stream->BufferCount; Index++) {
+    WaitTransfer (Stream, &Stream->Buffer[Index]);
+  }
+
+  //
+  // A preallocated file may have been given more than was written.
+  //
+  if (Stream->Writer && !EFI_ERROR (Stream->Status) && (Stream->Position != Stream->Size)) {
+    FileInfo = ShellGetFileInfo (Stream->FileHandle);
+    if (FileInfo == NULL) {
+      Stream->Status = EFI_DEVICE_ERROR;
+    } else {
+      if (FileInfo->FileSize != Stream->Position) {
+        FileInfo->FileSize = Stream->Position;
+        Stream->Status = ShellSetFileInfo (Stream->FileHandle, FileInfo);
+      }
+      FreePool (FileInfo);
+    }
+  }
+
+  Status = Stream->Status;
+  for (Index = 0; Index < ARRAY_SIZE (Stream->Buffer); Index++) {
+    if (Stream->Buffer[Index].Token.Event != NULL) {
+      gBS->CloseEvent (Stream->Buffer[Index].Token.Event);
+    }
+    if (Stream->Buffer[Index].Data != NULL) {
+      FreePool (Stream->Buffer[Index].Data);
+    }
+  }
+  if (Stream->FileHandle != NULL) {
+    ShellCloseFile (&Stream->FileHandle);
+  }
+  FreePool (Stream);
+
+  return Status;
+}
+
+/**
+  Read a whole file into a new pool buffer.
+
+  @param[in]  FileName      The file to read.
+  @param[out] BufferSize    Bytes read.
+  @param[out] Buffer        The file contents; free with FreePool.
+
+  @retval EFI_SUCCESS           The file was read.
+  @retval EFI_OUT_OF_RESOURCES  No enough buffer to allocate.
+  @retval Others                The file could not be read.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoReadFile (
+  IN  CONST CHAR16      *FileName,
+  OUT UINTN             *BufferSize,
+  OUT VOID              **Buffer
+  )
+{
+  EFI_STATUS           Status;
+  FILE_IO_STREAM       *Stream;
+  UINT64               FileSize;
+  UINTN                Size;
+  VOID                 *FileBuffer;
+
+  Status = FileIoOpenReader (FileName, 0, FILE_IO_DOUBLE_BUFFER, &Stream);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  FileSize = FileIoGetSize (Stream);
+  if (FileSize > MAX_UINTN) {
+    FileIoClose (Stream);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Size       = (UINTN) FileSize;
+  FileBuffer = AllocatePool (MAX (Size, 1));
+  if (FileBuffer == NULL) {
+    FileIoClose (Stream);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = FileIoRead (Stream, &Size, FileBuffer);
+  FileIoClose (Stream);
+  if (EFI_ERROR (Status)) {
+    FreePool (FileBuffer);
+    return Status;
+  }
+
+  *BufferSize = Size;
+  *Buffer     = FileBuffer;
+  return EFI_SUCCESS;
+}
+
+/**
+  Write a buffer to a file, replacing its contents.
+
+  @param[in]  FileName      The file to write.
+  @param[in]  BufferSize    Bytes to write.
+  @param[in]  Buffer        The bytes.
+
+  @retval EFI_SUCCESS       The file was written.
+  @retval Others            The file could not be written.
+
+**/
+EFI_STATUS
+EFIAPI
+FileIoWriteFile (
+  IN CONST CHAR16       *FileName,
+  IN UINTN              BufferSize,
+  IN CONST VOID         *Buffer
+  )
+{
+  EFI_STATUS           Status;
+  EFI_STATUS           CloseStatus;
+  FILE_IO_STREAM       *Stream;
+
+  Status = FileIoOpenWriter (FileName, BufferSize, 0, FILE_IO_DOUBLE_BUFFER, &Stream);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status      = FileIoWrite (Stream, BufferSize, Buffer);
+  CloseStatus = FileIoClose (Stream);
+
+  return EFI_ERROR (Status) ? Status : CloseStatus;
+}
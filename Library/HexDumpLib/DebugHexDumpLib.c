@@ -0,0 +1,97 @@
+/** @file
+  Hex dump library instance that writes to the debug output, for phases
+  without a console such as PEI.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include "HexDumpLibInternal.h"
+
+//
+// DebugPrint formats into a buffer of its own of a few hundred characters,
+// so hand it no more than this at a time.
+//
+#define HEX_DUMP_DEBUG_LENGTH          0xF0
+
+//
+// Widest line that still fits in HEX_DUMP_DEBUG_LENGTH with the largest
+// indent and 16 offset digits, so that every DEBUG call holds whole lines.
+//
+#define HEX_DUMP_DEBUG_MAX_WIDTH       ((HEX_DUMP_DEBUG_LENGTH - 1 - (HEX_DUMP_MAX_INDENT + 16 + 2 + 5)) / 4)
+
+/**
+  Dump some hexadecimal data, 16 bytes per line in two groups of 8.
+
+  @param[in] Indent     How many spaces to indent the output.
+  @param[in] Offset     The offset of the printing.
+  @param[in] DataSize   The size in bytes of UserData.
+  @param[in] UserData   The data to print out.
+
+**/
+VOID
+EFIAPI
+HexDump (
+  IN UINTN        Indent,
+  IN UINTN        Offset,
+  IN UINTN        DataSize,
+  IN CONST VOID   *UserData
+  )
+{
+  HexDumpEx (Indent, Offset, DataSize, UserData, HEX_DUMP_DEFAULT_WIDTH, HEX_DUMP_DEFAULT_GROUP);
+}
+
+/**
+  Dump some hexadecimal data with a given line width and grouping.
+
+  @param[in] Indent     How many spaces to indent the output, at most
+                        HEX_DUMP_MAX_INDENT.
+  @param[in] Offset     The offset of the printing.
+  @param[in] DataSize   The size in bytes of UserData.
+  @param[in] UserData   The data to print out.
+  @param[in] Width      Bytes per line; 0 for HEX_DUMP_DEFAULT_WIDTH.  This
+                        instance prints at most HEX_DUMP_DEBUG_MAX_WIDTH
+                        bytes per line so a line fits in one DEBUG call.
+  @param[in] Group      Bytes between '-' separators; 0 for
+                        HEX_DUMP_DEFAULT_GROUP, Width or more for none.
+
+**/
+VOID
+EFIAPI
+HexDumpEx (
+  IN UINTN        Indent,
+  IN UINTN        Offset,
+  IN UINTN        DataSize,
+  IN CONST VOID   *UserData,
+  IN UINTN        Width,
+  IN UINTN        Group
+  )
+{
+  HEX_DUMP_CONTEXT  Context;
+  CHAR16            Lines[HEX_DUMP_DEBUG_LENGTH];
+  CHAR8             AsciiLines[ARRAY_SIZE (Lines)];
+  UINTN             Index;
+
+  if ((DataSize == 0) || !DebugPrintLevelEnabled (DEBUG_ERROR)) {
+    return;
+  }
+
+  HexDumpInitialize (&Context, Indent, Offset, DataSize, UserData, MIN (Width, HEX_DUMP_DEBUG_MAX_WIDTH), Group);
+
+  //
+  // Batch as many whole lines as stay within HEX_DUMP_DEBUG_LENGTH.
+  //
+  while (HexDumpFormatLines (&Context, Lines, ARRAY_SIZE (Lines)) != 0) {
+    for (Index = 0; Lines[Index] != L'\0'; Index++) {
+      AsciiLines[Index] = (CHAR8) Lines[Index];
+    }
+    AsciiLines[Index] = '\0';
+    DEBUG ((DEBUG_ERROR, "%a", AsciiLines));
+  }
+}
@@ -0,0 +1,161 @@
+/** @file
+  Hex dump line formatting shared by the hex dump library instances.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include "HexDumpLibInternal.h"
+
+#define HEX_ROW(High) \
+  { High, '0' }, { High, '1' }, { High, '2' }, { High, '3' }, \
+  { High, '4' }, { High, '5' }, { High, '6' }, { High, '7' }, \
+  { High, '8' }, { High, '9' }, { High, 'A' }, { High, 'B' }, \
+  { High, 'C' }, { High, 'D' }, { High, 'E' }, { High, 'F' }
+
+//
+// The two hexadecimal digits of every byte value.
+//
+STATIC CONST CHAR8 mHexByte[256][2] = {
+  HEX_ROW ('0'), HEX_ROW ('1'), HEX_ROW ('2'), HEX_ROW ('3'),
+  HEX_ROW ('4'), HEX_ROW ('5'), HEX_ROW ('6'), HEX_ROW ('7'),
+  HEX_ROW ('8'), HEX_ROW ('9'), HEX_ROW ('A'), HEX_ROW ('B'),
+  HEX_ROW ('C'), HEX_ROW ('D'), HEX_ROW ('E'), HEX_ROW ('F')
+};
+
+/**
+  Set up a hex dump.
+
+  @param[out] Context   The dump.
+  @param[in]  Indent    Spaces before each line.
+  @param[in]  Offset    The offset of the first byte.
+  @param[in]  DataSize  Bytes to dump.
+  @param[in]  Data      The bytes.
+  @param[in]  Width     Bytes per line; 0 for the default.
+  @param[in]  Group     Bytes between separators; 0 for the default.
+
+**/
+VOID
+HexDumpInitialize (
+  OUT HEX_DUMP_CONTEXT  *Context,
+  IN  UINTN             Indent,
+  IN  UINTN             Offset,
+  IN  UINTN             DataSize,
+  IN  CONST VOID        *Data,
+  IN  UINTN             Width,
+  IN  UINTN             Group
+  )
+{
+  if (Width == 0) {
+    Width = HEX_DUMP_DEFAULT_WIDTH;
+  }
+  if (Group == 0) {
+    Group = HEX_DUMP_DEFAULT_GROUP;
+  }
+
+  Context->Indent   = MIN (Indent, HEX_DUMP_MAX_INDENT);
+  Context->Width    = MIN (Width, HEX_DUMP_MAX_WIDTH);
+  Context->Group    = Group;
+  Context->Offset   = Offset;
+  Context->Data     = Data;
+  Context->DataSize = DataSize;
+
+  //
+  // 8 offset digits as before, 16 when the offsets do not fit in 32 bits.
+  //
+  Context->OffsetDigits = 8;
+  if ((DataSize != 0) && ((UINT64) Offset + (DataSize - 1) > MAX_UINT32)) {
+    Context->OffsetDigits = 16;
+  }
+
+  Context->LineLength = Context->Indent + Context->OffsetDigits + 2 + Context->Width * 4 + 5;
+}
+
+/**
+  Format as many whole lines of a dump as fit in a buffer.
+
+  @param[in, out] Context       The dump; moved past the lines formatted.
+  @param[out]     Buffer        Receives the lines, NUL terminated.
+  @param[in]      BufferLength  Characters in Buffer, at least
+                                Context->LineLength + 1.
+
+  @return The characters formatted, not counting the NUL; 0 once the dump
+          is complete.
+
+**/
+UINTN
+HexDumpFormatLines (
+  IN OUT HEX_DUMP_CONTEXT  *Context,
+  OUT    CHAR16            *Buffer,
+  IN     UINTN             BufferLength
+  )
+{
+  CHAR16         *Out;
+  CHAR16         *End;
+  CONST UINT8    *Data;
+  UINTN          Size;
+  UINTN          Index;
+  UINTN          GroupCount;
+  UINTN          Shift;
+  UINT8          Byte;
+
+  ASSERT (BufferLength > Context->LineLength);
+
+  Out = Buffer;
+  End = Buffer + BufferLength - 1;
+  while ((Context->DataSize != 0) && ((UINTN) (End - Out) >= Context->LineLength)) {
+    Data = Context->Data;
+    Size = MIN (Context->Width, Context->DataSize);
+
+    for (Index = 0; Index < Context->Indent; Index++) {
+      *Out++ = L' ';
+    }
+
+    Shift = Context->OffsetDigits * 4;
+    while (Shift != 0) {
+      Shift -= 4;
+      *Out++ = (CHAR16) mHexByte[(RShiftU64 (Context->Offset, Shift) & 0xF)][1];
+    }
+    *Out++ = L':';
+    *Out++ = L' ';
+
+    GroupCount = 0;
+    for (Index = 0; Index < Size; Index++) {
+      Byte   = Data[Index];
+      *Out++ = (CHAR16) mHexByte[Byte][0];
+      *Out++ = (CHAR16) mHexByte[Byte][1];
+      if ((++GroupCount == Context->Group) && (Index + 1 != Context->Width)) {
+        *Out++     = L'-';
+        GroupCount = 0;
+      } else {
+        *Out++ = L' ';
+      }
+    }
+    for (Index = Size * 3; Index < Context->Width * 3; Index++) {
+      *Out++ = L' ';
+    }
+
+    *Out++ = L' ';
+    *Out++ = L'*';
+    for (Index = 0; Index < Size; Index++) {
+      Byte   = Data[Index];
+      *Out++ = (CHAR16) ((Byte < ' ' || Byte > '~') ? '.' : Byte);
+    }
+    *Out++ = L'*';
+    *Out++ = L'\r';
+    *Out++ = L'\n';
+
+    Context->Data     += Size;
+    Context->Offset   += Size;
+    Context->DataSize -= Size;
+  }
+
+  *Out = L'\0';
+  return (UINTN) (Out - Buffer);
+}
@@ -0,0 +1,81 @@
+/** @file
+  Internal definitions shared by the hex dump library instances.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#ifndef _HEX_DUMP_LIB_INTERNAL_H_
+#define _HEX_DUMP_LIB_INTERNAL_H_
+
+#include <Base.h>
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/HexDumpLib.h>
+
+//
+// Characters of the longest line: indent, 16 offset digits, ": ", 3 per
+// byte, " *", 1 per byte, "*" and CR LF.
+//
+#define HEX_DUMP_MAX_LINE_LENGTH       (HEX_DUMP_MAX_INDENT + 16 + 2 + HEX_DUMP_MAX_WIDTH * 4 + 5)
+
+typedef struct {
+  UINTN          Indent;
+  UINTN          Width;
+  UINTN          Group;
+  UINTN          OffsetDigits;
+  UINTN          LineLength;   // Characters of a full line
+  UINTN          Offset;       // Offset printed on the next line
+  CONST UINT8    *Data;        // Bytes not formatted yet
+  UINTN          DataSize;
+} HEX_DUMP_CONTEXT;
+
+/**
+  Set up a hex dump.
+
+  @param[out] Context   The dump.
+  @param[in]  Indent    Spaces before each line.
+  @param[in]  Offset    The offset of the first byte.
+  @param[in]  DataSize  Bytes to dump.
+  @param[in]  Data      The bytes.
+  @param[in]  Width     Bytes per line; 0 for the default.
+  @param[in]  Group     Bytes between separators; 0 for the default.
+
+**/
+VOID
+HexDumpInitialize (
+  OUT HEX_DUMP_CONTEXT  *Context,
+  IN  UINTN             Indent,
+  IN  UINTN             Offset,
+  IN  UINTN             DataSize,
+  IN  CONST VOID        *Data,
+  IN  UINTN             Width,
+  IN  UINTN             Group
+  );
+
+/**
+  Format as many whole lines of a dump as fit in a buffer.
+
+  @param[in, out] Context       The dump; moved past the lines formatted.
+  @param[out]     Buffer        Receives the lines, NUL terminated.
+  @param[in]      BufferLength  Characters in Buffer, at least
+                                Context->LineLength + 1.
+
+  @return The characters formatted, not counting the NUL; 0 once the dump
+          is complete.
+
+**/
+UINTN
+HexDumpFormatLines (
+  IN OUT HEX_DUMP_CONTEXT  *Context,
+  OUT    CHAR16            *Buffer,
+  IN     UINTN             BufferLength
+  );
+
+#endif
@@ -0,0 +1,99 @@
+/** @file
+  Hex dump library instance that writes to the console output of the system
+  table.
+
+  Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Uefi.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include "HexDumpLibInternal.h"
+
+//
+// Characters formatted before each OutputString call, about 100 default lines.
+//
+#define HEX_DUMP_OUTPUT_LENGTH         SIZE_8KB
+
+/**
+  Dump some hexadecimal data, 16 bytes per line in two groups of 8.
+
+  @param[in] Indent     How many spaces to indent the output.
+  @param[in] Offset     The offset of the printing.
+  @param[in] DataSize   The size in bytes of UserData.
+  @param[in] UserData   The data to print out.
+
+**/
+VOID
+EFIAPI
+HexDump (
+  IN UINTN        Indent,
+  IN UINTN        Offset,
+  IN UINTN        DataSize,
+  IN CONST VOID   *UserData
+  )
+{
+  HexDumpEx (Indent, Offset, DataSize, UserData, HEX_DUMP_DEFAULT_WIDTH, HEX_DUMP_DEFAULT_GROUP);
+}
+
+/**
+  Dump some hexadecimal data with a given line width and grouping.
+
+  @param[in] Indent     How many spaces to indent the output, at most
+                        HEX_DUMP_MAX_INDENT.
+  @param[in] Offset     The offset of the printing.
+  @param[in] DataSize   The size in bytes of UserData.
+  @param[in] UserData   The data to print out.
+  @param[in] Width      Bytes per line, at most HEX_DUMP_MAX_WIDTH; 0 for
+                        HEX_DUMP_DEFAULT_WIDTH.
+  @param[in] Group      Bytes between '-' separators; 0 for
+                        HEX_DUMP_DEFAULT_GROUP, Width or more for none.
+
+**/
+VOID
+EFIAPI
+HexDumpEx (
+  IN UINTN        Indent,
+  IN UINTN        Offset,
+  IN UINTN        DataSize,
+  IN CONST VOID   *UserData,
+  IN UINTN        Width,
+  IN UINTN        Group
+  )
+{
+  HEX_DUMP_CONTEXT  Context;
+  CHAR16            Line[HEX_DUMP_MAX_LINE_LENGTH + 1];
+  CHAR16            *Buffer;
+  UINTN             BufferLength;
+
+  if ((DataSize == 0) || (gST->ConOut == NULL)) {
+    return;
+  }
+
+  HexDumpInitialize (&Context, Indent, Offset, DataSize, UserData, Width, Group);
+
+  //
+  // Fall back to a line at a time when there is no pool for a large buffer.
+  //
+  Buffer       = AllocatePool (HEX_DUMP_OUTPUT_LENGTH * sizeof (CHAR16));
+  BufferLength = HEX_DUMP_OUTPUT_LENGTH;
+  if (Buffer == NULL) {
+    Buffer       = Line;
+    BufferLength = ARRAY_SIZE (Line);
+  }
+
+  while (HexDumpFormatLines (&Context, Buffer, BufferLength) != 0) {
+    gST->ConOut->OutputString (gST->ConOut, Buffer);
+  }
+
+  if (Buffer != Line) {
+    FreePool (Buffer);
+  }
+}
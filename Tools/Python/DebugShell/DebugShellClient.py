@@ -0,0 +1,419 @@
+## @file
+# Host client for the machine-readable request mode of DebugShellLib.
+#
+# Sends ":<seq> <command>" requests over a serial port (or any pyserial URL
+# such as socket://host:port) and parses the framed responses:
+#
+#   {<seq>
+#   key=value        result lines
+#   free text        messages
+#   }<seq> <status>
+#
+# Sequence numbers are 8 hex digits.  Status is 16 hex digits: the
+# RETURN_STATUS of the command with its error bit moved to bit 63, so an
+# error (8000000000000001) and a warning (0000000000000001) with the same
+# code stay apart.  Several requests may be kept in flight; the window is
+# kept small by default so that a target polling a UART with a 16-byte FIFO
+# does not drop characters.
+#
+# "bindump" is the exception to the text body: after a frame=<size> line
+# the target sends binary frames until one with no payload,
+#
+#   'DSBF' UINT32 sequence, UINT32 length, payload, UINT32 CRC32
+#
+# little-endian, then the end line.  Frame N holds the bytes at offset
+# N * size.  BinDump () checks the CRC32 of every frame and requests the
+# ranges of damaged or missing frames again.
+#
+# Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+# This program and the accompanying materials
+# are licensed and made available under the terms and conditions of the BSD License
+# which accompanies this distribution.  The full text of the license may be found at
+# http://opensource.org/licenses/bsd-license.php
+#
+# THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+# WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+#
+
+'''
+DebugShellClient
+'''
+
+import sys
+import re
+import time
+import json
+import zlib
+import struct
+import argparse
+from collections import OrderedDict
+
+try:
+    import serial
+except ImportError:
+    print ('DebugShellClient: error: pyserial is required (pip install pyserial)')
+    sys.exit (1)
+
+#
+# Globals for help information
+#
+__prog__        = 'DebugShellClient'
+__version__     = '1.0'
+__copyright__   = 'Copyright (c) 2026, Gavin Xue. All rights reserved.'
+__description__ = 'Send commands to DebugShellLib and parse its framed responses.\n'
+
+_BEGIN_RE  = re.compile (r'^\{([0-9A-Fa-f]{8})$')
+_END_RE    = re.compile (r'^\}([0-9A-Fa-f]{8}) ([0-9A-Fa-f]{16})$')
+_RESULT_RE = re.compile (r'^([A-Za-z_][\w.]*)=(.*)$')
+
+#
+# Binary frames.  After a damaged header the stream is searched for the next
+# frame or for the end line of the response.
+#
+_FRAME_SIGNATURE = b'DSBF'
+_FRAME_HEADER    = struct.Struct ('<4sII')
+_FRAME_CRC       = struct.Struct ('<I')
+_RESYNC_RE       = re.compile (br'DSBF|\}[0-9A-Fa-f]{8} [0-9A-Fa-f]{16}\r?\n')
+_RESYNC_TAIL     = 27
+
+STATUS_ERROR = 1 << 63
+
+STATUS_NAMES = {
+    0x00:                'SUCCESS',
+    STATUS_ERROR | 0x01: 'LOAD_ERROR',
+    STATUS_ERROR | 0x02: 'INVALID_PARAMETER',
+    STATUS_ERROR | 0x03: 'UNSUPPORTED',
+    STATUS_ERROR | 0x07: 'DEVICE_ERROR',
+    STATUS_ERROR | 0x09: 'OUT_OF_RESOURCES',
+    STATUS_ERROR | 0x0E: 'NOT_FOUND',
+    STATUS_ERROR | 0x15: 'ABORTED',
+    STATUS_ERROR | 0x1B: 'CRC_ERROR',
+    0x01:                'WARN_UNKNOWN_GLYPH',
+    0x02:                'WARN_DELETE_FAILURE',
+    0x03:                'WARN_WRITE_FAILURE',
+    0x04:                'WARN_BUFFER_TOO_SMALL',
+    }
+
+class DebugShellTimeout (Exception):
+    pass
+
+class DebugShellError (Exception):
+    pass
+
+class DebugShellResponse (object):
+    def __init__ (self, Sequence, Command, Index = 0, Attempt = 1):
+        self.Sequence = Sequence
+        self.Command  = Command
+        self.Index    = Index
+        self.Attempt  = Attempt
+        self.Status   = None
+        self.Values   = OrderedDict ()
+        self.Text     = []
+        #
+        # Binary frames of a bindump, by sequence number, with a good CRC32
+        #
+        self.FrameSize = None
+        self.Frames    = {}
+        self.Receiving = False
+
+    @property
+    def Success (self):
+        #
+        # Warnings still count as success; only the error bit fails a command.
+        #
+        return self.Status is not None and not (self.Status & STATUS_ERROR)
+
+    @property
+    def StatusName (self):
+        if self.Status is None:
+            return 'TIMEOUT'
+        return STATUS_NAMES.get (self.Status, '0x{0:016X}'.format (self.Status))
+
+    def AddLine (self, Line):
+        Match = _RESULT_RE.match (Line)
+        if Match is None:
+            self.Text.append (Line)
+            return
+        #
+        # A key repeats when the command runs more than once (repeat N ...);
+        # keep every value in that case.
+        #
+        Key, Value = Match.group (1), Match.group (2)
+        if Key == 'frame' and self.Command.split ()[0] == 'bindump':
+            self.FrameSize = int (Value, 16)
+            self.Receiving = True
+        if Key not in self.Values:
+            self.Values[Key] = Value
+        elif isinstance (self.Values[Key], list):
+            self.Values[Key].append (Value)
+        else:
+            self.Values[Key] = [self.Values[Key], Value]
+
+    def ToDict (self):
+        return OrderedDict ([
+            ('seq',     self.Sequence),
+            ('command', self.Command),
+            ('status',  self.StatusName),
+            ('values',  self.Values),
+            ('text',    self.Text),
+            ])
+
+class DebugShellClient (object):
+    def __init__ (self, Port, Baud = 115200, Timeout = 5.0, Window = 2, LineDelay = 0.0):
+        self.Serial    = serial.serial_for_url (Port, baudrate = Baud, timeout = 0.05)
+        self.Timeout   = Timeout
+        self.Window    = max (1, Window)
+        self.LineDelay = LineDelay
+        self.Sequence  = 0
+        self.Buffer    = b''
+        self.Pending   = OrderedDict ()
+        self.Current   = None
+
+    def Close (self):
+        self.Serial.close ()
+
+    def _NextSequence (self):
+        self.Sequence = (self.Sequence + 1) & 0xFFFFFFFF
+        return self.Sequence
+
+    def _Send (self, Command, Index = 0, Attempt = 1):
+        Sequence = self._NextSequence ()
+        #
+        # The shell ends a line on either CR or LF, so a CR LF pair would be
+        # read as a second, empty line.  Send CR only.
+        #
+        self.Serial.write (':{0:x} {1}\r'.format (Sequence, Command).encode ('ascii'))
+        self.Serial.flush ()
+        if self.LineDelay:
+            time.sleep (self.LineDelay)
+        self.Pending[Sequence] = DebugShellResponse (Sequence, Command, Index, Attempt)
+        return Sequence
+
+    def _Read (self):
+        Data = self.Serial.read (max (1, self.Serial.in_waiting))
+        self.Buffer += Data
+        return len (Data) != 0
+
+    def _NextLine (self):
+        Index = self.Buffer.find (b'\n')
+        if Index < 0:
+            return None
+        Line = self.Buffer[:Index].rstrip (b'\r').decode ('ascii', 'replace')
+        self.Buffer = self.Buffer[Index + 1:]
+        return Line
+
+    def _NextFrame (self):
+        #
+        # Take one frame of the current bindump from the buffer.  Returns
+        # False when more data is needed.
+        #
+        Response = self.Current
+        if len (self.Buffer) < _FRAME_HEADER.size:
+            return False
+        Signature, Sequence, Length = _FRAME_HEADER.unpack_from (self.Buffer)
+        if Signature != _FRAME_SIGNATURE or Length > Response.FrameSize:
+            Match = _RESYNC_RE.search (self.Buffer, 0 if Signature != _FRAME_SIGNATURE else 1)
+            if Match is None:
+                self.Buffer = self.Buffer[-_RESYNC_TAIL:]
+                return False
+            self.Buffer = self.Buffer[Match.start ():]
+            if not self.Buffer.startswith (_FRAME_SIGNATURE):
+                Response.Receiving = False
+            return True
+        End = _FRAME_HEADER.size + Length + _FRAME_CRC.size
+        if len (self.Buffer) < End:
+            return False
+        Payload = self.Buffer[_FRAME_HEADER.size:_FRAME_HEADER.size + Length]
+        Crc     = _FRAME_CRC.unpack_from (self.Buffer, End - _FRAME_CRC.size)[0]
+        self.Buffer = self.Buffer[End:]
+        if Length == 0:
+            Response.Receiving = False
+        elif zlib.crc32 (Payload) & 0xFFFFFFFF == Crc:
+            Response.Frames[Sequence] = Payload
+        return True
+
+    def _HandleLine (self, Line):
+        Match = _BEGIN_RE.match (Line)
+        if Match:
+            self.Current = self.Pending.get (int (Match.group (1), 16))
+            return None
+        Match = _END_RE.match (Line)
+        if Match:
+            Response = self.Pending.pop (int (Match.group (1), 16), None)
+            self.Current = None
+            if Response is not None:
+                Response.Status = int (Match.group (2), 16)
+            return Response
+        #
+        # Anything outside a frame is prompt, banner or debug output from the
+        # firmware and is ignored.
+        #
+        if self.Current is not None:
+            self.Current.AddLine (Line)
+        return None
+
+    def _WaitOne (self):
+        Deadline = time.time () + self.Timeout
+        while True:
+            #
+            # One read may complete several frames; keep the data after the
+            # first one in the buffer for the next call.
+            #
+            while True:
+                if self.Current is not None and self.Current.Receiving:
+                    if not self._NextFrame ():
+                        break
+                    continue
+                Line = self._NextLine ()
+                if Line is None:
+                    break
+                Response = self._HandleLine (Line)
+                if Response is not None:
+                    return Response
+            if time.time () >= Deadline:
+                break
+            #
+            # A long bindump takes more than the timeout; wait for it as long
+            # as its frames keep arriving.
+            #
+            if self._Read () and self.Current is not None and self.Current.Receiving:
+                Deadline = time.time () + self.Timeout
+        raise DebugShellTimeout ()
+
+    def RunCommands (self, Commands, Retries = 0):
+        Results = {}
+        Queue   = [(Index, Command, 1) for Index, Command in enumerate (Commands)]
+        while Queue or self.Pending:
+            while Queue and len (self.Pending) < self.Window:
+                Index, Command, Attempt = Queue.pop (0)
+                self._Send (Command, Index, Attempt)
+            try:
+                Response = self._WaitOne ()
+                Results[Response.Index] = Response
+            except DebugShellTimeout:
+                #
+                # Drop everything in flight; the target may have lost the
+                # request or be hung in a command.
+                #
+                Lost = list (self.Pending.values ())
+                self.Pending.clear ()
+                self.Current = None
+                for Response in reversed (Lost):
+                    if Response.Attempt <= Retries:
+                        Queue.insert (0, (Response.Index, Response.Command, Response.Attempt + 1))
+                    else:
+                        Results[Response.Index] = Response
+        return [Results[Key] for Key in sorted (Results)]
+
+    def RunCommand (self, Command, Retries = 0):
+        return self.RunCommands ([Command], Retries)[0]
+
+    def _BinDumpRange (self, Address, Offset, Size, Width, Data):
+        #
+        # Run one bindump and copy the frames with a good CRC32 into Data.
+        # Returns the (offset, size) ranges still missing.
+        #
+        Option   = '-w {0} '.format (Width) if Width else ''
+        Response = self.RunCommand ('bindump {0}{1:x} {2:x}'.format (Option, Address + Offset, Size))
+        if Response.Status is None:
+            return [(Offset, Size)]
+        if not Response.Success or not Response.FrameSize:
+            raise DebugShellError ('bindump {0:x} {1:x}: {2} {3}'.format (
+                                     Address + Offset, Size, Response.StatusName, ' '.join (Response.Text)))
+        Missing = []
+        for Start in range (0, Size, Response.FrameSize):
+            Length  = min (Response.FrameSize, Size - Start)
+            Payload = Response.Frames.get (Start // Response.FrameSize)
+            if Payload is not None and len (Payload) == Length:
+                Data[Offset + Start:Offset + Start + Length] = Payload
+            elif Missing and sum (Missing[-1]) == Offset + Start:
+                Missing[-1] = (Missing[-1][0], Missing[-1][1] + Length)
+            else:
+                Missing.append ((Offset + Start, Length))
+        return Missing
+
+    def BinDump (self, Address, Length, Width = None, Retries = 3):
+        Data    = bytearray (Length)
+        Missing = [(0, Length)]
+        for Attempt in range (Retries + 1):
+            Failed = []
+            for Offset, Size in Missing:
+                Failed.extend (self._BinDumpRange (Address, Offset, Size, Width, Data))
+            Missing = Failed
+            if not Missing:
+                return bytes (Data)
+        raise DebugShellError ('bindump: {0} bytes still damaged after {1} retries'.format (
+                                 sum (Size for Offset, Size in Missing), Retries))
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser (
+                        prog = __prog__,
+                        description = __description__ + __copyright__,
+                        conflict_handler = 'resolve'
+                        )
+    parser.add_argument ("Port",
+                         help = "Serial port or pyserial URL, e.g. COM3, /dev/ttyUSB0 or socket://localhost:4555.")
+    parser.add_argument ("Commands", nargs = '*',
+                         help = "Commands to run.  Read from --file or stdin when omitted.")
+    parser.add_argument ("-b", "--baud", dest = 'Baud', type = int, default = 115200,
+                         help = "Baud rate.  Default is 115200.")
+    parser.add_argument ("-f", "--file", dest = 'File', type = argparse.FileType ('r'),
+                         help = "File with one command per line.  Lines starting with '#' are ignored.")
+    parser.add_argument ("-w", "--window", dest = 'Window', type = int, default = 2,
+                         help = "Number of requests kept in flight.  Default is 2.")
+    parser.add_argument ("-t", "--timeout", dest = 'Timeout', type = float, default = 5.0,
+                         help = "Seconds to wait for each response.  Default is 5.")
+    parser.add_argument ("-r", "--retries", dest = 'Retries', type = int,
+                         help = "Times to resend a request that timed out, or with --bindump to request damaged ranges again.  Default is 0, 3 with --bindump.")
+    parser.add_argument ("-d", "--line-delay", dest = 'LineDelay', type = float, default = 0.0,
+                         help = "Seconds to pause after sending each request.")
+    parser.add_argument ("-j", "--json", dest = 'Json', action = "store_true",
+                         help = "Print the responses as JSON.")
+    parser.add_argument ("-B", "--bindump", dest = 'BinDump', nargs = 2, metavar = ('ADDRESS', 'LENGTH'),
+                         help = "Pull a memory range with bindump instead of running commands.  Hex values.")
+    parser.add_argument ("-W", "--width", dest = 'Width', type = int, choices = [1, 2, 4, 8],
+                         help = "MMIO access width for --bindump.  Default is a memory copy.")
+    parser.add_argument ("-o", "--output", dest = 'Output',
+                         help = "File receiving the --bindump data.  Default is stdout.")
+    parser.add_argument ('--version', action = 'version', version = '%(prog)s ' + __version__)
+    args = parser.parse_args ()
+
+    if args.BinDump:
+        Client = DebugShellClient (args.Port, args.Baud, args.Timeout, 1, args.LineDelay)
+        try:
+            Data = Client.BinDump (int (args.BinDump[0], 16), int (args.BinDump[1], 16), args.Width, 3 if args.Retries is None else args.Retries)
+        except (DebugShellError, DebugShellTimeout) as Error:
+            print ('DebugShellClient: error: {0}'.format (Error or 'timeout'), file = sys.stderr)
+            sys.exit (1)
+        finally:
+            Client.Close ()
+        if args.Output:
+            with open (args.Output, 'wb') as File:
+                File.write (Data)
+        else:
+            sys.stdout.buffer.write (Data)
+        sys.exit (0)
+
+    Commands = args.Commands
+    if not Commands:
+        Source   = args.File if args.File else sys.stdin
+        Commands = [Line.strip () for Line in Source]
+        Commands = [Line for Line in Commands if Line and not Line.startswith ('#')]
+
+    Client = DebugShellClient (args.Port, args.Baud, args.Timeout, args.Window, args.LineDelay)
+    try:
+        Responses = Client.RunCommands (Commands, args.Retries or 0)
+    finally:
+        Client.Close ()
+
+    if args.Json:
+        print (json.dumps ([Response.ToDict () for Response in Responses], indent = 2))
+    else:
+        for Response in Responses:
+            print ('[{0}] {1}'.format (Response.StatusName, Response.Command))
+            for Key, Value in Response.Values.items ():
+                print ('  {0} = {1}'.format (Key, Value))
+            for Line in Response.Text:
+                print ('  ' + Line)
+
+    sys.exit (0 if all (Response.Success for Response in Responses) else 1)
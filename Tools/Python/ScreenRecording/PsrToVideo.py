@@ -0,0 +1,177 @@
+## @file
+# Turn a PrintScreenLogger screen recording (PrtScreen####.psr) into a video.
+#
+# A recording holds the screen size and then one frame per sample in which
+# the screen changed.  Each frame is a list of rectangles of 24bpp pixels,
+# blue first, that replace that part of the screen:
+#
+#   'PSRC' Version:2 TileSize:2 Width:4 Height:4 Interval:4
+#   'PSRF' Sample:4 Time:4 { X:2 Y:2 Width:2 Height:2 Pixels } ... {0 0 0 0}
+#
+# The last frame has no rectangles and gives the end of the recording.  Time
+# is in milliseconds; when the firmware had no TimerLib it is always 0 and
+# the sample number times the interval is used instead.
+#
+# The frames are rebuilt at a constant rate and piped to ffmpeg, or written
+# as raw bgr24 video with --raw.
+#
+# Copyright (c) 2026, Gavin Xue. All rights reserved.<BR>
+# This program and the accompanying materials
+# are licensed and made available under the terms and conditions of the BSD License
+# which accompanies this distribution.  The full text of the license may be found at
+# http://opensource.org/licenses/bsd-license.php
+#
+# THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+# WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+#
+
+'''
+PsrToVideo
+'''
+
+import sys
+import struct
+import argparse
+import subprocess
+
+#
+# Globals for help information
+#
+__prog__        = 'PsrToVideo'
+__version__     = '1.0'
+__copyright__   = 'Copyright (c) 2026, Gavin Xue. All rights reserved.'
+__description__ = 'Convert a PrintScreenLogger screen recording to a video.\n'
+
+_HEADER = struct.Struct ('<4sHHIII')
+_FRAME  = struct.Struct ('<4sII')
+_RECT   = struct.Struct ('<HHHH')
+
+class PsrError (Exception):
+    pass
+
+class PsrFrame (object):
+    def __init__ (self, Sample, Time):
+        self.Sample = Sample
+        self.Time   = Time
+        self.Rects  = []        # (X, Y, Width, Height, Offset of the pixels)
+
+class PsrRecording (object):
+    def __init__ (self, Data):
+        if len (Data) < _HEADER.size:
+            raise PsrError ('file is too short')
+        Signature, Version, self.TileSize, self.Width, self.Height, self.Interval = _HEADER.unpack_from (Data, 0)
+        if Signature != b'PSRC' or Version != 1:
+            raise PsrError ('not a version 1 screen recording')
+        self.Data   = Data
+        self.Frames = []
+
+        Offset = _HEADER.size
+        while Offset + _FRAME.size <= len (Data):
+            Signature, Sample, Time = _FRAME.unpack_from (Data, Offset)
+            if Signature != b'PSRF':
+                raise PsrError ('bad frame signature at offset {0:#x}'.format (Offset))
+            Frame   = PsrFrame (Sample, Time)
+            Offset += _FRAME.size
+            while True:
+                if Offset + _RECT.size > len (Data):
+                    raise PsrError ('recording is truncated')
+                X, Y, Width, Height = _RECT.unpack_from (Data, Offset)
+                Offset += _RECT.size
+                if Width == 0:
+                    break
+                if X + Width > self.Width or Y + Height > self.Height or Offset + Width * Height * 3 > len (Data):
+                    raise PsrError ('bad rectangle at offset {0:#x}'.format (Offset - _RECT.size))
+                Frame.Rects.append ((X, Y, Width, Height, Offset))
+                Offset += Width * Height * 3
+            self.Frames.append (Frame)
+
+        if not self.Frames:
+            raise PsrError ('recording has no frames')
+
+        #
+        # Without a TimerLib every time is 0; fall back to the sample clock.
+        #
+        if self.Frames[-1].Time == 0:
+            for Frame in self.Frames:
+                Frame.Time = Frame.Sample * self.Interval
+
+    def Apply (self, Screen, Frame):
+        Stride = self.Width * 3
+        for X, Y, Width, Height, Offset in Frame.Rects:
+            for Row in range (Height):
+                Start = (Y + Row) * Stride + X * 3
+                Screen[Start:Start + Width * 3] = self.Data[Offset:Offset + Width * 3]
+                Offset += Width * 3
+
+    def Render (self, Rate, Output):
+        '''
+        Write bgr24 frames at Rate frames per second to Output.
+        Returns the number of frames written.
+        '''
+        Screen  = bytearray (self.Width * self.Height * 3)
+        Written = 0
+        for Frame in self.Frames:
+            Due = Frame.Time * Rate // 1000
+            while Written < Due:
+                Output.write (Screen)
+                Written += 1
+            self.Apply (Screen, Frame)
+        if Written == 0:
+            Output.write (Screen)
+            Written = 1
+        return Written
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser (
+                        prog = __prog__,
+                        description = __description__ + __copyright__,
+                        conflict_handler = 'resolve'
+                        )
+    parser.add_argument ("Input",
+                         help = "The PrtScreen####.psr recording.")
+    parser.add_argument ("Output",
+                         help = "The video to write, e.g. boot.mp4.")
+    parser.add_argument ("-r", "--rate", dest = 'Rate', type = int, default = 0,
+                         help = "Video frames per second.  Default is one per recording interval.")
+    parser.add_argument ("--raw", dest = 'Raw', action = "store_true",
+                         help = "Write raw bgr24 frames instead of running ffmpeg.")
+    parser.add_argument ("--ffmpeg", dest = 'FFmpeg', default = 'ffmpeg',
+                         help = "The ffmpeg program.  Default is ffmpeg.")
+    parser.add_argument ('--version', action = 'version', version = '%(prog)s ' + __version__)
+    args = parser.parse_args ()
+
+    with open (args.Input, 'rb') as File:
+        Data = File.read ()
+    try:
+        Recording = PsrRecording (Data)
+    except PsrError as Error:
+        print ('{0}: error: {1}: {2}'.format (__prog__, args.Input, Error))
+        sys.exit (1)
+
+    Rate = args.Rate if args.Rate > 0 else max (1, 1000 // max (1, Recording.Interval))
+
+    if args.Raw:
+        with open (args.Output, 'wb') as Output:
+            Count = Recording.Render (Rate, Output)
+    else:
+        Command = [args.FFmpeg, '-loglevel', 'error', '-y',
+                   '-f', 'rawvideo', '-pix_fmt', 'bgr24',
+                   '-s', '{0}x{1}'.format (Recording.Width, Recording.Height),
+                   '-r', str (Rate), '-i', '-',
+                   '-pix_fmt', 'yuv420p', args.Output]
+        try:
+            Encoder = subprocess.Popen (Command, stdin = subprocess.PIPE)
+        except OSError as Error:
+            print ('{0}: error: cannot run {1}: {2}'.format (__prog__, args.FFmpeg, Error))
+            sys.exit (1)
+        try:
+            Count = Recording.Render (Rate, Encoder.stdin)
+        finally:
+            Encoder.stdin.close ()
+        if Encoder.wait () != 0:
+            sys.exit (1)
+
+    print ('{0}: {1}x{2}, {3} changes, {4} frames at {5} fps written to {6}'.format (
+           args.Input, Recording.Width, Recording.Height, len (Recording.Frames) - 1,
+           Count, Rate, args.Output))
+    sys.exit (0)